@@ -0,0 +1,319 @@
+#include "ambience_gen.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Modulation (wind gusts, drop spawning) runs once per control chunk. */
+#define GEN_CONTROL_FRAMES 32u
+
+typedef struct {
+    AmbienceGenKind kind;
+    const char* id;   /* pseudo path suffix: "gen:<id>" */
+    const char* name; /* user-facing name */
+} GenInfo;
+
+static const GenInfo k_gens[] = {
+    { AMBIENCE_GEN_WHITE, "white", "white noise" },
+    { AMBIENCE_GEN_PINK,  "pink",  "pink noise" },
+    { AMBIENCE_GEN_BROWN, "brown", "brown noise" },
+    { AMBIENCE_GEN_RAIN,  "rain",  "rain" },
+    { AMBIENCE_GEN_WIND,  "wind",  "wind" },
+};
+
+#define GEN_COUNT ((int)(sizeof(k_gens) / sizeof(k_gens[0])))
+
+AmbienceGenKind ambience_gen_kind_from_name(const char* name) {
+    if (!name || !name[0]) return AMBIENCE_GEN_NONE;
+    for (int i = 0; i < GEN_COUNT; i++) {
+        if (strcasecmp(name, k_gens[i].name) == 0) return k_gens[i].kind;
+    }
+    return AMBIENCE_GEN_NONE;
+}
+
+AmbienceGenKind ambience_gen_kind_from_path(const char* path) {
+    const size_t plen = sizeof(AMBIENCE_GEN_PATH_PREFIX) - 1;
+    if (!path || strncmp(path, AMBIENCE_GEN_PATH_PREFIX, plen) != 0) return AMBIENCE_GEN_NONE;
+    for (int i = 0; i < GEN_COUNT; i++) {
+        if (strcmp(path + plen, k_gens[i].id) == 0) return k_gens[i].kind;
+    }
+    return AMBIENCE_GEN_NONE;
+}
+
+const char* ambience_gen_name(AmbienceGenKind kind) {
+    for (int i = 0; i < GEN_COUNT; i++) {
+        if (k_gens[i].kind == kind) return k_gens[i].name;
+    }
+    return "";
+}
+
+void ambience_gen_path(AmbienceGenKind kind, char* out, size_t cap) {
+    if (!out || cap == 0) return;
+    out[0] = 0;
+    for (int i = 0; i < GEN_COUNT; i++) {
+        if (k_gens[i].kind == kind) {
+            snprintf(out, cap, "%s%s", AMBIENCE_GEN_PATH_PREFIX, k_gens[i].id);
+            return;
+        }
+    }
+}
+
+static uint32_t rng_next(AmbienceGen* g) {
+    uint32_t x = g->ctl_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    g->ctl_rng = x;
+    return x;
+}
+
+/* Uniform in [0, 1). */
+static float rng_unit(AmbienceGen* g) {
+    return (float)(rng_next(g) >> 8) * (1.0f / 16777216.0f);
+}
+
+/* Block white noise in [-1, 1). The lanes are independent xorshift32
+   generators, so the inner loop is a straight SIMD candidate (shifts, xors
+   and an int->float convert). */
+static void fill_white(uint32_t rng[AMBIENCE_GEN_RNG_LANES], float* out, uint32_t n) {
+    uint32_t s[AMBIENCE_GEN_RNG_LANES];
+    memcpy(s, rng, sizeof(s));
+    uint32_t i = 0;
+    for (; i + AMBIENCE_GEN_RNG_LANES <= n; i += AMBIENCE_GEN_RNG_LANES) {
+        for (int l = 0; l < AMBIENCE_GEN_RNG_LANES; l++) {
+            uint32_t x = s[l];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            s[l] = x;
+            out[i + (uint32_t)l] = (float)(int32_t)x * (1.0f / 2147483648.0f);
+        }
+    }
+    for (int l = 0; i < n; i++, l++) {
+        uint32_t x = s[l];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        s[l] = x;
+        out[i] = (float)(int32_t)x * (1.0f / 2147483648.0f);
+    }
+    memcpy(rng, s, sizeof(s));
+}
+
+/* Paul Kellet's economy pink filter, in place. */
+static void pink_filter(float st[3], float* buf, uint32_t n, float gain) {
+    float b0 = st[0], b1 = st[1], b2 = st[2];
+    for (uint32_t i = 0; i < n; i++) {
+        const float w = buf[i];
+        b0 = 0.99765f * b0 + w * 0.0990460f;
+        b1 = 0.96300f * b1 + w * 0.2965164f;
+        b2 = 0.57000f * b2 + w * 1.0526913f;
+        buf[i] = (b0 + b1 + b2 + w * 0.1848f) * gain;
+    }
+    st[0] = b0;
+    st[1] = b1;
+    st[2] = b2;
+}
+
+/* Leaky integrator ("brown"/red noise), in place. */
+static void brown_filter(float* st, float* buf, uint32_t n, float gain) {
+    float b = *st;
+    for (uint32_t i = 0; i < n; i++) {
+        b = (b + 0.02f * buf[i]) * (1.0f / 1.02f);
+        buf[i] = b * gain;
+    }
+    *st = b;
+}
+
+static void gain_block(float* buf, uint32_t n, float gain) {
+    for (uint32_t i = 0; i < n; i++) buf[i] *= gain;
+}
+
+void ambience_gen_init(AmbienceGen* g, AmbienceGenKind kind, int sample_rate, uint32_t seed) {
+    if (!g) return;
+    memset(g, 0, sizeof(*g));
+    g->kind = kind;
+    g->sample_rate = sample_rate > 0 ? sample_rate : 44100;
+
+    /* Spread the seed over the lanes (splitmix-style mixing); xorshift state
+       must never be zero. */
+    uint32_t z = seed ? seed : 0x9E3779B9u;
+    for (int l = 0; l <= AMBIENCE_GEN_RNG_LANES; l++) {
+        z += 0x9E3779B9u;
+        uint32_t x = z;
+        x = (x ^ (x >> 16)) * 0x85EBCA6Bu;
+        x = (x ^ (x >> 13)) * 0xC2B2AE35u;
+        x ^= x >> 16;
+        x = x ? x : 0x6D2B79F5u;
+        if (l < AMBIENCE_GEN_RNG_LANES) g->rng[l] = x;
+        else g->ctl_rng = x;
+    }
+    g->lfo_phase[0] = 0.0f;
+    g->lfo_phase[1] = 0.37f;
+    g->gust = 0.5f;
+    g->gust_target = 0.5f;
+}
+
+static void render_wind(AmbienceGen* g, float* out_l, float* out_r, uint32_t frames) {
+    float* ch[2] = { out_l, out_r };
+    const float sr = (float)g->sample_rate;
+    const float lfo_inc[2] = { 0.07f / sr, 0.13f / sr };
+
+    /* Brown noise core: the body of the wind. */
+    fill_white(g->rng, out_l, frames);
+    fill_white(g->rng, out_r, frames);
+    brown_filter(&g->brown[0], out_l, frames, 3.5f);
+    brown_filter(&g->brown[1], out_r, frames, 3.5f);
+
+    for (uint32_t off = 0; off < frames; off += GEN_CONTROL_FRAMES) {
+        const uint32_t n = (frames - off < GEN_CONTROL_FRAMES) ? frames - off : GEN_CONTROL_FRAMES;
+
+        /* Gusts: glide towards a random target, pick a new one every few
+           seconds. */
+        if (g->gust_frames_left <= n) {
+            g->gust_target = 0.2f + 0.8f * rng_unit(g);
+            g->gust_frames_left = (uint32_t)((2.0f + 6.0f * rng_unit(g)) * sr);
+        } else {
+            g->gust_frames_left -= n;
+        }
+        g->gust += (g->gust_target - g->gust) * (0.35f * (float)n / sr);
+
+        for (int c = 0; c < 2; c++) {
+            const float lfo = sinf(2.0f * (float)M_PI * g->lfo_phase[c]);
+            g->lfo_phase[c] += lfo_inc[c] * (float)n;
+            if (g->lfo_phase[c] >= 1.0f) g->lfo_phase[c] -= 1.0f;
+
+            const float level = g->gust * (0.75f + 0.25f * lfo);
+            float fc = 180.0f + 900.0f * level;
+            float f = 2.0f * sinf((float)M_PI * fc / sr);
+            if (f > 0.9f) f = 0.9f;
+            const float q = 0.35f;
+
+            float low = g->svf_low[c], band = g->svf_band[c];
+            float* buf = ch[c] + off;
+            for (uint32_t i = 0; i < n; i++) {
+                low += f * band;
+                const float high = buf[i] - low - q * band;
+                band += f * high;
+                buf[i] = (0.6f * band + 0.4f * low) * level;
+            }
+            g->svf_low[c] = low;
+            g->svf_band[c] = band;
+        }
+    }
+}
+
+static void rain_spawn_drop(AmbienceGen* g) {
+    int slot = -1;
+    for (int d = 0; d < AMBIENCE_GEN_DROPS; d++) {
+        if (g->drop_frames_left[d] == 0) {
+            slot = d;
+            break;
+        }
+    }
+    if (slot < 0) return;
+
+    const float sr = (float)g->sample_rate;
+    const float hz = 1500.0f + 4000.0f * rng_unit(g);
+    const float decay_sec = 0.004f + 0.020f * rng_unit(g);
+    const float amp = 0.04f + 0.22f * rng_unit(g) * rng_unit(g);
+    const float w = 2.0f * (float)M_PI * hz / sr;
+    /* 60 dB down after decay_sec. */
+    const float k = expf(-6.9077553f / (decay_sec * sr));
+
+    g->drop_re[slot] = amp;
+    g->drop_im[slot] = 0.0f;
+    g->drop_c[slot] = k * cosf(w);
+    g->drop_s[slot] = k * sinf(w);
+    g->drop_pan[slot] = rng_unit(g);
+    g->drop_frames_left[slot] = (uint32_t)(decay_sec * sr) + 1u;
+}
+
+static void render_rain(AmbienceGen* g, float* out_l, float* out_r, uint32_t frames) {
+    const float sr = (float)g->sample_rate;
+    /* Roughly 45 audible drops per second over a soft hiss. */
+    const float spawn_p = 45.0f * (float)GEN_CONTROL_FRAMES / sr;
+    const float hiss_a = 1.0f - expf(-2.0f * (float)M_PI * 3500.0f / sr);
+
+    fill_white(g->rng, out_l, frames);
+    fill_white(g->rng, out_r, frames);
+    float* ch[2] = { out_l, out_r };
+    for (int c = 0; c < 2; c++) {
+        float lp = g->hiss_lp[c];
+        float* buf = ch[c];
+        for (uint32_t i = 0; i < frames; i++) {
+            lp += hiss_a * (buf[i] - lp);
+            buf[i] = lp;
+        }
+        g->hiss_lp[c] = lp;
+        pink_filter(g->pink[c], buf, frames, 0.05f);
+    }
+
+    for (uint32_t off = 0; off < frames; off += GEN_CONTROL_FRAMES) {
+        const uint32_t n = (frames - off < GEN_CONTROL_FRAMES) ? frames - off : GEN_CONTROL_FRAMES;
+        if (rng_unit(g) < spawn_p) rain_spawn_drop(g);
+
+        for (int d = 0; d < AMBIENCE_GEN_DROPS; d++) {
+            if (g->drop_frames_left[d] == 0) continue;
+            const uint32_t m = g->drop_frames_left[d] < n ? g->drop_frames_left[d] : n;
+            float re = g->drop_re[d], im = g->drop_im[d];
+            const float dc = g->drop_c[d], ds = g->drop_s[d];
+            const float pr = g->drop_pan[d], pl = 1.0f - pr;
+            for (uint32_t i = 0; i < m; i++) {
+                const float r = re * dc - im * ds;
+                im = re * ds + im * dc;
+                re = r;
+                out_l[off + i] += im * pl;
+                out_r[off + i] += im * pr;
+            }
+            g->drop_re[d] = re;
+            g->drop_im[d] = im;
+            g->drop_frames_left[d] -= m;
+        }
+    }
+}
+
+void ambience_gen_render(AmbienceGen* g, float* out_l, float* out_r, uint32_t frames) {
+    if (!out_l || !out_r || frames == 0) return;
+    if (!g || g->kind == AMBIENCE_GEN_NONE) {
+        memset(out_l, 0, (size_t)frames * sizeof(float));
+        memset(out_r, 0, (size_t)frames * sizeof(float));
+        return;
+    }
+
+    switch (g->kind) {
+    case AMBIENCE_GEN_WHITE:
+        fill_white(g->rng, out_l, frames);
+        fill_white(g->rng, out_r, frames);
+        gain_block(out_l, frames, 0.18f);
+        gain_block(out_r, frames, 0.18f);
+        break;
+    case AMBIENCE_GEN_PINK:
+        fill_white(g->rng, out_l, frames);
+        fill_white(g->rng, out_r, frames);
+        pink_filter(g->pink[0], out_l, frames, 0.06f);
+        pink_filter(g->pink[1], out_r, frames, 0.06f);
+        break;
+    case AMBIENCE_GEN_BROWN:
+        fill_white(g->rng, out_l, frames);
+        fill_white(g->rng, out_r, frames);
+        brown_filter(&g->brown[0], out_l, frames, 2.0f);
+        brown_filter(&g->brown[1], out_r, frames, 2.0f);
+        break;
+    case AMBIENCE_GEN_RAIN:
+        render_rain(g, out_l, out_r, frames);
+        break;
+    case AMBIENCE_GEN_WIND:
+        render_wind(g, out_l, out_r, frames);
+        break;
+    default:
+        memset(out_l, 0, (size_t)frames * sizeof(float));
+        memset(out_r, 0, (size_t)frames * sizeof(float));
+        break;
+    }
+}
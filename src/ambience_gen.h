@@ -0,0 +1,72 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Built-in ambience generators, rendered in the mixer instead of decoding a
+   looped file. They are addressed with pseudo paths ("gen:pink") so they can
+   go anywhere an ambience file path goes. Output is deterministic for a given
+   seed. */
+
+#define AMBIENCE_GEN_PATH_PREFIX "gen:"
+#define AMBIENCE_GEN_RNG_LANES 4
+#define AMBIENCE_GEN_DROPS 12
+
+typedef enum {
+    AMBIENCE_GEN_NONE = 0,
+    AMBIENCE_GEN_WHITE,
+    AMBIENCE_GEN_PINK,
+    AMBIENCE_GEN_BROWN,
+    AMBIENCE_GEN_RAIN,
+    AMBIENCE_GEN_WIND,
+} AmbienceGenKind;
+
+typedef struct AmbienceGen {
+    AmbienceGenKind kind;
+    int sample_rate;
+    /* Independent xorshift32 lanes; one block fill updates all lanes at once. */
+    uint32_t rng[AMBIENCE_GEN_RNG_LANES];
+    /* Separate xorshift32 state for modulation (gusts, drops), so drawing
+       from it doesn't disturb the noise lanes. */
+    uint32_t ctl_rng;
+    /* Per-channel filter state (pink: Kellet taps b0..b2, brown: b0). */
+    float pink[2][3];
+    float brown[2];
+    /* Wind: state-variable low-pass per channel plus slow modulation. */
+    float svf_low[2];
+    float svf_band[2];
+    float lfo_phase[2];
+    float gust;
+    float gust_target;
+    uint32_t gust_frames_left;
+    /* Rain: background hiss filter and a small pool of drop resonators. */
+    float hiss_lp[2];
+    float drop_re[AMBIENCE_GEN_DROPS];
+    float drop_im[AMBIENCE_GEN_DROPS];
+    float drop_c[AMBIENCE_GEN_DROPS];
+    float drop_s[AMBIENCE_GEN_DROPS];
+    float drop_pan[AMBIENCE_GEN_DROPS];
+    uint32_t drop_frames_left[AMBIENCE_GEN_DROPS];
+} AmbienceGen;
+
+/* Maps a user-facing name ("pink noise", "rain", ...) to a generator. */
+AmbienceGenKind ambience_gen_kind_from_name(const char* name);
+/* Maps a "gen:<id>" pseudo path to a generator; NONE for real files. */
+AmbienceGenKind ambience_gen_kind_from_path(const char* path);
+const char* ambience_gen_name(AmbienceGenKind kind);
+/* Writes the pseudo path for kind ("gen:pink"). */
+void ambience_gen_path(AmbienceGenKind kind, char* out, size_t cap);
+
+void ambience_gen_init(AmbienceGen* g, AmbienceGenKind kind, int sample_rate, uint32_t seed);
+
+/* Renders frames of planar stereo into out_l/out_r (overwrites, roughly
+   -1..1). Both buffers must hold at least frames floats. */
+void ambience_gen_render(AmbienceGen* g, float* out_l, float* out_r, uint32_t frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,8 @@
 #include "features/quest/quest_types.h"
 #include "features/routines/routine_types.h"
 #include "features/tasks/task_types.h"
+#include "ui/damage.h"
+#include "ui/particles.h"
 #include "utils/string_utils.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -25,14 +27,19 @@
 #endif
 
 #define STATES_TASKS_DIR STATES_DIR "/tasks"
+#define STATES_CACHE_DIR STATES_DIR "/cache"
 #define CONFIG_PATH STATES_DIR "/config.txt"
 #define FOCUS_STATS_PATH STATES_DIR "/focus_stats.txt"
+#define STATS_PATH STATES_DIR "/stats.txt"
 #define LOG_PATH STATES_DIR "/log.txt"
 #define BOOKLETS_STATE_PATH STATES_DIR "/booklets_state.txt"
 #define MUSIC_STATE_PATH STATES_DIR "/music_state.txt"
 #define HUD_STANZA_OVERRIDES_PATH STATES_DIR "/hud_stanzas.txt"
 #define ACTIVITY_LOG_PATH STATES_DIR "/activity_log.txt"
+#define ACTIVITY_ROLLUP_PATH STATES_DIR "/activity_rollup.txt"
 #define FOCUS_HISTORY_PATH STATES_DIR "/focus_history.txt"
+/* Monthly segments of the two logs above (history_log.h). */
+#define HISTORY_DIR STATES_DIR "/history"
 
 #define MAX_FOCUS_STATS 32
 
@@ -180,6 +187,9 @@ typedef struct {
   int font_small_pt;
   int font_med_pt;
   int font_big_pt;
+  int bg_cache_mb; /* background texture cache budget; 0 keeps just one */
+  int overlay_mb;  /* overlay frame budget; 0 turns frame overlays off */
+  int bg_disk_mb;  /* decoded background disk cache budget; 0 turns it off */
   int music_enabled;
   char music_folder[128];
   int ambience_enabled;
@@ -237,6 +247,15 @@ typedef struct {
   char user_name[64];                /* Personalized greeting name */
 } AppConfig;
 
+/* Screen-sized, pre-composited background variants (see bg_layers_build). */
+typedef enum {
+  BG_LAYER_NORMAL = 0,
+  BG_LAYER_BLURRED, /* blurred, 50% dim: menus and overlays */
+  BG_LAYER_FAINT,   /* BG_FAINT_ALPHA over black: booklet reader */
+  BG_LAYER_HIDDEN,  /* shifted up BG_HIDDEN_SHIFT_Y: hidden HUD */
+  BG_LAYER_COUNT
+} BgLayer;
+
 typedef struct UI {
   SDL_Window *win;
   SDL_Renderer *ren;
@@ -251,19 +270,21 @@ typedef struct UI {
   TTF_Font *font_big_i;
   SDL_Texture *bg_tex;
   SDL_Texture *bg_blur_tex;
-  int w, h;
+  /* Rebuilt whenever the background changes; all NULL if they could not
+   * be created, in which case frames compose from bg_tex/bg_blur_tex. */
+  SDL_Texture *bg_layers[BG_LAYER_COUNT];
+  int w, h; /* the window's actual size */
+  /* Opaque full-screen textures are created in this (the window's) format
+   * so copying them involves no conversion. */
+  Uint32 pixel_format;
+  /* The renderer draws straight into the window surface, so the main loop
+   * presents it itself and can push only the damaged rectangles. */
+  bool surface_present;
+  /* Time-varying widgets (timer digits, HUD status) drawn in the last frame.
+   * A one-second tick redraws just these rectangles. */
+  DamageList live;
 } UI;
 
-typedef struct TextCache {
-  SDL_Texture *tex;
-  TTF_Font *font;
-  int style;
-  SDL_Color color;
-  char text[256];
-  int w;
-  int h;
-} TextCache;
-
 typedef struct App {
   StrList scenes;
   StrList weathers;
@@ -332,7 +353,13 @@ typedef struct App {
     StrList tracks;
     int idx;
     bool active;
+    int load_failures; /* consecutive tracks that failed to open */
   } musicq;
+  /* SDL user event type the audio engine pushes to wake the main loop (0 =
+   * none). */
+  uint32_t audio_wake_event;
+  /* Same, pushed by the background loader when a decode is ready. */
+  uint32_t bg_wake_event;
   /* Ambience sounds (hardcoded list mapped to sounds/ambience/*.wav). */
   StrList ambience_sounds;
   int ambience_idx;
@@ -343,24 +370,27 @@ typedef struct App {
   /* Animated overlay (PNG frame sequence driven by ambience_tag) */
   int anim_overlay_enabled; /* mirrors cfg.animations, but may be forced off if
                                assets missing */
-  SDL_Texture **anim_overlay_frames;
+  /* Frames come from the overlay player. They are composited straight onto
+   * the window surface when the renderer draws there (direct), otherwise
+   * copied into one streaming texture when the frame changes. */
+  bool anim_overlay_direct;
+  SDL_Texture *anim_overlay_tex;
+  bool anim_overlay_tex_stale;
   int anim_overlay_frame_count;
-  int anim_overlay_frame_idx;
   float anim_overlay_frame_delay_sec; /* seconds between PNG frames */
   float anim_overlay_accum;
   uint64_t anim_overlay_last_ms;
+  /* Set instead of the player when the tag has a <tag>.particles file. */
+  ParticleSystem *anim_particles;
   /* UI scheduling / power:
      - ui_needs_redraw is set whenever something visible changes (input, timer
      tick, anim frame). The main loop skips rendering when nothing changed,
      letting the device truly idle.
+     - ui_tick_damage is set by the one-second tick when only the live
+     widgets (UI.live) changed; the main loop redraws just those.
   */
   bool ui_needs_redraw;
-  /* Cached rendered text for frequently redrawn UI elements. */
-  TextCache cache_big_time;
-  TextCache cache_clock_min;
-  TextCache cache_clock_hour;
-  TextCache cache_batt_bottom;
-  TextCache cache_batt_top;
+  bool ui_tick_damage;
   /* Sounds settings */
   int sounds_sel; /* 0=Music,1=Ambience,2=Notifications,3=Volume */
   int volume_sel; /* 0=Music,1=Ambience,2=Notifications */
@@ -380,9 +410,12 @@ typedef struct App {
   int meditation_bell_start_idx;
   int meditation_bell_interval_idx;
   int meditation_bell_end_idx;
-  /* History cache */
+  /* History cache: the rows shown, from row cached_history_first (newest
+   * first) */
   FocusHistoryRow cached_history_rows[30];
   int cached_history_count;
+  int cached_history_first;
+  int cached_history_max;
   bool history_dirty;
   AppConfig cfg;
   Screen screen;
@@ -458,6 +491,7 @@ typedef struct App {
   int stats_section;        /* 0: focus, 1: habits */
   int stats_page;           /* section-specific page index */
   int stats_history_scroll; /* scroll offset for history list */
+  int stats_history_rows;   /* history rows that fit on one page */
   int stats_list_scroll;    /* scroll offset for list-style stats */
   bool stats_return_to_settings;
   int settings_about_scroll; /* scroll offset for the About settings */
@@ -471,6 +505,8 @@ typedef struct App {
   char help_overlay_path[PATH_MAX];
   bool menu_btn_down;
   uint64_t menu_btn_down_ms;
+  /* MENU was used in a combo this press: no short-press action or help. */
+  bool menu_btn_combo;
   bool hud_hide_btn_down;
   bool hud_hide_hold_triggered;
   uint64_t hud_hide_btn_down_ms;
@@ -1,4 +1,6 @@
 #include "audio_engine.h"
+#include "ambience_gen.h"
+#include "bell_synth.h"
 
 #include <SDL2/SDL.h>
 #include <stdio.h>
@@ -29,6 +31,34 @@
 #define VIS_FFT_N        512u    /* must be power of two */
 #define VIS_MAX_BINS     64
 
+/* Synthesized bell voices that can ring over each other. */
+#define BELL_VOICES 4
+
+/* Engine -> UI events. One single-producer ring per producing thread, so
+   pushing never takes a lock or blocks the audio callback. */
+#define EVENT_QUEUE_CAP 64u /* must be power of two */
+#define AUDIO_MAX_CUES  8
+#define AMB_LOOP_MARKS  8
+
+enum {
+    EVQ_CALLBACK = 0,
+    EVQ_MUSIC_LOADER,
+    EVQ_AMBIENCE_LOADER,
+    EVQ_COUNT
+};
+
+typedef struct {
+    AudioEvent   items[EVENT_QUEUE_CAP];
+    SDL_atomic_t head; /* written by the consumer only */
+    SDL_atomic_t tail; /* written by the producer only */
+} EventQueue;
+
+typedef struct {
+    uint32_t id;
+    uint64_t due_frame;
+    bool     active;
+} AudioCue;
+
 static void fft_radix2(float* real, float* imag, uint32_t n) {
     /* In-place iterative Cooley–Tukey radix-2 FFT. */
     uint32_t j = 0;
@@ -137,6 +167,8 @@ struct AudioEngine {
     MusicDecoder dec;
     PcmRing      music_rb;
     bool         music_ended_latched;
+    bool         music_end_sent;
+    bool         music_underrun;
     bool         music_paused;
     /* Simple pop/click prevention: keep music muted until we have some buffered frames. */
     bool         music_wait_prefill;
@@ -153,10 +185,51 @@ struct AudioEngine {
     PcmRing      ambience_rb;
     bool         ambience_paused;
     bool         ambience_wait_prefill;
+    bool         ambience_underrun;
     char         ambience_path[512];
+    /* Loop points still in the ring, as counts of frames written to it;
+       LOOP_WRAPPED is sent when the callback has read up to one, i.e.
+       when the wrap is heard rather than when the loader decodes it. */
+    uint64_t     amb_frames_written;
+    uint64_t     amb_frames_read;
+    uint64_t     amb_loop_marks[AMB_LOOP_MARKS];
+    int          amb_loop_mark_count;
+
+    /* Generated ambience ("gen:" paths) bypasses the loader thread and the
+       ring; the callback renders it block-wise into gen_l/gen_r. */
+    AmbienceGen amb_gen;
+    bool        amb_gen_active;
+    uint32_t    amb_gen_seed;
+    float*      gen_l;
+    float*      gen_r;
 
     PcmBuffer sfx;
 
+    /* Event queues (see EVQ_*) and the optional SDL wake-up event. */
+    EventQueue   events[EVQ_COUNT];
+    SDL_atomic_t wake_event_type; /* 0 = don't push SDL events */
+    SDL_atomic_t wake_pending;
+    /* SDL_PushEvent locks SDL's event queue, so the callback never calls it:
+       it posts wake_sem and wake_thread pushes the event instead. */
+    SDL_sem*     wake_sem;
+    SDL_Thread*  wake_thread;
+    SDL_atomic_t wake_quit;
+
+    /* Callback time for audio_engine_callback_load: microseconds spent in
+       the callback since the last read, and when that read was. */
+    SDL_atomic_t cb_busy_us;
+    Uint64       cb_load_since;
+
+    /* Scheduled cues, checked against the output frame clock each block. */
+    AudioCue cues[AUDIO_MAX_CUES];
+    uint64_t frames_played;
+
+    /* Synthesized bells, rendered block-wise in the callback into bell_mix
+       (mono float, bell_mix_frames long). */
+    BellVoice bells[BELL_VOICES];
+    float*    bell_mix;
+    uint32_t  bell_mix_frames;
+
     int master_vol; /* 0..128 */
     int music_vol;  /* 0..128 */
     int ambience_vol;  /* 0..128 */
@@ -205,6 +278,14 @@ static void ring_clear(PcmRing* r) {
     r->frames_queued = 0;
 }
 
+/* Empties the ambience ring along with the loop points queued in it. */
+static void ambience_ring_clear(AudioEngine* a) {
+    ring_clear(&a->ambience_rb);
+    a->amb_frames_written = 0;
+    a->amb_frames_read = 0;
+    a->amb_loop_mark_count = 0;
+}
+
 static uint32_t ring_space_frames(const PcmRing* r) {
     if (!r || r->capacity_frames == 0) return 0;
     return r->capacity_frames - r->frames_queued;
@@ -446,7 +527,65 @@ static AudioResult music_decoder_open(MusicDecoder* d, const char* path, const S
     return AUDIO_OK;
 }
 
+static bool event_queue_push(EventQueue* q, const AudioEvent* ev) {
+    const uint32_t tail = (uint32_t)SDL_AtomicGet(&q->tail);
+    const uint32_t head = (uint32_t)SDL_AtomicGet(&q->head);
+    if (tail - head >= EVENT_QUEUE_CAP) return false; /* full: drop */
+    q->items[tail & (EVENT_QUEUE_CAP - 1u)] = *ev;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&q->tail, (int)(tail + 1u));
+    return true;
+}
+
+static bool event_queue_pop(EventQueue* q, AudioEvent* out) {
+    const uint32_t head = (uint32_t)SDL_AtomicGet(&q->head);
+    const uint32_t tail = (uint32_t)SDL_AtomicGet(&q->tail);
+    if (head == tail) return false;
+    SDL_MemoryBarrierAcquire();
+    *out = q->items[head & (EVENT_QUEUE_CAP - 1u)];
+    SDL_AtomicSet(&q->head, (int)(head + 1u));
+    return true;
+}
+
+static void push_wake_event(AudioEngine* a, Uint32 wake_type) {
+    SDL_Event e;
+    memset(&e, 0, sizeof(e));
+    e.type = wake_type;
+    if (SDL_PushEvent(&e) != 1) SDL_AtomicSet(&a->wake_pending, 0);
+}
+
+static int wake_thread_main(void* userdata) {
+    AudioEngine* a = (AudioEngine*)userdata;
+    for (;;) {
+        SDL_SemWait(a->wake_sem);
+        if (SDL_AtomicGet(&a->wake_quit)) break;
+        const Uint32 wake_type = (Uint32)SDL_AtomicGet(&a->wake_event_type);
+        if (wake_type != 0) push_wake_event(a, wake_type);
+        else SDL_AtomicSet(&a->wake_pending, 0);
+    }
+    return 0;
+}
+
+/* Queue an event from producer thread `queue` and, if the UI asked for it,
+   wake SDL_WaitEventTimeout with at most one pending user event. The
+   callback only posts a semaphore; the loaders push the event themselves. */
+static void emit_event(AudioEngine* a, int queue, AudioEventType type, AudioEventSource source, uint32_t value) {
+    AudioEvent ev;
+    ev.type = type;
+    ev.source = source;
+    ev.value = value;
+    if (!event_queue_push(&a->events[queue], &ev)) return;
+
+    const Uint32 wake_type = (Uint32)SDL_AtomicGet(&a->wake_event_type);
+    if (wake_type != 0 && SDL_AtomicCAS(&a->wake_pending, 0, 1)) {
+        if (queue != EVQ_CALLBACK) push_wake_event(a, wake_type);
+        else if (a->wake_sem) SDL_SemPost(a->wake_sem);
+        else SDL_AtomicSet(&a->wake_pending, 0);
+    }
+}
+
 static void audio_callback(void* userdata, Uint8* stream, int len) {
+    const Uint64 cb_t0 = SDL_GetPerformanceCounter();
     AudioEngine* a = (AudioEngine*)userdata;
     int16_t* out = (int16_t*)stream;
     int samples = len / (int)sizeof(int16_t);
@@ -471,21 +610,71 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
         const uint32_t prefill = (uint32_t)a->out_spec.freq / 20u; /* ~50ms */
         if (a->music_rb.frames_queued >= prefill) {
             a->music_wait_prefill = false;
+            if (a->music_path[0]) {
+                emit_event(a, EVQ_CALLBACK, AUDIO_EVENT_TRACK_STARTED, AUDIO_SOURCE_MUSIC,
+                           (uint32_t)a->active_music_gen);
+            }
         }
     }
 
+    /* Synthesized bells and generated ambience are rendered into the
+       scratch buffers a chunk at a time, since SDL may ask for more frames
+       than out_spec.samples. synth_at is where the current chunk starts. */
+    const bool have_gen = a->amb_gen_active && !a->ambience_paused && a->gen_l && a->gen_r &&
+                          a->bell_mix_frames > 0;
+    bool have_bells = false;
+    uint32_t synth_at = 0, synth_len = 0;
+
+    /* A stream "underruns" when it should be audible but its ring is dry. */
+    const bool music_expected = !a->music_paused && !a->music_wait_prefill && a->dec.inited && !a->dec.eof;
+    const bool amb_expected = !have_gen && !a->ambience_paused && !a->ambience_wait_prefill && a->amb_dec.inited;
+    bool music_starved = false;
+    bool amb_starved = false;
+
     for (int f = 0; f < frames_needed; f++) {
+        if (a->bell_mix_frames > 0 && (uint32_t)f >= synth_at + synth_len) {
+            synth_at = (uint32_t)f;
+            synth_len = (uint32_t)(frames_needed - f);
+            if (synth_len > a->bell_mix_frames) synth_len = a->bell_mix_frames;
+            have_bells = false;
+            for (int v = 0; v < BELL_VOICES; v++) {
+                if (!a->bells[v].active) continue;
+                if (!have_bells) {
+                    memset(a->bell_mix, 0, (size_t)synth_len * sizeof(float));
+                    have_bells = true;
+                }
+                (void)bell_voice_render_add(&a->bells[v], a->bell_mix, synth_len);
+            }
+            if (have_gen) ambience_gen_render(&a->amb_gen, a->gen_l, a->gen_r, synth_len);
+        }
+        const uint32_t k = (uint32_t)f - synth_at; /* index into the chunk */
+
         int16_t music_frame[OUT_CHANNELS] = {0, 0};
         bool have_music = false;
         if (!a->music_paused && !a->music_wait_prefill && a->music_rb.frames_queued > 0) {
             ring_read_frames(&a->music_rb, music_frame, 1, ch);
             have_music = true;
+        } else if (music_expected) {
+            music_starved = true;
         }
         int16_t amb_frame[OUT_CHANNELS] = {0, 0};
         bool have_amb = false;
-        if (!a->ambience_paused && !a->ambience_wait_prefill && a->ambience_rb.frames_queued > 0) {
+        if (have_gen) {
+            const int l = clamp16((int)(a->gen_l[k] * 32767.0f));
+            const int r = clamp16((int)(a->gen_r[k] * 32767.0f));
+            if (ch >= 2) {
+                amb_frame[0] = (int16_t)l;
+                amb_frame[1] = (int16_t)r;
+            } else {
+                amb_frame[0] = (int16_t)((l + r) / 2);
+            }
+            have_amb = true;
+        } else if (!a->ambience_paused && !a->ambience_wait_prefill && a->ambience_rb.frames_queued > 0) {
             ring_read_frames(&a->ambience_rb, amb_frame, 1, ch);
+            a->amb_frames_read++;
             have_amb = true;
+        } else if (amb_expected) {
+            amb_starved = true;
         }
 
         /* ---- Music-only waveform sampling (low-latency, ignores ambience/SFX) ---- */
@@ -529,6 +718,11 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
         }
 
 
+        int bell_s = 0;
+        if (have_bells) {
+            bell_s = (int)(a->bell_mix[k] * 32767.0f);
+        }
+
         for (int c = 0; c < ch; c++) {
             int mix = 0;
 
@@ -550,6 +744,9 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
                 mix += (s * a->sfx_vol) / 128;
             }
 
+            /* Synthesized bells share the SFX volume. */
+            mix += (bell_s * a->sfx_vol) / 128;
+
             mix = (mix * a->master_vol) / 128;
             out[f * ch + c] = (int16_t)clamp16(mix);
         }
@@ -582,6 +779,39 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
     /* If decoder has hit EOF and the ring is empty, latch an "ended" event. */
     if (!a->music_paused && a->dec.eof && a->music_rb.frames_queued == 0) {
         a->music_ended_latched = true;
+        if (!a->music_end_sent) {
+            a->music_end_sent = true;
+            emit_event(a, EVQ_CALLBACK, AUDIO_EVENT_TRACK_ENDED, AUDIO_SOURCE_MUSIC,
+                       (uint32_t)a->active_music_gen);
+        }
+    }
+
+    /* Report each underrun once, when it starts. */
+    if (music_starved && !a->music_underrun) {
+        emit_event(a, EVQ_CALLBACK, AUDIO_EVENT_UNDERRUN, AUDIO_SOURCE_MUSIC, (uint32_t)a->active_music_gen);
+    }
+    a->music_underrun = music_starved;
+    if (amb_starved && !a->ambience_underrun) {
+        emit_event(a, EVQ_CALLBACK, AUDIO_EVENT_UNDERRUN, AUDIO_SOURCE_AMBIENCE, (uint32_t)a->active_ambience_gen);
+    }
+    a->ambience_underrun = amb_starved;
+
+    /* Loop points of the ambience that have now been played. */
+    while (a->amb_loop_mark_count > 0 && a->amb_loop_marks[0] <= a->amb_frames_read) {
+        a->amb_loop_mark_count--;
+        memmove(&a->amb_loop_marks[0], &a->amb_loop_marks[1],
+                (size_t)a->amb_loop_mark_count * sizeof(a->amb_loop_marks[0]));
+        emit_event(a, EVQ_CALLBACK, AUDIO_EVENT_LOOP_WRAPPED, AUDIO_SOURCE_AMBIENCE,
+                   (uint32_t)a->active_ambience_gen);
+    }
+
+    /* Scheduled cues, at block granularity. */
+    a->frames_played += (uint64_t)frames_needed;
+    for (int i = 0; i < AUDIO_MAX_CUES; i++) {
+        if (a->cues[i].active && a->cues[i].due_frame <= a->frames_played) {
+            a->cues[i].active = false;
+            emit_event(a, EVQ_CALLBACK, AUDIO_EVENT_CUE_FIRED, AUDIO_SOURCE_CUE, a->cues[i].id);
+        }
     }
 
     /* Wake the loader thread when the ring drops below a low watermark. */
@@ -601,6 +831,8 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
     }
 
     SDL_UnlockMutex(a->lock);
+    const Uint64 cb_ticks = SDL_GetPerformanceCounter() - cb_t0;
+    SDL_AtomicAdd(&a->cb_busy_us, (int)(cb_ticks * 1000000u / SDL_GetPerformanceFrequency()));
 }
 
 static int ambience_loader_thread(void* userdata) {
@@ -639,11 +871,20 @@ static int ambience_loader_thread(void* userdata) {
             a->ambience_loading = false;
             a->pending_ambience_path[0] = 0;
             SDL_UnlockMutex(a->lock);
+            /* An empty path is a cancel (stop / generator), not a failure. */
+            if (path[0]) {
+                emit_event(a, EVQ_AMBIENCE_LOADER, AUDIO_EVENT_LOAD_FAILED, AUDIO_SOURCE_AMBIENCE, (uint32_t)job_gen);
+            }
             continue;
         }
 
         SDL_LockMutex(a->lock);
-        ring_clear(&a->ambience_rb);
+        if (job_gen != a->pending_ambience_gen) {
+            /* Replaced (e.g. by a generator) while we were opening. */
+            SDL_UnlockMutex(a->lock);
+            continue;
+        }
+        ambience_ring_clear(a);
         a->ambience_wait_prefill = true;
         strncpy(a->ambience_path, path, sizeof(a->ambience_path) - 1);
         a->ambience_path[sizeof(a->ambience_path) - 1] = 0;
@@ -701,6 +942,13 @@ static int ambience_loader_thread(void* userdata) {
                 } else if (a->amb_dec.type == MUSIC_DEC_WAV) {
                     (void)drwav_seek_to_pcm_frame(&a->amb_dec.wav, 0);
                 }
+                /* Everything decoded so far is in the ring; the wrap is
+                   reported once the callback gets there. */
+                SDL_LockMutex(a->lock);
+                if (job_gen == a->pending_ambience_gen && a->amb_loop_mark_count < AMB_LOOP_MARKS) {
+                    a->amb_loop_marks[a->amb_loop_mark_count++] = a->amb_frames_written;
+                }
+                SDL_UnlockMutex(a->lock);
                 continue;
             }
 
@@ -740,7 +988,7 @@ static int ambience_loader_thread(void* userdata) {
                 uint32_t frames = (uint32_t)got / bytes_per_frame;
 
                 SDL_LockMutex(a->lock);
-                (void)ring_write_frames(&a->ambience_rb, out_tmp, frames, (int)out_ch);
+                a->amb_frames_written += ring_write_frames(&a->ambience_rb, out_tmp, frames, (int)out_ch);
                 SDL_UnlockMutex(a->lock);
             }
         }
@@ -786,6 +1034,7 @@ static int music_loader_thread(void* userdata) {
         a->active_music_gen = job_gen;
         a->music_loading = true;
         a->music_ended_latched = false;
+        a->music_end_sent = false;
         ring_clear(&a->music_rb);
         music_decoder_close(&a->dec);
         a->music_path[0] = 0;
@@ -805,6 +1054,10 @@ static int music_loader_thread(void* userdata) {
             a->music_loading = false;
             SDL_UnlockMutex(a->lock);
             music_decoder_close(&a->dec);
+            /* An empty path is a cancel from audio_engine_stop_music. */
+            if (path[0]) {
+                emit_event(a, EVQ_MUSIC_LOADER, AUDIO_EVENT_LOAD_FAILED, AUDIO_SOURCE_MUSIC, (uint32_t)job_gen);
+            }
             continue;
         }
 
@@ -1086,6 +1339,27 @@ AudioResult audio_engine_init(AudioEngine** out) {
         return AUDIO_ERR_INIT;
     }
 
+    /* Synthesis scratch: one callback block of mono float for bells, planar
+       stereo for generated ambience; larger requests are rendered in chunks. Not fatal if it fails; synthesized bells
+       and generators just stay silent. */
+    {
+        const uint32_t frames = a->out_spec.samples ? (uint32_t)a->out_spec.samples : 4096u;
+        float* mix = (float*)calloc(frames, sizeof(float));
+        float* gen_l = (float*)calloc(frames, sizeof(float));
+        float* gen_r = (float*)calloc(frames, sizeof(float));
+        if (!mix || !gen_l || !gen_r) {
+            free(gen_l);
+            free(gen_r);
+            gen_l = gen_r = NULL;
+        }
+        SDL_LockMutex(a->lock);
+        a->bell_mix = mix;
+        a->bell_mix_frames = mix ? frames : 0;
+        a->gen_l = gen_l;
+        a->gen_r = gen_r;
+        SDL_UnlockMutex(a->lock);
+    }
+
     *out = a;
     return AUDIO_OK;
 }
@@ -1118,11 +1392,25 @@ void audio_engine_quit(AudioEngine** inout) {
         a->ambience_thread = NULL;
     }
 
+    /* The device is closed, so nothing posts wake_sem any more. */
+    if (a->wake_thread) {
+        SDL_AtomicSet(&a->wake_quit, 1);
+        SDL_SemPost(a->wake_sem);
+        SDL_WaitThread(a->wake_thread, NULL);
+        a->wake_thread = NULL;
+    }
+    if (a->wake_sem) SDL_DestroySemaphore(a->wake_sem);
+
     music_decoder_close(&a->dec);
     music_decoder_close(&a->amb_dec);
     ring_free(&a->music_rb);
     ring_free(&a->ambience_rb);
     pcm_free(&a->sfx);
+    free(a->bell_mix);
+    a->bell_mix = NULL;
+    free(a->gen_l);
+    free(a->gen_r);
+    a->gen_l = a->gen_r = NULL;
 
     if (a->music_cond) SDL_DestroyCond(a->music_cond);
     if (a->ambience_cond) SDL_DestroyCond(a->ambience_cond);
@@ -1176,13 +1464,46 @@ static bool file_exists_local(const char* path) {
     return true;
 }
 
+static AudioResult play_ambience_gen(AudioEngine* a, AmbienceGenKind kind, const char* path, bool restart_if_same) {
+    SDL_LockMutex(a->lock);
+
+    if (!a->gen_l || !a->gen_r) {
+        SDL_UnlockMutex(a->lock);
+        return AUDIO_ERR_INIT;
+    }
+
+    if (!restart_if_same && a->amb_gen_active && strcmp(a->ambience_path, path) == 0) {
+        SDL_UnlockMutex(a->lock);
+        return AUDIO_OK;
+    }
+
+    /* Cancel any file ambience; the loader thread sees an empty path and idles. */
+    ambience_ring_clear(a);
+    a->pending_ambience_path[0] = 0;
+    a->pending_ambience_gen++;
+
+    /* Deterministic per engine: the n-th generator started gets the n-th seed. */
+    ambience_gen_init(&a->amb_gen, kind, a->out_spec.freq, 0x5EED0000u + a->amb_gen_seed++);
+    a->amb_gen_active = true;
+    a->ambience_paused = false;
+    a->ambience_wait_prefill = false;
+    strncpy(a->ambience_path, path, sizeof(a->ambience_path) - 1);
+    a->ambience_path[sizeof(a->ambience_path) - 1] = 0;
+
+    SDL_CondSignal(a->ambience_cond);
+    SDL_UnlockMutex(a->lock);
+    return AUDIO_OK;
+}
+
 AudioResult audio_engine_play_ambience(AudioEngine* a, const char* path, bool restart_if_same) {
     if (!a || !path || !path[0]) return AUDIO_ERR_DECODE;
+    const AmbienceGenKind gen = ambience_gen_kind_from_path(path);
+    if (gen != AMBIENCE_GEN_NONE) return play_ambience_gen(a, gen, path, restart_if_same);
     if (!file_exists_local(path)) return AUDIO_ERR_DECODE;
 
     SDL_LockMutex(a->lock);
 
-    if (!restart_if_same && a->ambience_path[0] && strcmp(a->ambience_path, path) == 0) {
+    if (!restart_if_same && !a->amb_gen_active && a->ambience_path[0] && strcmp(a->ambience_path, path) == 0) {
         /* If something is already buffered/playing, keep it. */
         if (a->amb_dec.inited || a->ambience_rb.frames_queued > 0) {
             SDL_UnlockMutex(a->lock);
@@ -1191,7 +1512,8 @@ AudioResult audio_engine_play_ambience(AudioEngine* a, const char* path, bool re
     }
 
     /* Stop current ambience immediately and queue async load. */
-    ring_clear(&a->ambience_rb);
+    a->amb_gen_active = false;
+    ambience_ring_clear(a);
     /* decoder lifecycle is owned by ambience loader thread */
     a->ambience_paused = false;
     a->ambience_wait_prefill = true;
@@ -1211,7 +1533,8 @@ AudioResult audio_engine_play_ambience(AudioEngine* a, const char* path, bool re
 void audio_engine_stop_ambience(AudioEngine* a) {
     if (!a) return;
     SDL_LockMutex(a->lock);
-    ring_clear(&a->ambience_rb);
+    a->amb_gen_active = false;
+    ambience_ring_clear(a);
     /* decoder lifecycle is owned by ambience loader thread */
     a->pending_ambience_path[0] = 0;
     a->pending_ambience_gen++;
@@ -1254,6 +1577,7 @@ AudioResult audio_engine_play_music(AudioEngine* a, const char* path, bool resta
     /* decoder lifecycle is owned by music loader thread */
     a->music_paused = false;
     a->music_ended_latched = false;
+    a->music_end_sent = false;
     a->music_wait_prefill = true;
     a->music_path[0] = 0;
 
@@ -1277,6 +1601,7 @@ void audio_engine_stop_music(AudioEngine* a) {
     /* decoder lifecycle is owned by music loader thread */
     a->music_paused = false;
     a->music_ended_latched = false;
+    a->music_end_sent = true; /* stopped, not ended */
     a->music_wait_prefill = false;
     a->music_path[0] = 0;
 
@@ -1290,6 +1615,14 @@ void audio_engine_stop_music(AudioEngine* a) {
     SDL_UnlockMutex(a->lock);
 }
 
+uint32_t audio_engine_music_gen(AudioEngine* a) {
+    if (!a) return 0;
+    SDL_LockMutex(a->lock);
+    const uint32_t gen = (uint32_t)a->pending_music_gen;
+    SDL_UnlockMutex(a->lock);
+    return gen;
+}
+
 void audio_engine_set_music_paused(AudioEngine* a, bool paused) {
     if (!a) return;
     SDL_LockMutex(a->lock);
@@ -1315,6 +1648,29 @@ AudioResult audio_engine_play_sfx(AudioEngine* a, const char* path) {
     return AUDIO_OK;
 }
 
+AudioResult audio_engine_play_bell(AudioEngine* a, const BellPreset* preset) {
+    if (!a || !preset) return AUDIO_ERR_DECODE;
+
+    SDL_LockMutex(a->lock);
+    if (!a->bell_mix) {
+        SDL_UnlockMutex(a->lock);
+        return AUDIO_ERR_INIT;
+    }
+    /* Take a free voice, or steal the one closest to finishing. */
+    int slot = 0;
+    for (int v = 0; v < BELL_VOICES; v++) {
+        if (!a->bells[v].active) {
+            slot = v;
+            break;
+        }
+        if (a->bells[v].frames_left < a->bells[slot].frames_left) slot = v;
+    }
+    bell_voice_strike(&a->bells[slot], preset, a->out_spec.freq);
+    SDL_UnlockMutex(a->lock);
+
+    return AUDIO_OK;
+}
+
 void audio_engine_update(AudioEngine* a) {
     (void)a;
     /* Nothing needed right now, but kept for future streaming/queue logic. */
@@ -1332,6 +1688,64 @@ bool audio_engine_pop_music_ended(AudioEngine* a) {
     return ended;
 }
 
+bool audio_engine_poll_event(AudioEngine* a, AudioEvent* out) {
+    if (!a || !out) return false;
+    /* Re-arm the wake-up first, so an event pushed while we drain still
+       produces a fresh SDL event. */
+    SDL_AtomicSet(&a->wake_pending, 0);
+    for (int q = 0; q < EVQ_COUNT; q++) {
+        if (event_queue_pop(&a->events[q], out)) return true;
+    }
+    return false;
+}
+
+void audio_engine_set_wake_event(AudioEngine* a, uint32_t sdl_event_type) {
+    if (!a) return;
+    if (sdl_event_type != 0 && !a->wake_thread) {
+        /* Without the thread, callback events just wait for the next poll. */
+        if (!a->wake_sem) a->wake_sem = SDL_CreateSemaphore(0);
+        if (a->wake_sem) a->wake_thread = SDL_CreateThread(wake_thread_main, "audio_wake", a);
+    }
+    SDL_AtomicSet(&a->wake_event_type, (int)sdl_event_type);
+    SDL_AtomicSet(&a->wake_pending, 0);
+}
+
+AudioResult audio_engine_schedule_cue(AudioEngine* a, uint32_t cue_id, uint32_t delay_ms) {
+    if (!a) return AUDIO_ERR_INIT;
+    AudioResult r = AUDIO_ERR_INIT;
+    SDL_LockMutex(a->lock);
+    for (int i = 0; i < AUDIO_MAX_CUES; i++) {
+        if (a->cues[i].active) continue;
+        a->cues[i].id = cue_id;
+        a->cues[i].due_frame = a->frames_played + ((uint64_t)delay_ms * (uint64_t)a->out_spec.freq) / 1000u;
+        a->cues[i].active = true;
+        r = AUDIO_OK;
+        break;
+    }
+    SDL_UnlockMutex(a->lock);
+    return r;
+}
+
+void audio_engine_cancel_cue(AudioEngine* a, uint32_t cue_id) {
+    if (!a) return;
+    SDL_LockMutex(a->lock);
+    for (int i = 0; i < AUDIO_MAX_CUES; i++) {
+        if (a->cues[i].active && a->cues[i].id == cue_id) a->cues[i].active = false;
+    }
+    SDL_UnlockMutex(a->lock);
+}
+
+float audio_engine_callback_load(AudioEngine* a) {
+    if (!a) return 0.0f;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const int busy_us = SDL_AtomicSet(&a->cb_busy_us, 0);
+    const Uint64 since = a->cb_load_since;
+    a->cb_load_since = now;
+    if (since == 0 || now <= since) return 0.0f;
+    const double wall_us = (double)(now - since) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    return (float)((double)busy_us / wall_us);
+}
+
 bool audio_engine_get_spectrum(AudioEngine* a, float* out_bins, int bins_count) {
     if (!a || !out_bins || bins_count <= 0) return false;
     if (bins_count > VIS_MAX_BINS) bins_count = VIS_MAX_BINS;
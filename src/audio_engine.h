@@ -7,6 +7,7 @@ extern "C" {
 #endif
 
 typedef struct AudioEngine AudioEngine;
+typedef struct BellPreset BellPreset;
 
 typedef enum {
     AUDIO_OK = 0,
@@ -16,6 +17,28 @@ typedef enum {
     AUDIO_ERR_STREAM = -4,
 } AudioResult;
 
+/* Events reported by the engine (see audio_engine_poll_event). */
+typedef enum {
+    AUDIO_EVENT_TRACK_STARTED = 1, /* music became audible after a (re)start */
+    AUDIO_EVENT_TRACK_ENDED,       /* music drained after EOF (not on stop) */
+    AUDIO_EVENT_LOAD_FAILED,       /* music/ambience file could not be opened */
+    AUDIO_EVENT_UNDERRUN,          /* a playing stream ran out of decoded audio */
+    AUDIO_EVENT_LOOP_WRAPPED,      /* looped ambience played back to its start */
+    AUDIO_EVENT_CUE_FIRED,         /* a cue from audio_engine_schedule_cue is due */
+} AudioEventType;
+
+typedef enum {
+    AUDIO_SOURCE_MUSIC = 0,
+    AUDIO_SOURCE_AMBIENCE,
+    AUDIO_SOURCE_CUE,
+} AudioEventSource;
+
+typedef struct AudioEvent {
+    AudioEventType type;
+    AudioEventSource source;
+    uint32_t value; /* cue id for CUE_FIRED, else the play request generation */
+} AudioEvent;
+
 /* Initialize the audio device + mixer.
    Safe to call even if SDL audio subsystem isn't initialized yet. */
 AudioResult audio_engine_init(AudioEngine** out);
@@ -39,11 +62,15 @@ void audio_engine_set_ambience_volume(AudioEngine* a, int vol);
 /* Play / stop music (decodes WAV/MP3 fully to PCM and streams via callback). */
 AudioResult audio_engine_play_music(AudioEngine* a, const char* path, bool restart_if_same);
 void audio_engine_stop_music(AudioEngine* a);
+/* Generation of the latest play/stop request. Music events carry the
+   generation they belong to in their value; older ones are stale. */
+uint32_t audio_engine_music_gen(AudioEngine* a);
 
 /* Pause/resume music only. */
 void audio_engine_set_music_paused(AudioEngine* a, bool paused);
 
-/* Looping ambience (WAV/MP3). Streamed to avoid UI hitches. */
+/* Looping ambience (WAV/MP3). Streamed to avoid UI hitches. A "gen:<id>"
+   path (see ambience_gen.h) selects a generator rendered in the mixer. */
 AudioResult audio_engine_play_ambience(AudioEngine* a, const char* path, bool restart_if_same);
 void audio_engine_stop_ambience(AudioEngine* a);
 void audio_engine_set_ambience_paused(AudioEngine* a, bool paused);
@@ -51,12 +78,35 @@ void audio_engine_set_ambience_paused(AudioEngine* a, bool paused);
 /* Fire-and-forget SFX (bell/notifications). It will mix over music + ambience. */
 AudioResult audio_engine_play_sfx(AudioEngine* a, const char* path);
 
+/* Strike a synthesized bell (see bell_synth.h). Rendered in the mixer with no
+   file I/O or decoding; a few strikes can ring over each other. */
+AudioResult audio_engine_play_bell(AudioEngine* a, const BellPreset* preset);
+
 /* Call once per frame to service “track ended” bookkeeping. */
 void audio_engine_update(AudioEngine* a);
 
 /* True if music finished naturally (not stopped). Resets to false after read. */
 bool audio_engine_pop_music_ended(AudioEngine* a);
 
+/* Pops the next engine event; false when none are queued. Lock-free, call it
+   from the UI thread only. Events from different producer threads may arrive
+   out of order; a full queue drops new events. */
+bool audio_engine_poll_event(AudioEngine* a, AudioEvent* out);
+
+/* If sdl_event_type is non-zero (from SDL_RegisterEvents), an event of that
+   type is pushed to wake SDL_WaitEventTimeout when something is queued. At
+   most one is outstanding until the next audio_engine_poll_event. */
+void audio_engine_set_wake_event(AudioEngine* a, uint32_t sdl_event_type);
+
+/* Fires AUDIO_EVENT_CUE_FIRED with cue_id after delay_ms of output audio
+   (accurate to one callback block). A few cues can be pending at once. */
+AudioResult audio_engine_schedule_cue(AudioEngine* a, uint32_t cue_id, uint32_t delay_ms);
+void audio_engine_cancel_cue(AudioEngine* a, uint32_t cue_id);
+
+/* Fraction of wall time the audio callback has been running since the
+   previous call (0 on the first). UI thread only. */
+float audio_engine_callback_load(AudioEngine* a);
+
 /* Get a circular visualizer spectrum (post-mix). Writes bins_count values (suggest 64).
    Returns false if not enough audio history is available yet. */
 bool audio_engine_get_spectrum(AudioEngine* a, float* out_bins, int bins_count);
@@ -0,0 +1,134 @@
+#include "bell_synth.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ln(1000): a T60 decay is a 1000x drop in amplitude. */
+#define BELL_LN_1000 6.9077553f
+
+/* Mode frequency ratios relative to the prime partial. */
+static const float k_ratios[][BELL_MAX_PARTIALS] = {
+    /* BELL_MODEL_CHURCH */
+    { 0.5f, 1.0f, 1.183f, 1.506f, 2.0f, 2.514f, 2.662f, 3.011f },
+    /* BELL_MODEL_BOWL: each mode is split into a slightly detuned pair,
+       which gives the slow beating of a struck bowl. */
+    { 1.0f, 1.004f, 2.76f, 2.768f, 5.40f, 5.415f, 8.93f, 8.95f },
+    /* BELL_MODEL_BAR */
+    { 1.0f, 2.756f, 5.404f, 8.933f, 13.344f, 18.638f, 24.815f, 31.877f },
+};
+
+static const BellPreset k_presets[] = {
+    { "synth: temple bell",  BELL_MODEL_CHURCH, 392.0f, 6.0f, 0.0020f, 0.55f },
+    { "synth: singing bowl", BELL_MODEL_BOWL,   220.0f, 9.0f, 0.0f,    0.35f },
+    { "synth: chime",        BELL_MODEL_BAR,    1046.5f, 3.5f, 0.0f,   0.30f },
+    { "synth: deep gong",    BELL_MODEL_CHURCH, 98.0f,  12.0f, 0.0060f, 0.65f },
+    { "synth: glass",        BELL_MODEL_BAR,    1568.0f, 1.8f, 0.0010f, 0.20f },
+};
+
+#define BELL_PRESET_COUNT ((int)(sizeof(k_presets) / sizeof(k_presets[0])))
+
+int bell_synth_preset_count(void) {
+    return BELL_PRESET_COUNT;
+}
+
+const BellPreset* bell_synth_preset_at(int idx) {
+    if (idx < 0 || idx >= BELL_PRESET_COUNT) return NULL;
+    return &k_presets[idx];
+}
+
+const BellPreset* bell_synth_find(const char* name) {
+    if (!name || !name[0]) return NULL;
+    for (int i = 0; i < BELL_PRESET_COUNT; i++) {
+        if (strcmp(k_presets[i].name, name) == 0) return &k_presets[i];
+    }
+    return NULL;
+}
+
+void bell_voice_strike(BellVoice* v, const BellPreset* p, int sample_rate) {
+    if (!v) return;
+    memset(v, 0, sizeof(*v));
+    if (!p || sample_rate <= 0) return;
+
+    const int model = (p->model >= BELL_MODEL_CHURCH && p->model <= BELL_MODEL_BAR) ? (int)p->model : 0;
+    const float sr = (float)sample_rate;
+    const float nyquist_guard = sr * 0.45f;
+    const float brightness = p->brightness < 0.01f ? 0.01f : (p->brightness > 1.0f ? 1.0f : p->brightness);
+    const float stretch_norm = sqrtf(1.0f + p->inharmonicity);
+
+    float amp[BELL_MAX_PARTIALS];
+    float t60[BELL_MAX_PARTIALS];
+    float amp_sum = 0.0f;
+    float t60_max = 0.0f;
+
+    for (int k = 0; k < BELL_MAX_PARTIALS; k++) {
+        float ratio = k_ratios[model][k];
+        /* Stiffness-style stretch, normalized so the prime keeps its pitch. */
+        ratio *= sqrtf(1.0f + p->inharmonicity * ratio * ratio) / stretch_norm;
+        const float hz = p->pitch_hz * ratio;
+        if (hz <= 0.0f || hz >= nyquist_guard) {
+            amp[k] = 0.0f;
+            t60[k] = 0.0f;
+            continue;
+        }
+        /* Upper partials are quieter and die away faster; the hum (below the
+           prime) lingers. */
+        amp[k] = (ratio <= 1.0f) ? 0.8f : powf(brightness, log2f(ratio));
+        t60[k] = p->decay_sec * powf(ratio, -0.7f);
+        if (t60[k] < 0.05f) t60[k] = 0.05f;
+
+        const float w = 2.0f * (float)M_PI * hz / sr;
+        const float g = expf(-BELL_LN_1000 / (t60[k] * sr));
+        v->rot_c[k] = g * cosf(w);
+        v->rot_s[k] = g * sinf(w);
+
+        amp_sum += amp[k];
+        if (t60[k] > t60_max) t60_max = t60[k];
+    }
+
+    if (amp_sum <= 0.0f) return;
+
+    /* Keep the worst-case peak (all partials in phase) below full scale. */
+    const float norm = 0.8f / amp_sum;
+    for (int k = 0; k < BELL_MAX_PARTIALS; k++) {
+        v->re[k] = amp[k] * norm;
+        v->im[k] = 0.0f;
+    }
+    v->frames_left = (uint32_t)(t60_max * sr);
+    v->active = v->frames_left > 0;
+}
+
+bool bell_voice_render_add(BellVoice* v, float* out, uint32_t frames) {
+    if (!v || !v->active) return false;
+    if (frames > v->frames_left) frames = v->frames_left;
+
+    /* Work on local copies so the compiler can keep the bank in registers and
+       vectorize the fixed-width inner loop. */
+    float re[BELL_MAX_PARTIALS], im[BELL_MAX_PARTIALS];
+    float rc[BELL_MAX_PARTIALS], rs[BELL_MAX_PARTIALS];
+    memcpy(re, v->re, sizeof(re));
+    memcpy(im, v->im, sizeof(im));
+    memcpy(rc, v->rot_c, sizeof(rc));
+    memcpy(rs, v->rot_s, sizeof(rs));
+
+    for (uint32_t f = 0; f < frames; f++) {
+        float acc = 0.0f;
+        for (int k = 0; k < BELL_MAX_PARTIALS; k++) {
+            const float r = re[k] * rc[k] - im[k] * rs[k];
+            const float i = re[k] * rs[k] + im[k] * rc[k];
+            re[k] = r;
+            im[k] = i;
+            acc += i;
+        }
+        out[f] += acc;
+    }
+
+    memcpy(v->re, re, sizeof(re));
+    memcpy(v->im, im, sizeof(im));
+    v->frames_left -= frames;
+    if (v->frames_left == 0) v->active = false;
+    return v->active;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Modal bell synthesis: a bell strike is a small bank of exponentially damped
+   sinusoids ("partials"). Rendering needs no file I/O or decoding, and a voice
+   is a few hundred bytes of oscillator state. */
+
+#define BELL_MAX_PARTIALS 8
+
+typedef enum {
+    BELL_MODEL_CHURCH = 0, /* hum / prime / tierce / quint / nominal */
+    BELL_MODEL_BOWL,       /* beating doublets, like a singing bowl */
+    BELL_MODEL_BAR,        /* free-free bar modes (chimes, tubular bells) */
+} BellModel;
+
+typedef struct BellPreset {
+    const char* name;    /* settings name, stored in the bell_*_file keys */
+    BellModel model;
+    float pitch_hz;      /* frequency of the prime partial */
+    float decay_sec;     /* time for the prime partial to fall by 60 dB */
+    float inharmonicity; /* 0 = textbook ratios, >0 stretches upper partials */
+    float brightness;    /* 0..1, weight of the upper partials */
+} BellPreset;
+
+/* Oscillator bank in structure-of-arrays form so the per-sample update
+   vectorizes across partials. Each partial is a complex phasor rotated (and
+   damped) by rot_c/rot_s every sample; the output is the sum of the
+   imaginary parts. */
+typedef struct BellVoice {
+    float re[BELL_MAX_PARTIALS];
+    float im[BELL_MAX_PARTIALS];
+    float rot_c[BELL_MAX_PARTIALS];
+    float rot_s[BELL_MAX_PARTIALS];
+    uint32_t frames_left;
+    bool active;
+} BellVoice;
+
+int bell_synth_preset_count(void);
+const BellPreset* bell_synth_preset_at(int idx);
+
+/* Returns the preset with this settings name, or NULL for file-based bells. */
+const BellPreset* bell_synth_find(const char* name);
+
+/* (Re)starts a voice for one strike of preset at sample_rate. */
+void bell_voice_strike(BellVoice* v, const BellPreset* preset, int sample_rate);
+
+/* Adds up to frames mono samples (roughly -1..1) of the voice into out.
+   Returns false once the voice has decayed and was deactivated. */
+bool bell_voice_render_add(BellVoice* v, float* out, uint32_t frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../ui/text_measure.h"
 #include "../../utils/file_utils.h"
 #include "../../utils/string_utils.h"
 
@@ -310,6 +311,10 @@ static void wrap_and_push(UI *ui, App *a, TTF_Font *font, const char *text,
     booklets_push_render_line(ui, a, "", is_header);
     return;
   }
+  /* Words are measured once and summed; a line is only measured whole when
+     that sum comes close to max_w (see text_measure_line_fits()). */
+  const int fstyle = TTF_GetFontStyle(font);
+  const int space_w = text_measure_advance(font, fstyle, ' ');
   char *p = buf;
   while (*p) {
     while (*p == ' ')
@@ -318,6 +323,7 @@ static void wrap_and_push(UI *ui, App *a, TTF_Font *font, const char *text,
       break;
     char line[4096] = {0};
     int line_len = 0;
+    int line_w = 0;
     while (*p) {
       char word[512] = {0};
       int wl = 0;
@@ -332,16 +338,20 @@ static void wrap_and_push(UI *ui, App *a, TTF_Font *font, const char *text,
         safe_snprintf(trial, sizeof(trial), "%s", word);
       else
         safe_snprintf(trial, sizeof(trial), "%s %s", line, word);
-      int w = text_width(font, trial);
-      if (w <= max_w || line_len == 0) {
+      const int word_w = text_measure_sum(font, fstyle, word);
+      const int w = line_len == 0 ? word_w : line_w + space_w + word_w;
+      if (line_len == 0 ||
+          text_measure_line_fits(font, fstyle, trial, w, max_w)) {
         safe_snprintf(line, sizeof(line), "%s", trial);
         line_len = (int)strlen(line);
+        line_w = w;
       } else {
         booklets_push_render_line(ui, a, line, is_header);
         line[0] = 0;
         line_len = 0;
         safe_snprintf(line, sizeof(line), "%s", word);
         line_len = (int)strlen(line);
+        line_w = word_w;
       }
       if (*p == '\n') {
         p++;
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include "ambience_gen.h"
 #include "app.h"
 #include "audio_engine.h"
 #include "soundfx.h"
@@ -288,68 +289,139 @@ void music_player_update(App *a) {
   // Service the engine
   audio_engine_update(a->audio);
 
-  // Check for track end
-  if (audio_engine_pop_music_ended(a->audio)) {
-    music_player_next(a);
+  // Drain engine events (the engine also wakes the main loop when one is
+  // queued, see audio_engine_set_wake_event).
+  AudioEvent ev;
+  while (audio_engine_poll_event(a->audio, &ev)) {
+    // Events of a track that has since been replaced must not move the
+    // queue: a late TRACK_ENDED would skip the track that replaced it.
+    if (ev.source == AUDIO_SOURCE_MUSIC &&
+        ev.value != audio_engine_music_gen(a->audio))
+      continue;
+    switch (ev.type) {
+    case AUDIO_EVENT_TRACK_STARTED:
+      a->musicq.load_failures = 0;
+      a->ui_needs_redraw = true;
+      break;
+    case AUDIO_EVENT_TRACK_ENDED:
+      music_player_next(a);
+      a->ui_needs_redraw = true;
+      break;
+    case AUDIO_EVENT_LOAD_FAILED:
+      if (ev.source == AUDIO_SOURCE_MUSIC) {
+        // Skip unreadable tracks, but give up after one full lap.
+        a->musicq.load_failures++;
+        if (a->musicq.load_failures < a->musicq.tracks.count)
+          music_player_next(a);
+        else
+          a->musicq.active = false;
+        a->ui_needs_redraw = true;
+      }
+      break;
+    default:
+      break;
+    }
   }
 }
 
 // Ambience helpers
+/* sounds/ambience/<name>.wav or .mp3, the files the settings list offers. */
+static bool find_ambience_sound(const char *name, char *out, size_t cap) {
+  char path[PATH_MAX];
+  safe_snprintf(path, sizeof(path), "sounds/ambience/%s.wav", name);
+  if (!is_file(path))
+    safe_snprintf(path, sizeof(path), "sounds/ambience/%s.mp3", name);
+  if (!is_file(path))
+    return false;
+  safe_snprintf(out, cap, "%s", path);
+  return true;
+}
+
+// Resolves the ambience for the current scene and mood; the one mapping
+// used by the player and by stillroom.c.
 static void build_ambience_path_from_name(const App *a, char *out, size_t cap) {
-  if (!a || !out || cap == 0)
+  if (!out || cap == 0)
     return;
   out[0] = 0;
-  if (!a->cfg.ambience_name[0] || strcmp(a->cfg.ambience_name, "off") == 0)
+  if (!a)
     return;
-
-  // Logic from stillroom.c: try scenes/<location>/moods/... then
-  // sounds/ambience/... For brevity/modularity, we'll implement the search
-  // logic here or call a shared helper. We need to know the current scene
-  // (location) to check scenes/<loc>/moods.
-
-  // 1. Check scene-specific mood
-  if (a->scene_name[0]) {
-    char check[PATH_MAX];
-    // Assuming relative root
-    safe_snprintf(check, sizeof(check), "scenes/%s/moods/%s", a->scene_name,
-                  a->cfg.ambience_name);
-    if (is_dir(check)) {
-      // It's a folder mood (containing multiple files? or just a category?)
-      // Original logic: "mood_display_from_folder" suggested moods are
-      // folders? Actually, if it's a file? Re-reading stillroom.c logic:
-      // ambience might be a file inside scenes/<loc>/moods/
+  const char *name = a->cfg.ambience_name;
+  const char *loc = a->scenes.count > 0 ? a->scenes.items[a->scene_idx] : "";
+  const char *mood = (a->moods.count > 0) ? a->moods.items[a->mood_idx] : "";
+  /* A generator picked in settings comes first, unless the name is really
+     the current mood's or that of a sounds/ambience file. */
+  AmbienceGenKind gen = ambience_gen_kind_from_name(name);
+  if (gen != AMBIENCE_GEN_NONE && SDL_strcasecmp(name, mood) != 0 &&
+      !find_ambience_sound(name, out, cap)) {
+    ambience_gen_path(gen, out, cap);
+    return;
+  }
+  out[0] = 0;
+  char pref[PATH_MAX];
+  if (loc[0]) {
+    /* Preferred names: ambience.mp3, then ambience.wav */
+    if (mood && mood[0]) {
+      safe_snprintf(pref, sizeof(pref), "scenes/%s/%s/ambience.mp3", loc,
+                    mood);
+      if (is_file(pref)) {
+        safe_snprintf(out, cap, "%s", pref);
+        return;
+      }
+      safe_snprintf(pref, sizeof(pref), "scenes/%s/%s/ambience.wav", loc,
+                    mood);
+      if (is_file(pref)) {
+        safe_snprintf(out, cap, "%s", pref);
+        return;
+      }
+    } else {
+      safe_snprintf(pref, sizeof(pref), "scenes/%s/ambience.mp3", loc);
+      if (is_file(pref)) {
+        safe_snprintf(out, cap, "%s", pref);
+        return;
+      }
+      safe_snprintf(pref, sizeof(pref), "scenes/%s/ambience.wav", loc);
+      if (is_file(pref)) {
+        safe_snprintf(out, cap, "%s", pref);
+        return;
+      }
     }
-
-    // Check for direct file match in scenes/<loc>/moods/
-    char path[PATH_MAX];
-    safe_snprintf(path, sizeof(path), "scenes/%s/moods/%s.wav", a->scene_name,
-                  a->cfg.ambience_name);
-    if (is_file(path)) {
-      safe_snprintf(out, cap, "%s", path);
-      return;
+    char root[PATH_MAX];
+    if (mood && mood[0])
+      safe_snprintf(root, sizeof(root), "scenes/%s/%s", loc, mood);
+    else
+      safe_snprintf(root, sizeof(root), "scenes/%s", loc);
+    /* ambience.gen: a one-line text file naming a built-in
+       generator ("rain", "pink noise", ...) instead of a
+       recording. */
+    safe_snprintf(pref, sizeof(pref), "%s/ambience.gen", root);
+    if (is_file(pref)) {
+      char *txt = read_entire_file(pref, NULL);
+      if (txt) {
+        trim_ascii_inplace(txt);
+        AmbienceGenKind file_gen = ambience_gen_kind_from_name(txt);
+        free(txt);
+        if (file_gen != AMBIENCE_GEN_NONE) {
+          ambience_gen_path(file_gen, out, cap);
+          return;
+        }
+      }
     }
-    safe_snprintf(path, sizeof(path), "scenes/%s/moods/%s.mp3", a->scene_name,
-                  a->cfg.ambience_name);
-    if (is_file(path)) {
-      safe_snprintf(out, cap, "%s", path);
-      return;
+    /* Then the first audio file in the mood folder. */
+    StrList aud = list_audio_files_in(root);
+    if (aud.count > 0) {
+      safe_snprintf(out, cap, "%s/%s", root, aud.items[0]);
     }
+    sl_free(&aud);
+    if (out[0])
+      return;
   }
-
-  // 2. Check global ambience
-  char path[PATH_MAX];
-  safe_snprintf(path, sizeof(path), "sounds/ambience/%s.wav",
-                a->cfg.ambience_name);
-  if (is_file(path)) {
-    safe_snprintf(out, cap, "%s", path);
-    return;
-  }
-  safe_snprintf(path, sizeof(path), "sounds/ambience/%s.mp3",
-                a->cfg.ambience_name);
-  if (is_file(path)) {
-    safe_snprintf(out, cap, "%s", path);
+  /* A sound picked from sounds/ambience. */
+  if (name[0] && strcmp(name, "off") != 0 &&
+      find_ambience_sound(name, out, cap))
     return;
-  }
+  /* Last, a generator named like the mood, rendered by the mixer. */
+  if (gen != AMBIENCE_GEN_NONE)
+    ambience_gen_path(gen, out, cap);
 }
 
 void music_player_update_ambience(App *a, bool user_action) {
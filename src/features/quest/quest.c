@@ -3,6 +3,7 @@
 #include "../../ui/ui_shared.h"
 #include "../../utils/file_utils.h"
 #include "../../utils/string_utils.h"
+#include "../stats/activity_rollup.h"
 #include <ctype.h>
 #include <math.h>
 #include <stdio.h>
@@ -59,17 +60,6 @@ void quest_format_date_line(char *out, size_t cap) {
                 day_ordinal_lower(tmv.tm_mday), month_name_lower(tmv.tm_mon));
 }
 
-static int quest_date_int_from_string(const char *s) {
-  if (!s)
-    return 0;
-  int y = 0, m = 0, d = 0;
-  if (sscanf(s, "%4d-%2d-%2d", &y, &m, &d) != 3)
-    return 0;
-  if (y <= 0 || m < 1 || m > 12 || d < 1 || d > 31)
-    return 0;
-  return (y * 10000) + (m * 100) + d;
-}
-
 static int quest_season_rank_for_date_int(int date) {
   if (date <= 0)
     return quest_season_rank_today();
@@ -522,33 +512,9 @@ void quest_sync_daily(App *a) {
 }
 
 static uint32_t quest_focus_seconds_since(const App *a, int anchor_date) {
-  uint32_t total = 0;
   if (anchor_date <= 0)
     anchor_date = quest_today_date_int();
-  FILE *f = fopen(ACTIVITY_LOG_PATH, "r");
-  if (f) {
-    char line[256];
-    while (fgets(line, sizeof(line), f)) {
-      trim_ascii_inplace(line);
-      if (!line[0])
-        continue;
-      char *tab = strchr(line, '\t');
-      if (!tab)
-        tab = strchr(line, ' ');
-      if (!tab)
-        continue;
-      *tab = 0;
-      int date_int = quest_date_int_from_string(line);
-      const char *v = tab + 1;
-      while (*v == '\t' || *v == ' ')
-        v++;
-      if (date_int <= 0 || date_int < anchor_date)
-        continue;
-      unsigned long secs = strtoul(v, NULL, 10);
-      total += (uint32_t)secs;
-    }
-    fclose(f);
-  }
+  uint32_t total = (uint32_t)activity_rollup_since(anchor_date);
   if (a && a->running && a->run_focus_seconds > 0) {
     total += a->run_focus_seconds;
   }
@@ -552,7 +552,7 @@ void draw_routine_list(UI *ui, App *a) {
 
     int gap_w = text_width(ui->font_small, "     ") + 20;
     int total_w = pw + aw + gap_w + dw;
-    int x = CIRCLE_LAYOUT_CX - total_w / 2;
+    int x = CIRCLE_LAYOUT_CX(ui) - total_w / 2;
 
     bool done = routine_is_done(a, real_idx);
 
@@ -581,7 +581,7 @@ void draw_routine_list(UI *ui, App *a) {
       char trig[128];
       safe_snprintf(trig, sizeof(trig), "after I %s", r->trigger);
       int tw = text_width(ui->font_small, trig);
-      int tx = CIRCLE_LAYOUT_CX - tw / 2;
+      int tx = CIRCLE_LAYOUT_CX(ui) - tw / 2;
 
       SDL_Color trig_c = accent;
 
@@ -636,8 +636,8 @@ void draw_routine_list(UI *ui, App *a) {
     SDL_Color dim = {80, 80, 80, 255};
     const char *msg = "delete routine?";
     int w = text_width(ui->font_med, msg);
-    draw_text(ui, ui->font_med, CIRCLE_LAYOUT_CX - w / 2, cy - 40, msg, main,
-              false);
+    draw_text(ui, ui->font_med, CIRCLE_LAYOUT_CX(ui) - w / 2, cy - 40, msg,
+              main, false);
 
     int opt_y = cy + 20;
     int opt_gap = 100;
@@ -650,8 +650,8 @@ void draw_routine_list(UI *ui, App *a) {
     int wn = text_width(ui->font_med, sNo);
     int wy = text_width(ui->font_med, sYes);
 
-    int cx_no = CIRCLE_LAYOUT_CX - opt_gap / 2;
-    int cx_yes = CIRCLE_LAYOUT_CX + opt_gap / 2;
+    int cx_no = CIRCLE_LAYOUT_CX(ui) - opt_gap / 2;
+    int cx_yes = CIRCLE_LAYOUT_CX(ui) + opt_gap / 2;
 
     draw_text(ui, ui->font_med, cx_no - wn / 2, opt_y, sNo, c0, false);
     draw_text(ui, ui->font_med, cx_yes - wy / 2, opt_y, sYes, c1, false);
@@ -0,0 +1,381 @@
+#include "activity_rollup.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "../../utils/string_utils.h"
+#include "history_log.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define ROLLUP_HEADER "# stillroom activity rollup v3"
+
+typedef struct {
+  int date;
+  uint32_t secs;
+} RollupDay;
+
+/* How much of one month's segment is already in g_days, and enough about
+ * the file to tell if it was replaced since: its inode and the last line
+ * read (the tail_len bytes before bytes, hashed without the newline). */
+typedef struct {
+  int month;
+  int gen; /* of the segment when it was read */
+  long long bytes;
+  unsigned long long ino; /* 0 when not known yet */
+  int tail_len;
+  uint32_t tail_hash;
+} RollupCover;
+
+static RollupDay *g_days; /* sorted by date */
+static int g_count;
+static int g_cap;
+static RollupCover *g_covers; /* sorted by month */
+static int g_cover_count;
+static int g_cover_cap;
+static char g_rollup_path[PATH_MAX];
+static bool g_dirty;
+static uint32_t g_log_gen; /* history_log_generation() at the last catch-up */
+
+static int date_index(int date, bool *found) {
+  int lo = 0, hi = g_count;
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (g_days[mid].date < date)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  *found = lo < g_count && g_days[lo].date == date;
+  return lo;
+}
+
+static void rollup_add(int date, uint32_t secs) {
+  if (date <= 0 || secs == 0)
+    return;
+  bool found;
+  /* New rows are almost always for today, the last day. */
+  int i;
+  if (g_count > 0 && g_days[g_count - 1].date == date) {
+    i = g_count - 1;
+    found = true;
+  } else if (g_count == 0 || g_days[g_count - 1].date < date) {
+    i = g_count;
+    found = false;
+  } else {
+    i = date_index(date, &found);
+  }
+  if (found) {
+    g_days[i].secs += secs;
+  } else {
+    if (g_count == g_cap) {
+      const int ncap = g_cap ? g_cap * 2 : 64;
+      RollupDay *grown =
+          (RollupDay *)realloc(g_days, sizeof(RollupDay) * (size_t)ncap);
+      if (!grown)
+        return;
+      g_days = grown;
+      g_cap = ncap;
+    }
+    memmove(&g_days[i + 1], &g_days[i],
+            sizeof(RollupDay) * (size_t)(g_count - i));
+    g_days[i].date = date;
+    g_days[i].secs = secs;
+    g_count++;
+  }
+  g_dirty = true;
+}
+
+static int date_int_from_string(const char *s) {
+  int y = 0, m = 0, d = 0;
+  if (sscanf(s, "%4d-%2d-%2d", &y, &m, &d) != 3)
+    return 0;
+  if (y <= 0 || m < 1 || m > 12 || d < 1 || d > 31)
+    return 0;
+  return (y * 10000) + (m * 100) + d;
+}
+
+/* One log row: "YYYY-MM-DD<TAB>seconds". */
+static void parse_log_line(char *line) {
+  char *v = strchr(line, '\t');
+  if (!v)
+    v = strchr(line, ' ');
+  if (!v)
+    return;
+  *v++ = 0;
+  while (*v == '\t' || *v == ' ')
+    v++;
+  const int date = date_int_from_string(line);
+  rollup_add(date, (uint32_t)strtoul(v, NULL, 10));
+}
+
+static RollupCover *cover_for(int month) {
+  int i = 0;
+  while (i < g_cover_count && g_covers[i].month < month)
+    i++;
+  if (i < g_cover_count && g_covers[i].month == month)
+    return &g_covers[i];
+  if (g_cover_count == g_cover_cap) {
+    const int ncap = g_cover_cap ? g_cover_cap * 2 : 32;
+    RollupCover *grown =
+        (RollupCover *)realloc(g_covers, sizeof(RollupCover) * (size_t)ncap);
+    if (!grown)
+      return NULL;
+    g_covers = grown;
+    g_cover_cap = ncap;
+  }
+  memmove(&g_covers[i + 1], &g_covers[i],
+          sizeof(RollupCover) * (size_t)(g_cover_count - i));
+  memset(&g_covers[i], 0, sizeof(g_covers[i]));
+  g_covers[i].month = month;
+  g_cover_count++;
+  return &g_covers[i];
+}
+
+static void drop_month(int month) {
+  bool found;
+  const int first = date_index(month * 100, &found);
+  int end = first;
+  while (end < g_count && g_days[end].date / 100 == month)
+    end++;
+  if (end == first)
+    return;
+  memmove(&g_days[first], &g_days[end],
+          sizeof(RollupDay) * (size_t)(g_count - end));
+  g_count -= end - first;
+}
+
+/* A line's hash, ignoring its line ending. */
+static uint32_t line_hash(char *line, size_t len) {
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+    len--;
+  line[len] = 0;
+  return fnv1a32(line);
+}
+
+/* Whether the file still holds the last line read where it was read. */
+static bool tail_matches(FILE *f, const RollupCover *c) {
+  if (c->bytes == 0)
+    return true;
+  char line[128];
+  if (c->tail_len <= 0 || c->tail_len >= (int)sizeof(line) ||
+      c->tail_len > c->bytes ||
+      fseek(f, (long)(c->bytes - c->tail_len), SEEK_SET) != 0 ||
+      fread(line, 1, (size_t)c->tail_len, f) != (size_t)c->tail_len)
+    return false;
+  return line_hash(line, (size_t)c->tail_len) == c->tail_hash;
+}
+
+/* Parses the complete lines of a month's segment past what is covered. A
+ * last line without its newline is left for next time: it may still be
+ * being written. */
+static void catch_up_segment(const HistorySegment *seg) {
+  RollupCover *c = cover_for(seg->month);
+  if (!c)
+    return;
+  char path[PATH_MAX];
+  history_log_segment_path(HISTORY_LOG_ACTIVITY, seg->month, path,
+                           sizeof(path));
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return;
+  struct stat st;
+  if (fstat(fileno(f), &st) != 0) {
+    fclose(f);
+    return;
+  }
+  const long long size = (long long)st.st_size;
+  const unsigned long long ino = (unsigned long long)st.st_ino;
+  if (c->gen != seg->gen || size < c->bytes || (c->ino && c->ino != ino) ||
+      !tail_matches(f, c)) {
+    /* Rewritten (compacted) or replaced since it was read: read it
+     * again. */
+    drop_month(seg->month);
+    c->gen = seg->gen;
+    c->bytes = 0;
+    c->tail_len = 0;
+    g_dirty = true;
+  }
+  if (c->ino != ino) {
+    c->ino = ino;
+    g_dirty = true;
+  }
+  if (size <= c->bytes || fseek(f, (long)c->bytes, SEEK_SET) != 0) {
+    fclose(f);
+    return;
+  }
+  const size_t len = (size_t)(size - c->bytes);
+  char *buf = (char *)malloc(len + 1);
+  if (!buf) {
+    fclose(f);
+    return;
+  }
+  const size_t got = fread(buf, 1, len, f);
+  fclose(f);
+  buf[got] = 0;
+  char *p = buf;
+  char *nl;
+  while ((nl = memchr(p, '\n', got - (size_t)(p - buf))) != NULL) {
+    const size_t line_len = (size_t)(nl + 1 - p);
+    const uint32_t hash = line_hash(p, line_len);
+    c->tail_len = (int)line_len;
+    c->tail_hash = hash;
+    parse_log_line(p);
+    p = nl + 1;
+  }
+  if (p != buf) {
+    c->bytes += (long long)(p - buf);
+    g_dirty = true;
+  }
+  free(buf);
+}
+
+static void catch_up(int only_month) {
+  g_log_gen = history_log_generation();
+  const int n = history_log_segment_count(HISTORY_LOG_ACTIVITY);
+  if (n <= 0)
+    return;
+  HistorySegment *segs = (HistorySegment *)malloc(sizeof(HistorySegment) * n);
+  if (!segs)
+    return;
+  const int got = history_log_segments(HISTORY_LOG_ACTIVITY, segs, n);
+  for (int i = 0; i < got; i++) {
+    if (!only_month || segs[i].month == only_month)
+      catch_up_segment(&segs[i]);
+  }
+  free(segs);
+}
+
+static bool rollup_read(void) {
+  FILE *f = fopen(g_rollup_path, "r");
+  if (!f)
+    return false;
+  char line[64];
+  bool ok = fgets(line, sizeof(line), f) &&
+            strncmp(line, ROLLUP_HEADER, strlen(ROLLUP_HEADER)) == 0;
+  while (ok && fgets(line, sizeof(line), f)) {
+    int date = 0, gen = 0, tail_len = 0;
+    unsigned int secs = 0, tail_hash = 0;
+    long long bytes = 0;
+    unsigned long long ino = 0;
+    if (sscanf(line, "seg %d %d %lld %llu %d %u", &date, &gen, &bytes, &ino,
+               &tail_len, &tail_hash) == 6) {
+      RollupCover *c = cover_for(date);
+      if (c) {
+        c->gen = gen;
+        c->bytes = bytes;
+        c->ino = ino;
+        c->tail_len = tail_len;
+        c->tail_hash = (uint32_t)tail_hash;
+      }
+    } else if (sscanf(line, "%d %u", &date, &secs) == 2) {
+      rollup_add(date, (uint32_t)secs);
+    }
+  }
+  fclose(f);
+  if (!ok) {
+    g_count = 0;
+    g_cover_count = 0;
+  }
+  return ok;
+}
+
+void activity_rollup_load(const char *rollup_path) {
+  activity_rollup_free();
+  snprintf(g_rollup_path, sizeof(g_rollup_path), "%s",
+           rollup_path ? rollup_path : "");
+  const bool have = rollup_read();
+  g_dirty = !have;
+  catch_up(0);
+}
+
+void activity_rollup_save(void) {
+  if (!g_dirty || !g_rollup_path[0])
+    return;
+  char tmp[PATH_MAX + 4];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", g_rollup_path);
+  FILE *f = fopen(tmp, "w");
+  if (!f)
+    return;
+  fprintf(f, "%s\n", ROLLUP_HEADER);
+  for (int i = 0; i < g_cover_count; i++) {
+    const RollupCover *c = &g_covers[i];
+    fprintf(f, "seg %d %d %lld %llu %d %u\n", c->month, c->gen, c->bytes,
+            c->ino, c->tail_len, (unsigned)c->tail_hash);
+  }
+  for (int i = 0; i < g_count; i++)
+    fprintf(f, "%d %u\n", g_days[i].date, (unsigned)g_days[i].secs);
+  const bool ok = fclose(f) == 0;
+  if (!ok || rename(tmp, g_rollup_path) != 0) {
+    remove(tmp);
+    return;
+  }
+  g_dirty = false;
+}
+
+void activity_rollup_free(void) {
+  free(g_days);
+  g_days = NULL;
+  g_count = 0;
+  g_cap = 0;
+  free(g_covers);
+  g_covers = NULL;
+  g_cover_count = 0;
+  g_cover_cap = 0;
+  g_dirty = false;
+}
+
+bool activity_rollup_append(int date, uint32_t secs) {
+  if (date <= 0)
+    return false;
+  char row[32];
+  const int len = snprintf(row, sizeof(row), "%04d-%02d-%02d\t%u",
+                           date / 10000, (date / 100) % 100, date % 100,
+                           (unsigned)secs);
+  long long end = 0;
+  if (!history_log_append(HISTORY_LOG_ACTIVITY, date, row, &end))
+    return false;
+  /* The usual case: the row went straight after what is covered, so it is
+   * added as it is, without reading the segment. Anything else (a segment
+   * rewritten, rows appended from elsewhere) goes through a catch-up. */
+  RollupCover *c = cover_for(date / 100);
+  if (c && history_log_generation() == g_log_gen &&
+      end == c->bytes + len + 1) {
+    rollup_add(date, secs);
+    c->bytes = end;
+    c->tail_len = len + 1;
+    c->tail_hash = fnv1a32(row);
+    g_dirty = true;
+  } else {
+    catch_up(date / 100);
+  }
+  return true;
+}
+
+uint32_t activity_rollup_day(int date) {
+  bool found;
+  const int i = date_index(date, &found);
+  return found ? g_days[i].secs : 0;
+}
+
+uint64_t activity_rollup_since(int date) {
+  uint64_t total = 0;
+  for (int i = g_count - 1; i >= 0 && g_days[i].date >= date; i--)
+    total += g_days[i].secs;
+  return total;
+}
+
+int activity_rollup_day_count(void) { return g_count; }
+
+uint32_t activity_rollup_day_at(int i, int *date) {
+  if (i < 0 || i >= g_count)
+    return 0;
+  if (date)
+    *date = g_days[i].date;
+  return g_days[i].secs;
+}
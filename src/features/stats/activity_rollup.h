@@ -0,0 +1,43 @@
+#ifndef ACTIVITY_ROLLUP_H
+#define ACTIVITY_ROLLUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Focus seconds per day, kept in memory so the stats heatmap and the quest
+ * don't reparse the activity log.
+ *
+ * The log (history_log.h, one segment per month) stays the source of
+ * truth. The rollup is persisted with how many bytes of each segment it
+ * covers; loading reads that file and then parses only what was written
+ * after it, so a run that ended without saving costs the lines it
+ * appended and nothing more. A segment rewritten by compaction since is
+ * read again whole, which is cheap as it is one row per day by then; so is
+ * one replaced by another file, noticed by its inode or by the last line
+ * read no longer being where it was. Rows appended through this module are
+ * added directly, without reading them back.
+ * Days are kept sorted, so lookups are a binary search and range sums
+ * touch only the days in the range.
+ *
+ * Dates are YYYYMMDD ints in local time.
+ */
+
+/* Loads the rollup from rollup_path and catches up with the log's
+ * segments. history_log_open must have been called. */
+void activity_rollup_load(const char *rollup_path);
+/* Writes the rollup back if it changed since it was loaded or saved. */
+void activity_rollup_save(void);
+void activity_rollup_free(void);
+
+/* Appends a row to the log and adds it to the rollup. */
+bool activity_rollup_append(int date, uint32_t secs);
+
+uint32_t activity_rollup_day(int date);
+/* Sum of all days on or after date. */
+uint64_t activity_rollup_since(int date);
+int activity_rollup_day_count(void);
+/* The i-th day in date order, for 0 <= i < activity_rollup_day_count(). */
+uint32_t activity_rollup_day_at(int i, int *date);
+
+#endif // ACTIVITY_ROLLUP_H
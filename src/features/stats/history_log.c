@@ -0,0 +1,500 @@
+#include "history_log.h"
+
+#include <SDL2/SDL.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../utils/file_utils.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define MANIFEST_HEADER "# stillroom history manifest v1"
+#define MIGRATE_MONTHS_MAX 1024
+
+typedef struct {
+  HistoryLogKind kind;
+  HistorySegment seg;
+} ManifestEntry;
+
+static const char *const kind_names[HISTORY_LOG_KIND_COUNT] = {"activity",
+                                                               "focus"};
+
+static struct {
+  bool open;
+  char dir[PATH_MAX];
+  SDL_mutex *lock;
+  SDL_Thread *thread;
+  SDL_atomic_t quit;
+  ManifestEntry *entries; /* by kind, then month */
+  int count;
+  int cap;
+  /* The segment being appended to, per kind. */
+  FILE *out[HISTORY_LOG_KIND_COUNT];
+  int out_month[HISTORY_LOG_KIND_COUNT];
+} g;
+
+static int current_month(void) {
+  time_t now = time(NULL);
+  struct tm tmv;
+  localtime_r(&now, &tmv);
+  return (tmv.tm_year + 1900) * 100 + tmv.tm_mon + 1;
+}
+
+static int month_minus(int month, int n) {
+  int m = (month / 100) * 12 + (month % 100 - 1) - n;
+  return (m / 12) * 100 + m % 12 + 1;
+}
+
+/* The date (YYYYMMDD) a row starts with, or 0. */
+static int row_date(const char *row) {
+  int y = 0, m = 0, d = 0;
+  if (sscanf(row, "%4d-%2d-%2d", &y, &m, &d) != 3)
+    return 0;
+  if (y <= 0 || m < 1 || m > 12 || d < 1 || d > 31)
+    return 0;
+  return (y * 10000) + (m * 100) + d;
+}
+
+void history_log_segment_path(HistoryLogKind kind, int month, char *out,
+                              size_t cap) {
+  if (!out || cap == 0)
+    return;
+  if (kind < 0 || kind >= HISTORY_LOG_KIND_COUNT) {
+    out[0] = 0;
+    return;
+  }
+  snprintf(out, cap, "%s/%s-%04d-%02d.txt", g.dir, kind_names[kind],
+           month / 100, month % 100);
+}
+
+/* ---- Manifest (lock held) ---- */
+
+static int entry_find(HistoryLogKind kind, int month) {
+  for (int i = 0; i < g.count; i++) {
+    if (g.entries[i].kind == kind && g.entries[i].seg.month == month)
+      return i;
+  }
+  return -1;
+}
+
+static int entry_add(HistoryLogKind kind, int month) {
+  if (g.count == g.cap) {
+    const int ncap = g.cap ? g.cap * 2 : 64;
+    ManifestEntry *grown =
+        (ManifestEntry *)realloc(g.entries, sizeof(ManifestEntry) * ncap);
+    if (!grown)
+      return -1;
+    g.entries = grown;
+    g.cap = ncap;
+  }
+  int i = g.count;
+  while (i > 0 && (g.entries[i - 1].kind > kind ||
+                   (g.entries[i - 1].kind == kind &&
+                    g.entries[i - 1].seg.month > month)))
+    i--;
+  memmove(&g.entries[i + 1], &g.entries[i],
+          sizeof(ManifestEntry) * (size_t)(g.count - i));
+  memset(&g.entries[i], 0, sizeof(g.entries[i]));
+  g.entries[i].kind = kind;
+  g.entries[i].seg.month = month;
+  g.count++;
+  return i;
+}
+
+static void manifest_path(char *out, size_t cap) {
+  snprintf(out, cap, "%s/manifest.txt", g.dir);
+}
+
+static void manifest_load(void) {
+  char path[PATH_MAX];
+  manifest_path(path, sizeof(path));
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return;
+  char line[128];
+  if (!fgets(line, sizeof(line), f) ||
+      strncmp(line, MANIFEST_HEADER, strlen(MANIFEST_HEADER)) != 0) {
+    fclose(f);
+    return;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    char kind[16];
+    int month = 0, gen = 0, compacted = 0;
+    if (sscanf(line, "%15s %d %d %d", kind, &month, &gen, &compacted) != 4)
+      continue;
+    for (int k = 0; k < HISTORY_LOG_KIND_COUNT; k++) {
+      if (strcmp(kind, kind_names[k]) != 0 ||
+          entry_find((HistoryLogKind)k, month) >= 0)
+        continue;
+      const int i = entry_add((HistoryLogKind)k, month);
+      if (i >= 0) {
+        g.entries[i].seg.gen = gen;
+        g.entries[i].seg.compacted = compacted != 0;
+      }
+    }
+  }
+  fclose(f);
+}
+
+static bool manifest_save(void) {
+  char path[PATH_MAX], tmp[PATH_MAX + 4];
+  manifest_path(path, sizeof(path));
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *f = fopen(tmp, "w");
+  if (!f)
+    return false;
+  fprintf(f, "%s\n", MANIFEST_HEADER);
+  for (int i = 0; i < g.count; i++) {
+    const ManifestEntry *e = &g.entries[i];
+    fprintf(f, "%s %d %d %d\n", kind_names[e->kind], e->seg.month, e->seg.gen,
+            e->seg.compacted ? 1 : 0);
+  }
+  const bool ok = fclose(f) == 0;
+  if (!ok || rename(tmp, path) != 0) {
+    remove(tmp);
+    return false;
+  }
+  return true;
+}
+
+/* ---- Appending ---- */
+
+bool history_log_append(HistoryLogKind kind, int date, const char *row,
+                        long long *end) {
+  if (!g.open || kind < 0 || kind >= HISTORY_LOG_KIND_COUNT || !row ||
+      date <= 0)
+    return false;
+  const int month = date / 100;
+  /* Held throughout: compact_thread reads g.out under the lock. */
+  SDL_LockMutex(g.lock);
+  if (g.out[kind] && g.out_month[kind] != month) {
+    fclose(g.out[kind]);
+    g.out[kind] = NULL;
+  }
+  int i = entry_find(kind, month);
+  bool changed = false;
+  if (i < 0) {
+    i = entry_add(kind, month);
+    changed = true;
+  }
+  /* A month before the newest one only gets rows if the clock moved back;
+   * that shifts the offsets of every later segment, so treat it as a
+   * rewrite. */
+  if (i >= 0 && i + 1 < g.count && g.entries[i + 1].kind == kind) {
+    g.entries[i].seg.gen++;
+    changed = true;
+  }
+  if (changed)
+    manifest_save();
+  if (!g.out[kind]) {
+    char path[PATH_MAX];
+    history_log_segment_path(kind, month, path, sizeof(path));
+    g.out[kind] = fopen(path, "a");
+    g.out_month[kind] = month;
+  }
+  FILE *f = g.out[kind];
+  bool ok = f && fprintf(f, "%s\n", row) >= 0 && fflush(f) == 0;
+  if (ok && end)
+    *end = (long long)ftell(f);
+  SDL_UnlockMutex(g.lock);
+  return ok;
+}
+
+/* ---- Migration ---- */
+
+void history_log_migrate(HistoryLogKind kind, const char *legacy_path) {
+  if (!g.open || !legacy_path || !is_file(legacy_path))
+    return;
+  char done[PATH_MAX + 16];
+  snprintf(done, sizeof(done), "%s.migrated", legacy_path);
+  /* Segments already there: an earlier migration stopped short of the
+   * rename. */
+  if (history_log_segment_count(kind) > 0) {
+    rename(legacy_path, done);
+    return;
+  }
+  FILE *in = fopen(legacy_path, "r");
+  if (!in)
+    return;
+  static int months[MIGRATE_MONTHS_MAX];
+  int month_count = 0;
+  FILE *out = NULL;
+  int out_month = 0;
+  bool ok = true;
+  char line[512];
+  SDL_LockMutex(g.lock);
+  while (ok && fgets(line, sizeof(line), in)) {
+    const int date = row_date(line);
+    if (date <= 0)
+      continue;
+    const int month = date / 100;
+    if (!out || month != out_month) {
+      if (out)
+        fclose(out);
+      /* Truncate a segment the first time round, in case a migration was
+       * cut short before the manifest was written. */
+      bool seen = false;
+      for (int i = 0; i < month_count; i++)
+        seen = seen || months[i] == month;
+      if (!seen && month_count < MIGRATE_MONTHS_MAX)
+        months[month_count++] = month;
+      char path[PATH_MAX];
+      history_log_segment_path(kind, month, path, sizeof(path));
+      out = fopen(path, seen ? "a" : "w");
+      out_month = month;
+      ok = out != NULL && (seen || entry_add(kind, month) >= 0);
+    }
+    if (ok)
+      ok = fputs(line, out) >= 0;
+  }
+  if (out)
+    ok = fclose(out) == 0 && ok;
+  fclose(in);
+  ok = ok && manifest_save();
+  SDL_UnlockMutex(g.lock);
+  if (ok)
+    rename(legacy_path, done);
+}
+
+/* ---- Compaction ---- */
+
+typedef struct {
+  int day;
+  char activity[64];
+  uint64_t secs;
+  int sessions;
+} FocusSum;
+
+static bool compact_activity(FILE *in, FILE *out, int month) {
+  uint64_t day_secs[32] = {0};
+  char line[512];
+  while (fgets(line, sizeof(line), in)) {
+    const int date = row_date(line);
+    const char *v = line + strcspn(line, "\t ");
+    if (date / 100 != month || !*v)
+      continue;
+    day_secs[date % 100] += strtoull(v, NULL, 10);
+  }
+  bool ok = true;
+  for (int d = 1; d <= 31 && ok; d++) {
+    if (day_secs[d])
+      ok = fprintf(out, "%04d-%02d-%02d\t%llu\n", month / 100, month % 100, d,
+                   (unsigned long long)day_secs[d]) > 0;
+  }
+  return ok;
+}
+
+static int by_day_activity(const void *a, const void *b) {
+  const FocusSum *x = (const FocusSum *)a, *y = (const FocusSum *)b;
+  if (x->day != y->day)
+    return x->day - y->day;
+  return strcmp(x->activity, y->activity);
+}
+
+/* Every row is collected, then sorted by day and activity, so the rows to
+ * merge end up next to each other. */
+static bool compact_focus(FILE *in, FILE *out, int month) {
+  FocusSum *sums = NULL;
+  int count = 0, cap = 0;
+  bool ok = true;
+  char line[512];
+  while (ok && fgets(line, sizeof(line), in)) {
+    line[strcspn(line, "\r\n")] = 0;
+    const int date = row_date(line);
+    if (date / 100 != month)
+      continue;
+    char *p1 = strtok(line, "\t");
+    char *p2 = strtok(NULL, "\t");
+    char *p3 = strtok(NULL, "\t");
+    char *p4 = strtok(NULL, "");
+    if (!p1 || !p2 || !p3 || !p4)
+      continue;
+    /* Rows already summarized say how many sessions they stand for. */
+    int sessions = 1;
+    if (sscanf(p3, "%d session", &sessions) != 1 || sessions < 1)
+      sessions = 1;
+    if (count == cap) {
+      const int ncap = cap ? cap * 2 : 64;
+      FocusSum *grown = (FocusSum *)realloc(sums, sizeof(FocusSum) * ncap);
+      if (!grown) {
+        ok = false;
+        break;
+      }
+      sums = grown;
+      cap = ncap;
+    }
+    FocusSum *s = &sums[count++];
+    s->day = date % 100;
+    snprintf(s->activity, sizeof(s->activity), "%s", p4);
+    s->secs = strtoull(p2, NULL, 10);
+    s->sessions = sessions;
+  }
+  if (ok && count > 0)
+    qsort(sums, (size_t)count, sizeof(FocusSum), by_day_activity);
+  for (int i = 0; i < count && ok;) {
+    FocusSum sum = sums[i];
+    for (i++; i < count && by_day_activity(&sums[i], &sum) == 0; i++) {
+      sum.secs += sums[i].secs;
+      sum.sessions += sums[i].sessions;
+    }
+    ok = fprintf(out, "%04d-%02d-%02d\t%llu\t%d session%s\t%s\n",
+                 month / 100, month % 100, sum.day,
+                 (unsigned long long)sum.secs, sum.sessions,
+                 sum.sessions == 1 ? "" : "s", sum.activity) > 0;
+  }
+  free(sums);
+  return ok;
+}
+
+/* Writes the summary of a segment next to it; the caller renames it into
+ * place. */
+static bool compact_segment(HistoryLogKind kind, int month, const char *path,
+                            const char *tmp) {
+  FILE *in = fopen(path, "r");
+  if (!in)
+    return false;
+  FILE *out = fopen(tmp, "w");
+  if (!out) {
+    fclose(in);
+    return false;
+  }
+  bool ok = kind == HISTORY_LOG_ACTIVITY ? compact_activity(in, out, month)
+                                         : compact_focus(in, out, month);
+  fclose(in);
+  ok = fclose(out) == 0 && ok;
+  if (!ok)
+    remove(tmp);
+  return ok;
+}
+
+static bool compactable(const HistorySegment *s, HistoryLogKind kind,
+                        int now_month) {
+  if (s->compacted)
+    return false;
+  if (kind == HISTORY_LOG_ACTIVITY)
+    return s->month < now_month;
+  return s->month <= month_minus(now_month, HISTORY_FOCUS_KEEP_MONTHS);
+}
+
+static int compact_thread(void *userdata) {
+  (void)userdata;
+  const int now_month = current_month();
+  SDL_LockMutex(g.lock);
+  const int n = g.count;
+  ManifestEntry *todo = (ManifestEntry *)malloc(sizeof(ManifestEntry) * n);
+  if (todo && n > 0)
+    memcpy(todo, g.entries, sizeof(ManifestEntry) * n);
+  SDL_UnlockMutex(g.lock);
+  if (!todo)
+    return 0;
+  for (int t = 0; t < n && !SDL_AtomicGet(&g.quit); t++) {
+    const ManifestEntry *e = &todo[t];
+    if (!compactable(&e->seg, e->kind, now_month))
+      continue;
+    char path[PATH_MAX], tmp[PATH_MAX + 4];
+    history_log_segment_path(e->kind, e->seg.month, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    if (!compact_segment(e->kind, e->seg.month, path, tmp))
+      continue;
+    SDL_LockMutex(g.lock);
+    /* Skip it if rows went in meanwhile (see history_log_append). */
+    const int i = entry_find(e->kind, e->seg.month);
+    const bool same = i >= 0 && g.entries[i].seg.gen == e->seg.gen &&
+                      !(g.out[e->kind] && g.out_month[e->kind] == e->seg.month);
+    if (same && rename(tmp, path) == 0) {
+      g.entries[i].seg.gen++;
+      g.entries[i].seg.compacted = true;
+      manifest_save();
+    } else {
+      remove(tmp);
+    }
+    SDL_UnlockMutex(g.lock);
+  }
+  free(todo);
+  return 0;
+}
+
+/* ---- Lifecycle and queries ---- */
+
+bool history_log_open(const char *dir) {
+  history_log_close();
+  if (!dir || !dir[0])
+    return false;
+  snprintf(g.dir, sizeof(g.dir), "%s", dir);
+  ensure_dir(g.dir);
+  g.lock = SDL_CreateMutex();
+  if (!g.lock)
+    return false;
+  manifest_load();
+  g.open = true;
+  return true;
+}
+
+bool history_log_compact_start(void) {
+  if (!g.open || g.thread)
+    return false;
+  SDL_AtomicSet(&g.quit, 0);
+  g.thread = SDL_CreateThread(compact_thread, "history_compact", NULL);
+  return g.thread != NULL;
+}
+
+void history_log_close(void) {
+  if (g.thread) {
+    SDL_AtomicSet(&g.quit, 1);
+    SDL_WaitThread(g.thread, NULL);
+    g.thread = NULL;
+  }
+  for (int k = 0; k < HISTORY_LOG_KIND_COUNT; k++) {
+    if (g.out[k])
+      fclose(g.out[k]);
+    g.out[k] = NULL;
+  }
+  if (g.lock)
+    SDL_DestroyMutex(g.lock);
+  g.lock = NULL;
+  free(g.entries);
+  g.entries = NULL;
+  g.count = 0;
+  g.cap = 0;
+  g.open = false;
+}
+
+int history_log_segments(HistoryLogKind kind, HistorySegment *out, int max) {
+  if (!g.open || !out || max <= 0)
+    return 0;
+  int n = 0;
+  SDL_LockMutex(g.lock);
+  for (int i = 0; i < g.count && n < max; i++) {
+    if (g.entries[i].kind == kind)
+      out[n++] = g.entries[i].seg;
+  }
+  SDL_UnlockMutex(g.lock);
+  return n;
+}
+
+int history_log_segment_count(HistoryLogKind kind) {
+  if (!g.open)
+    return 0;
+  int n = 0;
+  SDL_LockMutex(g.lock);
+  for (int i = 0; i < g.count; i++)
+    n += g.entries[i].kind == kind;
+  SDL_UnlockMutex(g.lock);
+  return n;
+}
+
+uint32_t history_log_generation(void) {
+  if (!g.open)
+    return 0;
+  uint32_t sum = 0;
+  SDL_LockMutex(g.lock);
+  for (int i = 0; i < g.count; i++)
+    sum += (uint32_t)g.entries[i].seg.gen;
+  SDL_UnlockMutex(g.lock);
+  return sum;
+}
@@ -0,0 +1,62 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The activity log and the focus history, stored as one file per month
+ * ("activity-2026-01.txt", "focus-2026-01.txt") under a directory with a
+ * manifest of the segments.
+ *
+ * Only the current month's segment is appended to; its file stays open
+ * and is flushed per row instead of being reopened for every event. Older
+ * segments are rewritten once by a background job into summaries in the
+ * same row format, so every reader keeps working on them:
+ *   activity: one row per day.
+ *   focus:    one row per day and activity ("3 sessions"), for months
+ *             older than HISTORY_FOCUS_KEEP_MONTHS; newer months keep
+ *             every session.
+ * Each rewrite bumps the segment's gen, which is how readers holding
+ * offsets into it notice.
+ */
+
+#define HISTORY_FOCUS_KEEP_MONTHS 12
+
+typedef enum {
+  HISTORY_LOG_ACTIVITY = 0, /* "YYYY-MM-DD<TAB>seconds" */
+  HISTORY_LOG_FOCUS, /* "YYYY-MM-DD HH:MM<TAB>seconds<TAB>status<TAB>act" */
+  HISTORY_LOG_KIND_COUNT
+} HistoryLogKind;
+
+typedef struct HistorySegment {
+  int month; /* YYYYMM */
+  int gen;   /* bumped each time the segment is rewritten */
+  bool compacted;
+} HistorySegment;
+
+/* Opens (creating) dir and reads its manifest. */
+bool history_log_open(const char *dir);
+/* One-time move of a single-file log from before segments; the old file
+ * is renamed to "<path>.migrated". */
+void history_log_migrate(HistoryLogKind kind, const char *legacy_path);
+/* Starts compacting closed segments on a worker thread. */
+bool history_log_compact_start(void);
+/* Stops the worker and closes the open segments. */
+void history_log_close(void);
+
+/* Appends row (without its newline) to the segment of date (YYYYMMDD).
+ * If end is not NULL it gets the segment's size after the row. */
+bool history_log_append(HistoryLogKind kind, int date, const char *row,
+                        long long *end);
+
+/* Copies up to max segments of kind, oldest first; returns how many. */
+int history_log_segments(HistoryLogKind kind, HistorySegment *out, int max);
+int history_log_segment_count(HistoryLogKind kind);
+void history_log_segment_path(HistoryLogKind kind, int month, char *out,
+                              size_t cap);
+/* Changes whenever any segment is rewritten. */
+uint32_t history_log_generation(void);
+
+#endif // HISTORY_LOG_H
@@ -0,0 +1,312 @@
+#include "history_reader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "../../utils/string_utils.h"
+#include "history_log.h"
+
+#define HISTORY_BLOCK 4096
+#define HISTORY_LINE_MAX 512
+
+/* `row` rows lie after off: the line ending at off is row `row`. */
+typedef struct {
+  int row;
+  long long off;
+} HistoryMark;
+
+/* The focus segments, oldest first, read as one file: a segment starts
+ * where the one before it ends. */
+typedef struct {
+  int month;
+  long long start;
+  long long size;
+} ReaderSeg;
+
+static ReaderSeg *g_segs;
+static int g_seg_count;
+static uint32_t g_gen; /* history_log_generation() the offsets are for */
+static FILE *g_f;      /* the segment g_f_seg */
+static int g_f_seg = -1;
+static long long g_size; /* of all segments */
+static long long g_end; /* just past the last complete line indexed */
+static HistoryMark *g_marks; /* ascending row, descending offset */
+static int g_mark_count;
+static int g_mark_cap;
+static int g_total = -1;
+
+static char g_blk[HISTORY_BLOCK];
+static long long g_blk_off = -1;
+static int g_blk_len;
+
+static int seg_at(long long off) {
+  int lo = 0, hi = g_seg_count;
+  while (hi - lo > 1) {
+    const int mid = (lo + hi) / 2;
+    if (g_segs[mid].start <= off)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static bool seg_open(int i) {
+  if (g_f && g_f_seg == i)
+    return true;
+  if (g_f)
+    fclose(g_f);
+  char path[PATH_MAX];
+  history_log_segment_path(HISTORY_LOG_FOCUS, g_segs[i].month, path,
+                           sizeof(path));
+  g_f = fopen(path, "rb");
+  g_f_seg = g_f ? i : -1;
+  return g_f != NULL;
+}
+
+/* The byte at off, reading the block of its segment that ends there if
+ * needed; -1 on a read error. */
+static int byte_at(long long off) {
+  if (g_blk_off < 0 || off < g_blk_off || off >= g_blk_off + g_blk_len) {
+    if (g_seg_count == 0 || off < 0 || off >= g_size)
+      return -1;
+    const ReaderSeg *sg = &g_segs[seg_at(off)];
+    long long start = off - HISTORY_BLOCK + 1;
+    if (start < sg->start)
+      start = sg->start;
+    long long len = sg->start + sg->size - start;
+    if (len > HISTORY_BLOCK)
+      len = HISTORY_BLOCK;
+    g_blk_off = -1;
+    if (len <= 0 || !seg_open((int)(sg - g_segs)) ||
+        fseek(g_f, (long)(start - sg->start), SEEK_SET) != 0)
+      return -1;
+    g_blk_len = (int)fread(g_blk, 1, (size_t)len, g_f);
+    g_blk_off = start;
+    if (off >= g_blk_off + g_blk_len)
+      return -1;
+  }
+  return (unsigned char)g_blk[off - g_blk_off];
+}
+
+/* Copies the line that ends with the newline at end - 1 into line and
+ * returns where it starts. */
+static long long prev_line(long long end, char *line, size_t cap) {
+  const long long stop = end - 1;
+  long long s = stop;
+  while (s > 0) {
+    const int c = byte_at(s - 1);
+    if (c == '\n' || c < 0)
+      break;
+    s--;
+  }
+  size_t n = 0;
+  for (long long i = s; i < stop && n + 1 < cap; i++) {
+    const int c = byte_at(i);
+    if (c < 0)
+      break;
+    line[n++] = (char)c;
+  }
+  while (n > 0 && line[n - 1] == '\r')
+    n--;
+  line[n] = 0;
+  return s;
+}
+
+/* One row: "YYYY-MM-DD HH:MM<TAB>seconds<TAB>status<TAB>activity". */
+static bool parse_row(char *line, FocusHistoryRow *r) {
+  char *p1 = strtok(line, "\t");
+  char *p2 = strtok(NULL, "\t");
+  char *p3 = strtok(NULL, "\t");
+  char *p4 = strtok(NULL, ""); /* rest of line */
+  if (!p1 || !p2 || !p3 || !p4)
+    return false;
+  memset(r, 0, sizeof(*r));
+  safe_snprintf(r->dt, sizeof(r->dt), "%s", p1);
+  r->seconds = (uint32_t)strtoul(p2, NULL, 10);
+  safe_snprintf(r->status, sizeof(r->status), "%s", p3);
+  safe_snprintf(r->activity, sizeof(r->activity), "%s", p4);
+  for (char *c = r->activity; *c; c++) {
+    if (*c == '\t')
+      *c = ' ';
+  }
+  return true;
+}
+
+static void marks_reset(void) {
+  g_mark_count = 0;
+  g_end = 0;
+  g_total = -1;
+}
+
+static bool mark_insert(int at, int row, long long off) {
+  if (g_mark_count == g_mark_cap) {
+    const int ncap = g_mark_cap ? g_mark_cap * 2 : 64;
+    HistoryMark *grown =
+        (HistoryMark *)realloc(g_marks, sizeof(HistoryMark) * (size_t)ncap);
+    if (!grown)
+      return false;
+    g_marks = grown;
+    g_mark_cap = ncap;
+  }
+  memmove(&g_marks[at + 1], &g_marks[at],
+          sizeof(HistoryMark) * (size_t)(g_mark_count - at));
+  g_marks[at].row = row;
+  g_marks[at].off = off;
+  g_mark_count++;
+  return true;
+}
+
+static long long file_size(int month) {
+  char path[PATH_MAX];
+  history_log_segment_path(HISTORY_LOG_FOCUS, month, path, sizeof(path));
+  struct stat st;
+  return stat(path, &st) == 0 ? (long long)st.st_size : 0;
+}
+
+static void segs_close(void) {
+  if (g_f)
+    fclose(g_f);
+  g_f = NULL;
+  g_f_seg = -1;
+  g_blk_off = -1;
+}
+
+/* Re-reads the segment list if it changed, else just the size of the
+ * newest segment, the only one that grows. */
+static void segs_refresh(void) {
+  const uint32_t gen = history_log_generation();
+  const int n = history_log_segment_count(HISTORY_LOG_FOCUS);
+  if (gen != g_gen || n != g_seg_count) {
+    if (gen != g_gen)
+      marks_reset(); /* segments were rewritten: offsets moved */
+    g_gen = gen;
+    segs_close();
+    HistorySegment *list =
+        (HistorySegment *)malloc(sizeof(HistorySegment) * (n > 0 ? n : 1));
+    ReaderSeg *segs = (ReaderSeg *)realloc(
+        g_segs, sizeof(ReaderSeg) * (size_t)(n > 0 ? n : 1));
+    if (segs)
+      g_segs = segs;
+    g_seg_count = 0;
+    g_size = 0;
+    if (!list || !segs) {
+      free(list);
+      marks_reset();
+      return;
+    }
+    const int got = history_log_segments(HISTORY_LOG_FOCUS, list, n);
+    for (int i = 0; i < got; i++) {
+      g_segs[i].month = list[i].month;
+      g_segs[i].start = g_size;
+      g_segs[i].size = file_size(list[i].month);
+      g_size += g_segs[i].size;
+    }
+    g_seg_count = got;
+    free(list);
+    return;
+  }
+  if (g_seg_count == 0)
+    return;
+  ReaderSeg *last = &g_segs[g_seg_count - 1];
+  const long long size = file_size(last->month);
+  if (size != last->size) {
+    if (size < last->size)
+      marks_reset();
+    last->size = size;
+    g_size = last->start + size;
+    g_blk_off = -1;
+  }
+}
+
+/* Brings the index up to the current end of the segments. */
+static bool refresh(void) {
+  segs_refresh();
+  const long long size = g_size;
+  /* A last line without its newline is still being written. */
+  long long end = size;
+  while (end > 0 && byte_at(end - 1) != '\n')
+    end--;
+  if (end < g_end)
+    marks_reset(); /* replaced or truncated */
+  if (end == 0) {
+    g_total = 0; /* nothing written yet */
+    return false;
+  }
+  if (end == g_end)
+    return g_mark_count > 0;
+  if (g_mark_count == 0) {
+    g_total = -1; /* counted again by the first read to reach the start */
+  } else {
+    /* Count the rows appended since, which become the newest ones. */
+    char line[HISTORY_LINE_MAX];
+    int added = 0;
+    for (long long off = end; off > g_end;) {
+      off = prev_line(off, line, sizeof(line));
+      FocusHistoryRow r;
+      if (parse_row(line, &r))
+        added++;
+    }
+    for (int i = 0; i < g_mark_count; i++)
+      g_marks[i].row += added;
+    if (g_total >= 0)
+      g_total += added;
+  }
+  g_end = end;
+  return mark_insert(0, 0, end);
+}
+
+void history_reader_open(void) {
+  history_reader_close();
+  g_gen = history_log_generation();
+}
+
+void history_reader_close(void) {
+  segs_close();
+  free(g_segs);
+  g_segs = NULL;
+  g_seg_count = 0;
+  free(g_marks);
+  g_marks = NULL;
+  g_mark_cap = 0;
+  g_size = 0;
+  marks_reset();
+}
+
+int history_reader_page(int first, FocusHistoryRow *out, int max) {
+  if (!out || first < 0 || max <= 0 || !refresh())
+    return 0;
+  if (g_total >= 0 && first >= g_total)
+    return 0;
+  /* The nearest mark at or before the first row wanted. */
+  int lo = 0, hi = g_mark_count;
+  while (hi - lo > 1) {
+    const int mid = (lo + hi) / 2;
+    if (g_marks[mid].row <= first)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  int row = g_marks[lo].row;
+  long long off = g_marks[lo].off;
+  int n = 0;
+  char line[HISTORY_LINE_MAX];
+  while (off > 0 && row < first + max) {
+    off = prev_line(off, line, sizeof(line));
+    FocusHistoryRow r;
+    if (!parse_row(line, &r))
+      continue;
+    if (row >= first)
+      out[n++] = r;
+    row++;
+    if (row >= g_marks[g_mark_count - 1].row + HISTORY_INDEX_STRIDE)
+      mark_insert(g_mark_count, row, off);
+  }
+  if (off == 0)
+    g_total = row;
+  return n;
+}
+
+int history_reader_total(void) { return g_total; }
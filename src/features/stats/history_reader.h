@@ -0,0 +1,34 @@
+#ifndef HISTORY_READER_H
+#define HISTORY_READER_H
+
+#include <stdbool.h>
+
+#include "../../app.h"
+
+/*
+ * Newest-first pages of the focus history, read from the end of its
+ * segments (history_log.h), which are taken as one file.
+ *
+ * Rows are numbered from the newest (row 0 is the last line). Reading a
+ * page walks backwards from the nearest known offset in blocks, so the
+ * cost is the page plus at most HISTORY_INDEX_STRIDE rows, not the whole
+ * file. Offsets passed on the way are kept in a sparse index, which is
+ * what makes paging deep into old history cheap the next time. Rows
+ * appended while the reader is open are counted on the next read and
+ * shift the index instead of invalidating it; a segment rewritten by
+ * compaction does invalidate it.
+ */
+
+#define HISTORY_INDEX_STRIDE 64 /* rows between index entries */
+
+void history_reader_open(void);
+void history_reader_close(void);
+
+/* Copies rows [first, first + max) into out, newest first; returns how
+ * many there were. */
+int history_reader_page(int first, FocusHistoryRow *out, int max);
+/* Number of rows, or -1 until a read has reached the start of the file
+ * (0 straight away for an empty history). */
+int history_reader_total(void);
+
+#endif // HISTORY_READER_H
@@ -0,0 +1,575 @@
+#include "stats_engine.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../utils/string_utils.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define STATS_HEADER "# stillroom stats v1"
+#define STATS_JOURNAL_HEADER "# stillroom stats journal"
+#define STATS_NAME_MAX 64
+/* A longer name keeps this many bytes, then "~" and a hash of the rest. */
+#define STATS_NAME_KEEP (STATS_NAME_MAX - 11)
+#define STATS_SERIES_SPAN_MAX (366 * 100) /* ignore dates from a wild clock */
+
+/* Values indexed by day, week or month number, from `first` on. */
+typedef struct {
+  int first;
+  int count;
+  int cap;
+  uint64_t *v;
+} Series;
+
+typedef struct {
+  char name[STATS_NAME_MAX];
+  uint64_t secs;
+  uint32_t sessions;
+  Series months;
+} Activity;
+
+static struct {
+  char path[PATH_MAX];
+  bool dirty;
+  /* Sessions added since the last save, one line each, so an add costs an
+   * append rather than a rewrite. The state file names the generation of
+   * the journal still to be replayed over it; a journal from an older
+   * generation is already folded in. */
+  FILE *journal;
+  int journal_gen;
+  Series day_secs;
+  Series day_sessions;
+  Series week_secs;
+  Series month_secs;
+  uint64_t hour_secs[24];
+  /* The last day with focus and the run of days ending there. */
+  int last_day;
+  int run;
+  int longest;
+  int best_day;
+  /* Activities and a hash of names to indices. They are put in order of
+   * total (largest first) when next asked for, not on every add. */
+  Activity *acts;
+  int act_count;
+  int act_cap;
+  bool act_unsorted;
+  int *slots; /* index + 1; 0 = empty */
+  int slot_cap;
+} g;
+
+/* ---- Dates ---- */
+
+/* Days since 1970-01-01 of a YYYYMMDD date. */
+static int day_number(int date) {
+  int y = date / 10000;
+  const int m = (date / 100) % 100;
+  const int d = date % 100;
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const int yoe = y - era * 400;
+  const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static int date_of_day(int z) {
+  z += 719468;
+  const int era = (z >= 0 ? z : z - 146096) / 146097;
+  const int doe = z - era * 146097;
+  const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int mp = (5 * doy + 2) / 153;
+  const int d = doy - (153 * mp + 2) / 5 + 1;
+  const int m = mp < 10 ? mp + 3 : mp - 9;
+  const int y = yoe + era * 400 + (m <= 2);
+  return y * 10000 + m * 100 + d;
+}
+
+/* 1970-01-01 was a Thursday; weeks start on Monday. */
+static int week_of_day(int day) { return (day + 3) / 7; }
+
+static int month_index(int date) {
+  return (date / 10000) * 12 + (date / 100) % 100 - 1;
+}
+
+int stats_month_minus(int month, int n) {
+  const int m = (month / 100) * 12 + month % 100 - 1 - n;
+  return (m / 12) * 100 + m % 12 + 1;
+}
+
+/* ---- Series ---- */
+
+static bool series_reserve(Series *s, int count) {
+  if (count <= s->cap)
+    return true;
+  int ncap = s->cap ? s->cap : 32;
+  while (ncap < count)
+    ncap *= 2;
+  uint64_t *grown = (uint64_t *)realloc(s->v, sizeof(uint64_t) * ncap);
+  if (!grown)
+    return false;
+  s->v = grown;
+  s->cap = ncap;
+  return true;
+}
+
+static void series_add(Series *s, int idx, uint64_t val) {
+  if (s->count == 0) {
+    s->first = idx;
+  } else if (idx < s->first) {
+    const int shift = s->first - idx;
+    if (s->count + shift > STATS_SERIES_SPAN_MAX ||
+        !series_reserve(s, s->count + shift))
+      return;
+    memmove(s->v + shift, s->v, sizeof(uint64_t) * s->count);
+    memset(s->v, 0, sizeof(uint64_t) * shift);
+    s->first = idx;
+    s->count += shift;
+  }
+  const int need = idx - s->first + 1;
+  if (need > s->count) {
+    if (need > STATS_SERIES_SPAN_MAX || !series_reserve(s, need))
+      return;
+    memset(s->v + s->count, 0, sizeof(uint64_t) * (need - s->count));
+    s->count = need;
+  }
+  s->v[idx - s->first] += val;
+}
+
+static uint64_t series_get(const Series *s, int idx) {
+  if (idx < s->first || idx >= s->first + s->count)
+    return 0;
+  return s->v[idx - s->first];
+}
+
+static void series_free(Series *s) {
+  free(s->v);
+  memset(s, 0, sizeof(*s));
+}
+
+/* ---- Activities ---- */
+
+static int slot_of(const char *name) {
+  if (g.slot_cap == 0)
+    return -1;
+  int i = (int)(fnv1a32(name) & (uint32_t)(g.slot_cap - 1));
+  while (g.slots[i] && strcmp(g.acts[g.slots[i] - 1].name, name) != 0)
+    i = (i + 1) & (g.slot_cap - 1);
+  return i;
+}
+
+static void slots_rebuild(int cap) {
+  int *slots = (int *)calloc((size_t)cap, sizeof(int));
+  if (!slots)
+    return;
+  free(g.slots);
+  g.slots = slots;
+  g.slot_cap = cap;
+  for (int a = 0; a < g.act_count; a++)
+    g.slots[slot_of(g.acts[a].name)] = a + 1;
+}
+
+/* The name an activity is stored under. One too long to fit is cut on a
+ * character boundary and given a hash of the whole name, so two long names
+ * that start alike stay two activities. */
+static void activity_key(const char *full_name, char *out) {
+  const size_t len = strlen(full_name);
+  if (len < STATS_NAME_MAX) {
+    memcpy(out, full_name, len + 1);
+    return;
+  }
+  size_t keep = STATS_NAME_KEEP;
+  while (keep > 0 && ((unsigned char)full_name[keep] & 0xC0) == 0x80)
+    keep--;
+  memcpy(out, full_name, keep);
+  snprintf(out + keep, STATS_NAME_MAX - keep, "~%08x",
+           (unsigned)fnv1a32(full_name));
+}
+
+static Activity *activity_get(const char *full_name, bool create) {
+  char name[STATS_NAME_MAX];
+  activity_key(full_name, name);
+  const int s = slot_of(name);
+  if (s >= 0 && g.slots[s])
+    return &g.acts[g.slots[s] - 1];
+  if (!create)
+    return NULL;
+  /* Keep the table at most half full. */
+  if ((g.act_count + 1) * 2 > g.slot_cap) {
+    slots_rebuild(g.slot_cap ? g.slot_cap * 2 : 64);
+    if ((g.act_count + 1) * 2 > g.slot_cap)
+      return NULL;
+  }
+  if (g.act_count == g.act_cap) {
+    const int ncap = g.act_cap ? g.act_cap * 2 : 32;
+    Activity *grown = (Activity *)realloc(g.acts, sizeof(Activity) * ncap);
+    if (!grown)
+      return NULL;
+    g.acts = grown;
+    g.act_cap = ncap;
+  }
+  Activity *a = &g.acts[g.act_count];
+  memset(a, 0, sizeof(*a));
+  safe_snprintf(a->name, sizeof(a->name), "%s", name);
+  g.act_count++;
+  g.slots[slot_of(a->name)] = g.act_count;
+  return a;
+}
+
+static int by_total(const void *a, const void *b) {
+  const Activity *x = (const Activity *)a, *y = (const Activity *)b;
+  if (x->secs != y->secs)
+    return x->secs < y->secs ? 1 : -1;
+  return strcmp(x->name, y->name);
+}
+
+static void activities_sort(void) {
+  if (!g.act_unsorted)
+    return;
+  qsort(g.acts, (size_t)g.act_count, sizeof(Activity), by_total);
+  slots_rebuild(g.slot_cap);
+  g.act_unsorted = false;
+}
+
+/* ---- Updates ---- */
+
+static void day_add(int date, uint64_t secs, uint32_t sessions) {
+  const int day = day_number(date);
+  series_add(&g.day_secs, day, secs);
+  series_add(&g.day_sessions, day, sessions);
+  series_add(&g.week_secs, week_of_day(day), secs);
+  series_add(&g.month_secs, month_index(date), secs);
+  if (series_get(&g.day_secs, day) >
+      series_get(&g.day_secs, g.best_day))
+    g.best_day = day;
+  if (g.run == 0 || day == g.last_day + 1) {
+    g.run++;
+    g.last_day = day;
+  } else if (day > g.last_day + 1) {
+    g.run = 1;
+    g.last_day = day;
+  }
+  if (g.run > g.longest)
+    g.longest = g.run;
+  g.dirty = true;
+}
+
+static int date_of_time(time_t t) {
+  struct tm tmv;
+  localtime_r(&t, &tmv);
+  return (tmv.tm_year + 1900) * 10000 + (tmv.tm_mon + 1) * 100 + tmv.tm_mday;
+}
+
+static void session_add(time_t end, uint32_t secs, const char *activity) {
+  const int date = date_of_time(end);
+  day_add(date, secs, 1);
+
+  /* Spread the session over the hours it ran in, latest first. */
+  time_t t = end;
+  uint32_t left = secs;
+  while (left > 0) {
+    const time_t last = t - 1; /* the last second still in the session */
+    struct tm tmv;
+    localtime_r(&last, &tmv);
+    uint32_t in_hour = (uint32_t)(tmv.tm_min * 60 + tmv.tm_sec + 1);
+    if (in_hour > left)
+      in_hour = left;
+    g.hour_secs[tmv.tm_hour] += in_hour;
+    left -= in_hour;
+    t -= (time_t)in_hour;
+  }
+
+  Activity *a = activity_get(activity && activity[0] ? activity
+                                                     : "unspecified",
+                             true);
+  if (a) {
+    a->secs += secs;
+    a->sessions++;
+    series_add(&a->months, month_index(date), secs);
+    g.act_unsorted = true;
+  }
+}
+
+static void journal_close(void) {
+  if (g.journal)
+    fclose(g.journal);
+  g.journal = NULL;
+}
+
+static void journal_path(char *out, size_t cap) {
+  snprintf(out, cap, "%s.journal", g.path);
+}
+
+/* Appends one session; false if it could not be written. */
+static bool journal_add(time_t end, uint32_t secs, const char *activity) {
+  if (!g.path[0])
+    return false;
+  if (!g.journal) {
+    char path[PATH_MAX + 16];
+    journal_path(path, sizeof(path));
+    g.journal = fopen(path, "a");
+    if (!g.journal)
+      return false;
+    if (ftell(g.journal) == 0)
+      fprintf(g.journal, "%s %d\n", STATS_JOURNAL_HEADER, g.journal_gen);
+  }
+  fprintf(g.journal, "add %lld %u\t%s\n", (long long)end, (unsigned)secs,
+          activity ? activity : "");
+  return fflush(g.journal) == 0;
+}
+
+/* Replays the journal of the current generation; any other is removed. */
+static void journal_replay(void) {
+  char path[PATH_MAX + 16];
+  journal_path(path, sizeof(path));
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return;
+  char line[512];
+  int gen = -1;
+  const size_t hlen = strlen(STATS_JOURNAL_HEADER);
+  if (fgets(line, sizeof(line), f) &&
+      strncmp(line, STATS_JOURNAL_HEADER, hlen) == 0)
+    gen = atoi(line + hlen);
+  if (gen != g.journal_gen) {
+    fclose(f);
+    remove(path);
+    return;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = 0;
+    long long end = 0;
+    unsigned int secs = 0;
+    char *tab = strchr(line, '\t');
+    if (tab && sscanf(line, "add %lld %u", &end, &secs) == 2 && secs > 0) {
+      session_add((time_t)end, secs, tab + 1);
+      g.dirty = true;
+    }
+  }
+  fclose(f);
+}
+
+void stats_engine_add(time_t end, uint32_t secs, const char *activity) {
+  if (secs == 0)
+    return;
+  session_add(end, secs, activity);
+  /* Journaled, the state file can wait for the next save; if not, it
+   * stays dirty and that save still has it. */
+  journal_add(end, secs, activity);
+}
+
+void stats_engine_seed_day(int date, uint32_t secs) {
+  if (date > 0 && secs > 0)
+    day_add(date, secs, 0);
+}
+
+void stats_engine_seed_activity(const char *name, uint64_t secs) {
+  if (!name || !name[0] || secs == 0)
+    return;
+  Activity *a = activity_get(name, true);
+  if (!a)
+    return;
+  a->secs += secs;
+  g.act_unsorted = true;
+  g.dirty = true;
+}
+
+void stats_engine_remove_activity(const char *name) {
+  if (!name)
+    return;
+  Activity *a = activity_get(name, false);
+  if (!a)
+    return;
+  const int i = (int)(a - g.acts);
+  series_free(&a->months);
+  memmove(&g.acts[i], &g.acts[i + 1],
+          sizeof(Activity) * (size_t)(g.act_count - i - 1));
+  g.act_count--;
+  slots_rebuild(g.slot_cap);
+  g.dirty = true;
+}
+
+/* ---- Queries ---- */
+
+bool stats_engine_empty(void) {
+  return g.day_secs.count == 0 && g.act_count == 0;
+}
+
+void stats_engine_summary(int today, StatsSummary *out) {
+  if (!out)
+    return;
+  memset(out, 0, sizeof(*out));
+  const int day = day_number(today);
+  out->current_streak =
+      (g.run > 0 && (g.last_day == day || g.last_day == day - 1)) ? g.run : 0;
+  out->longest_streak = g.longest;
+  for (int i = 0; i < g.day_secs.count; i++)
+    out->active_days += g.day_secs.v[i] != 0;
+  out->today_secs = series_get(&g.day_secs, day);
+  out->week_secs = series_get(&g.week_secs, week_of_day(day));
+  out->last_week_secs = series_get(&g.week_secs, week_of_day(day) - 1);
+  out->month_secs = series_get(&g.month_secs, month_index(today));
+  out->last_month_secs = series_get(&g.month_secs, month_index(today) - 1);
+  out->best_day_secs = series_get(&g.day_secs, g.best_day);
+  out->best_day_date = out->best_day_secs ? date_of_day(g.best_day) : 0;
+}
+
+void stats_engine_hours(uint64_t out[24]) {
+  memcpy(out, g.hour_secs, sizeof(g.hour_secs));
+}
+
+uint64_t stats_engine_month(int month) {
+  return series_get(&g.month_secs, month_index(month * 100 + 1));
+}
+
+int stats_engine_activities(StatsActivity *out, int max) {
+  if (!out || max <= 0)
+    return 0;
+  activities_sort();
+  const int n = g.act_count < max ? g.act_count : max;
+  for (int i = 0; i < n; i++) {
+    out[i].name = g.acts[i].name;
+    out[i].secs = g.acts[i].secs;
+    out[i].sessions = g.acts[i].sessions;
+  }
+  return n;
+}
+
+int stats_engine_activity_count(void) { return g.act_count; }
+
+uint64_t stats_engine_activity_month(const char *name, int month) {
+  const Activity *a = name ? activity_get(name, false) : NULL;
+  return a ? series_get(&a->months, month_index(month * 100 + 1)) : 0;
+}
+
+/* ---- Persistence ---- */
+
+void stats_engine_load(const char *path) {
+  stats_engine_free();
+  safe_snprintf(g.path, sizeof(g.path), "%s", path ? path : "");
+  FILE *f = g.path[0] ? fopen(g.path, "r") : NULL;
+  if (!f) {
+    journal_replay(); /* sessions from before the first save */
+    return;
+  }
+  static char line[8192];
+  if (!fgets(line, sizeof(line), f) ||
+      strncmp(line, STATS_HEADER, strlen(STATS_HEADER)) != 0) {
+    fclose(f);
+    return;
+  }
+  int longest = 0;
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = 0;
+    if (strncmp(line, "hours ", 6) == 0) {
+      const char *p = line + 6;
+      for (int h = 0; h < 24; h++) {
+        char *end;
+        g.hour_secs[h] = strtoull(p, &end, 10);
+        p = end;
+      }
+    } else if (strncmp(line, "longest ", 8) == 0) {
+      longest = atoi(line + 8);
+    } else if (strncmp(line, "journal ", 8) == 0) {
+      g.journal_gen = atoi(line + 8);
+    } else if (strncmp(line, "day ", 4) == 0) {
+      int date = 0;
+      unsigned long long secs = 0;
+      unsigned int sessions = 0;
+      if (sscanf(line + 4, "%d %llu %u", &date, &secs, &sessions) == 3)
+        day_add(date, secs, sessions);
+    } else if (strncmp(line, "act ", 4) == 0) {
+      /* act <secs> <sessions> <first month> <count> <values...><TAB>name */
+      char *tab = strchr(line, '\t');
+      unsigned long long secs = 0;
+      unsigned int sessions = 0;
+      int first = 0, count = 0, n = 0;
+      if (!tab || sscanf(line + 4, "%llu %u %d %d%n", &secs, &sessions,
+                         &first, &count, &n) != 4)
+        continue;
+      Activity *a = activity_get(tab + 1, true);
+      if (!a)
+        continue;
+      a->secs = secs;
+      a->sessions = sessions;
+      const char *p = line + 4 + n;
+      for (int i = 0; i < count && p < tab; i++) {
+        char *end;
+        const uint64_t v = strtoull(p, &end, 10);
+        if (end == p)
+          break;
+        if (v)
+          series_add(&a->months, first + i, v);
+        p = end;
+      }
+      g.act_unsorted = true;
+    }
+  }
+  fclose(f);
+  /* day_add rebuilt the streaks from the days. The saved longest also
+   * counts runs it skipped, such as days before a clock jump back. */
+  if (longest > g.longest)
+    g.longest = longest;
+  g.dirty = false;
+  journal_replay();
+}
+
+void stats_engine_save(void) {
+  if (!g.dirty || !g.path[0])
+    return;
+  char tmp[PATH_MAX + 4];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", g.path);
+  FILE *f = fopen(tmp, "w");
+  if (!f)
+    return;
+  fprintf(f, "%s\nhours", STATS_HEADER);
+  for (int h = 0; h < 24; h++)
+    fprintf(f, " %llu", (unsigned long long)g.hour_secs[h]);
+  fprintf(f, "\nlongest %d\njournal %d\n", g.longest, g.journal_gen + 1);
+  for (int i = 0; i < g.day_secs.count; i++) {
+    const uint64_t sessions =
+        series_get(&g.day_sessions, g.day_secs.first + i);
+    if (g.day_secs.v[i] || sessions)
+      fprintf(f, "day %d %llu %llu\n", date_of_day(g.day_secs.first + i),
+              (unsigned long long)g.day_secs.v[i],
+              (unsigned long long)sessions);
+  }
+  for (int i = 0; i < g.act_count; i++) {
+    const Activity *a = &g.acts[i];
+    fprintf(f, "act %llu %u %d %d", (unsigned long long)a->secs, a->sessions,
+            a->months.first, a->months.count);
+    for (int m = 0; m < a->months.count; m++)
+      fprintf(f, " %llu", (unsigned long long)a->months.v[m]);
+    fprintf(f, "\t%s\n", a->name);
+  }
+  const bool ok = fclose(f) == 0;
+  if (!ok || rename(tmp, g.path) != 0) {
+    remove(tmp);
+    return;
+  }
+  g.dirty = false;
+  /* The journal is folded in; the state file now points past it. */
+  journal_close();
+  char path[PATH_MAX + 16];
+  journal_path(path, sizeof(path));
+  remove(path);
+  g.journal_gen++;
+}
+
+void stats_engine_free(void) {
+  journal_close();
+  series_free(&g.day_secs);
+  series_free(&g.day_sessions);
+  series_free(&g.week_secs);
+  series_free(&g.month_secs);
+  for (int i = 0; i < g.act_count; i++)
+    series_free(&g.acts[i].months);
+  free(g.acts);
+  free(g.slots);
+  memset(&g, 0, sizeof(g));
+}
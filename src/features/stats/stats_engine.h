@@ -0,0 +1,72 @@
+#ifndef STATS_ENGINE_H
+#define STATS_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Focus statistics kept up to date per awarded session, so the stats pages
+ * never scan the logs.
+ *
+ * Seconds and sessions are kept per day, with weekly (Monday-first) and
+ * monthly totals beside them, per hour of the day, and per activity with a
+ * monthly series each. Activities live in a hash map, however many there
+ * are, and are sorted by total only when the top ones are asked for.
+ * Adding a session touches a fixed number of counters, plus one per hour it
+ * spans, and appends one line to a journal beside the state file.
+ *
+ * The state is saved to a small text file, which folds the journal in;
+ * weeks, months and the best day are rebuilt from the days when it is
+ * loaded, and the journal is replayed over it. Dates are YYYYMMDD ints and
+ * months YYYYMM, in local time.
+ */
+
+typedef struct StatsSummary {
+  int current_streak; /* days in a row up to today or yesterday */
+  int longest_streak;
+  int active_days;
+  uint64_t today_secs;
+  uint64_t week_secs; /* this week so far */
+  uint64_t last_week_secs;
+  uint64_t month_secs; /* this month so far */
+  uint64_t last_month_secs;
+  uint64_t best_day_secs;
+  int best_day_date;
+} StatsSummary;
+
+typedef struct StatsActivity {
+  const char *name; /* valid until the next add or remove */
+  uint64_t secs;
+  uint32_t sessions;
+} StatsActivity;
+
+void stats_engine_load(const char *path);
+/* Writes the state back if it changed since it was loaded or saved, and
+ * drops the journal. Sessions are journaled as they are added, so this is
+ * only needed on shutdown and after seeding or removing. */
+void stats_engine_save(void);
+void stats_engine_free(void);
+/* True if nothing has been recorded (e.g. no state file yet). */
+bool stats_engine_empty(void);
+
+/* A session of secs that ended at end. */
+void stats_engine_add(time_t end, uint32_t secs, const char *activity);
+/* Seeding from totals that predate the engine: no sessions, no hours. */
+void stats_engine_seed_day(int date, uint32_t secs);
+void stats_engine_seed_activity(const char *name, uint64_t secs);
+void stats_engine_remove_activity(const char *name);
+
+void stats_engine_summary(int today, StatsSummary *out);
+void stats_engine_hours(uint64_t out[24]);
+uint64_t stats_engine_month(int month);
+/* The top activities by total, largest first; returns how many. */
+int stats_engine_activities(StatsActivity *out, int max);
+int stats_engine_activity_count(void);
+/* Seconds of one activity in month, 0 if unknown. */
+uint64_t stats_engine_activity_month(const char *name, int month);
+
+/* month (YYYYMM) n months before. */
+int stats_month_minus(int month, int n);
+
+#endif // STATS_ENGINE_H
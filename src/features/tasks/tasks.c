@@ -697,7 +697,7 @@ void draw_tasks_list(UI *ui, App *a) {
 
     if (done) {
       int w = text_width(ui->font_small, txt);
-      int x = CIRCLE_LAYOUT_CX - w / 2;
+      int x = CIRCLE_LAYOUT_CX(ui) - w / 2;
       /* Get band Y for strikethrough positioning */
       int th = TTF_FontHeight(ui->font_small);
       /* Approximate y from band - bands are centered around CIRCLE_LAYOUT_CY */
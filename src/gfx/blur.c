@@ -0,0 +1,468 @@
+#include "blur.h"
+
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GFX_BLUR_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GFX_BLUR_NEON 1
+#endif
+
+#define GFX_BLUR_MAX_THREADS 4        /* row/column bands per pass */
+#define GFX_BLUR_MT_MIN_PIXELS 65536  /* smaller images stay on one thread */
+#define GFX_BLUR_MIN_BAND 16          /* pixels per band, either axis */
+#define GFX_BLUR_TABLES 4             /* (length, radius) edge tables kept */
+
+/*
+ * Edge tables for one line length and radius. After output i the window
+ * slides by adding sample add[i] and dropping sample sub[i]; both are
+ * clamped to the line, which repeats the edge pixels. The box average is
+ * ((sum + half) * mul) >> 16 with mul = 65536 / (2r + 1); the sum of
+ * 2r + 1 bytes fits in 16 bits for radii up to GFX_BLUR_MAX_RADIUS, so
+ * the whole kernel runs on 16-bit lanes.
+ */
+typedef struct {
+  int len;
+  int radius;
+  unsigned last_use;
+  uint16_t mul;
+  uint16_t half;
+  int cap;
+  int32_t *add;
+  int32_t *sub;
+} EdgeTable;
+
+typedef struct {
+  struct GfxBlur *b;
+  int band;
+  unsigned start_seq; /* job_seq when started: jobs up to it are not its */
+} Worker;
+
+struct GfxBlur {
+  uint32_t *plane[2]; /* transposed and intermediate copies */
+  size_t plane_px;
+  uint16_t *acc; /* GFX_BLUR_MAX_THREADS accumulator rows */
+  size_t acc_stride;
+  EdgeTable tables[GFX_BLUR_TABLES];
+  unsigned use_clock;
+  /* Helper threads for bands 1.., started on the first threaded blur and
+     kept until gfx_blur_destroy. lock and cond guard the fields below and
+     the band barrier. */
+  SDL_mutex *lock;
+  SDL_cond *cond;
+  SDL_Thread *threads[GFX_BLUR_MAX_THREADS];
+  Worker workers[GFX_BLUR_MAX_THREADS];
+  int worker_count;
+  struct Job *job; /* the blur in progress */
+  unsigned job_seq; /* bumped per threaded blur */
+  int done;         /* workers finished with job_seq */
+  bool quit;
+};
+
+GfxBlur *gfx_blur_create(void) {
+  return (GfxBlur *)calloc(1, sizeof(GfxBlur));
+}
+
+void gfx_blur_destroy(GfxBlur *b) {
+  if (!b)
+    return;
+  if (b->worker_count > 0) {
+    SDL_LockMutex(b->lock);
+    b->quit = true;
+    SDL_CondBroadcast(b->cond);
+    SDL_UnlockMutex(b->lock);
+    for (int i = 1; i <= b->worker_count; i++)
+      SDL_WaitThread(b->threads[i], NULL);
+  }
+  free(b->plane[0]);
+  free(b->plane[1]);
+  free(b->acc);
+  for (int i = 0; i < GFX_BLUR_TABLES; i++) {
+    free(b->tables[i].add);
+    free(b->tables[i].sub);
+  }
+  if (b->cond)
+    SDL_DestroyCond(b->cond);
+  if (b->lock)
+    SDL_DestroyMutex(b->lock);
+  free(b);
+}
+
+static bool arena_reserve(GfxBlur *b, int w, int h) {
+  const size_t px = (size_t)w * (size_t)h;
+  if (px > b->plane_px) {
+    for (int i = 0; i < 2; i++) {
+      free(b->plane[i]);
+      b->plane[i] = (uint32_t *)malloc(px * sizeof(uint32_t));
+    }
+    if (!b->plane[0] || !b->plane[1]) {
+      free(b->plane[0]);
+      free(b->plane[1]);
+      b->plane[0] = b->plane[1] = NULL;
+      b->plane_px = 0;
+      return false;
+    }
+    b->plane_px = px;
+  }
+  const size_t stride = (size_t)(w > h ? w : h) * 4;
+  if (stride > b->acc_stride) {
+    free(b->acc);
+    b->acc = (uint16_t *)malloc(stride * GFX_BLUR_MAX_THREADS *
+                                sizeof(uint16_t));
+    b->acc_stride = b->acc ? stride : 0;
+    if (!b->acc)
+      return false;
+  }
+  return true;
+}
+
+static const EdgeTable *edge_table(GfxBlur *b, int len, int radius) {
+  EdgeTable *t = NULL;
+  for (int i = 0; i < GFX_BLUR_TABLES; i++) {
+    EdgeTable *c = &b->tables[i];
+    if (c->len == len && c->radius == radius) {
+      c->last_use = ++b->use_clock;
+      return c;
+    }
+    if (!t || c->last_use < t->last_use)
+      t = c;
+  }
+
+  if (t->cap < len) {
+    free(t->add);
+    free(t->sub);
+    t->add = (int32_t *)malloc((size_t)len * sizeof(int32_t));
+    t->sub = (int32_t *)malloc((size_t)len * sizeof(int32_t));
+    if (!t->add || !t->sub) {
+      free(t->add);
+      free(t->sub);
+      memset(t, 0, sizeof(*t));
+      return NULL;
+    }
+    t->cap = len;
+  }
+  const int d = 2 * radius + 1;
+  t->len = len;
+  t->radius = radius;
+  t->last_use = ++b->use_clock;
+  t->mul = (uint16_t)(65536 / d);
+  t->half = (uint16_t)(d / 2);
+  for (int i = 0; i < len; i++) {
+    const int a = i + radius + 1;
+    const int s = i - radius;
+    t->add[i] = a < len ? a : len - 1;
+    t->sub[i] = s > 0 ? s : 0;
+  }
+  return t;
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* Emits one output line from the window sums, then slides the window. */
+static void box_line(uint16_t *acc, uint8_t *out, const uint8_t *add,
+                     const uint8_t *sub, int n, uint16_t mul, uint16_t half) {
+  int i = 0;
+#if defined(GFX_BLUR_SSE2)
+  const __m128i vmul = _mm_set1_epi16((short)mul);
+  const __m128i vhalf = _mm_set1_epi16((short)half);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i lo = _mm_loadu_si128((const __m128i *)(acc + i));
+    __m128i hi = _mm_loadu_si128((const __m128i *)(acc + i + 8));
+    const __m128i olo = _mm_mulhi_epu16(_mm_add_epi16(lo, vhalf), vmul);
+    const __m128i ohi = _mm_mulhi_epu16(_mm_add_epi16(hi, vhalf), vmul);
+    _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(olo, ohi));
+    const __m128i a = _mm_loadu_si128((const __m128i *)(add + i));
+    const __m128i s = _mm_loadu_si128((const __m128i *)(sub + i));
+    lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(a, zero));
+    hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(a, zero));
+    lo = _mm_sub_epi16(lo, _mm_unpacklo_epi8(s, zero));
+    hi = _mm_sub_epi16(hi, _mm_unpackhi_epi8(s, zero));
+    _mm_storeu_si128((__m128i *)(acc + i), lo);
+    _mm_storeu_si128((__m128i *)(acc + i + 8), hi);
+  }
+#elif defined(GFX_BLUR_NEON)
+  const uint16x4_t vmul = vdup_n_u16(mul);
+  const uint16x8_t vhalf = vdupq_n_u16(half);
+  for (; i + 16 <= n; i += 16) {
+    uint16x8_t lo = vld1q_u16(acc + i);
+    uint16x8_t hi = vld1q_u16(acc + i + 8);
+    const uint16x8_t rlo = vaddq_u16(lo, vhalf);
+    const uint16x8_t rhi = vaddq_u16(hi, vhalf);
+    const uint16x8_t olo =
+        vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(rlo), vmul), 16),
+                     vshrn_n_u32(vmull_u16(vget_high_u16(rlo), vmul), 16));
+    const uint16x8_t ohi =
+        vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(rhi), vmul), 16),
+                     vshrn_n_u32(vmull_u16(vget_high_u16(rhi), vmul), 16));
+    vst1q_u8(out + i, vcombine_u8(vmovn_u16(olo), vmovn_u16(ohi)));
+    const uint8x16_t a = vld1q_u8(add + i);
+    const uint8x16_t s = vld1q_u8(sub + i);
+    lo = vsubw_u8(vaddw_u8(lo, vget_low_u8(a)), vget_low_u8(s));
+    hi = vsubw_u8(vaddw_u8(hi, vget_high_u8(a)), vget_high_u8(s));
+    vst1q_u16(acc + i, lo);
+    vst1q_u16(acc + i + 8, hi);
+  }
+#endif
+  for (; i < n; i++) {
+    out[i] = (uint8_t)(((uint32_t)(acc[i] + half) * mul) >> 16);
+    acc[i] = (uint16_t)(acc[i] + add[i] - sub[i]);
+  }
+}
+
+/* Box-blurs bytes [b0, b1) of every line down the columns of src into dst. */
+static void box_columns(const uint8_t *src, size_t src_pitch, uint8_t *dst,
+                        size_t dst_pitch, int b0, int b1, const EdgeTable *t,
+                        uint16_t *acc) {
+  const int n = b1 - b0;
+  if (n <= 0)
+    return;
+  src += b0;
+  dst += b0;
+  memset(acc, 0, (size_t)n * sizeof(uint16_t));
+  for (int k = -t->radius; k <= t->radius; k++) {
+    const int y = k < 0 ? 0 : (k < t->len ? k : t->len - 1);
+    const uint8_t *row = src + (size_t)y * src_pitch;
+    for (int i = 0; i < n; i++)
+      acc[i] = (uint16_t)(acc[i] + row[i]);
+  }
+  for (int y = 0; y < t->len; y++) {
+    box_line(acc, dst + (size_t)y * dst_pitch,
+             src + (size_t)t->add[y] * src_pitch,
+             src + (size_t)t->sub[y] * src_pitch, n, t->mul, t->half);
+  }
+}
+
+/* Writes rows [y0, y1) of src (w pixels wide) as columns of dst. */
+static void transpose_rows(const uint32_t *src, int src_stride, uint32_t *dst,
+                           int dst_stride, int w, int y0, int y1) {
+  int y = y0;
+#if defined(GFX_BLUR_SSE2) || defined(GFX_BLUR_NEON)
+  for (; y + 4 <= y1; y += 4) {
+    const uint32_t *s = src + (size_t)y * src_stride;
+    int x = 0;
+    for (; x + 4 <= w; x += 4) {
+      uint32_t *d = dst + (size_t)x * dst_stride + y;
+#if defined(GFX_BLUR_SSE2)
+      const __m128i r0 = _mm_loadu_si128((const __m128i *)(s + x));
+      const __m128i r1 = _mm_loadu_si128((const __m128i *)(s + src_stride + x));
+      const __m128i r2 =
+          _mm_loadu_si128((const __m128i *)(s + 2 * src_stride + x));
+      const __m128i r3 =
+          _mm_loadu_si128((const __m128i *)(s + 3 * src_stride + x));
+      const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+      const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+      const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+      const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+      _mm_storeu_si128((__m128i *)d, _mm_unpacklo_epi64(t0, t1));
+      _mm_storeu_si128((__m128i *)(d + dst_stride),
+                       _mm_unpackhi_epi64(t0, t1));
+      _mm_storeu_si128((__m128i *)(d + 2 * dst_stride),
+                       _mm_unpacklo_epi64(t2, t3));
+      _mm_storeu_si128((__m128i *)(d + 3 * dst_stride),
+                       _mm_unpackhi_epi64(t2, t3));
+#else
+      const uint32x4x2_t t01 =
+          vtrnq_u32(vld1q_u32(s + x), vld1q_u32(s + src_stride + x));
+      const uint32x4x2_t t23 = vtrnq_u32(vld1q_u32(s + 2 * src_stride + x),
+                                         vld1q_u32(s + 3 * src_stride + x));
+      vst1q_u32(d, vcombine_u32(vget_low_u32(t01.val[0]),
+                                vget_low_u32(t23.val[0])));
+      vst1q_u32(d + dst_stride, vcombine_u32(vget_low_u32(t01.val[1]),
+                                             vget_low_u32(t23.val[1])));
+      vst1q_u32(d + 2 * dst_stride, vcombine_u32(vget_high_u32(t01.val[0]),
+                                                 vget_high_u32(t23.val[0])));
+      vst1q_u32(d + 3 * dst_stride, vcombine_u32(vget_high_u32(t01.val[1]),
+                                                 vget_high_u32(t23.val[1])));
+#endif
+    }
+    for (; x < w; x++) {
+      for (int k = 0; k < 4; k++)
+        dst[(size_t)x * dst_stride + y + k] = s[(size_t)k * src_stride + x];
+    }
+  }
+#endif
+  for (; y < y1; y++) {
+    const uint32_t *s = src + (size_t)y * src_stride;
+    for (int x = 0; x < w; x++)
+      dst[(size_t)x * dst_stride + y] = s[x];
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+typedef struct Job {
+  GfxBlur *b;
+  uint32_t *pix;
+  int w, h, stride;
+  int passes;
+  const EdgeTable *rows; /* along x: length w */
+  const EdgeTable *cols; /* along y: length h */
+  int bands;
+  int waiting;
+  unsigned generation;
+} Job;
+
+static void band_sync(Job *j) {
+  if (j->bands < 2)
+    return;
+  SDL_LockMutex(j->b->lock);
+  const unsigned gen = j->generation;
+  if (++j->waiting == j->bands) {
+    j->waiting = 0;
+    j->generation++;
+    SDL_CondBroadcast(j->b->cond);
+  } else {
+    while (gen == j->generation)
+      SDL_CondWait(j->b->cond, j->b->lock);
+  }
+  SDL_UnlockMutex(j->b->lock);
+}
+
+static void span(int n, int band, int bands, int *lo, int *hi) {
+  *lo = (int)((long long)n * band / bands);
+  *hi = (int)((long long)n * (band + 1) / bands);
+}
+
+/*
+ * One band's share of every pass. Each pass transposes the image into
+ * plane 0, blurs its columns (the image's rows) into plane 1, transposes
+ * back into plane 0 and blurs the columns into pix. Bands own disjoint
+ * rows or columns of each step and meet at a barrier in between.
+ */
+static void run_band(Job *j, int band) {
+  GfxBlur *b = j->b;
+  uint32_t *tp = b->plane[0];
+  uint32_t *mid = b->plane[1];
+  uint16_t *acc = b->acc + (size_t)band * b->acc_stride;
+  const int w = j->w, h = j->h;
+  int y0, y1, x0, x1;
+  span(h, band, j->bands, &y0, &y1);
+  span(w, band, j->bands, &x0, &x1);
+
+  for (int p = 0; p < j->passes; p++) {
+    transpose_rows(j->pix, j->stride, tp, h, w, y0, y1);
+    band_sync(j);
+    box_columns((const uint8_t *)tp, (size_t)h * 4, (uint8_t *)mid,
+                (size_t)h * 4, y0 * 4, y1 * 4, j->rows, acc);
+    band_sync(j);
+    transpose_rows(mid, h, tp, w, h, x0, x1);
+    band_sync(j);
+    box_columns((const uint8_t *)tp, (size_t)w * 4, (uint8_t *)j->pix,
+                (size_t)j->stride * 4, x0 * 4, x1 * 4, j->cols, acc);
+    band_sync(j);
+  }
+}
+
+/* A pool worker: runs its band of each job, if the job has that many. */
+static int band_thread(void *userdata) {
+  Worker *wk = (Worker *)userdata;
+  GfxBlur *b = wk->b;
+  unsigned seen = wk->start_seq;
+  SDL_LockMutex(b->lock);
+  for (;;) {
+    while (!b->quit && b->job_seq == seen)
+      SDL_CondWait(b->cond, b->lock);
+    if (b->quit)
+      break;
+    seen = b->job_seq;
+    Job *j = b->job;
+    SDL_UnlockMutex(b->lock);
+    if (wk->band < j->bands)
+      run_band(j, wk->band);
+    SDL_LockMutex(b->lock);
+    b->done++;
+    SDL_CondBroadcast(b->cond);
+  }
+  SDL_UnlockMutex(b->lock);
+  return 0;
+}
+
+/* Starts helpers until there are want - 1 of them; returns how many run. */
+static int pool_reserve(GfxBlur *b, int want) {
+  while (b->worker_count < want - 1) {
+    const int i = b->worker_count + 1;
+    b->workers[i].b = b;
+    b->workers[i].band = i;
+    b->workers[i].start_seq = b->job_seq;
+    b->threads[i] = SDL_CreateThread(band_thread, "gfx_blur", &b->workers[i]);
+    if (!b->threads[i])
+      break;
+    b->worker_count = i;
+  }
+  return b->worker_count;
+}
+
+static int band_count(GfxBlur *b, int w, int h) {
+  if ((long long)w * h < GFX_BLUR_MT_MIN_PIXELS)
+    return 1;
+  int n = SDL_GetCPUCount();
+  if (n > GFX_BLUR_MAX_THREADS)
+    n = GFX_BLUR_MAX_THREADS;
+  while (n > 1 && (w < n * GFX_BLUR_MIN_BAND || h < n * GFX_BLUR_MIN_BAND))
+    n--;
+  if (n > 1 && !b->lock) {
+    b->lock = SDL_CreateMutex();
+    b->cond = SDL_CreateCond();
+  }
+  return (b->lock && b->cond) ? n : 1;
+}
+
+bool gfx_blur_rgba(GfxBlur *b, uint32_t *pix, int w, int h, int stride_px,
+                   int radius, int passes) {
+  if (!b || !pix || w <= 0 || h <= 0 || stride_px < w)
+    return false;
+  if (radius > GFX_BLUR_MAX_RADIUS)
+    radius = GFX_BLUR_MAX_RADIUS;
+  if (radius < 1 || passes < 1)
+    return true;
+  if (!arena_reserve(b, w, h))
+    return false;
+
+  Job j;
+  memset(&j, 0, sizeof(j));
+  j.b = b;
+  j.pix = pix;
+  j.w = w;
+  j.h = h;
+  j.stride = stride_px;
+  j.passes = passes;
+  j.rows = edge_table(b, w, radius);
+  j.cols = edge_table(b, h, radius);
+  if (!j.rows || !j.cols)
+    return false;
+
+  const int want = band_count(b, w, h);
+  if (want < 2) {
+    j.bands = 1;
+    run_band(&j, 0);
+    return true;
+  }
+
+  /* Every pool worker takes the job; those past j.bands just report done. */
+  const int helpers = pool_reserve(b, want);
+  j.bands = (helpers + 1 < want ? helpers + 1 : want);
+  if (helpers == 0) {
+    run_band(&j, 0);
+    return true;
+  }
+  SDL_LockMutex(b->lock);
+  b->job = &j;
+  b->done = 0;
+  b->job_seq++;
+  SDL_CondBroadcast(b->cond);
+  SDL_UnlockMutex(b->lock);
+
+  run_band(&j, 0);
+
+  SDL_LockMutex(b->lock);
+  while (b->done < helpers)
+    SDL_CondWait(b->cond, b->lock);
+  b->job = NULL;
+  SDL_UnlockMutex(b->lock);
+  return true;
+}
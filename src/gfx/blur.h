@@ -0,0 +1,33 @@
+#ifndef GFX_BLUR_H
+#define GFX_BLUR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Separable box blur for 32-bit pixels (all four channels, so alpha is
+ * blurred too). Each pass is a horizontal and a vertical box of width
+ * 2 * radius + 1; three passes approximate a Gaussian.
+ *
+ * Rows are handled by transposing into the scratch arena and running the
+ * same vertical kernel (SSE2/NEON, 16 bytes at a time), and large images are
+ * split into bands across threads. The context keeps its helper threads,
+ * scratch planes and per-size edge tables between calls, so repeated blurs
+ * neither allocate nor start threads. A context must only be used by one
+ * caller at a time.
+ */
+
+#define GFX_BLUR_MAX_RADIUS 64
+
+typedef struct GfxBlur GfxBlur;
+
+GfxBlur *gfx_blur_create(void);
+void gfx_blur_destroy(GfxBlur *b);
+
+/* Blurs pix (w x h, stride_px pixels per row) in place. radius is clamped to
+ * GFX_BLUR_MAX_RADIUS. Returns false, leaving pix untouched, if scratch
+ * memory could not be allocated. */
+bool gfx_blur_rgba(GfxBlur *b, uint32_t *pix, int w, int h, int stride_px,
+                   int radius, int passes);
+
+#endif
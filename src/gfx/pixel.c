@@ -0,0 +1,349 @@
+#include "pixel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GFX_PIXEL_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GFX_PIXEL_NEON 1
+#endif
+
+static bool g_simd = true;
+
+bool gfx_pixel_set_simd(bool on) {
+  const bool old = g_simd;
+  g_simd = on;
+  return old;
+}
+
+const char *gfx_pixel_simd_name(void) {
+#if defined(GFX_PIXEL_SSE2)
+  return g_simd ? "sse2" : "scalar";
+#elif defined(GFX_PIXEL_NEON)
+  return g_simd ? "neon" : "scalar";
+#else
+  return "scalar";
+#endif
+}
+
+/* Rounded x / 255 for x <= 255 * 255. */
+static inline uint32_t div255(uint32_t x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+#if defined(GFX_PIXEL_SSE2)
+static inline __m128i div255_epu16(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/* Each pixel's alpha copied to its four 16-bit lanes. */
+static inline __m128i alpha_epu16(__m128i px16) {
+  px16 = _mm_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_shufflehi_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Four pixels times per-lane 8-bit factors (as 16-bit lanes), / 255. */
+static inline __m128i scale4(__m128i px, __m128i f_lo, __m128i f_hi) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = _mm_unpacklo_epi8(px, zero);
+  const __m128i hi = _mm_unpackhi_epi8(px, zero);
+  return _mm_packus_epi16(div255_epu16(_mm_mullo_epi16(lo, f_lo)),
+                          div255_epu16(_mm_mullo_epi16(hi, f_hi)));
+}
+#elif defined(GFX_PIXEL_NEON)
+static inline uint8x8_t div255_u16(uint16x8_t x) {
+  return vrshrn_n_u16(vrsraq_n_u16(x, x, 8), 8);
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+
+/* col[i] += row[i] for n bytes. */
+static void add_row(uint32_t *col, const uint8_t *row, int n) {
+  int i = 0;
+  if (g_simd) {
+#if defined(GFX_PIXEL_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+      const __m128i b = _mm_loadu_si128((const __m128i *)(row + i));
+      const __m128i lo = _mm_unpacklo_epi8(b, zero);
+      const __m128i hi = _mm_unpackhi_epi8(b, zero);
+      __m128i *c = (__m128i *)(col + i);
+      _mm_storeu_si128(c + 0, _mm_add_epi32(_mm_loadu_si128(c + 0),
+                                            _mm_unpacklo_epi16(lo, zero)));
+      _mm_storeu_si128(c + 1, _mm_add_epi32(_mm_loadu_si128(c + 1),
+                                            _mm_unpackhi_epi16(lo, zero)));
+      _mm_storeu_si128(c + 2, _mm_add_epi32(_mm_loadu_si128(c + 2),
+                                            _mm_unpacklo_epi16(hi, zero)));
+      _mm_storeu_si128(c + 3, _mm_add_epi32(_mm_loadu_si128(c + 3),
+                                            _mm_unpackhi_epi16(hi, zero)));
+    }
+#elif defined(GFX_PIXEL_NEON)
+    for (; i + 16 <= n; i += 16) {
+      const uint8x16_t b = vld1q_u8(row + i);
+      const uint16x8_t lo = vmovl_u8(vget_low_u8(b));
+      const uint16x8_t hi = vmovl_u8(vget_high_u8(b));
+      uint32_t *c = col + i;
+      vst1q_u32(c + 0, vaddw_u16(vld1q_u32(c + 0), vget_low_u16(lo)));
+      vst1q_u32(c + 4, vaddw_u16(vld1q_u32(c + 4), vget_high_u16(lo)));
+      vst1q_u32(c + 8, vaddw_u16(vld1q_u32(c + 8), vget_low_u16(hi)));
+      vst1q_u32(c + 12, vaddw_u16(vld1q_u32(c + 12), vget_high_u16(hi)));
+    }
+#endif
+  }
+  for (; i < n; i++)
+    col[i] += row[i];
+}
+
+/* Channel sums of column sums [x0, x1), in byte order B, G, R, A. */
+static void sum_block(const uint32_t *col, int x0, int x1, uint32_t s[4]) {
+  int x = x0;
+  s[0] = s[1] = s[2] = s[3] = 0;
+  if (g_simd) {
+#if defined(GFX_PIXEL_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; x < x1; x++)
+      acc = _mm_add_epi32(acc, _mm_loadu_si128((const __m128i *)(col + x * 4)));
+    _mm_storeu_si128((__m128i *)s, acc);
+#elif defined(GFX_PIXEL_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; x < x1; x++)
+      acc = vaddq_u32(acc, vld1q_u32(col + x * 4));
+    vst1q_u32(s, acc);
+#endif
+  }
+  for (; x < x1; x++) {
+    s[0] += col[x * 4 + 0];
+    s[1] += col[x * 4 + 1];
+    s[2] += col[x * 4 + 2];
+    s[3] += col[x * 4 + 3];
+  }
+}
+
+bool gfx_downscale_area(const uint32_t *src, int sw, int sh, int src_stride,
+                        uint32_t *dst, int dw, int dh, int dst_stride) {
+  if (!src || !dst || sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0)
+    return false;
+  uint32_t *col = (uint32_t *)malloc((size_t)sw * 4 * sizeof(uint32_t));
+  if (!col)
+    return false;
+
+  for (int dy = 0; dy < dh; dy++) {
+    const int y0 = (int)((long long)dy * sh / dh);
+    int y1 = (int)((long long)(dy + 1) * sh / dh);
+    if (y1 <= y0)
+      y1 = y0 + 1;
+    memset(col, 0, (size_t)sw * 4 * sizeof(uint32_t));
+    for (int y = y0; y < y1; y++)
+      add_row(col, (const uint8_t *)(src + (size_t)y * src_stride), sw * 4);
+
+    uint32_t *out = dst + (size_t)dy * dst_stride;
+    for (int dx = 0; dx < dw; dx++) {
+      const int x0 = (int)((long long)dx * sw / dw);
+      int x1 = (int)((long long)(dx + 1) * sw / dw);
+      if (x1 <= x0)
+        x1 = x0 + 1;
+      uint32_t s[4];
+      sum_block(col, x0, x1, s);
+      /* Rounded s / n as a multiply by a 24-bit reciprocal. */
+      const uint64_t n = (uint64_t)(x1 - x0) * (uint64_t)(y1 - y0);
+      const uint64_t recip = ((1ull << 24) + n / 2) / n;
+      uint32_t px = 0;
+      for (int c = 0; c < 4; c++) {
+        uint64_t v = ((uint64_t)s[c] * recip + (1ull << 23)) >> 24;
+        px |= (uint32_t)(v > 255 ? 255 : v) << (c * 8);
+      }
+      out[dx] = px;
+    }
+  }
+  free(col);
+  return true;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void premultiply_row(uint32_t *p, int w) {
+  int x = 0;
+  if (g_simd) {
+#if defined(GFX_PIXEL_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32((int)0xFF000000u);
+    for (; x + 4 <= w; x += 4) {
+      const __m128i px = _mm_loadu_si128((const __m128i *)(p + x));
+      const __m128i f_lo = alpha_epu16(_mm_unpacklo_epi8(px, zero));
+      const __m128i f_hi = alpha_epu16(_mm_unpackhi_epi8(px, zero));
+      const __m128i rgb = _mm_andnot_si128(amask, scale4(px, f_lo, f_hi));
+      _mm_storeu_si128((__m128i *)(p + x),
+                       _mm_or_si128(rgb, _mm_and_si128(px, amask)));
+    }
+#elif defined(GFX_PIXEL_NEON)
+    for (; x + 16 <= w; x += 16) {
+      uint8x16x4_t v = vld4q_u8((const uint8_t *)(p + x));
+      for (int c = 0; c < 3; c++) {
+        const uint8x8_t lo =
+            div255_u16(vmull_u8(vget_low_u8(v.val[c]), vget_low_u8(v.val[3])));
+        const uint8x8_t hi = div255_u16(
+            vmull_u8(vget_high_u8(v.val[c]), vget_high_u8(v.val[3])));
+        v.val[c] = vcombine_u8(lo, hi);
+      }
+      vst4q_u8((uint8_t *)(p + x), v);
+    }
+#endif
+  }
+  for (; x < w; x++) {
+    const uint32_t c = p[x];
+    const uint32_t a = c >> 24;
+    p[x] = (a << 24) | div255(((c >> 16) & 0xFF) * a) << 16 |
+           div255(((c >> 8) & 0xFF) * a) << 8 | div255((c & 0xFF) * a);
+  }
+}
+
+void gfx_premultiply(uint32_t *pix, int w, int h, int stride) {
+  if (!pix)
+    return;
+  for (int y = 0; y < h; y++)
+    premultiply_row(pix + (size_t)y * stride, w);
+}
+
+void gfx_unpremultiply(uint32_t *pix, int w, int h, int stride) {
+  if (!pix)
+    return;
+  for (int y = 0; y < h; y++) {
+    uint32_t *p = pix + (size_t)y * stride;
+    for (int x = 0; x < w; x++) {
+      const uint32_t c = p[x];
+      const uint32_t a = c >> 24;
+      if (a == 255)
+        continue;
+      if (a == 0) {
+        p[x] = 0;
+        continue;
+      }
+      uint32_t out = a << 24;
+      for (int sh = 0; sh <= 16; sh += 8) {
+        uint32_t v = (((c >> sh) & 0xFF) * 255 + a / 2) / a;
+        out |= (v > 255 ? 255 : v) << sh;
+      }
+      p[x] = out;
+    }
+  }
+}
+
+static void dim_row(uint32_t *p, int w, uint32_t k) {
+  int x = 0;
+  if (g_simd) {
+#if defined(GFX_PIXEL_SSE2)
+    /* Alpha lanes scale by 255/255. */
+    const __m128i f = _mm_set_epi16(255, (short)k, (short)k, (short)k, 255,
+                                    (short)k, (short)k, (short)k);
+    for (; x + 4 <= w; x += 4) {
+      const __m128i px = _mm_loadu_si128((const __m128i *)(p + x));
+      _mm_storeu_si128((__m128i *)(p + x), scale4(px, f, f));
+    }
+#elif defined(GFX_PIXEL_NEON)
+    const uint8x8_t f = vdup_n_u8((uint8_t)k);
+    for (; x + 16 <= w; x += 16) {
+      uint8x16x4_t v = vld4q_u8((const uint8_t *)(p + x));
+      for (int c = 0; c < 3; c++) {
+        const uint8x8_t lo = div255_u16(vmull_u8(vget_low_u8(v.val[c]), f));
+        const uint8x8_t hi = div255_u16(vmull_u8(vget_high_u8(v.val[c]), f));
+        v.val[c] = vcombine_u8(lo, hi);
+      }
+      vst4q_u8((uint8_t *)(p + x), v);
+    }
+#endif
+  }
+  for (; x < w; x++) {
+    const uint32_t c = p[x];
+    p[x] = (c & 0xFF000000u) | div255(((c >> 16) & 0xFF) * k) << 16 |
+           div255(((c >> 8) & 0xFF) * k) << 8 | div255((c & 0xFF) * k);
+  }
+}
+
+void gfx_dim(uint32_t *pix, int w, int h, int stride, uint8_t alpha) {
+  if (!pix || alpha == 0)
+    return;
+  for (int y = 0; y < h; y++)
+    dim_row(pix + (size_t)y * stride, w, 255u - alpha);
+}
+
+static inline uint32_t over1(uint32_t d, uint32_t s) {
+  const uint32_t k = 255u - (s >> 24);
+  uint32_t out = 0;
+  for (int sh = 0; sh < 32; sh += 8) {
+    uint32_t v = ((s >> sh) & 0xFF) + div255(((d >> sh) & 0xFF) * k);
+    out |= (v > 255 ? 255 : v) << sh;
+  }
+  return out;
+}
+
+static void over_row(uint32_t *d, const uint32_t *s, int w) {
+  int x = 0;
+  if (g_simd) {
+#if defined(GFX_PIXEL_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32((int)0xFF000000u);
+    const __m128i full = _mm_set1_epi16(255);
+    for (; x + 4 <= w; x += 4) {
+      const __m128i sp = _mm_loadu_si128((const __m128i *)(s + x));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(sp, zero)) == 0xFFFF)
+        continue;
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(sp, amask),
+                                            amask)) == 0xFFFF) {
+        _mm_storeu_si128((__m128i *)(d + x), sp);
+        continue;
+      }
+      const __m128i dp = _mm_loadu_si128((const __m128i *)(d + x));
+      const __m128i k_lo =
+          _mm_sub_epi16(full, alpha_epu16(_mm_unpacklo_epi8(sp, zero)));
+      const __m128i k_hi =
+          _mm_sub_epi16(full, alpha_epu16(_mm_unpackhi_epi8(sp, zero)));
+      _mm_storeu_si128((__m128i *)(d + x),
+                       _mm_adds_epu8(sp, scale4(dp, k_lo, k_hi)));
+    }
+#elif defined(GFX_PIXEL_NEON)
+    for (; x + 16 <= w; x += 16) {
+      const uint8x16x4_t sv = vld4q_u8((const uint8_t *)(s + x));
+#if defined(__aarch64__)
+      const uint8x16_t any = vorrq_u8(vorrq_u8(sv.val[0], sv.val[1]),
+                                      vorrq_u8(sv.val[2], sv.val[3]));
+      if (vmaxvq_u8(any) == 0)
+        continue;
+      if (vminvq_u8(sv.val[3]) == 255) {
+        vst4q_u8((uint8_t *)(d + x), sv);
+        continue;
+      }
+#endif
+      uint8x16x4_t dv = vld4q_u8((const uint8_t *)(d + x));
+      const uint8x16_t k = vmvnq_u8(sv.val[3]);
+      for (int c = 0; c < 4; c++) {
+        const uint8x8_t lo =
+            div255_u16(vmull_u8(vget_low_u8(dv.val[c]), vget_low_u8(k)));
+        const uint8x8_t hi =
+            div255_u16(vmull_u8(vget_high_u8(dv.val[c]), vget_high_u8(k)));
+        dv.val[c] = vqaddq_u8(sv.val[c], vcombine_u8(lo, hi));
+      }
+      vst4q_u8((uint8_t *)(d + x), dv);
+    }
+#endif
+  }
+  for (; x < w; x++) {
+    const uint32_t sp = s[x];
+    if (sp == 0)
+      continue;
+    d[x] = (sp >> 24) == 255 ? sp : over1(d[x], sp);
+  }
+}
+
+void gfx_over(uint32_t *dst, int dst_stride, const uint32_t *src,
+              int src_stride, int w, int h) {
+  if (!dst || !src)
+    return;
+  for (int y = 0; y < h; y++)
+    over_row(dst + (size_t)y * dst_stride, src + (size_t)y * src_stride, w);
+}
@@ -0,0 +1,50 @@
+#ifndef GFX_PIXEL_H
+#define GFX_PIXEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Pixel kernels for 32-bit ARGB8888 buffers (as read by a little-endian
+ * uint32_t: 0xAARRGGBB). Strides are in pixels. Each kernel has an SSE2 or
+ * NEON path, chosen at build time, and a scalar path; they give identical
+ * results.
+ *
+ * Divisions by 255 are exact and rounded, so premultiplying and then
+ * compositing over an opaque buffer matches a straight-alpha blend.
+ */
+
+/* Box (area) average of src into dst: every destination pixel is the mean
+ * of the source block it covers. Meant for shrinking; returns false if the
+ * column sums could not be allocated. */
+bool gfx_downscale_area(const uint32_t *src, int sw, int sh, int src_stride,
+                        uint32_t *dst, int dw, int dh, int dst_stride);
+
+/* Straight alpha to premultiplied, in place. */
+void gfx_premultiply(uint32_t *pix, int w, int h, int stride);
+
+/* Premultiplied back to straight alpha, in place. Scalar only: it runs once
+ * per scaled asset, never per frame. */
+void gfx_unpremultiply(uint32_t *pix, int w, int h, int stride);
+
+/* Darkens colour as if black at the given alpha were blended over it. The
+ * alpha channel is left alone. */
+void gfx_dim(uint32_t *pix, int w, int h, int stride, uint8_t alpha);
+
+/* Premultiplied src over dst, in place on dst. Fully transparent runs of
+ * src are skipped, so sparse overlays cost little. */
+void gfx_over(uint32_t *dst, int dst_stride, const uint32_t *src,
+              int src_stride, int w, int h);
+
+/* Turns the SIMD paths off (for benchmarks and checking against scalar).
+ * Returns the previous setting. */
+bool gfx_pixel_set_simd(bool on);
+
+/* "sse2", "neon" or "scalar". */
+const char *gfx_pixel_simd_name(void);
+
+/* Times each kernel at 1024x768 with and without SIMD, checks the results
+ * agree and prints a table to stdout. Returns 0 if they all agree. */
+int gfx_pixel_bench(void);
+
+#endif
@@ -0,0 +1,126 @@
+#include "pixel.h"
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_W 1024
+#define BENCH_H 768
+#define BENCH_ITERS 20
+
+typedef enum {
+  KERNEL_DOWNSCALE,
+  KERNEL_PREMULTIPLY,
+  KERNEL_DIM,
+  KERNEL_OVER,
+  KERNEL_COUNT
+} Kernel;
+
+static const char *const kernel_names[KERNEL_COUNT] = {
+    "downscale 1/4", "premultiply", "dim 128", "over (sparse)"};
+
+typedef struct {
+  uint32_t *src;  /* straight-alpha test pattern */
+  uint32_t *over; /* premultiplied, mostly transparent */
+  uint32_t *work; /* kernel output */
+} Buffers;
+
+static uint32_t rng_next(uint32_t *s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 17;
+  *s ^= *s << 5;
+  return *s;
+}
+
+static void run_kernel(Kernel k, const Buffers *b) {
+  const size_t bytes = (size_t)BENCH_W * BENCH_H * sizeof(uint32_t);
+  switch (k) {
+  case KERNEL_DOWNSCALE:
+    gfx_downscale_area(b->src, BENCH_W, BENCH_H, BENCH_W, b->work, BENCH_W / 4,
+                       BENCH_H / 4, BENCH_W / 4);
+    break;
+  case KERNEL_PREMULTIPLY:
+    memcpy(b->work, b->src, bytes);
+    gfx_premultiply(b->work, BENCH_W, BENCH_H, BENCH_W);
+    break;
+  case KERNEL_DIM:
+    memcpy(b->work, b->src, bytes);
+    gfx_dim(b->work, BENCH_W, BENCH_H, BENCH_W, 128);
+    break;
+  case KERNEL_OVER:
+    memcpy(b->work, b->src, bytes);
+    gfx_over(b->work, BENCH_W, b->over, BENCH_W, BENCH_W, BENCH_H);
+    break;
+  default:
+    break;
+  }
+}
+
+/* Milliseconds per call (the copies that set up in-place kernels
+ * included). */
+static double time_kernel(Kernel k, const Buffers *b) {
+  run_kernel(k, b);
+  const Uint64 t0 = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_ITERS; i++)
+    run_kernel(k, b);
+  const Uint64 t1 = SDL_GetPerformanceCounter();
+  return (double)(t1 - t0) * 1000.0 /
+         ((double)SDL_GetPerformanceFrequency() * BENCH_ITERS);
+}
+
+int gfx_pixel_bench(void) {
+  const size_t px = (size_t)BENCH_W * BENCH_H;
+  Buffers b;
+  b.src = (uint32_t *)malloc(px * sizeof(uint32_t));
+  b.over = (uint32_t *)malloc(px * sizeof(uint32_t));
+  b.work = (uint32_t *)malloc(px * sizeof(uint32_t));
+  uint32_t *expect = (uint32_t *)malloc(px * sizeof(uint32_t));
+  if (!b.src || !b.over || !b.work || !expect) {
+    free(b.src);
+    free(b.over);
+    free(b.work);
+    free(expect);
+    fprintf(stderr, "bench: out of memory\n");
+    return 1;
+  }
+  memset(b.work, 0, px * sizeof(uint32_t));
+
+  /* Noise for the image; an overlay that is 90% clear, like rain. */
+  uint32_t seed = 0x9E3779B9u;
+  for (size_t i = 0; i < px; i++)
+    b.src[i] = rng_next(&seed);
+  for (size_t i = 0; i < px; i++)
+    b.over[i] = (rng_next(&seed) % 10 == 0) ? rng_next(&seed) : 0;
+  gfx_premultiply(b.over, BENCH_W, BENCH_H, BENCH_W);
+
+  const bool was = gfx_pixel_set_simd(false);
+  gfx_pixel_set_simd(true);
+  const char *simd = gfx_pixel_simd_name();
+  printf("pixel kernels, %dx%d, %d iterations\n", BENCH_W, BENCH_H,
+         BENCH_ITERS);
+  printf("%-16s %10s %10s %8s  %s\n", "kernel", "scalar ms", simd, "speedup",
+         "match");
+
+  int mismatches = 0;
+  for (int k = 0; k < KERNEL_COUNT; k++) {
+    gfx_pixel_set_simd(false);
+    const double scalar_ms = time_kernel((Kernel)k, &b);
+    memcpy(expect, b.work, px * sizeof(uint32_t));
+    gfx_pixel_set_simd(true);
+    const double simd_ms = time_kernel((Kernel)k, &b);
+    const bool match = memcmp(expect, b.work, px * sizeof(uint32_t)) == 0;
+    if (!match)
+      mismatches++;
+    printf("%-16s %10.3f %10.3f %7.2fx  %s\n", kernel_names[k], scalar_ms,
+           simd_ms, simd_ms > 0.0 ? scalar_ms / simd_ms : 0.0,
+           match ? "yes" : "NO");
+  }
+  gfx_pixel_set_simd(was);
+
+  free(b.src);
+  free(b.over);
+  free(b.work);
+  free(expect);
+  return mismatches ? 1 : 0;
+}
@@ -1,5 +1,6 @@
 #include "soundfx.h"
 #include "audio_engine.h"
+#include "bell_synth.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -36,6 +37,12 @@ void soundfx_set_enabled(SoundFX* sfx, bool enabled) {
 void soundfx_play_bell(SoundFX* sfx) {
     if (!sfx || !sfx->eng) return;
     if (!sfx->enabled) return;
+
+    const BellPreset* preset = bell_synth_find(sfx->bell_path);
+    if (preset) {
+        audio_engine_play_bell(sfx->eng, preset);
+        return;
+    }
     if (!file_exists(sfx->bell_path)) return;
 
     /* Ignore errors for now. If decoding fails, we just stay silent. */
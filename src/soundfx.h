@@ -17,7 +17,8 @@ void soundfx_init(SoundFX* sfx, AudioEngine* eng);
 void soundfx_set_bell(SoundFX* sfx, const char* path);
 void soundfx_set_enabled(SoundFX* sfx, bool enabled);
 
-/* Plays the configured bell if enabled and the file exists. */
+/* Plays the configured bell if enabled: a synthesized preset name (see
+   bell_synth.h) or a file that exists. */
 void soundfx_play_bell(SoundFX* sfx);
 
 #ifdef __cplusplus
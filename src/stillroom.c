@@ -31,6 +31,12 @@
 #ifndef STILLROOM_SHOW_TAGLINE
 #define STILLROOM_SHOW_TAGLINE 0
 #endif
+/* Debug toggle: set to 1 to check every partial redraw against a full one
+   and log live widgets that changed outside the damage (a missing
+   ui_mark_live). Costs a full frame per tick. */
+#ifndef STILLROOM_DEBUG_DAMAGE
+#define STILLROOM_DEBUG_DAMAGE 0
+#endif
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -40,19 +46,38 @@
 #ifndef MAX
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
+#include "ambience_gen.h"
 #include "app.h"
 #include "audio_engine.h"
+#include "bell_synth.h"
 #include "features/booklets/booklets.h"
 #include "features/focus_menu/focus_menu.h"
 #include "features/meditation/meditation.h"
 #include "features/music/music_player.h"
 #include "features/quest/quest.h"
 #include "features/routines/routines.h"
+#include "features/stats/activity_rollup.h"
+#include "features/stats/history_log.h"
+#include "features/stats/history_reader.h"
+#include "features/stats/stats_engine.h"
 #include "features/tasks/tasks.h"
 #include "features/timer/timer.h"
 #include "features/updater/updater.h"
+#include "gfx/pixel.h"
+#include "ui/asset_norm.h"
+#include "ui/bg_cache.h"
+#include "ui/bg_disk.h"
+#include "ui/bg_loader.h"
+#include "ui/input_log.h"
 #include "ui/keyboard.h"
+#include "ui/overlay_player.h"
 #include "ui/palette.h"
+#include "ui/particles.h"
+#include "ui/prof.h"
+#include "ui/sched.h"
+#include "ui/text_atlas.h"
+#include "ui/text_cache.h"
+#include "ui/text_measure.h"
 #include "ui/ui_shared.h"
 
 #include "utils/file_utils.h"
@@ -166,7 +191,6 @@ static void draw_bg_faint(UI *ui, int bg_alpha);
 static void draw_bg_normal(UI *ui);
 static void anim_overlay_draw(UI *ui, App *a);
 static void draw_help_overlay(UI *ui, App *a);
-static void textcache_free(TextCache *tc);
 static void anim_overlay_unload(App *a);
 static void help_overlay_close(App *a);
 static void ui_close_fonts(UI *ui);
@@ -184,7 +208,6 @@ static void apply_ambience_from_cfg(UI *ui, App *a, bool user_action);
 static void refresh_moods_for_location(App *a);
 static void seasons_init(App *a);
 static void refresh_weathers_for_scene(App *a);
-static void ambience_path_from_name(const App *a, char *out, size_t cap);
 
 int hud_draw_tpl_line(UI *ui, int xR, int y, const char *tpl, SDL_Color main,
                       SDL_Color accent, const char *season, const char *bg,
@@ -213,9 +236,6 @@ static void draw_icon_heart(UI *ui, int x, int y, int scale, SDL_Color col);
 static void draw_clock_upper_left_stacked(UI *ui, App *a, int xL, int y);
 static void draw_battery_upper_right_stacked(UI *ui, App *a, int xR, int y);
 static void format_focusing_line(App *a, char *buf, size_t cap);
-static void draw_text_cached(UI *ui, TextCache *cache, TTF_Font *font, int x,
-                             int y, const char *text, SDL_Color color,
-                             bool center, int style);
 
 static void fmt_hms_opt_hours(char *buf, size_t cap, uint32_t seconds);
 
@@ -231,7 +251,7 @@ static void format_duration_hm(uint64_t seconds, char *buf, size_t cap);
 static void draw_inline_left(UI *ui, TTF_Font *f1, TTF_Font *f2, int x, int y,
                              const char *s1, const char *s2, SDL_Color c1,
                              SDL_Color c2);
-static void focus_history_load_to_cache(App *a);
+static void focus_history_load_page(App *a, int first, int max);
 static void truncate_to_width(UI *ui, TTF_Font *font, const char *src, int w,
                               char *dst, size_t dst_cap);
 static int ui_bottom_baseline_y(UI *ui);
@@ -347,13 +367,23 @@ static void log_session_header(void) {
   fprintf(g_log_fp, "Build: %s %s\n", __DATE__, __TIME__);
   fflush(g_log_fp);
 }
-uint64_t now_ms(void) { return (uint64_t)SDL_GetTicks(); }
+/* Non-zero while replaying input: the virtual time now_ms() reports. */
+static uint64_t g_virtual_ms = 0;
+uint64_t now_ms(void) {
+  return g_virtual_ms ? g_virtual_ms : (uint64_t)SDL_GetTicks();
+}
 /* -------- Battery (sysfs) --------
    Reads battery percentage from /sys/class/power_supply/<battery>/capacity.
    Cached and refreshed every few seconds to avoid per-frame file I/O.
 */
+#define BATTERY_SAMPLE_MS 5000 /* between sysfs reads */
 static int g_batt_percent = -1;
 static uint64_t g_batt_last_ms = 0;
+/* Whether the last frame showed the battery and (as minutes since the
+   epoch, -1 if not) the clock, so the loop only wakes for them while they
+   are on screen. */
+static bool g_batt_shown = false;
+static long g_clock_shown_min = -1;
 static bool read_int_file(const char *path, int *out) {
   FILE *f = fopen(path, "r");
   if (!f)
@@ -416,7 +446,7 @@ static void battery_tick_update(void) {
   /* Update immediately at startup, then every 5 seconds.
      This avoids showing "n/a" for the first few seconds after launch. */
   if (g_batt_percent < 0 || g_batt_last_ms == 0 ||
-      (now - g_batt_last_ms) >= 5000) {
+      (now - g_batt_last_ms) >= BATTERY_SAMPLE_MS) {
     g_batt_percent = get_battery_percent_sysfs();
     g_batt_last_ms = now;
   }
@@ -547,6 +577,9 @@ static void config_defaults(AppConfig *c) {
   c->font_small_pt = 42;
   c->font_med_pt = 50;
   c->font_big_pt = 100;
+  c->bg_cache_mb = 48;
+  c->overlay_mb = 16;
+  c->bg_disk_mb = 128;
   c->music_enabled = 0;
   safe_snprintf(c->music_folder, sizeof(c->music_folder), "%s", "music");
   c->ambience_enabled = 0;
@@ -659,6 +692,12 @@ void config_load(AppConfig *c, const char *path) {
       c->highlight_color_idx = atoi(val);
     else if (strcmp(key, "font_file") == 0)
       safe_snprintf(c->font_file, sizeof(c->font_file), "%s", val);
+    else if (strcmp(key, "bg_cache_mb") == 0)
+      c->bg_cache_mb = atoi(val);
+    else if (strcmp(key, "overlay_mb") == 0)
+      c->overlay_mb = atoi(val);
+    else if (strcmp(key, "bg_disk_mb") == 0)
+      c->bg_disk_mb = atoi(val);
     else if (strcmp(key, "font_small_pt") == 0)
       c->font_small_pt = atoi(val);
     else if (strcmp(key, "font_med_pt") == 0)
@@ -831,6 +870,18 @@ void config_load(AppConfig *c, const char *path) {
     c->font_med_pt = 120;
   if (c->font_big_pt > 220)
     c->font_big_pt = 220;
+  if (c->bg_cache_mb < 0)
+    c->bg_cache_mb = 0;
+  if (c->bg_cache_mb > 512)
+    c->bg_cache_mb = 512;
+  if (c->overlay_mb < 0)
+    c->overlay_mb = 0;
+  if (c->overlay_mb > 64)
+    c->overlay_mb = 64;
+  if (c->bg_disk_mb < 0)
+    c->bg_disk_mb = 0;
+  if (c->bg_disk_mb > 1024)
+    c->bg_disk_mb = 1024;
   if (!c->bell_phase_file[0])
     safe_snprintf(c->bell_phase_file, sizeof(c->bell_phase_file), "%s",
                   "bell.wav");
@@ -979,6 +1030,9 @@ void config_save(const AppConfig *c, const char *path) {
   fprintf(f, "font_small_pt=%d\n", c->font_small_pt);
   fprintf(f, "font_med_pt=%d\n", c->font_med_pt);
   fprintf(f, "font_big_pt=%d\n", c->font_big_pt);
+  fprintf(f, "bg_cache_mb=%d\n", c->bg_cache_mb);
+  fprintf(f, "overlay_mb=%d\n", c->overlay_mb);
+  fprintf(f, "bg_disk_mb=%d\n", c->bg_disk_mb);
   fprintf(f, "music_enabled=%d\n", c->music_enabled);
   fprintf(f, "music_folder=%s\n", c->music_folder);
   fprintf(f, "ambience_enabled=%d\n", c->ambience_enabled);
@@ -1042,13 +1096,23 @@ void config_save(const AppConfig *c, const char *path) {
  */
 // Removed duplicate TextCache struct definition
 
+/* Copies a pre-composited layer: one opaque, unscaled full-screen copy. */
+static bool bg_layer_copy(UI *ui, BgLayer layer) {
+  if (!ui->bg_layers[layer])
+    return false;
+  SDL_RenderCopy(ui->ren, ui->bg_layers[layer], NULL, NULL);
+  return true;
+}
 static void draw_bg_normal(UI *ui) {
+  if (bg_layer_copy(ui, BG_LAYER_NORMAL))
+    return;
   if (ui->bg_tex) {
     SDL_Rect dst = {0, 0, ui->w, ui->h};
     SDL_RenderCopy(ui->ren, ui->bg_tex, NULL, &dst);
   } else {
     SDL_SetRenderDrawColor(ui->ren, 15, 15, 20, 255);
-    SDL_RenderClear(ui->ren);
+    /* Not SDL_RenderClear: that ignores the clip rect of partial redraws. */
+    SDL_RenderFillRect(ui->ren, NULL);
   }
 }
 static void draw_bg_scaled(UI *ui, float scale, int y_shift_up, bool blurred) {
@@ -1067,15 +1131,18 @@ static void draw_bg_scaled(UI *ui, float scale, int y_shift_up, bool blurred) {
   SDL_Rect dst = {x, y, w, h};
   SDL_RenderCopy(ui->ren, tex, NULL, &dst);
 
-  if (blurred) {
+  /* The blur texture comes pre-dimmed; a sharp fallback needs the dim. */
+  if (blurred && tex != ui->bg_blur_tex) {
     /* 50% Dimming Overlay (Alpha 128) to match standard blurred menu style */
     SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(ui->ren, 0, 0, 0, 128);
+    SDL_SetRenderDrawColor(ui->ren, 0, 0, 0, BG_BLUR_DIM_ALPHA);
     SDL_RenderFillRect(ui->ren, &dst);
     SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
   }
 }
 static void draw_bg_normal_shifted(UI *ui, int y_shift_up) {
+  if (y_shift_up == BG_HIDDEN_SHIFT_Y && bg_layer_copy(ui, BG_LAYER_HIDDEN))
+    return;
   if (!ui->bg_tex) {
     draw_bg_normal(ui);
     return;
@@ -1093,7 +1160,8 @@ static void draw_bg_dimmed(UI *ui, Uint8 overlay_alpha) {
   SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
 }
 static void draw_bg_faint(UI *ui, int bg_alpha) {
-
+  if (bg_alpha == BG_FAINT_ALPHA && bg_layer_copy(ui, BG_LAYER_FAINT))
+    return;
   if (!ui->bg_tex) {
     draw_bg_normal(ui);
     return;
@@ -1106,43 +1174,94 @@ static void draw_bg_faint(UI *ui, int bg_alpha) {
   SDL_SetTextureAlphaMod(ui->bg_tex, old);
 }
 static void draw_bg_blurred(UI *ui) {
+  if (bg_layer_copy(ui, BG_LAYER_BLURRED))
+    return;
   if (ui->bg_blur_tex) {
+    /* Already dimmed 50% for readability by the loader. */
     SDL_Rect dst = {0, 0, ui->w, ui->h};
     SDL_RenderCopy(ui->ren, ui->bg_blur_tex, NULL, &dst);
-
-    /* 50% Dimming Overlay (Alpha 128) for readability */
-    SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(ui->ren, 0, 0, 0, 128);
-    SDL_RenderFillRect(ui->ren, &dst);
-    SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
   } else {
     draw_bg_normal(ui);
   }
 }
+/* Points the UI at a cached texture set (NULL for no background). The
+   textures stay owned by the background cache. */
+static void bg_use(UI *ui, const BgTextures *t) {
+  ui->bg_tex = t ? t->tex : NULL;
+  ui->bg_blur_tex = t ? t->blur_tex : NULL;
+  for (int i = 0; i < BG_LAYER_COUNT; i++)
+    ui->bg_layers[i] = t ? t->layers[i] : NULL;
+  bg_cache_pin(t);
+}
+/* Pre-composites the static background variants at screen size with the
+   draw_bg_* paths above, so a frame costs one opaque copy instead of a
+   scaled copy plus dim/alpha passes. All or nothing: if any layer fails,
+   frames keep composing on the fly. */
+static void bg_layers_build(UI *ui) {
+  if (!ui->bg_tex)
+    return;
+  SDL_Texture *layers[BG_LAYER_COUNT] = {0};
+  SDL_Texture *old_target = SDL_GetRenderTarget(ui->ren);
+  bool ok = true;
+  for (int i = 0; i < BG_LAYER_COUNT; i++) {
+    layers[i] = SDL_CreateTexture(ui->ren, ui->pixel_format,
+                                  SDL_TEXTUREACCESS_TARGET, ui->w, ui->h);
+    if (!layers[i] || SDL_SetRenderTarget(ui->ren, layers[i]) != 0) {
+      ok = false;
+      break;
+    }
+    SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(ui->ren, 0, 0, 0, 255);
+    SDL_RenderFillRect(ui->ren, NULL);
+    switch ((BgLayer)i) {
+    case BG_LAYER_NORMAL:
+      draw_bg_normal(ui);
+      break;
+    case BG_LAYER_BLURRED:
+      draw_bg_blurred(ui);
+      break;
+    case BG_LAYER_FAINT:
+      draw_bg_faint(ui, BG_FAINT_ALPHA);
+      break;
+    case BG_LAYER_HIDDEN:
+      draw_bg_normal_shifted(ui, BG_HIDDEN_SHIFT_Y);
+      break;
+    default:
+      break;
+    }
+    SDL_SetTextureBlendMode(layers[i], SDL_BLENDMODE_NONE);
+  }
+  SDL_SetRenderTarget(ui->ren, old_target);
+  if (!ok) {
+    for (int i = 0; i < BG_LAYER_COUNT; i++) {
+      if (layers[i])
+        SDL_DestroyTexture(layers[i]);
+    }
+    return;
+  }
+  memcpy(ui->bg_layers, layers, sizeof(layers));
+}
 /* ----------------------------- Bottom hint rendering (mixed colors)
  * ----------------------------- */
 /* ----------------------------- Shared UI Functions
  * ----------------------------- */
 
+/* Records a widget whose contents change with the one-second tick. Widgets
+   report the full-width band they occupy, so centered or proportional digits
+   that change width stay inside the damage. */
+static void ui_mark_live(UI *ui, int y, int h) {
+  SDL_Rect r = {0, y, ui->w, h};
+  damage_add(&ui->live, r, ui->w, ui->h);
+}
+
 int text_width(TTF_Font *font, const char *s) {
-  if (!s || !s[0])
-    return 0;
-  int w = 0, h = 0;
-  if (TTF_SizeUTF8(font, s, &w, &h) != 0)
+  if (!font || !s || !s[0])
     return 0;
-  return w;
+  return text_measure(font, TTF_GetFontStyle(font), s);
 }
 
 int text_width_style(TTF_Font *font, int style, const char *s) {
-  if (!s || !s[0])
-    return 0;
-  int old = TTF_GetFontStyle(font);
-  TTF_SetFontStyle(font, style);
-  int w = 0, h = 0;
-  if (TTF_SizeUTF8(font, s, &w, &h) != 0)
-    w = 0;
-  TTF_SetFontStyle(font, old);
-  return w;
+  return text_measure(font, style, s);
 }
 
 int text_width_style_ui(UI *ui, TTF_Font *font, int style, const char *s) {
@@ -1160,13 +1279,7 @@ int text_width_style_ui(UI *ui, TTF_Font *font, int style, const char *s) {
     if (use_font != font)
       use_style &= ~TTF_STYLE_ITALIC;
   }
-  int old = TTF_GetFontStyle(use_font);
-  TTF_SetFontStyle(use_font, use_style);
-  int w = 0, h = 0;
-  if (TTF_SizeUTF8(use_font, s, &w, &h) != 0)
-    w = 0;
-  TTF_SetFontStyle(use_font, old);
-  return w;
+  return text_measure(use_font, use_style, s);
 }
 
 /* Draws text centered horizontally at cx, wrapping to multiple lines if it
@@ -1200,7 +1313,9 @@ static int draw_text_wrapped_centered(UI *ui, TTF_Font *font, int cx, int y,
   char line[512];
   line[0] = '\0';
   int line_len = 0;
+  int line_w = 0;
   int current_y = y;
+  const int style = TTF_GetFontStyle(font);
 
   const char *p = buf;
   while (*p) {
@@ -1220,12 +1335,16 @@ static int draw_text_wrapped_centered(UI *ui, TTF_Font *font, int cx, int y,
     memcpy(word, word_start, word_len);
     word[word_len] = '\0';
 
-    /* Test if adding this word exceeds max_width */
-    char test_line[512];
-    safe_snprintf(test_line, sizeof(test_line), "%s%s", line, word);
-    int test_w = text_width(font, test_line);
+    /* Test if adding this word exceeds max_width (summed advances; the
+       line is measured whole only near max_width, like the other wrap
+       loops) */
+    int word_w = text_measure_sum(font, style, word);
+    char trial[768];
+    safe_snprintf(trial, sizeof(trial), "%s%s", line, word);
 
-    if (test_w > max_width && line[0] != '\0') {
+    if (line[0] != '\0' && !text_measure_line_fits(font, style, trial,
+                                                   line_w + word_w,
+                                                   max_width)) {
       /* Flush current line */
       int lw = text_width(font, line);
       int lx = cx - lw / 2;
@@ -1236,10 +1355,14 @@ static int draw_text_wrapped_centered(UI *ui, TTF_Font *font, int cx, int y,
       /* Start new line with current word */
       safe_snprintf(line, sizeof(line), "%s", word);
       line_len = (int)word_len;
+      line_w = word_w;
     } else {
       /* Append word to current line */
-      safe_snprintf(line, sizeof(line), "%s", test_line);
-      line_len = (int)strlen(line);
+      if ((size_t)line_len + word_len < sizeof(line)) {
+        memcpy(line + line_len, word, word_len + 1);
+        line_len += (int)word_len;
+      }
+      line_w += word_w;
     }
 
     if (has_delim)
@@ -1278,13 +1401,25 @@ static void draw_circle_fill(UI *ui, int cx, int cy, int r, SDL_Color c) {
 
 static SDL_Surface *render_text_surface(TTF_Font *font, const char *text,
                                         SDL_Color col) {
-  return TTF_RenderUTF8_Blended(font, text, col);
+  const uint64_t t = prof_begin();
+  SDL_Surface *s = TTF_RenderUTF8_Blended(font, text, col);
+  prof_end(PROF_TEXT, t);
+  return s;
 }
 
 void draw_text(UI *ui, TTF_Font *font, int x, int y, const char *text,
                SDL_Color col, bool right_align) {
   if (!text || !text[0])
     return;
+  const int style = TTF_GetFontStyle(font);
+  const TextCacheResult cached =
+      text_cache_draw(ui->ren, font, style, x, y, text, col, right_align);
+  if (cached == TEXT_CACHE_DRAWN)
+    return;
+  if (text_atlas_draw(ui->ren, font, style, x, y, text, col, right_align))
+    return;
+  if (cached == TEXT_CACHE_FAILED)
+    return; /* rendering it whole failed before */
   SDL_Surface *s = render_text_surface(font, text, col);
   if (!s)
     return;
@@ -1345,6 +1480,15 @@ void draw_text_style(UI *ui, TTF_Font *font, int x, int y, const char *text,
     if (use_font != font)
       use_style &= ~TTF_STYLE_ITALIC;
   }
+  const TextCacheResult cached = text_cache_draw(
+      ui->ren, use_font, use_style, x, y, text, color, right_align);
+  if (cached == TEXT_CACHE_DRAWN)
+    return;
+  if (text_atlas_draw(ui->ren, use_font, use_style, x, y, text, color,
+                      right_align))
+    return;
+  if (cached == TEXT_CACHE_FAILED)
+    return; /* rendering it whole failed before */
   int old = TTF_GetFontStyle(use_font);
   TTF_SetFontStyle(use_font, use_style);
   SDL_Surface *surf = render_text_surface(use_font, text, color);
@@ -2032,6 +2176,8 @@ static void focus_stats_remove_name(App *a, const char *name) {
     a->focus_activity_dirty = true;
   }
   focus_stats_save(a, FOCUS_STATS_PATH);
+  stats_engine_remove_activity(name);
+  stats_engine_save();
   if (a->focus_activity_dirty) {
     config_save(&a->cfg, CONFIG_PATH);
     a->focus_activity_dirty = false;
@@ -2090,6 +2236,19 @@ static void focus_stats_add(App *a, const char *name, uint64_t secs) {
   a->focus_stats[a->focus_stats_count].seconds = secs;
   a->focus_stats_count++;
 }
+/* The first run with the stats engine starts it from what came before:
+   the days in the rollup and the per-entry totals. */
+static void stats_engine_seed(App *a) {
+  for (int i = 0; i < activity_rollup_day_count(); i++) {
+    int date = 0;
+    const uint32_t secs = activity_rollup_day_at(i, &date);
+    stats_engine_seed_day(date, secs);
+  }
+  for (int i = 0; a && i < a->focus_stats_count; i++)
+    stats_engine_seed_activity(a->focus_stats[i].name,
+                               a->focus_stats[i].seconds);
+  stats_engine_save();
+}
 static void activity_log_append_seconds(uint32_t secs);
 static void award_focus_seconds(App *a, uint32_t secs) {
   if (!a || secs == 0)
@@ -2100,6 +2259,7 @@ static void award_focus_seconds(App *a, uint32_t secs) {
   if ((uint64_t)secs > a->cfg.focus_longest_span_seconds)
     a->cfg.focus_longest_span_seconds = (uint64_t)secs;
   focus_stats_add(a, a->run_focus_activity, (uint64_t)secs);
+  stats_engine_add(time(NULL), secs, a->run_focus_activity);
   config_save(&a->cfg, CONFIG_PATH);
   focus_stats_save(a, FOCUS_STATS_PATH);
 }
@@ -2150,19 +2310,18 @@ static void format_as_of_today_phrase(char *out, size_t cap) {
   safe_snprintf(out, cap, "the %s of %s", day_ordinal_lower(tmv.tm_mday),
                 month_name_lower(tmv.tm_mon));
 }
+static int date_int_from_tm(const struct tm *tmv) {
+  return date_int_from_ymd(tmv->tm_year + 1900, tmv->tm_mon + 1,
+                           tmv->tm_mday);
+}
 static void activity_log_append_seconds(uint32_t secs) {
   /* Append a dated row so we can build a day-based
-     activity heatmap. Format: YYYY-MM-DD<TAB>seconds */
+     activity heatmap. Format: YYYY-MM-DD<TAB>seconds.
+     The rollup keeps the per-day sums in memory. */
   time_t now = time(NULL);
   struct tm tmv;
   localtime_r(&now, &tmv);
-  char d[16];
-  strftime(d, sizeof(d), "%Y-%m-%d", &tmv);
-  FILE *f = fopen(ACTIVITY_LOG_PATH, "a");
-  if (!f)
-    return;
-  fprintf(f, "%s\t%u\n", d, (unsigned)secs);
-  fclose(f);
+  activity_rollup_append(date_int_from_tm(&tmv), secs);
 }
 
 static void tsv_sanitize_inplace(char *s) {
@@ -2195,72 +2354,27 @@ void focus_history_append(App *a, uint32_t secs, const char *status) {
     safe_snprintf(act, sizeof(act), "%s", "unspecified");
   tsv_sanitize_inplace(act);
 
-  FILE *f = fopen(FOCUS_HISTORY_PATH, "a");
-  if (!f)
+  char row[160];
+  safe_snprintf(row, sizeof(row), "%s\t%u\t%s\t%s", dt, (unsigned)secs,
+                status, act);
+  if (!history_log_append(HISTORY_LOG_FOCUS, date_int_from_tm(&tmv), row,
+                          NULL))
     return;
-  fprintf(f, "%s\t%u\t%s\t%s\n", dt, (unsigned)secs, status, act);
-  fclose(f);
   if (a)
     a->history_dirty = true;
 }
 
-static void focus_history_load_to_cache(App *a) {
+static void focus_history_load_page(App *a, int first, int max) {
   if (!a)
     return;
-  int cap = 30;
-  FocusHistoryRow *out = a->cached_history_rows;
-  FILE *f = fopen(FOCUS_HISTORY_PATH, "r");
-  if (!f) {
-    a->cached_history_count = 0;
-    a->history_dirty = false;
-    return;
-  }
-
-  /* Ring-buffer so we only keep the last cap rows. */
-  FocusHistoryRow *ring =
-      (FocusHistoryRow *)calloc((size_t)cap, sizeof(FocusHistoryRow));
-  if (!ring) {
-    fclose(f);
-    a->cached_history_count = 0;
-    return;
-  }
-
-  char line[512];
-  int total = 0;
-  while (fgets(line, (int)sizeof(line), f)) {
-    size_t n = strlen(line);
-    while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
-      line[--n] = 0;
-
-    char *p1 = strtok(line, "\t");
-    char *p2 = strtok(NULL, "\t");
-    char *p3 = strtok(NULL, "\t");
-    char *p4 = strtok(NULL, ""); /* rest of line */
-
-    if (!p1 || !p2 || !p3 || !p4)
-      continue;
-
-    FocusHistoryRow r = {0};
-    safe_snprintf(r.dt, sizeof(r.dt), "%s", p1);
-    r.seconds = (uint32_t)strtoul(p2, NULL, 10);
-    safe_snprintf(r.status, sizeof(r.status), "%s", p3);
-    safe_snprintf(r.activity, sizeof(r.activity), "%s", p4);
-    tsv_sanitize_inplace(r.activity);
-
-    ring[total % cap] = r;
-    total++;
-  }
-  fclose(f);
-
-  int n = total < cap ? total : cap;
-  for (int i = 0; i < n; i++) {
-    int src = (total - 1 - i);
-    if (src < 0)
-      break;
-    out[i] = ring[src % cap]; /* newest first */
-  }
-  free(ring);
-  a->cached_history_count = n;
+  if (max > (int)(sizeof(a->cached_history_rows) /
+                  sizeof(a->cached_history_rows[0])))
+    max = (int)(sizeof(a->cached_history_rows) /
+                sizeof(a->cached_history_rows[0]));
+  a->cached_history_count =
+      history_reader_page(first, a->cached_history_rows, max);
+  a->cached_history_first = first;
+  a->cached_history_max = max;
   a->history_dirty = false;
 }
 
@@ -2279,20 +2393,22 @@ static void truncate_to_width(UI *ui, TTF_Font *f, const char *in, int max_w,
   if (text_width(f, out) <= max_w)
     return;
 
+  /* Longest prefix that leaves room for the ellipsis, from cached glyph
+     advances instead of re-measuring one character shorter each time. */
   const char *ell = "...";
-  char buf[256];
-  safe_snprintf(buf, sizeof(buf), "%s", out);
-
-  int len = (int)strlen(buf);
-  while (len > 0) {
-    buf[len] = 0;
-    char tmp[256];
-    safe_snprintf(tmp, sizeof(tmp), "%s%s", buf, ell);
-    if (text_width(f, tmp) <= max_w) {
-      safe_snprintf(out, out_sz, "%s", tmp);
-      return;
-    }
-    len--;
+  const int style = TTF_GetFontStyle(f);
+  const int ell_w = text_measure_sum(f, style, ell);
+  size_t keep = text_measure_fit(f, style, in, max_w - ell_w);
+  if (keep > 0) {
+    char buf[256];
+    if (keep >= sizeof(buf))
+      keep = sizeof(buf) - 1;
+    while (keep > 0 && ((unsigned char)in[keep] & 0xC0) == 0x80)
+      keep--;
+    memcpy(buf, in, keep);
+    buf[keep] = 0;
+    safe_snprintf(out, out_sz, "%s%s", buf, ell);
+    return;
   }
   safe_snprintf(out, out_sz, "%s", ell);
 }
@@ -2428,17 +2544,6 @@ static void focus_pick_cycle(App *a, int dir) {
  * ----------------------------- */
 /* (App forward declaration moved above for Tasks
  * helpers.) */
-static SDL_Texture *load_texture(SDL_Renderer *ren, const char *path) {
-  if (!is_file(path))
-    return NULL;
-  SDL_Surface *s = IMG_Load(path);
-  if (!s)
-    return NULL;
-  SDL_Texture *t = SDL_CreateTextureFromSurface(ren, s);
-  SDL_FreeSurface(s);
-  return t;
-}
-
 /* ----------------------------- UI help overlay (MENU
  * hold)
  * ----------------------------- */
@@ -2607,9 +2712,8 @@ static void help_overlay_open_for(UI *ui, App *a) {
 
   a->help_overlay_missing = !is_file(a->help_overlay_path);
   if (!a->help_overlay_missing) {
-    a->help_overlay_tex = load_texture(ui->ren, a->help_overlay_path);
-    if (a->help_overlay_tex)
-      SDL_SetTextureBlendMode(a->help_overlay_tex, SDL_BLENDMODE_BLEND);
+    a->help_overlay_tex = asset_load_texture(
+        ui->ren, a->help_overlay_path, ui->w, ui->h, ui->pixel_format);
     a->help_overlay_missing = (a->help_overlay_tex == NULL);
   }
 
@@ -2632,7 +2736,7 @@ static void help_overlay_tick(UI *ui, App *a, Buttons *b) {
   }
 
   /* Closed: if MENU is held long enough, open. */
-  if (a->menu_btn_down) {
+  if (a->menu_btn_down && !a->menu_btn_combo) {
     if (timer_main_screen(a))
       return;
     if ((now - a->menu_btn_down_ms) >= (uint64_t)UI_HELP_OVERLAY_HOLD_MS) {
@@ -2661,99 +2765,6 @@ static void draw_help_overlay(UI *ui, App *a) {
   }
 }
 
-/* -------------------------- TextCache helpers
- * -------------------------- */
-static bool sdl_color_eq(SDL_Color a, SDL_Color b) {
-  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
-}
-static void textcache_free(TextCache *c) {
-  if (!c)
-    return;
-  if (c->tex)
-    SDL_DestroyTexture(c->tex);
-  c->tex = NULL;
-  c->font = NULL;
-  c->style = 0;
-  c->color = (SDL_Color){0, 0, 0, 0};
-  c->text[0] = 0;
-  c->w = 0;
-  c->h = 0;
-}
-/* Cached version of draw_text_style(): re-renders only
- * when text/font/style/color changes. */
-static void draw_text_cached(UI *ui, TextCache *c, TTF_Font *font, int x, int y,
-                             const char *text, SDL_Color col, bool right_align,
-                             int style) {
-  if (!ui || !c)
-    return;
-  if (!text || !text[0]) {
-    textcache_free(c);
-    return;
-  }
-
-  /* Match draw_text_style() italic companion swap. */
-  TTF_Font *use_font = font;
-  int use_style = style;
-  if (style & TTF_STYLE_ITALIC) {
-    if (style & TTF_STYLE_ITALIC) {
-      if (font == ui->font_small && ui->font_small_i)
-        use_font = ui->font_small_i;
-      else if (font == ui->font_med && ui->font_med_i)
-        use_font = ui->font_med_i;
-      else if (font == ui->font_big && ui->font_big_i)
-        use_font = ui->font_big_i;
-      if (use_font != font)
-        use_style &= ~TTF_STYLE_ITALIC;
-    }
-  }
-
-  const bool needs_rerender = (!c->tex) || (c->font != use_font) ||
-                              (c->style != use_style) ||
-                              (!sdl_color_eq(c->color, col)) ||
-                              (strncmp(c->text, text, sizeof(c->text)) != 0);
-
-  if (needs_rerender) {
-    if (c->tex)
-      SDL_DestroyTexture(c->tex);
-    c->tex = NULL;
-
-    int old = TTF_GetFontStyle(use_font);
-    TTF_SetFontStyle(use_font, use_style);
-    SDL_Surface *surf = render_text_surface(use_font, text, col);
-    TTF_SetFontStyle(use_font, old);
-    if (!surf) {
-      c->text[0] = 0;
-      c->font = use_font;
-      c->style = use_style;
-      c->color = col;
-      c->w = 0;
-      c->h = 0;
-      return;
-    }
-
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(ui->ren, surf);
-    if (!tex) {
-      SDL_FreeSurface(surf);
-      return;
-    }
-
-    c->tex = tex;
-    c->font = use_font;
-    c->style = use_style;
-    c->color = col;
-    safe_snprintf(c->text, sizeof(c->text), "%s", text);
-    c->w = surf->w;
-    c->h = surf->h;
-    SDL_FreeSurface(surf);
-  }
-
-  if (!c->tex)
-    return;
-  SDL_Rect dst = {x, y, c->w, c->h};
-  if (right_align)
-    dst.x -= c->w;
-  SDL_RenderCopy(ui->ren, c->tex, NULL, &dst);
-}
 /* --- Animated overlay (tag-driven PNG sequence) --- */
 /*
    Rain overlays are tied to the current ambience
@@ -2772,21 +2783,67 @@ static void draw_text_cached(UI *ui, TextCache *c, TTF_Font *font, int x, int y,
      scenes/<location>/overlays/<tag>/<tag>_001.png ...
    Fallback:
      overlays/<tag>/<tag>_001.png ...
+   A <tag>.particles file in the same places takes
+   precedence: the effect is then drawn procedurally
+   (see ui/particles.h) and needs no frames at all.
 */
+/* True when the renderer draws into a 32-bit xRGB window surface that
+   overlay frames can be composited onto directly. */
+static bool overlay_direct_ok(UI *ui) {
+  if (!ui || !ui->surface_present)
+    return false;
+  SDL_Surface *s = SDL_GetWindowSurface(ui->win);
+  return s && s->w == ui->w && s->h == ui->h &&
+         s->format->BytesPerPixel == 4 && s->format->Rmask == 0x00FF0000 &&
+         s->format->Gmask == 0x0000FF00 && s->format->Bmask == 0x000000FF;
+}
+/* Composites the player's premultiplied frame over what has been rendered
+   so far, within the renderer's clip rect. */
+static void overlay_composite(UI *ui) {
+  SDL_Surface *dst = SDL_GetWindowSurface(ui->win);
+  if (!dst)
+    return;
+  SDL_Rect r = {0, 0, ui->w < dst->w ? ui->w : dst->w,
+                ui->h < dst->h ? ui->h : dst->h};
+  SDL_Rect clip;
+  SDL_RenderGetClipRect(ui->ren, &clip);
+  if (clip.w > 0 && clip.h > 0 && !SDL_IntersectRect(&r, &clip, &r))
+    return;
+  /* Queued draws (the background) must land first. */
+  SDL_RenderFlush(ui->ren);
+  if (SDL_MUSTLOCK(dst))
+    SDL_LockSurface(dst);
+  overlay_player_composite((Uint32 *)dst->pixels, dst->pitch / 4, &r);
+  if (SDL_MUSTLOCK(dst))
+    SDL_UnlockSurface(dst);
+}
 static void anim_overlay_refresh(UI *ui, App *a);
 static void anim_overlay_unload(App *a) {
   if (!a)
     return;
-  if (a->anim_overlay_frames) {
-    for (int i = 0; i < a->anim_overlay_frame_count; i++) {
-      if (a->anim_overlay_frames[i])
-        SDL_DestroyTexture(a->anim_overlay_frames[i]);
-    }
-    free(a->anim_overlay_frames);
-  }
-  a->anim_overlay_frames = NULL;
+  if (overlay_player_active()) {
+    OverlayPlayerStats st;
+    overlay_player_get_stats(&st);
+    log_printf("anim overlay: %u shown, %u dropped, %u decoded (slowest %u "
+               "ms), %u failed, %u slots, %zu/%zu bytes%s",
+               st.shown, st.dropped, st.decoded, st.decode_ms, st.failed,
+               st.slots, st.bytes, st.budget_bytes,
+               st.packed ? ", packed" : "");
+  }
+  overlay_player_close();
+  if (a->anim_particles) {
+    log_printf("anim overlay: %d particles, %zu bytes",
+               particles_count(a->anim_particles),
+               particles_bytes(a->anim_particles));
+    particles_destroy(a->anim_particles);
+    a->anim_particles = NULL;
+  }
+  if (a->anim_overlay_tex)
+    SDL_DestroyTexture(a->anim_overlay_tex);
+  a->anim_overlay_tex = NULL;
+  a->anim_overlay_tex_stale = false;
+  a->anim_overlay_direct = false;
   a->anim_overlay_frame_count = 0;
-  a->anim_overlay_frame_idx = 0;
   a->anim_overlay_accum = 0.0f;
   a->anim_overlay_last_ms = 0;
 }
@@ -2807,40 +2864,45 @@ static bool anim_overlay_should_run(const App *a) {
   return true;
 }
 static bool file_exists_local(const char *path);
+static bool anim_overlay_dir_has(const char *dir, const char *tag) {
+  char path[512];
+  safe_snprintf(path, sizeof(path), "%s/%s.particles", dir, tag);
+  if (file_exists_local(path))
+    return true;
+  safe_snprintf(path, sizeof(path), "%s/%s_001.png", dir, tag);
+  return file_exists_local(path);
+}
 static bool anim_overlay_resolve_dir(const App *a, char *out, size_t cap) {
   /* Resolve the first existing directory for the
      current ambience_tag. Search order: 1)
      scenes/<location>/<mood>/overlays 2)
      scenes/<location>/overlays 3) overlays The
      directory is considered valid if
-     "<dir>/<tag>_001.png" exists. */
+     "<dir>/<tag>.particles" or "<dir>/<tag>_001.png"
+     exists. */
   if (!a || !a->ambience_tag[0])
     return false;
   const char *tag = a->ambience_tag;
-  char first[512];
   char dir1[512];
   const char *loc =
       (a->scenes.count > 0) ? a->scenes.items[a->scene_idx] : NULL;
   const char *mood = (a->moods.count > 0) ? a->moods.items[a->mood_idx] : NULL;
   if (loc && mood) {
     safe_snprintf(dir1, sizeof(dir1), "scenes/%s/%s/overlays", loc, mood);
-    safe_snprintf(first, sizeof(first), "%s/%s_001.png", dir1, tag);
-    if (file_exists_local(first)) {
+    if (anim_overlay_dir_has(dir1, tag)) {
       SDL_strlcpy(out, dir1, cap);
       return true;
     }
   }
   if (loc) {
     safe_snprintf(dir1, sizeof(dir1), "scenes/%s/overlays", loc);
-    safe_snprintf(first, sizeof(first), "%s/%s_001.png", dir1, tag);
-    if (file_exists_local(first)) {
+    if (anim_overlay_dir_has(dir1, tag)) {
       SDL_strlcpy(out, dir1, cap);
       return true;
     }
   }
   safe_snprintf(dir1, sizeof(dir1), "overlays");
-  safe_snprintf(first, sizeof(first), "%s/%s_001.png", dir1, tag);
-  if (file_exists_local(first)) {
+  if (anim_overlay_dir_has(dir1, tag)) {
     SDL_strlcpy(out, dir1, cap);
     return true;
   }
@@ -2880,57 +2942,43 @@ static void anim_overlay_refresh(UI *ui, App *a) {
     anim_overlay_unload(a);
     return;
   }
-  /* Load PNG sequence: <dir>/<tag>_001.png ... until
-   * missing. */
   anim_overlay_unload(a);
+  char particles[PATH_MAX];
+  safe_snprintf(particles, sizeof(particles), "%s/%s.particles", dir,
+                a->ambience_tag);
+  ParticleParams pp;
+  if (particles_load(particles, &pp)) {
+    a->anim_particles =
+        particles_create(&pp, ui->w, ui->h, fnv1a32(a->ambience_tag));
+    a->anim_overlay_enabled = a->anim_particles ? 1 : 0;
+    return;
+  }
+  /* Stream the PNG sequence <dir>/<tag>_001.png ... (until missing)
+   * through a few decoded frames instead of loading it all. */
   /* Default: advance one PNG every 0.50s (tweakable in
    * code; future: config/UI). */
   if (a->anim_overlay_frame_delay_sec <= 0.0f)
     a->anim_overlay_frame_delay_sec = 0.10f;
   a->anim_overlay_accum = 0.0f;
-  a->anim_overlay_frame_idx = 0;
-  const int MAX_FRAMES = 240;
-  SDL_Texture **frames =
-      (SDL_Texture **)calloc((size_t)MAX_FRAMES, sizeof(SDL_Texture *));
-  if (!frames) {
+  /* Straight onto the window surface when possible: frames come
+     premultiplied and each one is a SIMD over-composite that skips the
+     clear pixels, instead of a per-pixel blended texture copy. */
+  const bool direct = overlay_direct_ok(ui);
+  if (!overlay_player_open(dir, a->ambience_tag, ui->w, ui->h, direct,
+                           (size_t)a->cfg.overlay_mb * 1024 * 1024)) {
     a->anim_overlay_enabled = 0;
     return;
   }
-  int count = 0;
-  for (int i = 1; i <= MAX_FRAMES; i++) {
-    char path[PATH_MAX];
-    safe_snprintf(path, sizeof(path), "%s/%s_%03d.png", dir, a->ambience_tag,
-                  i);
-    SDL_Texture *t = load_texture(ui->ren, path);
-    if (!t) {
-      if (count > 0)
-        break;
-      continue;
-    }
-    SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
-    frames[count++] = t;
-  }
-  if (count <= 0) {
-    free(frames);
-    a->anim_overlay_enabled = 0;
-    return;
-  }
-  a->anim_overlay_frames =
-      (SDL_Texture **)realloc(frames, (size_t)count * sizeof(SDL_Texture *));
-  if (!a->anim_overlay_frames)
-    a->anim_overlay_frames = frames;
-  a->anim_overlay_frame_count = count;
+  a->anim_overlay_direct = direct;
+  a->anim_overlay_frame_count = overlay_player_frame_count();
   a->anim_overlay_enabled = 1;
 }
-static void anim_overlay_update(App *a) {
-  if (!a || !a->anim_overlay_enabled || !a->anim_overlay_frames ||
-      a->anim_overlay_frame_count <= 1)
-    return;
-  int old_idx = a->anim_overlay_frame_idx;
+/* Seconds since the last call, clamped; 0 on the first. */
+static float anim_overlay_tick(App *a) {
   uint64_t now = now_ms();
   if (a->anim_overlay_last_ms == 0) {
     a->anim_overlay_last_ms = now;
-    return;
+    return 0.0f;
   }
   float dt = (float)(now - a->anim_overlay_last_ms) / 1000.0f;
   a->anim_overlay_last_ms = now;
@@ -2938,28 +2986,78 @@ static void anim_overlay_update(App *a) {
     dt = 0.0f;
   if (dt > 0.25f)
     dt = 0.25f; /* clamp long hitches */
-  a->anim_overlay_accum += dt;
+  return dt;
+}
+static void anim_overlay_update(App *a) {
+  if (!a || !a->anim_overlay_enabled)
+    return;
+  if (a->anim_particles) {
+    const float dt = anim_overlay_tick(a);
+    if (dt > 0.0f) {
+      particles_update(a->anim_particles, dt);
+      a->ui_needs_redraw = true;
+    }
+    return;
+  }
+  if (!overlay_player_active())
+    return;
+  /* Show the first frame as soon as the player has decoded it. */
+  if (!overlay_player_ready()) {
+    if (overlay_player_advance(0)) {
+      a->anim_overlay_tex_stale = true;
+      a->ui_needs_redraw = true;
+    }
+    return;
+  }
+  if (a->anim_overlay_frame_count <= 1)
+    return;
+  a->anim_overlay_accum += anim_overlay_tick(a);
   float frame_time = (a->anim_overlay_frame_delay_sec > 0.0f)
                          ? a->anim_overlay_frame_delay_sec
                          : 0.50f;
+  int steps = 0;
   while (a->anim_overlay_accum >= frame_time) {
     a->anim_overlay_accum -= frame_time;
-    a->anim_overlay_frame_idx =
-        (a->anim_overlay_frame_idx + 1) % a->anim_overlay_frame_count;
+    steps++;
   }
-  if (a->anim_overlay_frame_idx != old_idx) {
+  /* A frame that wasn't decoded in time is dropped: the old one stays. */
+  if (steps > 0 && overlay_player_advance(steps)) {
+    a->anim_overlay_tex_stale = true;
     a->ui_needs_redraw = true;
   }
 }
 static void anim_overlay_draw(UI *ui, App *a) {
-  if (!ui || !a || !a->anim_overlay_enabled || !a->anim_overlay_frames ||
-      a->anim_overlay_frame_count <= 0)
+  if (!ui || !a || !a->anim_overlay_enabled)
+    return;
+  if (a->anim_particles) {
+    particles_draw(a->anim_particles, ui->ren);
     return;
-  SDL_Texture *t = a->anim_overlay_frames[a->anim_overlay_frame_idx];
-  if (!t)
+  }
+  if (!overlay_player_ready())
+    return;
+  if (a->anim_overlay_direct) {
+    overlay_composite(ui);
+    return;
+  }
+  SDL_Surface *frame = overlay_player_frame();
+  if (!frame)
     return;
+  /* One streaming texture, refreshed when the frame changes. */
+  if (!a->anim_overlay_tex) {
+    a->anim_overlay_tex =
+        SDL_CreateTexture(ui->ren, SDL_PIXELFORMAT_ARGB8888,
+                          SDL_TEXTUREACCESS_STREAMING, frame->w, frame->h);
+    if (!a->anim_overlay_tex)
+      return;
+    SDL_SetTextureBlendMode(a->anim_overlay_tex, SDL_BLENDMODE_BLEND);
+    a->anim_overlay_tex_stale = true;
+  }
+  if (a->anim_overlay_tex_stale) {
+    SDL_UpdateTexture(a->anim_overlay_tex, NULL, frame->pixels, frame->pitch);
+    a->anim_overlay_tex_stale = false;
+  }
   SDL_Rect dst = {0, 0, ui->w, ui->h};
-  SDL_RenderCopy(ui->ren, t, NULL, &dst);
+  SDL_RenderCopy(ui->ren, a->anim_overlay_tex, NULL, &dst);
 }
 /* --- End animated overlay --- */
 /* --- Active-session resume helpers (used when opening
@@ -3158,6 +3256,11 @@ static void ui_close_fonts(UI *ui);
 static bool ui_open_fonts(UI *ui, const AppConfig *cfg);
 
 static void ui_close_fonts(UI *ui) {
+  /* Glyph atlases, cached text and measurements are keyed
+   * by font pointer. */
+  text_atlas_clear();
+  text_cache_clear();
+  text_measure_clear();
   if (ui->font_small) {
     TTF_CloseFont(ui->font_small);
     ui->font_small = NULL;
@@ -3285,6 +3388,7 @@ static void draw_clock_upper_right_stacked(UI *ui, App *a, int xR, int yTop) {
   time_t t = time(NULL);
   struct tm lt;
   localtime_r(&t, &lt);
+  g_clock_shown_min = (long)(t / 60);
   const char *hour_word = hour_to_word_12h(lt.tm_hour);
   char minute_word[64];
   minute_to_words(minute_word, sizeof(minute_word), lt.tm_min);
@@ -3294,10 +3398,9 @@ static void draw_clock_upper_right_stacked(UI *ui, App *a, int xR, int yTop) {
   int yMin = yTop;
   int yHour = yMin + TTF_FontHeight(ui->font_small) + HUD_STACK_GAP;
 
-  draw_text_cached(ui, &a->cache_clock_min, ui->font_small, xR, yMin,
-                   minute_word, accent, true, TTF_STYLE_ITALIC);
-  draw_text_cached(ui, &a->cache_clock_hour, ui->font_med, xR, yHour, hour_word,
-                   main, true, 0);
+  draw_text_style(ui, ui->font_small, xR, yMin, minute_word, accent, true,
+                  TTF_STYLE_ITALIC);
+  draw_text_style(ui, ui->font_med, xR, yHour, hour_word, main, true, 0);
 }
 /* Upper-left stacked clock: hour (normal, med), minute
  * (small italic accent).
@@ -3308,6 +3411,7 @@ static void draw_clock_upper_left_stacked(UI *ui, App *a, int xL, int yTop) {
   time_t t = time(NULL);
   struct tm lt;
   localtime_r(&t, &lt);
+  g_clock_shown_min = (long)(t / 60);
   const char *hour_word = hour_to_word_12h(lt.tm_hour);
   char minute_word[64];
   minute_to_words(minute_word, sizeof(minute_word), lt.tm_min);
@@ -3317,15 +3421,15 @@ static void draw_clock_upper_left_stacked(UI *ui, App *a, int xL, int yTop) {
   int yMin = yTop;
   int yHour = yMin + TTF_FontHeight(ui->font_small) + HUD_STACK_GAP;
 
-  draw_text_cached(ui, &a->cache_clock_min, ui->font_small, xL, yMin,
-                   minute_word, accent, false, TTF_STYLE_ITALIC);
-  draw_text_cached(ui, &a->cache_clock_hour, ui->font_med, xL, yHour, hour_word,
-                   main, false, 0);
+  draw_text_style(ui, ui->font_small, xL, yMin, minute_word, accent, false,
+                  TTF_STYLE_ITALIC);
+  draw_text_style(ui, ui->font_med, xL, yHour, hour_word, main, false, 0);
 }
 static void draw_battery_upper_right_stacked(UI *ui, App *a, int xR, int yTop) {
   SDL_Color main = color_from_idx(a->cfg.main_color_idx);
   SDL_Color accent = color_from_idx(a->cfg.accent_color_idx);
   battery_tick_update();
+  g_batt_shown = true;
   char top_word[64];
   const char *bottom_word = "percent";
   if (g_batt_percent < 0) {
@@ -3340,10 +3444,9 @@ static void draw_battery_upper_right_stacked(UI *ui, App *a, int xR, int yTop) {
   int yPercent = yTop;
   int yBattery = yPercent + TTF_FontHeight(ui->font_small) + HUD_STACK_GAP;
 
-  draw_text_cached(ui, &a->cache_batt_bottom, ui->font_small, xR, yPercent,
-                   bottom_word, accent, true, TTF_STYLE_ITALIC);
-  draw_text_cached(ui, &a->cache_batt_top, ui->font_med, xR, yBattery, top_word,
-                   main, true, 0);
+  draw_text_style(ui, ui->font_small, xR, yPercent, bottom_word, accent, true,
+                  TTF_STYLE_ITALIC);
+  draw_text_style(ui, ui->font_med, xR, yBattery, top_word, main, true, 0);
 }
 static void sync_font_list(App *a) {
   sl_free(&a->fonts);
@@ -3362,10 +3465,13 @@ static void sync_meditation_bell_indices(App *a);
 static void sync_bell_list(App *a) {
   sl_free(&a->bell_sounds);
   a->bell_sounds = list_wav_files_in("sounds");
-  if (a->bell_sounds.count == 0) {
+  /* The first entry is what unknown config values fall back to, so keep it
+     a file even when sounds/ has none. */
+  if (a->bell_sounds.count == 0)
     sl_push(&a->bell_sounds, "bell.wav");
-    sl_sort(&a->bell_sounds);
-  }
+  /* Synthesized presets follow the WAV files; they need no assets. */
+  for (int i = 0; i < bell_synth_preset_count(); i++)
+    sl_push(&a->bell_sounds, bell_synth_preset_at(i)->name);
   int p = sl_find(&a->bell_sounds, a->cfg.bell_phase_file);
   int d = sl_find(&a->bell_sounds, a->cfg.bell_done_file);
   if (p < 0) {
@@ -3443,6 +3549,12 @@ static void sync_ambience_list(App *a) {
     }
   }
   sl_free(&files);
+  /* Built-in generators, rendered by the mixer. */
+  for (int k = AMBIENCE_GEN_WHITE; k <= AMBIENCE_GEN_WIND; k++) {
+    const char *name = ambience_gen_name((AmbienceGenKind)k);
+    if (sl_find(&a->ambience_sounds, name) < 0)
+      sl_push(&a->ambience_sounds, name);
+  }
   int idx = sl_find(&a->ambience_sounds, a->cfg.ambience_name);
   a->ambience_idx = (idx >= 0) ? idx : 0;
   if (idx < 0) {
@@ -3450,51 +3562,6 @@ static void sync_ambience_list(App *a) {
                   a->ambience_sounds.items[0]);
   }
 }
-static void ambience_path_from_name(const App *a, char *out, size_t cap) {
-  if (!out || cap == 0)
-    return;
-  out[0] = 0;
-  if (!a || a->scenes.count == 0)
-    return;
-  const char *loc = a->scenes.items[a->scene_idx];
-  const char *mood = (a->moods.count > 0) ? a->moods.items[a->mood_idx] : "";
-  char pref[PATH_MAX];
-  /* Preferred names: ambience.mp3, then ambience.wav */
-  if (mood && mood[0]) {
-    safe_snprintf(pref, sizeof(pref), "scenes/%s/%s/ambience.mp3", loc, mood);
-    if (is_file(pref)) {
-      safe_snprintf(out, cap, "%s", pref);
-      return;
-    }
-    safe_snprintf(pref, sizeof(pref), "scenes/%s/%s/ambience.wav", loc, mood);
-    if (is_file(pref)) {
-      safe_snprintf(out, cap, "%s", pref);
-      return;
-    }
-  } else {
-    safe_snprintf(pref, sizeof(pref), "scenes/%s/ambience.mp3", loc);
-    if (is_file(pref)) {
-      safe_snprintf(out, cap, "%s", pref);
-      return;
-    }
-    safe_snprintf(pref, sizeof(pref), "scenes/%s/ambience.wav", loc);
-    if (is_file(pref)) {
-      safe_snprintf(out, cap, "%s", pref);
-      return;
-    }
-  }
-  /* Fallback: first audio file in the mood folder. */
-  char root[PATH_MAX];
-  if (mood && mood[0])
-    safe_snprintf(root, sizeof(root), "scenes/%s/%s", loc, mood);
-  else
-    safe_snprintf(root, sizeof(root), "scenes/%s", loc);
-  StrList aud = list_audio_files_in(root);
-  if (aud.count > 0) {
-    safe_snprintf(out, cap, "%s/%s", root, aud.items[0]);
-  }
-  sl_free(&aud);
-}
 /* Forward declarations for ambience-tag/background
  * helpers (defined below). */
 static bool split_trailing_tag(const char *in, char *base_out, size_t base_cap,
@@ -3525,7 +3592,7 @@ static void apply_ambience_from_cfg(UI *ui, App *a, bool restart_if_same) {
     return;
   }
   char path[512];
-  ambience_path_from_name(a, path, sizeof(path));
+  music_player_ambience_path_from_name(a, path, sizeof(path));
   if (!path[0]) {
     if (a->audio)
       audio_engine_set_ambience_paused(a->audio, true);
@@ -3987,7 +4054,7 @@ static void sync_ambience_tag_from_cfg(App *a) {
   {
     char p[PATH_MAX];
     p[0] = 0;
-    ambience_path_from_name(a, p, sizeof(p));
+    music_player_ambience_path_from_name(a, p, sizeof(p));
     if (!p[0])
       return;
   }
@@ -4165,206 +4232,79 @@ static void apply_detected_weather(UI *ui, App *a, bool persist) {
   if (persist)
     config_save(&a->cfg, CONFIG_PATH);
 }
-/* ----------------------------- Stack Blur
- * ----------------------------- */
-static void stack_blur_rgba(Uint32 *pix, int w, int h, int radius) {
-  if (radius < 1)
-    return;
-  int wm = w - 1;
-  int hm = h - 1;
-  int wh = w * h;
-  int div = radius + radius + 1;
-  int *r = (int *)malloc(wh * sizeof(int));
-  int *g = (int *)malloc(wh * sizeof(int));
-  int *b = (int *)malloc(wh * sizeof(int));
-  int rsum, gsum, bsum, x, y, i, p, yp, yi, yw;
-  int *vmin = (int *)malloc((MAX(w, h)) * sizeof(int));
-  int divsum = (div + 1) >> 1;
-  divsum *= divsum;
-  int *dv = (int *)malloc(256 * divsum * sizeof(int));
-  for (i = 0; i < 256 * divsum; i++) {
-    dv[i] = (i / divsum);
-  }
-  yw = yi = 0;
-  int **stack = (int **)malloc(div * sizeof(int *));
-  for (i = 0; i < div; i++)
-    stack[i] = (int *)malloc(3 * sizeof(int));
-  int stackpointer;
-  int stackstart;
-  int *sir;
-  int rbs;
-  int r1 = radius + 1;
-  int routsum, goutsum, boutsum;
-  int rinsum, ginsum, binsum;
-
-  for (y = 0; y < h; y++) {
-    rinsum = ginsum = binsum = routsum = goutsum = boutsum = rsum = gsum =
-        bsum = 0;
-    for (i = -radius; i <= radius; i++) {
-      p = pix[yi + MIN(wm, MAX(i, 0))];
-      sir = stack[i + radius];
-      sir[0] = (p & 0xff0000) >> 16;
-      sir[1] = (p & 0x00ff00) >> 8;
-      sir[2] = (p & 0x0000ff);
-      rbs = r1 - abs(i);
-      rsum += sir[0] * rbs;
-      gsum += sir[1] * rbs;
-      bsum += sir[2] * rbs;
-      if (i > 0) {
-        rinsum += sir[0];
-        ginsum += sir[1];
-        binsum += sir[2];
-      } else {
-        routsum += sir[0];
-        goutsum += sir[1];
-        boutsum += sir[2];
-      }
-    }
-    stackpointer = radius;
-
-    for (x = 0; x < w; x++) {
-      r[yi] = dv[rsum];
-      g[yi] = dv[gsum];
-      b[yi] = dv[bsum];
-
-      rsum -= routsum;
-      gsum -= goutsum;
-      bsum -= boutsum;
-
-      stackstart = stackpointer - radius + div;
-      sir = stack[stackstart % div];
-
-      routsum -= sir[0];
-      goutsum -= sir[1];
-      boutsum -= sir[2];
-
-      if (y == 0) {
-        vmin[x] = MIN(x + radius + 1, wm);
-      }
-      p = pix[yw + vmin[x]];
-
-      sir[0] = (p & 0xff0000) >> 16;
-      sir[1] = (p & 0x00ff00) >> 8;
-      sir[2] = (p & 0x0000ff);
-
-      rinsum += sir[0];
-      ginsum += sir[1];
-      binsum += sir[2];
-
-      rsum += rinsum;
-      gsum += ginsum;
-      bsum += binsum;
-
-      stackpointer = (stackpointer + 1) % div;
-      sir = stack[(stackpointer) % div];
-
-      routsum += sir[0];
-      goutsum += sir[1];
-      boutsum += sir[2];
-
-      rinsum -= sir[0];
-      ginsum -= sir[1];
-      binsum -= sir[2];
-
-      yi++;
-    }
-    yw += w;
-  }
-  for (x = 0; x < w; x++) {
-    rinsum = ginsum = binsum = routsum = goutsum = boutsum = rsum = gsum =
-        bsum = 0;
-    yp = -radius * w;
-    for (i = -radius; i <= radius; i++) {
-      yi = MAX(0, yp) + x;
-      sir = stack[i + radius];
-      sir[0] = r[yi];
-      sir[1] = g[yi];
-      sir[2] = b[yi];
-      rbs = r1 - abs(i);
-      rsum += r[yi] * rbs;
-      gsum += g[yi] * rbs;
-      bsum += b[yi] * rbs;
-      if (i > 0) {
-        rinsum += sir[0];
-        ginsum += sir[1];
-        binsum += sir[2];
-      } else {
-        routsum += sir[0];
-        goutsum += sir[1];
-        boutsum += sir[2];
-      }
-      if (i < hm) {
-        yp += w;
-      }
-    }
-    yi = x;
-    stackpointer = radius;
-    for (y = 0; y < h; y++) {
-      pix[yi] = (0xff000000) | (dv[rsum] << 16) | (dv[gsum] << 8) | dv[bsum];
-
-      rsum -= routsum;
-      gsum -= goutsum;
-      bsum -= boutsum;
-
-      stackstart = stackpointer - radius + div;
-      sir = stack[stackstart % div];
-
-      routsum -= sir[0];
-      goutsum -= sir[1];
-      boutsum -= sir[2];
-
-      if (x == 0) {
-        vmin[y] = MIN(y + r1, hm) * w;
+/* Uploads a decoded image, builds its layers and shows it through the
+   background cache (NULL, or a failed decode, clears the background). Frees
+   the image. */
+static void bg_apply_image(UI *ui, BgImage *img) {
+  bg_use(ui, NULL);
+  if (img && img->full) {
+    /* The image is already screen size; opaque ones upload in the
+       window's format, so drawing them is a plain copy. */
+    ui->bg_tex =
+        asset_texture(ui->ren, img->full, ui->pixel_format, img->opaque);
+    if (img->blur) {
+      /* Always drawn unblended (and scaled up). */
+      ui->bg_blur_tex =
+          asset_texture(ui->ren, img->blur, ui->pixel_format, true);
+      if (ui->bg_blur_tex)
+        SDL_SetTextureScaleMode(ui->bg_blur_tex, SDL_ScaleModeLinear);
+    }
+    if (ui->bg_tex)
+      bg_layers_build(ui);
+    BgTextures t = {ui->bg_tex, ui->bg_blur_tex, {NULL}};
+    memcpy(t.layers, ui->bg_layers, sizeof(t.layers));
+    bg_use(ui, bg_cache_insert(img->path, img->mtime, &t));
+  }
+  bg_image_free(img);
+}
+/* Queues the backgrounds one step either way in the vibe and time-of-day
+   cycles. (Location, mood and season neighbours would need their folders
+   rescanned, so those cycles only get the async decode.) */
+static void bg_prefetch_neighbours(App *a, const char *root) {
+  char p[PATH_MAX];
+  for (int d = -1; d <= 1; d += 2) {
+    if (a->weathers.count > 1) {
+      int i = (a->weather_idx + d + a->weathers.count) % a->weathers.count;
+      safe_snprintf(p, sizeof(p), "%s/%s", root, a->weathers.items[i]);
+      if (!bg_cache_contains(p, file_mtime(p)))
+        bg_loader_prefetch(p);
+    }
+  }
+  for (int d = -1; d <= 1; d += 2) {
+    if (a->weather_bases.count > 1) {
+      int bi = (a->weather_base_idx + d + a->weather_bases.count) %
+               a->weather_bases.count;
+      int wi = find_weather_idx_for_base_and_tag(
+          a, a->weather_bases.items[bi], a->ambience_tag);
+      if (wi >= 0 && wi != a->weather_idx) {
+        safe_snprintf(p, sizeof(p), "%s/%s", root, a->weathers.items[wi]);
+        if (!bg_cache_contains(p, file_mtime(p)))
+          bg_loader_prefetch(p);
       }
-      p = x + vmin[y];
-
-      sir[0] = r[p];
-      sir[1] = g[p];
-      sir[2] = b[p];
-
-      rinsum += sir[0];
-      ginsum += sir[1];
-      binsum += sir[2];
-
-      rsum += rinsum;
-      gsum += ginsum;
-      bsum += binsum;
-
-      stackpointer = (stackpointer + 1) % div;
-      sir = stack[stackpointer];
-
-      routsum += sir[0];
-      goutsum += sir[1];
-      boutsum += sir[2];
-
-      rinsum -= sir[0];
-      ginsum -= sir[1];
-      binsum -= sir[2];
-
-      yi += w;
     }
   }
-  free(r);
-  free(g);
-  free(b);
-  free(vmin);
-  free(dv);
-  for (i = 0; i < div; i++)
-    free(stack[i]);
-  free(stack);
 }
-
-static void update_bg_texture(UI *ui, App *a) {
-  if (ui->bg_tex) {
-    SDL_DestroyTexture(ui->bg_tex);
-    ui->bg_tex = NULL;
-  }
-  if (ui->bg_blur_tex) {
-    SDL_DestroyTexture(ui->bg_blur_tex);
-    ui->bg_blur_tex = NULL;
+/* Queues disk-cache builds for every background of the current scene, so
+   switching weather or time of day later never has to decode. */
+static void bg_warm_scene(App *a, const char *root) {
+  static char warmed[PATH_MAX];
+  if (!bg_disk_enabled() || strcmp(warmed, root) == 0)
+    return;
+  safe_snprintf(warmed, sizeof(warmed), "%s", root);
+  char p[PATH_MAX];
+  for (int i = 0; i < a->weathers.count; i++) {
+    if (i == a->weather_idx)
+      continue;
+    safe_snprintf(p, sizeof(p), "%s/%s", root, a->weathers.items[i]);
+    bg_loader_warm(p);
   }
-  if (a->scenes.count == 0 || a->weathers.count == 0)
+}
+static void update_bg_texture(UI *ui, App *a) {
+  if (a->scenes.count == 0 || a->weathers.count == 0) {
+    bg_loader_request(NULL);
+    bg_apply_image(ui, NULL);
     return;
+  }
   const char *scene = a->scenes.items[a->scene_idx];
   const char *file = a->weathers.items[a->weather_idx];
   char root[PATH_MAX];
@@ -4372,75 +4312,30 @@ static void update_bg_texture(UI *ui, App *a) {
   char path[PATH_MAX];
   safe_snprintf(path, sizeof(path), "%s/%s", root, file);
 
-  /* Load surface directly to generate both normal and
-   * blurred textures */
-  if (is_file(path)) {
-    SDL_Surface *s = IMG_Load(path);
-    if (s) {
-      ui->bg_tex = SDL_CreateTextureFromSurface(ui->ren, s);
-
-      /* Generate blurred version */
-      int sw = ui->w / 8;
-      int sh = ui->h / 8;
-      if (sw < 16)
-        sw = 16;
-      if (sh < 16)
-        sh = 16;
-
-      /* Convert source to ARGB8888 for safe pixel
-       * reading */
-      SDL_Surface *s_argb =
-          SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
-      if (s_argb) {
-        Uint32 *blur_buf = (Uint32 *)malloc(sw * sh * sizeof(Uint32));
-        if (blur_buf) {
-          /* Manual nearest-neighbor downscale to avoid
-           * BlitScaled issues */
-          if (SDL_MUSTLOCK(s_argb))
-            SDL_LockSurface(s_argb);
-
-          Uint8 *src_bytes = (Uint8 *)s_argb->pixels;
-          int src_pitch = s_argb->pitch;
-          int src_w = s_argb->w;
-          int src_h = s_argb->h;
-
-          for (int y = 0; y < sh; y++) {
-            int sy = y * src_h / sh;
-            Uint8 *row = src_bytes + (sy * src_pitch);
-            for (int x = 0; x < sw; x++) {
-              int sx = x * src_w / sw;
-              /* ARGB8888 is 4 bytes per pixel */
-              blur_buf[y * sw + x] = *(Uint32 *)(row + sx * 4);
-            }
-          }
-
-          if (SDL_MUSTLOCK(s_argb))
-            SDL_UnlockSurface(s_argb);
-
-          /* Blur the buffer */
-          stack_blur_rgba(blur_buf, sw, sh, 2);
-
-          /* Create texture from buffer using a
-           * temporary surface wrapper */
-          SDL_Surface *blur_surf = SDL_CreateRGBSurfaceWithFormatFrom(
-              blur_buf, sw, sh, 32, sw * 4, SDL_PIXELFORMAT_ARGB8888);
-
-          if (blur_surf) {
-            ui->bg_blur_tex = SDL_CreateTextureFromSurface(ui->ren, blur_surf);
-            if (ui->bg_blur_tex) {
-              SDL_SetTextureScaleMode(ui->bg_blur_tex, SDL_ScaleModeLinear);
-              SDL_SetTextureBlendMode(ui->bg_blur_tex, SDL_BLENDMODE_NONE);
-            }
-            SDL_FreeSurface(blur_surf);
-          }
-          free(blur_buf);
-        }
-        SDL_FreeSurface(s_argb);
-      }
-
-      SDL_FreeSurface(s);
-    }
+  const bool exists = is_file(path);
+  const BgTextures *cached =
+      exists ? bg_cache_lookup(path, file_mtime(path)) : NULL;
+  if (!exists) {
+    bg_loader_request(NULL);
+    bg_apply_image(ui, NULL);
+  } else if (cached) {
+    /* Seen recently: just swap the textures in. */
+    bg_loader_request(NULL);
+    bg_use(ui, cached);
+    bg_prefetch_neighbours(a, root);
+  } else if (ui->bg_tex && bg_loader_running()) {
+    /* Keep the current background on screen; the main loop swaps
+     * in the new one once the worker has decoded it. */
+    bg_loader_request(path);
+    bg_prefetch_neighbours(a, root);
+  } else {
+    /* Nothing on screen yet (startup): decode in place. */
+    bg_loader_request(NULL);
+    bg_apply_image(ui, bg_image_load(path, ui->w, ui->h));
+    bg_prefetch_neighbours(a, root);
   }
+  if (exists)
+    bg_warm_scene(a, root);
   /* "scene_name" is the LOCATION label (e.g., Home).
    * Mood is shown on the
    * "...and ..." line. */
@@ -4813,8 +4708,9 @@ static void tick_one_second(App *a) {
   if (a->session_complete)
     return;
   /* Any one-second tick affects something visible (time
-   * readout, progress, labels). */
-  a->ui_needs_redraw = true;
+   * readout, progress, labels), but normally only the live
+   * widgets; phase changes below ask for a full redraw. */
+  a->ui_tick_damage = true;
   /* Accumulate focused time for the current run.
      Pomodoro breaks are not counted. */
   if (a->mode == MODE_POMODORO) {
@@ -4832,6 +4728,7 @@ static void tick_one_second(App *a) {
       a->pomo_remaining_seconds--;
     if (a->pomo_remaining_seconds == 0) {
       /* Phase ended: ring, then transition. */
+      a->ui_needs_redraw = true;
       bool will_finish = false;
       if (!a->pomo_is_break) {
         /* Focus ended -> we have completed one focus
@@ -4899,6 +4796,7 @@ static void tick_one_second(App *a) {
         a->paused = false;
         a->session_complete = true;
         a->run_focus_seconds = 0;
+        a->ui_needs_redraw = true;
         return;
       }
     }
@@ -4926,6 +4824,7 @@ static void tick_one_second(App *a) {
         a->paused = false;
         a->session_complete = true;
         a->run_focus_seconds = 0;
+        a->ui_needs_redraw = true;
         return;
       }
     }
@@ -4948,6 +4847,7 @@ static void tick_one_second(App *a) {
       a->session_complete = true;
       a->run_focus_seconds = 0;
       a->hud_hidden = false; /* Reveal HUD when meditation ends */
+      a->ui_needs_redraw = true;
       return;
     }
     if (a->meditation_run_kind == 0 &&
@@ -5208,14 +5108,26 @@ void mood_display_from_folder(const char *in, char *out, size_t cap) {
  * later) */
 #define SONG_LABEL_MAX_CHARS 40
 
+/* Plays a bell by its settings name: a synthesized preset (see bell_synth.h)
+   or a file under sounds/. Ignores the notifications toggle (previews). */
+static void play_bell_sound(App *a, const char *name) {
+  if (!a || !a->audio || !name || !name[0])
+    return;
+  const BellPreset *preset = bell_synth_find(name);
+  if (preset) {
+    audio_engine_play_bell(a->audio, preset);
+    return;
+  }
+  char path[PATH_MAX];
+  safe_snprintf(path, sizeof(path), "sounds/%s", name);
+  audio_engine_play_sfx(a->audio, path);
+}
 static void play_bell_named(App *a, const char *filename) {
   if (!a || !a->audio || !filename || !filename[0])
     return;
   if (!a->cfg.notifications_enabled)
     return;
-  char path[PATH_MAX];
-  safe_snprintf(path, sizeof(path), "sounds/%s", filename);
-  audio_engine_play_sfx(a->audio, path);
+  play_bell_sound(a, filename);
 }
 static void play_bell_phase(App *a) {
   play_bell_named(a, a->cfg.bell_phase_file);
@@ -5236,9 +5148,7 @@ static void meditation_queue_bell_sequence(App *a, const char *filename,
   a->meditation_bell_strikes_remaining = strikes;
   a->meditation_bell_strike_elapsed = 0.0f;
   if (a->meditation_bell_strikes_remaining > 0) {
-    char path[PATH_MAX];
-    safe_snprintf(path, sizeof(path), "sounds/%s", filename);
-    audio_engine_play_sfx(a->audio, path);
+    play_bell_sound(a, filename);
     a->meditation_bell_strikes_remaining--;
   }
 }
@@ -5251,10 +5161,7 @@ static void meditation_bell_strike_update(App *a, float dt_sec) {
   }
   a->meditation_bell_strike_elapsed += dt_sec;
   if (a->meditation_bell_strike_elapsed >= 1.0f) {
-    char path[PATH_MAX];
-    safe_snprintf(path, sizeof(path), "sounds/%s",
-                  a->meditation_bell_strike_file);
-    audio_engine_play_sfx(a->audio, path);
+    play_bell_sound(a, a->meditation_bell_strike_file);
     a->meditation_bell_strikes_remaining--;
     a->meditation_bell_strike_elapsed = 0.0f;
   }
@@ -7008,7 +6915,7 @@ static void draw_poetic_stack_upper_right(UI *ui, App *a, int xR, int y_top,
   {
     char p[PATH_MAX];
     p[0] = 0;
-    ambience_path_from_name(a, p, sizeof(p));
+    music_player_ambience_path_from_name(a, p, sizeof(p));
     ambience_file_present = (p[0] != 0);
   }
   const bool ambience_audible =
@@ -7073,7 +6980,13 @@ static void draw_poetic_stack_upper_right(UI *ui, App *a, int xR, int y_top,
   }
 }
 
+static void draw_top_hud_body(UI *ui, App *a);
 void draw_top_hud(UI *ui, App *a) {
+  const uint64_t t = prof_begin();
+  draw_top_hud_body(ui, a);
+  prof_end(PROF_HUD, t);
+}
+static void draw_top_hud_body(UI *ui, App *a) {
   SDL_Color main = color_from_idx(a->cfg.main_color_idx);
   SDL_Color accent = color_from_idx(a->cfg.accent_color_idx);
 
@@ -7194,6 +7107,8 @@ void draw_top_hud(UI *ui, App *a) {
   int y2 = y1 + TTF_FontHeight(ui->font_med) + HUD_STACK_GAP;
   if (y2 < y1 + 1)
     y2 = y1 + 1;
+  /* Mode/status lines and the poetic stack share this band. */
+  ui_mark_live(ui, y1, y2 + TTF_FontHeight(ui->font_med) - y1);
   /* Left side */
   bool left_is_pomo_progress = false;
   char left_main[256] = {0};
@@ -7385,8 +7300,8 @@ static void draw_big_time_upper_left(UI *ui, App *a, const char *s) {
   int y2 = UI_MARGIN_TOP + UI_ROW_GAP;
   int y = y2 + UI_ROW_GAP + TIMER_TOP_PAD;
   int x = TIMER_LEFT_X;
-  draw_text_cached(ui, &a->cache_big_time, ui->font_big, x, y, s ? s : "", main,
-                   false, 0);
+  draw_text_style(ui, ui->font_big, x, y, s ? s : "", main, false, 0);
+  ui_mark_live(ui, y, TTF_FontHeight(ui->font_big));
 }
 static void format_ordinal(char *out, size_t out_sz, int n1) {
   /* n1 is 1-based */
@@ -7440,21 +7355,9 @@ static void draw_stopwatch_laps(UI *ui, App *a) {
 }
 static void draw_session_complete_upper_left(UI *ui, App *a, const char *msg) {
   SDL_Color main = color_from_idx(a->cfg.main_color_idx);
-  SDL_Surface *surf = render_text_surface(ui->font_med, msg, main);
-  if (!surf)
-    return;
-  SDL_Texture *tex = SDL_CreateTextureFromSurface(ui->ren, surf);
-  if (!tex) {
-    SDL_FreeSurface(surf);
-    return;
-  }
   int y2 = UI_MARGIN_TOP + UI_ROW_GAP;
   int y = y2 + UI_ROW_GAP + TIMER_TOP_PAD + 10;
-  int x = TIMER_LEFT_X;
-  SDL_Rect dst = {x, y, surf->w, surf->h};
-  SDL_RenderCopy(ui->ren, tex, NULL, &dst);
-  SDL_DestroyTexture(tex);
-  SDL_FreeSurface(surf);
+  draw_text(ui, ui->font_med, TIMER_LEFT_X, y, msg, main, false);
 }
 /* ----------------------------- Settings headers
  * -----------------------------
@@ -7500,6 +7403,10 @@ static int about_wrap_count(UI *ui, TTF_Font *font, const char *text,
     return 0;
   if (!text[0])
     return 1;
+  /* Lines are summed word advances, measured whole only near max_w; see
+     text_measure_line_fits(). */
+  const int fstyle = TTF_GetFontStyle(font);
+  const int space_w = text_measure_advance(font, fstyle, ' ');
   int count = 0;
   const char *p = text;
   while (*p) {
@@ -7510,6 +7417,7 @@ static int about_wrap_count(UI *ui, TTF_Font *font, const char *text,
     }
     char line[4096] = {0};
     int line_len = 0;
+    int line_w = 0;
     while (*p && *p != '\n') {
       while (*p == ' ')
         p++;
@@ -7528,14 +7436,18 @@ static int about_wrap_count(UI *ui, TTF_Font *font, const char *text,
         safe_snprintf(trial, sizeof(trial), "%s", word);
       else
         safe_snprintf(trial, sizeof(trial), "%s %s", line, word);
-      int w = text_width(font, trial);
-      if (w <= max_w || line_len == 0) {
+      const int word_w = text_measure_sum(font, fstyle, word);
+      const int w = line_len == 0 ? word_w : line_w + space_w + word_w;
+      if (line_len == 0 ||
+          text_measure_line_fits(font, fstyle, trial, w, max_w)) {
         safe_snprintf(line, sizeof(line), "%s", trial);
         line_len = (int)strlen(line);
+        line_w = w;
       } else {
         count++;
         safe_snprintf(line, sizeof(line), "%s", word);
         line_len = (int)strlen(line);
+        line_w = word_w;
       }
     }
     if (line_len > 0)
@@ -7553,6 +7465,9 @@ static bool about_draw_wrapped(UI *ui, TTF_Font *font, int x, int *y, int row_h,
     return false;
   if (!text[0])
     text = "(no release notes available.)";
+  /* Must break lines exactly like about_wrap_count(). */
+  const int fstyle = TTF_GetFontStyle(font);
+  const int space_w = text_measure_advance(font, fstyle, ' ');
   const char *p = text;
   while (*p) {
     if (*p == '\n') {
@@ -7569,6 +7484,7 @@ static bool about_draw_wrapped(UI *ui, TTF_Font *font, int x, int *y, int row_h,
     }
     char line[4096] = {0};
     int line_len = 0;
+    int line_w = 0;
     while (*p && *p != '\n') {
       while (*p == ' ')
         p++;
@@ -7587,10 +7503,13 @@ static bool about_draw_wrapped(UI *ui, TTF_Font *font, int x, int *y, int row_h,
         safe_snprintf(trial, sizeof(trial), "%s", word);
       else
         safe_snprintf(trial, sizeof(trial), "%s %s", line, word);
-      int w = text_width(font, trial);
-      if (w <= max_w || line_len == 0) {
+      const int word_w = text_measure_sum(font, fstyle, word);
+      const int w = line_len == 0 ? word_w : line_w + space_w + word_w;
+      if (line_len == 0 ||
+          text_measure_line_fits(font, fstyle, trial, w, max_w)) {
         safe_snprintf(line, sizeof(line), "%s", trial);
         line_len = (int)strlen(line);
+        line_w = w;
       } else {
         if (*skip > 0) {
           (*skip)--;
@@ -7606,6 +7525,7 @@ static bool about_draw_wrapped(UI *ui, TTF_Font *font, int x, int *y, int row_h,
         }
         safe_snprintf(line, sizeof(line), "%s", word);
         line_len = (int)strlen(line);
+        line_w = word_w;
       }
     }
     if (line_len > 0) {
@@ -7730,9 +7650,11 @@ static void draw_release_popup(UI *ui, App *a) {
    Band 0 Y (center) should be 160 + 22 = 182? No, Band
    0 center aligns with PICKER_HEADER_Y (160) roughly?
    Actually comment says "Target Band 0 Y = 160 + 22 =
-   182". So CY = 182 + 195 = 377. */
-#define CIRCLE_LAYOUT_CY 377
-#define CIRCLE_LAYOUT_R 350
+   182". So CY = 182 + 195 = 377. Those figures are for
+   the default 1024x768 window; the centre and radius
+   scale with the size actually granted. */
+#define CIRCLE_LAYOUT_CY(ui) ((ui)->h * 377 / UI_DEFAULT_H)
+#define CIRCLE_LAYOUT_R(ui) ((ui)->w * 350 / UI_DEFAULT_W)
 #define CIRCLE_LAYOUT_BANDS 7
 #define CIRCLE_LAYOUT_BAND_H 45
 #define CIRCLE_LAYOUT_GAP 20 // Reduced to 20
@@ -7744,7 +7666,7 @@ typedef struct {
   int x_left;
 } CircleBand;
 
-static CircleBand get_circle_band(int idx) {
+static CircleBand get_circle_band(const UI *ui, int idx) {
   if (idx < 0 || idx >= CIRCLE_LAYOUT_BANDS)
     return (CircleBand){0};
 
@@ -7756,7 +7678,7 @@ static CircleBand get_circle_band(int idx) {
    * other bands down by 22px.
    */
   int extra_offset = (idx > 0) ? 22 : 0;
-  int y_c = CIRCLE_LAYOUT_CY + (offset_steps * step) + extra_offset;
+  int y_c = CIRCLE_LAYOUT_CY(ui) + (offset_steps * step) + extra_offset;
 
   // Calculate safe width
   // The band extends from y_c - H/2 to y_c + H/2.
@@ -7765,24 +7687,25 @@ static CircleBand get_circle_band(int idx) {
   int y_top = y_c - CIRCLE_LAYOUT_BAND_H / 2;
   int y_bot = y_c + CIRCLE_LAYOUT_BAND_H / 2;
 
-  int dy_top = abs(y_top - CIRCLE_LAYOUT_CY);
-  int dy_bot = abs(y_bot - CIRCLE_LAYOUT_CY);
+  int dy_top = abs(y_top - CIRCLE_LAYOUT_CY(ui));
+  int dy_bot = abs(y_bot - CIRCLE_LAYOUT_CY(ui));
   int dy_max = (dy_top > dy_bot) ? dy_top : dy_bot;
 
   int half_w = 0;
-  if (dy_max < CIRCLE_LAYOUT_R) {
-    half_w = (int)sqrt(CIRCLE_LAYOUT_R * CIRCLE_LAYOUT_R - dy_max * dy_max);
+  const int r = CIRCLE_LAYOUT_R(ui);
+  if (dy_max < r) {
+    half_w = (int)sqrt(r * r - dy_max * dy_max);
   }
 
   return (CircleBand){.y_center = y_c,
                       .height = CIRCLE_LAYOUT_BAND_H,
                       .width_at_limit = half_w * 2,
-                      .x_left = CIRCLE_LAYOUT_CX - half_w};
+                      .x_left = CIRCLE_LAYOUT_CX(ui) - half_w};
 }
 
 void draw_text_centered_band(UI *ui, TTF_Font *font, int band_idx,
                              const char *text, SDL_Color color) {
-  CircleBand b = get_circle_band(band_idx);
+  CircleBand b = get_circle_band(ui, band_idx);
   if (b.height == 0)
     return;
   /* Clamp width to USABLE_COLUMN_WIDTH to ensure
@@ -7798,10 +7721,10 @@ void draw_text_centered_band(UI *ui, TTF_Font *font, int band_idx,
 
   if (w > max_w) {
     /* Use wrapping instead of truncation */
-    draw_text_wrapped_centered(ui, font, CIRCLE_LAYOUT_CX, y, text, color,
+    draw_text_wrapped_centered(ui, font, CIRCLE_LAYOUT_CX(ui), y, text, color,
                                max_w, 2);
   } else {
-    int x = CIRCLE_LAYOUT_CX - w / 2;
+    int x = CIRCLE_LAYOUT_CX(ui) - w / 2;
     draw_text(ui, font, x, y, text, color, false);
   }
 }
@@ -8173,7 +8096,7 @@ static void draw_settings_overlay(UI *ui, App *a) {
     int x_line2 = (ui->w - w2) / 2;
     int x_line3 = (ui->w - w3) / 2;
 
-    CircleBand b4 = get_circle_band(4);
+    CircleBand b4 = get_circle_band(ui, 4);
     int h_text = TTF_FontHeight(ui->font_small);
     /* Push down slightly to create gap from
      * 'optional downloads' */
@@ -8271,7 +8194,7 @@ static void draw_settings_overlay(UI *ui, App *a) {
 
       /* Move buttons down to Band 4 and 5 to give
        * more room for notes */
-      int y_buttons_start = get_circle_band(4).y_center - 10;
+      int y_buttons_start = get_circle_band(ui, 4).y_center - 10;
 
       if (notes && notes[0]) {
         /* Reduce gap between Title and Notes */
@@ -8361,8 +8284,8 @@ static void draw_settings_overlay(UI *ui, App *a) {
     /* Draw item */
     if (items[idx].strikethrough) {
       int w = text_width(ui->font_small, items[idx].text);
-      int x = CIRCLE_LAYOUT_CX - w / 2;
-      CircleBand b = get_circle_band(band);
+      int x = CIRCLE_LAYOUT_CX(ui) - w / 2;
+      CircleBand b = get_circle_band(ui, band);
       int y = b.y_center - TTF_FontHeight(ui->font_small) / 2;
       draw_text_centered_band(ui, ui->font_small, band, items[idx].text,
                               items[idx].color);
@@ -8386,12 +8309,12 @@ static void draw_settings_overlay(UI *ui, App *a) {
                     (a->settings_view == SET_VIEW_FONTS && sel_idx == 0) ||
                     (a->settings_view == SET_VIEW_MISC && sel_idx == 3));
     if (uses_lr && idx == sel_idx) {
-      CircleBand b = get_circle_band(band);
+      CircleBand b = get_circle_band(ui, band);
       int w = text_width(ui->font_small, items[idx].text);
       int arrow_gap = 12;
-      int x_left = CIRCLE_LAYOUT_CX - w / 2 - arrow_gap -
+      int x_left = CIRCLE_LAYOUT_CX(ui) - w / 2 - arrow_gap -
                    text_width(ui->font_small, "<");
-      int x_right = CIRCLE_LAYOUT_CX + w / 2 + arrow_gap;
+      int x_right = CIRCLE_LAYOUT_CX(ui) + w / 2 + arrow_gap;
       int y = b.y_center - TTF_FontHeight(ui->font_small) / 2;
       draw_text(ui, ui->font_small, x_left, y, "<", main, false);
       draw_text(ui, ui->font_small, x_right, y, ">", main, false);
@@ -8753,7 +8676,7 @@ static int focus_stat_cmp_desc(const void *A, const void *B) {
 
 static const char *stats_section_label(int section) { return "focus"; }
 
-static int stats_pages_for_section(int section) { return 4; }
+static int stats_pages_for_section(int section) { return 6; }
 
 static int date_int_days_ago(int days) {
   time_t now = time(NULL);
@@ -8929,11 +8852,8 @@ static void draw_stats(UI *ui, App *a) {
     }
     y += line_h;
 
-    /* Build the last 35 dates (local time). */
-    char dates[35][11];
+    /* The last 35 days (local time). */
     uint32_t day_secs[35];
-    for (int i = 0; i < 35; i++)
-      day_secs[i] = 0;
 
     time_t now = time(NULL);
     struct tm base_tm;
@@ -8948,38 +8868,7 @@ static void draw_stats(UI *ui, App *a) {
       time_t t = base - (time_t)(34 - i) * 86400;
       struct tm tmv;
       localtime_r(&t, &tmv);
-      strftime(dates[i], sizeof(dates[i]), "%Y-%m-%d", &tmv);
-    }
-
-    /* Sum activity log state into those days. */
-    FILE *f = fopen(ACTIVITY_LOG_PATH, "r");
-    if (f) {
-      char line[256];
-      while (fgets(line, sizeof(line), f)) {
-        trim_ascii_inplace(line);
-        if (!line[0])
-          continue;
-        char *tab = strchr(line, '	');
-        if (!tab)
-          tab = strchr(line, ' ');
-        if (!tab)
-          continue;
-        *tab = 0;
-        const char *date = line;
-        const char *v = tab + 1;
-        while (*v == '	' || *v == ' ')
-          v++;
-        unsigned long secs = strtoul(v, NULL, 10);
-        if (!date[0] || secs == 0)
-          continue;
-        for (int i = 0; i < 35; i++) {
-          if (strcmp(date, dates[i]) == 0) {
-            day_secs[i] += (uint32_t)secs;
-            break;
-          }
-        }
-      }
-      fclose(f);
+      day_secs[i] = activity_rollup_day(date_int_from_tm(&tmv));
     }
 
     /* Draw grid */
@@ -9017,20 +8906,47 @@ static void draw_stats(UI *ui, App *a) {
     y_end = grid_y + rows * cell + (rows - 1) * gap;
     y = y_end;
   } else if (a->stats_section == 0 && a->stats_page == 2) {
-    /* Page 3: activity history (last 30 sessions).
+    /* Page 3: activity history, newest first, a page at a
+     * time (up/down) read from the end of the file.
      */
-    if (a->history_dirty) {
-      focus_history_load_to_cache(a);
-    }
-    int n = a->cached_history_count;
-    FocusHistoryRow *rows = a->cached_history_rows;
-
     int y0 = y;
     int y_limit = overlay_bottom_text_limit_y(ui);
     int row_h = TTF_FontHeight(ui->font_small) + 10;
 
-    draw_text_style(ui, ui->font_small, x, y, "history (last 30 sessions)",
-                    main, false, TTF_STYLE_ITALIC);
+    /* Rows below the title and the column header. */
+    int visible = (y_limit - y) / row_h - 2;
+    if (visible < 1)
+      visible = 1;
+    a->stats_history_rows = visible;
+    if (a->stats_history_scroll < 0)
+      a->stats_history_scroll = 0;
+    if (a->history_dirty ||
+        a->cached_history_first != a->stats_history_scroll ||
+        a->cached_history_max != visible) {
+      focus_history_load_page(a, a->stats_history_scroll, visible);
+    }
+    if (a->cached_history_count == 0 && a->stats_history_scroll > 0) {
+      /* Paged past the oldest row: show the last full page. */
+      int last = history_reader_total() - visible;
+      a->stats_history_scroll = last > 0 ? last : 0;
+      focus_history_load_page(a, a->stats_history_scroll, visible);
+    }
+    int n = a->cached_history_count;
+    FocusHistoryRow *rows = a->cached_history_rows;
+
+    char title[96];
+    const int total = history_reader_total();
+    if (n <= 0)
+      safe_snprintf(title, sizeof(title), "history");
+    else if (total >= 0)
+      safe_snprintf(title, sizeof(title), "history (sessions %d-%d of %d)",
+                    a->stats_history_scroll + 1, a->stats_history_scroll + n,
+                    total);
+    else
+      safe_snprintf(title, sizeof(title), "history (sessions %d-%d)",
+                    a->stats_history_scroll + 1, a->stats_history_scroll + n);
+    draw_text_style(ui, ui->font_small, x, y, title, main, false,
+                    TTF_STYLE_ITALIC);
     y += row_h;
 
     if (n <= 0) {
@@ -9038,21 +8954,11 @@ static void draw_stats(UI *ui, App *a) {
       y += row_h;
       y_end = y;
     } else {
-      int visible = (y_limit - y) / row_h;
-      if (visible < 1)
-        visible = 1;
-
-      int max_scroll = n - visible;
-      if (max_scroll < 0)
-        max_scroll = 0;
-      if (a->stats_history_scroll < 0)
-        a->stats_history_scroll = 0;
-      if (a->stats_history_scroll > max_scroll)
-        a->stats_history_scroll = max_scroll;
 
       int w_dt = text_width(ui->font_small, "YYYY-MM-DD HH:MM");
       int w_dur = text_width(ui->font_small, "99h 59m");
-      int w_st = text_width(ui->font_small, "completed");
+      /* Months compacted by history_log say "12 sessions" here. */
+      int w_st = text_width(ui->font_small, "99 sessions");
       int g = 18;
 
       int x_dt = x;
@@ -9071,11 +8977,7 @@ static void draw_stats(UI *ui, App *a) {
                       TTF_STYLE_ITALIC);
       y += row_h;
 
-      int end_i = a->stats_history_scroll + visible;
-      if (end_i > n)
-        end_i = n;
-
-      for (int i = a->stats_history_scroll; i < end_i; i++) {
+      for (int i = 0; i < n; i++) {
         FocusHistoryRow *r = &rows[i];
         char dur[64];
         format_duration_hm(r->seconds, dur, sizeof(dur));
@@ -9101,44 +9003,165 @@ static void draw_stats(UI *ui, App *a) {
     }
   }
 
+  else if (a->stats_section == 0 && a->stats_page == 3) {
+    /* Page 4: streaks, weeks and months, from the stats
+     * engine.
+     */
+    StatsSummary st;
+    stats_engine_summary(date_int_days_ago(0), &st);
+    char buf[64], buf2[64], tmp[96];
+
+    safe_snprintf(tmp, sizeof(tmp), "%d day%s", st.current_streak,
+                  st.current_streak == 1 ? "" : "s");
+    draw_inline_left(ui, ui->font_small, ui->font_small, x, y,
+                     "current streak:", tmp, main, accent);
+    y += line_h;
+
+    safe_snprintf(tmp, sizeof(tmp), "%d day%s", st.longest_streak,
+                  st.longest_streak == 1 ? "" : "s");
+    draw_inline_left(ui, ui->font_small, ui->font_small, x, y,
+                     "longest streak:", tmp, main, accent);
+    y += line_h;
+
+    format_duration_hm(st.today_secs, buf, sizeof(buf));
+    draw_inline_left(ui, ui->font_small, ui->font_small, x, y, "today:", buf,
+                     main, accent);
+    y += line_h;
+
+    format_duration_hm(st.week_secs, buf, sizeof(buf));
+    format_duration_hm(st.last_week_secs, buf2, sizeof(buf2));
+    safe_snprintf(tmp, sizeof(tmp), "%s (last week %s)", buf, buf2);
+    draw_inline_left(ui, ui->font_small, ui->font_small, x, y, "this week:",
+                     tmp, main, accent);
+    y += line_h;
+
+    format_duration_hm(st.month_secs, buf, sizeof(buf));
+    format_duration_hm(st.last_month_secs, buf2, sizeof(buf2));
+    safe_snprintf(tmp, sizeof(tmp), "%s (last month %s)", buf, buf2);
+    draw_inline_left(ui, ui->font_small, ui->font_small, x, y, "this month:",
+                     tmp, main, accent);
+    y += line_h;
+
+    if (st.best_day_date > 0) {
+      char day[16];
+      date_str_from_int(st.best_day_date, day, sizeof(day));
+      format_duration_hm(st.best_day_secs, buf, sizeof(buf));
+      safe_snprintf(tmp, sizeof(tmp), "%s (%s)", buf, day);
+      draw_inline_left(ui, ui->font_small, ui->font_small, x, y, "best day:",
+                       tmp, main, accent);
+      y += line_h;
+    }
+
+    safe_snprintf(tmp, sizeof(tmp), "%d", st.active_days);
+    draw_inline_left(ui, ui->font_small, ui->font_small, x, y, "active days:",
+                     tmp, main, accent);
+    y += line_h;
+
+    y_end = y;
+  } else if (a->stats_section == 0 && a->stats_page == 4) {
+    /* Page 5: focus by hour of the day, one bar per
+     * hour.
+     */
+    draw_text(ui, ui->font_small, x, y, "focus by hour of day", main, false);
+    y += line_h;
+
+    uint64_t hours[24];
+    stats_engine_hours(hours);
+    uint64_t most = 0;
+    for (int h = 0; h < 24; h++)
+      if (hours[h] > most)
+        most = hours[h];
+
+    const int gap = 6;
+    const int bar_w = (ui->w - 2 * UI_MARGIN_X - 23 * gap) / 24;
+    const int label_h = TTF_FontHeight(ui->font_small);
+    int chart_h = overlay_bottom_text_limit_y(ui) - y - label_h - 10;
+    if (chart_h > 240)
+      chart_h = 240;
+    if (chart_h < 20)
+      chart_h = 20;
+    const int base_y = y + chart_h;
+    for (int h = 0; h < 24; h++) {
+      const int bx = x + h * (bar_w + gap);
+      int bh = most ? (int)((double)hours[h] * chart_h / (double)most) : 0;
+      if (hours[h] && bh < 2)
+        bh = 2;
+      SDL_Rect frame = {bx, y, bar_w, chart_h};
+      SDL_SetRenderDrawColor(ui->ren, main.r, main.g, main.b, 60);
+      SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_BLEND);
+      SDL_RenderDrawRect(ui->ren, &frame);
+      SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
+      if (bh > 0) {
+        SDL_Rect bar = {bx, base_y - bh, bar_w, bh};
+        SDL_SetRenderDrawColor(ui->ren, accent.r, accent.g, accent.b, 255);
+        SDL_RenderFillRect(ui->ren, &bar);
+      }
+      if (h % 6 == 0) {
+        char lab[8];
+        safe_snprintf(lab, sizeof(lab), "%d", h);
+        draw_text(ui, ui->font_small, bx, base_y + 6, lab, main, false);
+      }
+    }
+    y = base_y + 6 + label_h;
+    if (most == 0) {
+      draw_text(ui, ui->font_small, x, y, "no sessions recorded yet.", main,
+                false);
+      y += line_h;
+    }
+    y_end = y;
+  }
+
   else if (a->stats_section == 0) {
-    /* Page 4: per-entry breakdown (top buckets).
+    /* Page 6: per-entry breakdown (top buckets), with
+     * each one's last six months as bars.
      */
     int y0 = y;
-    if (a->focus_stats_count == 0) {
+    if (stats_engine_activity_count() == 0) {
       draw_text(ui, ui->font_small, x, y, "no per-entry stats yet.", main,
                 false);
       y += line_h;
       y_end = y;
     } else {
-      FocusStat tmp[MAX_FOCUS_STATS];
-      int n = a->focus_stats_count;
-      if (n > MAX_FOCUS_STATS)
-        n = MAX_FOCUS_STATS;
-      for (int i = 0; i < n; i++)
-        tmp[i] = a->focus_stats[i];
-      for (int i = 0; i < n - 1; i++) {
-        for (int j = i + 1; j < n; j++) {
-          if (tmp[j].seconds > tmp[i].seconds) {
-            FocusStat t = tmp[i];
-            tmp[i] = tmp[j];
-            tmp[j] = t;
-          }
-        }
-      }
       int row_h = UI_ROW_GAP + 8;
       int max_rows = (ui->h - UI_MARGIN_BOTTOM - y0) / row_h;
       if (max_rows < 1)
         max_rows = 1;
-      if (max_rows > n)
-        max_rows = n;
-      for (int i = 0; i < max_rows; i++) {
+      if (max_rows > 32)
+        max_rows = 32;
+      StatsActivity top[32];
+      const int n = stats_engine_activities(top, max_rows);
+
+      /* Months oldest -> newest, ending with this one. */
+      enum { MONTHS = 6 };
+      const int this_month = date_int_days_ago(0) / 100;
+      const int bar_w = 12, bar_gap = 4, bar_h = row_h - 16;
+      const int bars_x =
+          ui->w - UI_MARGIN_X - MONTHS * bar_w - (MONTHS - 1) * bar_gap;
+      for (int i = 0; i < n; i++) {
         char dur[64];
-        format_duration_hm(tmp[i].seconds, dur, sizeof(dur));
+        format_duration_hm(top[i].secs, dur, sizeof(dur));
         char label[160];
-        safe_snprintf(label, sizeof(label), "%s:", tmp[i].name);
+        safe_snprintf(label, sizeof(label), "%s:", top[i].name);
         draw_inline_left(ui, ui->font_small, ui->font_small, x, y, label, dur,
                          main, accent);
+
+        uint64_t months[MONTHS], most = 0;
+        for (int m = 0; m < MONTHS; m++) {
+          months[m] = stats_engine_activity_month(
+              top[i].name, stats_month_minus(this_month, MONTHS - 1 - m));
+          if (months[m] > most)
+            most = months[m];
+        }
+        const int base_y = y + TTF_FontAscent(ui->font_small);
+        for (int m = 0; m < MONTHS && most > 0; m++) {
+          int bh = (int)((double)months[m] * bar_h / (double)most);
+          if (months[m] && bh < 2)
+            bh = 2;
+          SDL_Rect bar = {bars_x + m * (bar_w + bar_gap), base_y - bh, bar_w,
+                          bh};
+          SDL_SetRenderDrawColor(ui->ren, accent.r, accent.g, accent.b, 255);
+          SDL_RenderFillRect(ui->ren, &bar);
+        }
         y += row_h;
       }
       y_end = y;
@@ -9185,6 +9208,19 @@ static void handle_stats(App *a, Buttons *b) {
 
   /* habit section navigation removed */
 
+  if (a->stats_section == 0 && a->stats_page == 2 &&
+      (b->up || b->down)) {
+    const int step = a->stats_history_rows > 0 ? a->stats_history_rows : 1;
+    const int prev = a->stats_history_scroll;
+    if (b->up)
+      a->stats_history_scroll = prev > step ? prev - step : 0;
+    else if (a->cached_history_count >= step)
+      a->stats_history_scroll = prev + step;
+    if (a->stats_history_scroll != prev)
+      a->ui_needs_redraw = true;
+    return;
+  }
+
   const int pages = stats_pages_for_section(a->stats_section);
   if (b->left) {
     a->stats_page = (a->stats_page + pages - 1) % pages;
@@ -9474,6 +9510,7 @@ void draw_timer(UI *ui, App *a) {
       int x = (ui->w - w) / 2;
       int y = (ui->h - TTF_FontHeight(ui->font_med)) / 2;
       draw_text(ui, ui->font_med, x, y, msg, main, false);
+      ui_mark_live(ui, y, TTF_FontHeight(ui->font_med));
 
       /* Skip standard timer drawing */
       return;
@@ -9512,57 +9549,49 @@ void draw_timer(UI *ui, App *a) {
            !a->end_focus_summary_open);
       if (hud_hidden_clean) {
         SDL_Color main2 = color_from_idx(a->cfg.main_color_idx);
-        SDL_Surface *surf = render_text_surface(ui->font_big, t, main2);
-        if (surf) {
-          SDL_Texture *tex = SDL_CreateTextureFromSurface(ui->ren, surf);
-          if (tex) {
-            int wBig = surf->w;
-            int hBig = surf->h;
-            /* Place timer low enough to sit
-             * under the visible background
-             * "window" when shifted. */
-            /* Stack the big timer and the state
-             * label as a single movable block.
-             */
-            const int hState = TTF_FontHeight(ui->font_med);
-            const int stack_h = hBig + HUD_HIDDEN_TIMER_STATE_GAP + hState;
-            /* Anchor the stack to the bottom
-             * with a tunable pad, then apply a
-             * user-tweakable offset. */
-            int y_timer = ui->h - UI_MARGIN_BOTTOM -
-                          HUD_HIDDEN_STACK_BOTTOM_PAD - stack_h;
-            y_timer += HUD_HIDDEN_STACK_Y_OFFSET;
-            if (y_timer < UI_MARGIN_TOP)
-              y_timer = UI_MARGIN_TOP;
-            int x_timer = (ui->w - wBig) / 2;
-            SDL_Rect dst = {x_timer, y_timer, wBig, hBig};
-            SDL_RenderCopy(ui->ren, tex, NULL, &dst);
-            /* State label under the timer (main
-             * color, medium, non-italic).
-             */
-            const char *state = "focusing";
-            if (a->paused)
-              state = "paused";
-            else if (a->mode == MODE_POMODORO && a->running &&
-                     a->pomo_is_break) {
-              state = a->pomo_break_is_long ? "resting" : "taking a break";
-            } else if (a->mode == MODE_MEDITATION) {
-              if (a->meditation_run_kind == 2 &&
-                  a->meditation_guided_repeats_remaining > 0) {
-                state = breath_phase_label(a->breath_phase);
-              } else
-                state = "meditating";
-            } else if (!a->running) {
-              state = "paused";
-            }
-            int wState = text_width(ui->font_med, state);
-            int xState = (ui->w - wState) / 2;
-            int yState = y_timer + hBig + HUD_HIDDEN_TIMER_STATE_GAP;
-            draw_text(ui, ui->font_med, xState, yState, state, main2, false);
-            SDL_DestroyTexture(tex);
-          }
-          SDL_FreeSurface(surf);
+        int wBig = text_width(ui->font_big, t);
+        int hBig = TTF_FontHeight(ui->font_big);
+        /* Place timer low enough to sit
+         * under the visible background
+         * "window" when shifted. */
+        /* Stack the big timer and the state
+         * label as a single movable block.
+         */
+        const int hState = TTF_FontHeight(ui->font_med);
+        const int stack_h = hBig + HUD_HIDDEN_TIMER_STATE_GAP + hState;
+        /* Anchor the stack to the bottom
+         * with a tunable pad, then apply a
+         * user-tweakable offset. */
+        int y_timer = ui->h - UI_MARGIN_BOTTOM -
+                      HUD_HIDDEN_STACK_BOTTOM_PAD - stack_h;
+        y_timer += HUD_HIDDEN_STACK_Y_OFFSET;
+        if (y_timer < UI_MARGIN_TOP)
+          y_timer = UI_MARGIN_TOP;
+        int x_timer = (ui->w - wBig) / 2;
+        draw_text(ui, ui->font_big, x_timer, y_timer, t, main2, false);
+        /* State label under the timer (main
+         * color, medium, non-italic).
+         */
+        const char *state = "focusing";
+        if (a->paused)
+          state = "paused";
+        else if (a->mode == MODE_POMODORO && a->running &&
+                 a->pomo_is_break) {
+          state = a->pomo_break_is_long ? "resting" : "taking a break";
+        } else if (a->mode == MODE_MEDITATION) {
+          if (a->meditation_run_kind == 2 &&
+              a->meditation_guided_repeats_remaining > 0) {
+            state = breath_phase_label(a->breath_phase);
+          } else
+            state = "meditating";
+        } else if (!a->running) {
+          state = "paused";
         }
+        int wState = text_width(ui->font_med, state);
+        int xState = (ui->w - wState) / 2;
+        int yState = y_timer + hBig + HUD_HIDDEN_TIMER_STATE_GAP;
+        draw_text(ui, ui->font_med, xState, yState, state, main2, false);
+        ui_mark_live(ui, y_timer, yState + hState - y_timer);
       } else {
         draw_big_time_upper_left(ui, a, t);
       }
@@ -10253,7 +10282,7 @@ static void cycle_location(UI *ui, App *a, int dir) {
   refresh_weathers_for_scene(a);
   {
     char ap[PATH_MAX];
-    ambience_path_from_name(a, ap, sizeof(ap));
+    music_player_ambience_path_from_name(a, ap, sizeof(ap));
     a->cfg.ambience_enabled = (ap[0] != 0) ? 1 : 0;
   }
   apply_ambience_from_cfg(ui, a, true);
@@ -10277,7 +10306,7 @@ static void cycle_mood(UI *ui, App *a, int dir) {
   refresh_weathers_for_scene(a);
   {
     char ap[PATH_MAX];
-    ambience_path_from_name(a, ap, sizeof(ap));
+    music_player_ambience_path_from_name(a, ap, sizeof(ap));
     a->cfg.ambience_enabled = (ap[0] != 0) ? 1 : 0;
   }
   apply_ambience_from_cfg(ui, a, true);
@@ -11049,21 +11078,13 @@ static void handle_settings(UI *ui, App *a, Buttons *b) {
              a->bell_phase_idx < a->bell_sounds.count)
                 ? a->bell_sounds.items[a->bell_phase_idx]
                 : a->cfg.bell_phase_file;
-        if (phase && phase[0] && a->audio) {
-          char pth[PATH_MAX];
-          safe_snprintf(pth, sizeof(pth), "sounds/%s", phase);
-          audio_engine_play_sfx(a->audio, pth);
-        }
+        play_bell_sound(a, phase);
       } else if (a->notif_sel == 2) {
         const char *done = (a->bell_sounds.count > 0 && a->bell_done_idx >= 0 &&
                             a->bell_done_idx < a->bell_sounds.count)
                                ? a->bell_sounds.items[a->bell_done_idx]
                                : a->cfg.bell_done_file;
-        if (done && done[0] && a->audio) {
-          char pth[PATH_MAX];
-          safe_snprintf(pth, sizeof(pth), "sounds/%s", done);
-          audio_engine_play_sfx(a->audio, pth);
-        }
+        play_bell_sound(a, done);
       }
     }
     if (b->b)
@@ -11117,11 +11138,7 @@ static void handle_settings(UI *ui, App *a, Buttons *b) {
         bell = a->cfg.meditation_interval_bell_file;
       else
         bell = a->cfg.meditation_end_bell_file;
-      if (bell && bell[0] && a->audio) {
-        char pth[PATH_MAX];
-        safe_snprintf(pth, sizeof(pth), "sounds/%s", bell);
-        audio_engine_play_sfx(a->audio, pth);
-      }
+      play_bell_sound(a, bell);
     }
     if (b->b)
       a->settings_view = SET_VIEW_SOUND_NOTIFICATIONS;
@@ -11667,10 +11684,737 @@ void handle_timer(UI *ui, App *a, Buttons *b) {
    * timer on this screen. */
 }
 
+/* Frame cost split by full and partial (damage-only) redraws, logged at
+   exit so the per-tick saving can be read off a device log. */
+typedef struct {
+  uint32_t frames[2]; /* [0] full, [1] partial */
+  uint64_t ticks[2];  /* performance-counter ticks spent */
+  uint64_t pixels[2]; /* pixels recomposited */
+} RenderStats;
+
+static void render_stats_add(RenderStats *st, bool partial, uint64_t t0,
+                             long pixels) {
+  const int k = partial ? 1 : 0;
+  st->frames[k]++;
+  st->ticks[k] += SDL_GetPerformanceCounter() - t0;
+  st->pixels[k] += (uint64_t)pixels;
+}
+
+static void render_stats_log(const RenderStats *st) {
+  const double freq = (double)SDL_GetPerformanceFrequency();
+  for (int k = 0; k < 2; k++) {
+    if (!st->frames[k])
+      continue;
+    log_printf("render: %u %s frames, avg %.2f ms, avg %llu px",
+               st->frames[k], k ? "partial" : "full",
+               (double)st->ticks[k] * 1000.0 / freq / st->frames[k],
+               (unsigned long long)(st->pixels[k] / st->frames[k]));
+  }
+}
+
+/* --- Main-loop deadlines --- */
+#define LOOP_MAX_SLEEP_MS 60000 /* backstop when nothing is pending */
+#define LOOP_POLL_MS 100        /* for workers that cannot wake the loop */
+#define BREATH_FRAME_MS 100     /* breathing guide redraw interval */
+#define PARTICLES_FRAME_MS 60   /* particle overlay frame interval */
+
+static bool anim_overlay_animating(const App *a) {
+  return a->anim_overlay_enabled &&
+         (a->anim_particles || a->anim_overlay_frame_count > 1);
+}
+
+static SchedMode loop_mode(const App *a) {
+  if (anim_overlay_animating(a))
+    return SCHED_MODE_ANIM;
+  if (a->running && !a->paused)
+    return SCHED_MODE_RUN;
+  return SCHED_MODE_IDLE;
+}
+
+/* Milliseconds until the wall clock next reaches a whole minute. */
+static uint64_t ms_to_next_minute(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)(60 - ts.tv_sec % 60) * 1000 -
+         (uint64_t)(ts.tv_nsec / 1000000) + 1;
+}
+
+/* Milliseconds left of a 1 s accumulator at the given fill. */
+static uint64_t ms_left_of_second(float accum) {
+  const float left = 1.0f - accum;
+  return left > 0.0f ? (uint64_t)ceilf(left * 1000.0f) : 0;
+}
+
+/* Collects when each subsystem next has work; the loop sleeps until the
+   earliest. Every deadline here must be consumed by the code that runs
+   after the wakeup, or the loop would spin. */
+static void loop_schedule(Sched *s, const App *a, uint64_t now) {
+  sched_reset(s);
+  /* app_update only runs on the timer screen; elsewhere the timer catches
+     up from last_tick_ms when it comes back. */
+  if (a->screen == SCREEN_TIMER) {
+    if (a->running && !a->paused) {
+      if (a->mode == MODE_MEDITATION && a->meditation_run_kind == 2)
+        sched_at(s, SCHED_TIMER, a->last_tick_ms + BREATH_FRAME_MS);
+      else
+        sched_at(s, SCHED_TIMER,
+                 a->last_tick_ms + ms_left_of_second(a->tick_accum));
+    }
+    if (a->meditation_bell_strikes_remaining > 0)
+      sched_at(s, SCHED_BELL,
+               a->last_tick_ms +
+                   ms_left_of_second(a->meditation_bell_strike_elapsed));
+  }
+  if (a->anim_overlay_enabled) {
+    if (a->anim_particles) {
+      sched_at(s, SCHED_ANIM, a->anim_overlay_last_ms + PARTICLES_FRAME_MS);
+    } else if (overlay_player_active() && !overlay_player_ready()) {
+      sched_at(s, SCHED_POLL, now + LOOP_POLL_MS);
+    } else if (overlay_player_active() && a->anim_overlay_frame_count > 1) {
+      const float frame_time = (a->anim_overlay_frame_delay_sec > 0.0f)
+                                   ? a->anim_overlay_frame_delay_sec
+                                   : 0.50f;
+      const float left = frame_time - a->anim_overlay_accum;
+      sched_at(s, SCHED_ANIM,
+               a->anim_overlay_last_ms +
+                   (left > 0.0f ? (uint64_t)ceilf(left * 1000.0f) : 0));
+    }
+  }
+  if (g_batt_shown)
+    sched_at(s, SCHED_BATTERY, g_batt_last_ms + BATTERY_SAMPLE_MS);
+  if (g_clock_shown_min >= 0)
+    sched_at(s, SCHED_CLOCK, now + ms_to_next_minute());
+  /* A hold fires from the input handlers on the first iteration at or past
+     its deadline; only a future one is worth waking for. */
+  if (a->menu_btn_down && !a->help_overlay_open && !timer_main_screen(a)) {
+    const uint64_t due = a->menu_btn_down_ms + UI_HELP_OVERLAY_HOLD_MS;
+    if (due > now)
+      sched_at(s, SCHED_HOLD, due);
+  }
+  if (a->hud_hide_btn_down && !a->hud_hide_hold_triggered) {
+    const uint64_t due = a->hud_hide_btn_down_ms + HUD_HIDE_HOLD_MS;
+    if (due > now)
+      sched_at(s, SCHED_HOLD, due);
+  }
+  if (a->update_status == UPDATE_STATUS_DOWNLOADING)
+    sched_at(s, SCHED_POLL, a->update_anim_last_ms + 500);
+  if (a->update_thread)
+    sched_at(s, SCHED_POLL, now + LOOP_POLL_MS);
+}
+
+/* Redraws when the clock on screen has turned over a minute, or when a
+   fresh battery sample differs from the one shown. */
+static void clock_battery_poll(App *a) {
+  if (g_clock_shown_min >= 0 && (long)(time(NULL) / 60) != g_clock_shown_min)
+    a->ui_needs_redraw = true;
+  if (g_batt_shown && now_ms() - g_batt_last_ms >= BATTERY_SAMPLE_MS) {
+    const int before = g_batt_percent;
+    battery_tick_update();
+    if (g_batt_percent != before)
+      a->ui_needs_redraw = true;
+  }
+}
+
+static void loop_stats_log(const Sched *s) {
+  for (int m = 0; m < SCHED_MODE_COUNT; m++) {
+    if (!s->wakeups[m])
+      continue;
+    log_printf("loop: %s %.1f wakeups/min (%u in %.1f min, %u by input)",
+               sched_mode_name((SchedMode)m),
+               sched_per_minute(s, (SchedMode)m), s->wakeups[m],
+               (double)s->ms_in[m] / 60000.0, s->input[m]);
+  }
+  char buf[192];
+  size_t n = 0;
+  buf[0] = 0;
+  for (int i = 0; i < SCHED_SOURCE_COUNT && n < sizeof(buf); i++) {
+    int k = snprintf(buf + n, sizeof(buf) - n, " %s=%u",
+                     sched_source_name((SchedSource)i), s->fired[i]);
+    if (k < 0)
+      break;
+    n += (size_t)k;
+  }
+  log_printf("loop: deadline wakeups:%s", buf);
+}
+
+/* --- Profiling overlay ---
+   MENU+SELECT toggles it; MENU+START, while it is up, dumps the frame
+   history to the log. The text is refreshed a few times a second so the
+   overlay's own rasterization stays out of the numbers it shows. */
+#define PROF_OVERLAY_REFRESH_MS 250
+#define PROF_OVERLAY_LINES (PROF_SECTION_COUNT + 2)
+
+static char g_prof_lines[PROF_OVERLAY_LINES][64];
+static uint64_t g_prof_lines_ms;
+
+static void prof_dump_log(void) {
+  ProfFrame frames[PROF_HISTORY];
+  const int n = prof_history(frames, PROF_HISTORY);
+  log_printf("prof: %d frames, ms per frame: total bg hud screen text "
+             "present input poll",
+             n);
+  for (int i = 0; i < n; i++) {
+    const ProfFrame *f = &frames[i];
+    log_printf("prof: %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f", f->total_ms,
+               f->ms[PROF_BG], f->ms[PROF_HUD], f->ms[PROF_SCREEN],
+               f->ms[PROF_TEXT], f->ms[PROF_PRESENT], f->ms[PROF_INPUT],
+               f->ms[PROF_POLL]);
+  }
+}
+
+/* Consumes MENU+SELECT and MENU+START. */
+static void prof_overlay_combo(App *a, Buttons *b) {
+  if (!a->menu_btn_down)
+    return;
+  if (b->select) {
+    prof_set_enabled(!prof_enabled());
+    g_prof_lines_ms = 0;
+    log_printf("prof overlay %s", prof_enabled() ? "on" : "off");
+  } else if (b->start && prof_enabled()) {
+    prof_dump_log();
+  } else {
+    return;
+  }
+  b->select = false;
+  b->start = false;
+  a->menu_btn_combo = true;
+  a->ui_needs_redraw = true;
+}
+
+/* Returns whether any line changed. */
+static bool prof_overlay_refresh(App *a) {
+  char old[PROF_OVERLAY_LINES][64];
+  memcpy(old, g_prof_lines, sizeof(old));
+  ProfSummary st;
+  prof_summary(&st);
+  /* Nested sections are indented under the ones they are part of. */
+  static const char *const labels[PROF_SECTION_COUNT] = {
+      "bg", "  hud", "screen", "  text", "present", "input", "poll"};
+  safe_snprintf(g_prof_lines[0], sizeof(g_prof_lines[0]),
+                "frame    %6.2f %6.2f ms (%d)", st.avg_total_ms,
+                st.max_total_ms, st.frames);
+  for (int i = 0; i < PROF_SECTION_COUNT; i++)
+    safe_snprintf(g_prof_lines[i + 1], sizeof(g_prof_lines[i + 1]),
+                  "%-8s %6.2f %6.2f", labels[i], st.avg_ms[i], st.max_ms[i]);
+  const float load = a->audio ? audio_engine_callback_load(a->audio) : 0.0f;
+  safe_snprintf(g_prof_lines[PROF_OVERLAY_LINES - 1],
+                sizeof(g_prof_lines[0]), "wake/s %.1f  audio %.1f%%",
+                st.wakeups_per_sec, load * 100.0f);
+  return memcmp(old, g_prof_lines, sizeof(old)) != 0;
+}
+
+static void draw_prof_overlay(UI *ui, App *a) {
+  if (!prof_enabled())
+    return;
+  /* The overlay's own cost stays out of the frame it reports on. */
+  const uint64_t t_paused = prof_pause();
+  const uint64_t now = now_ms();
+  bool changed = false;
+  if (g_prof_lines_ms == 0 ||
+      now - g_prof_lines_ms >= PROF_OVERLAY_REFRESH_MS) {
+    changed = prof_overlay_refresh(a);
+    g_prof_lines_ms = now;
+  }
+  const int line_h = TTF_FontHeight(ui->font_small);
+  SDL_Rect box = {UI_MARGIN_X / 2, UI_MARGIN_TOP / 2, ui->w / 3,
+                  line_h * PROF_OVERLAY_LINES + 16};
+  SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor(ui->ren, 0, 0, 0, 180);
+  SDL_RenderFillRect(ui->ren, &box);
+  SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
+  const SDL_Color white = {255, 255, 255, 255};
+  for (int i = 0; i < PROF_OVERLAY_LINES; i++)
+    draw_text(ui, ui->font_small, box.x + 8, box.y + 8 + i * line_h,
+              g_prof_lines[i], white, false);
+  /* New numbers go out with the next partial redraw; unchanged ones add
+     nothing to it, so the box doesn't inflate what it measures. */
+  if (changed)
+    damage_add(&ui->live, box, ui->w, ui->h);
+  prof_resume(t_paused);
+}
+
+/* Composes one whole frame (background, overlay, current screen). A
+   partial redraw calls it once, with the clip rect set to the bounding box
+   of the damage (damage_bounds()); only the damaged rectangles are then
+   presented. */
+static void render_frame(UI *ui, App *a) {
+  const uint64_t t_bg = prof_begin();
+  SDL_SetRenderDrawBlendMode(ui->ren, SDL_BLENDMODE_NONE);
+  /* Set again by the clock and battery widgets if this frame has them. */
+  g_batt_shown = false;
+  g_clock_shown_min = -1;
+  /* Dim background whenever any overlay/menu
+   * is open, so all menus feel consistent.
+   */
+  bool want_dim = (a->screen != SCREEN_TIMER) || a->settings_open ||
+                  a->timer_menu_open || a->booklets.open ||
+                  a->help_overlay_open || a->end_focus_confirm_open ||
+                  a->end_focus_summary_open;
+  /* Base background first */
+  bool breathe_bg =
+      (a->screen == SCREEN_TIMER &&
+       (a->mode == MODE_MEDITATION && a->meditation_run_kind == 2 &&
+        a->meditation_guided_repeats_remaining > 0)) &&
+      !a->settings_open && !a->timer_menu_open && !a->booklets.open &&
+      !a->help_overlay_open && !a->end_focus_confirm_open &&
+      !a->end_focus_summary_open;
+  bool shift_bg_hidden =
+      (a->screen == SCREEN_TIMER && a->hud_hidden && !a->settings_open &&
+       !a->timer_menu_open && !a->booklets.open &&
+       !a->help_overlay_open && !a->end_focus_confirm_open &&
+       !a->end_focus_summary_open);
+  /* Pre-composited layers cover the screen opaquely; only the scaled
+     breathing background (or no layers at all) needs a cleared frame. */
+  if (breathe_bg || !ui->bg_layers[BG_LAYER_NORMAL]) {
+    SDL_SetRenderDrawColor(ui->ren, 0, 0, 0, 255);
+    /* Not SDL_RenderClear: that ignores the clip rect of partial redraws. */
+    SDL_RenderFillRect(ui->ren, NULL);
+  }
+  if (shift_bg_hidden) {
+    if (breathe_bg)
+      draw_bg_scaled(ui, breath_phase_scale(a), 0, true);
+    else
+      draw_bg_normal_shifted(ui, BG_HIDDEN_SHIFT_Y);
+  } else {
+    if (want_dim)
+      draw_bg_blurred(ui);
+    else if (a->booklets.open && a->booklets.mode == 1)
+      draw_bg_faint(ui, BG_FAINT_ALPHA);
+    else if (breathe_bg)
+      draw_bg_scaled(ui, breath_phase_scale(a), 0, true);
+    else
+      draw_bg_normal(ui);
+  }
+  /* Optional animated overlay (e.g., rain)
+   */
+  anim_overlay_draw(ui, a);
+  prof_end(PROF_BG, t_bg);
+
+  const uint64_t t_screen = prof_begin();
+  if (a->screen == SCREEN_POMO_PICK)
+    draw_pomo_picker(ui, a);
+  else if (a->screen == SCREEN_MEDITATION_PICK)
+    draw_meditation_picker(ui, a);
+  else if (a->screen == SCREEN_CUSTOM_PICK)
+    draw_custom_picker(ui, a);
+  else if (a->screen == SCREEN_FOCUS_MENU)
+    draw_focus_menu(ui, a);
+  else if (a->screen == SCREEN_FOCUS_TEXT)
+    draw_focus_text(ui, a);
+  else if (a->screen == SCREEN_STATS)
+    draw_stats(ui, a);
+  else if (a->screen == SCREEN_TASKS_PICK)
+    draw_tasks_pick(ui, a);
+  else if (a->screen == SCREEN_TASKS_LIST)
+    draw_tasks_list(ui, a);
+  else if (a->screen == SCREEN_TASKS_TEXT)
+    draw_tasks_text(ui, a);
+
+  else if (a->screen == SCREEN_ROUTINE_LIST) {
+    if (a->routine.grid_view)
+      draw_routine_grid(ui, a);
+    else
+      draw_routine_list(ui, a);
+  } else if (a->screen == SCREEN_ROUTINE_EDIT)
+    draw_routine_edit(ui, a);
+  else if (a->screen == SCREEN_SETTINGS_NAME)
+    draw_settings_name(ui, a);
+  else if (a->screen == SCREEN_ROUTINE_ENTRY_PICKER)
+    draw_routine_entry_picker(ui, a);
+  else if (a->screen == SCREEN_ROUTINE_ENTRY_TEXT)
+    draw_routine_entry_text(ui, a);
+  else if (a->screen == SCREEN_QUEST)
+    draw_quest(ui, a);
+  else
+    draw_timer(ui, a);
+  if (a->booklets.open) {
+    draw_booklets(ui, a);
+  }
+  draw_help_overlay(ui, a);
+  prof_end(PROF_SCREEN, t_screen);
+  draw_prof_overlay(ui, a);
+}
+
+/* --- Headless render benchmark (--bench-render) ---
+   Renders every screen render_frame draws and every settings view
+   offscreen for a number of frames and writes frame-time percentiles per
+   case to a CSV, so rendering cost can be compared between builds on
+   machines without a display. */
+#define BENCH_RENDER_FRAMES 120 /* default frames per case */
+#define BENCH_RENDER_CSV "render_bench.csv"
+
+typedef struct {
+  const char *name;
+  Screen screen;
+  bool settings; /* settings open over the timer, in view */
+  SettingsView view;
+} BenchCase;
+
+static const BenchCase bench_cases[] = {
+    {"pomo_pick", SCREEN_POMO_PICK, false, SET_VIEW_MAIN},
+    {"custom_pick", SCREEN_CUSTOM_PICK, false, SET_VIEW_MAIN},
+    {"routine_entry_picker", SCREEN_ROUTINE_ENTRY_PICKER, false,
+     SET_VIEW_MAIN},
+    {"routine_entry_text", SCREEN_ROUTINE_ENTRY_TEXT, false, SET_VIEW_MAIN},
+    {"meditation_pick", SCREEN_MEDITATION_PICK, false, SET_VIEW_MAIN},
+    {"tasks_pick", SCREEN_TASKS_PICK, false, SET_VIEW_MAIN},
+    {"tasks_list", SCREEN_TASKS_LIST, false, SET_VIEW_MAIN},
+    {"tasks_text", SCREEN_TASKS_TEXT, false, SET_VIEW_MAIN},
+    {"timer", SCREEN_TIMER, false, SET_VIEW_MAIN},
+    {"quest", SCREEN_QUEST, false, SET_VIEW_MAIN},
+    {"focus_menu", SCREEN_FOCUS_MENU, false, SET_VIEW_MAIN},
+    {"focus_text", SCREEN_FOCUS_TEXT, false, SET_VIEW_MAIN},
+    {"stats", SCREEN_STATS, false, SET_VIEW_MAIN},
+    {"routine_list", SCREEN_ROUTINE_LIST, false, SET_VIEW_MAIN},
+    {"routine_edit", SCREEN_ROUTINE_EDIT, false, SET_VIEW_MAIN},
+    {"settings_name", SCREEN_SETTINGS_NAME, false, SET_VIEW_MAIN},
+    {"settings/main", SCREEN_TIMER, true, SET_VIEW_MAIN},
+    {"settings/scene", SCREEN_TIMER, true, SET_VIEW_SCENE},
+    {"settings/appearance", SCREEN_TIMER, true, SET_VIEW_APPEARANCE},
+    {"settings/fonts", SCREEN_TIMER, true, SET_VIEW_FONTS},
+    {"settings/colors", SCREEN_TIMER, true, SET_VIEW_COLORS},
+    {"settings/sounds", SCREEN_TIMER, true, SET_VIEW_SOUNDS},
+    {"settings/sound_volume", SCREEN_TIMER, true, SET_VIEW_SOUND_VOLUME},
+    {"settings/sound_notifications", SCREEN_TIMER, true,
+     SET_VIEW_SOUND_NOTIFICATIONS},
+    {"settings/sound_meditation", SCREEN_TIMER, true,
+     SET_VIEW_SOUND_MEDITATION},
+    {"settings/misc", SCREEN_TIMER, true, SET_VIEW_MISC},
+    {"settings/font_sizes", SCREEN_TIMER, true, SET_VIEW_FONT_SIZES},
+    {"settings/about", SCREEN_TIMER, true, SET_VIEW_ABOUT},
+    {"settings/changelog", SCREEN_TIMER, true, SET_VIEW_CHANGELOG},
+    {"settings/releases", SCREEN_TIMER, true, SET_VIEW_RELEASES},
+};
+
+static int cmp_double(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of n sorted samples. */
+static double percentile_sorted(const double *v, int n, int pct) {
+  int k = (n * pct + 99) / 100;
+  if (k < 1)
+    k = 1;
+  if (k > n)
+    k = n;
+  return v[k - 1];
+}
+
+#if STILLROOM_DEBUG_DAMAGE
+/* Renders a full frame over a partial one and logs pixels that changed
+   outside dmg, i.e. a per-second widget that never called ui_mark_live.
+   True if any did; the full frame is left in the surface either way. */
+static bool damage_debug_check(UI *ui, App *a, const DamageList *dmg) {
+  SDL_Surface *s = SDL_GetWindowSurface(ui->win);
+  if (!s || s->format->BytesPerPixel != 4)
+    return false;
+  const size_t bytes = (size_t)s->pitch * (size_t)s->h;
+  uint8_t *before = (uint8_t *)malloc(bytes);
+  if (!before)
+    return false;
+  memcpy(before, s->pixels, bytes);
+  render_frame(ui, a);
+  long stale = 0;
+  int fx = 0, fy = 0;
+  for (int y = 0; y < s->h; y++) {
+    const uint32_t *p0 = (const uint32_t *)(before + (size_t)y * s->pitch);
+    const uint32_t *p1 =
+        (const uint32_t *)((const uint8_t *)s->pixels + (size_t)y * s->pitch);
+    for (int x = 0; x < s->w; x++) {
+      if (p0[x] == p1[x])
+        continue;
+      bool inside = false;
+      for (int i = 0; i < dmg->count && !inside; i++) {
+        const SDL_Rect *r = &dmg->rects[i];
+        inside = x >= r->x && x < r->x + r->w && y >= r->y && y < r->y + r->h;
+      }
+      if (inside)
+        continue;
+      if (stale++ == 0) {
+        fx = x;
+        fy = y;
+      }
+    }
+  }
+  free(before);
+  if (stale > 0)
+    log_printf("damage: %ld px changed outside the live rects, first at "
+               "%d,%d (missing ui_mark_live?)",
+               stale, fx, fy);
+  return stale > 0;
+}
+#endif
+
+static int render_bench(UI *ui, App *a, int frames, const char *csv_path) {
+  double *ms = (double *)malloc(sizeof(double) * (size_t)frames);
+  FILE *f = fopen(csv_path, "w");
+  if (!ms || !f) {
+    fprintf(stderr, "bench-render: cannot write %s\n", csv_path);
+    free(ms);
+    if (f)
+      fclose(f);
+    return 1;
+  }
+  fprintf(f, "case,frames,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n");
+  printf("%-30s %8s %8s %8s %8s\n", "case", "p50 ms", "p90 ms", "p99 ms",
+         "max ms");
+  const double freq = (double)SDL_GetPerformanceFrequency();
+  const int n_cases = (int)(sizeof(bench_cases) / sizeof(bench_cases[0]));
+  for (int c = 0; c < n_cases; c++) {
+    const BenchCase *bc = &bench_cases[c];
+    a->screen = bc->screen;
+    a->settings_open = bc->settings;
+    a->settings_view = bc->view;
+    a->settings_sel = 0;
+    a->timer_menu_open = false;
+    a->help_overlay_open = false;
+    a->end_focus_confirm_open = false;
+    a->end_focus_summary_open = false;
+    a->booklets.open = false;
+    /* Every frame is a full redraw, the cost a screen change pays. The
+       first one includes whatever the screen caches on first draw. */
+    double sum = 0.0;
+    for (int i = 0; i < frames; i++) {
+      anim_overlay_update(a);
+      const uint64_t t0 = SDL_GetPerformanceCounter();
+      render_frame(ui, a);
+      SDL_RenderPresent(ui->ren);
+      ms[i] = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / freq;
+      sum += ms[i];
+      damage_clear(&ui->live);
+    }
+    qsort(ms, (size_t)frames, sizeof(double), cmp_double);
+    const double p50 = percentile_sorted(ms, frames, 50);
+    const double p90 = percentile_sorted(ms, frames, 90);
+    const double p99 = percentile_sorted(ms, frames, 99);
+    fprintf(f, "%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", bc->name, frames,
+            sum / frames, p50, p90, p99, ms[frames - 1]);
+    printf("%-30s %8.3f %8.3f %8.3f %8.3f\n", bc->name, p50, p90, p99,
+           ms[frames - 1]);
+  }
+  free(ms);
+  const bool ok = fclose(f) == 0;
+  printf("wrote %s\n", csv_path);
+  return ok ? 0 : 1;
+}
+
+/* --- Held-button edges ---
+   Shared by live input and replay; live edges are also recorded. */
+#define REPLAY_CLOCK_START_MS 1000 /* virtual now_ms() at startup */
+static uint64_t g_input_epoch_ms; /* now_ms() when the main loop started */
+/* now_ms() when the loop last woke: every record of one iteration gets the
+   same stamp, so a replay applies them together. */
+static uint64_t g_input_wake_ms;
+
+/* Recording and replaying run in a scratch copy of the exe dir, so a scripted
+   session never touches the user's focus history, stats, logs or tasks.
+   Everything but states/ is symlinked; states/ starts empty apart from the
+   settings in config.txt. The directory is left behind for inspection.
+   Call after chdir_to_exe_dir(). */
+#define REPLAY_SCRATCH_TEMPLATE "/tmp/stillroom-replay-XXXXXX"
+static bool enter_replay_scratch(void) {
+  char exe[PATH_MAX], scratch[] = REPLAY_SCRATCH_TEMPLATE;
+  if (!getcwd(exe, sizeof(exe)) || !mkdtemp(scratch))
+    return false;
+  DIR *d = opendir(exe);
+  if (!d)
+    return false;
+  char from[PATH_MAX], to[PATH_MAX];
+  struct dirent *e;
+  bool ok = true;
+  while (ok && (e = readdir(d)) != NULL) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0 ||
+        strcmp(e->d_name, STATES_DIR) == 0)
+      continue;
+    safe_snprintf(from, sizeof(from), "%s/%s", exe, e->d_name);
+    safe_snprintf(to, sizeof(to), "%s/%s", scratch, e->d_name);
+    ok = symlink(from, to) == 0;
+  }
+  closedir(d);
+  safe_snprintf(to, sizeof(to), "%s/" STATES_DIR, scratch);
+  if (!ok || mkdir(to, 0755) != 0 || chdir(scratch) != 0)
+    return false;
+  size_t len = 0;
+  safe_snprintf(from, sizeof(from), "%s/" CONFIG_PATH, exe);
+  char *cfg = read_entire_file(from, &len);
+  if (cfg) {
+    FILE *f = fopen(CONFIG_PATH, "wb");
+    if (f) {
+      fwrite(cfg, 1, len, f);
+      fclose(f);
+    }
+    free(cfg);
+  }
+  fprintf(stderr, "%s: state goes to %s/" STATES_DIR "\n",
+          input_replaying() ? "replay" : "record", scratch);
+  return true;
+}
+
+static void record_input(InputRecKind kind, uint32_t buttons) {
+  if (input_recording())
+    input_record(g_input_wake_ms - g_input_epoch_ms, kind, buttons);
+}
+
+/* Held MENU (GUIDE) opens the contextual help overlay. */
+static void input_menu_down(App *a) {
+  if (a->menu_btn_down)
+    return;
+  record_input(INPUT_REC_MENU_DOWN, 0);
+  a->menu_btn_down = true;
+  a->menu_btn_down_ms = now_ms();
+  a->menu_btn_combo = false;
+  if (timer_main_screen(a)) {
+    quest_reload_list(a);
+    quest_sync_daily(a);
+  }
+}
+
+static void input_menu_up(App *a) {
+  record_input(INPUT_REC_MENU_UP, 0);
+  uint64_t held_ms = now_ms() - a->menu_btn_down_ms;
+  bool short_press =
+      held_ms < (uint64_t)UI_HELP_OVERLAY_HOLD_MS && !a->menu_btn_combo;
+  a->menu_btn_down = false;
+  if (short_press && a->screen == SCREEN_QUEST) {
+    a->screen = SCREEN_TIMER;
+    a->timer_menu_open = false;
+    a->settings_open = false;
+    a->nav_from_timer_menu = false;
+    a->quest_from_timer_button = false;
+  } else if (short_press && timer_main_screen(a)) {
+    a->quest_from_timer_button = true;
+    a->screen = SCREEN_QUEST;
+    a->timer_menu_open = false;
+    a->settings_open = false;
+    a->nav_from_timer_menu = false;
+  }
+  a->ui_needs_redraw = true;
+}
+
+/* Held B toggles the HUD on the timer screen. */
+static void input_back_down(App *a) {
+  if (a->hud_hide_btn_down)
+    return;
+  record_input(INPUT_REC_BACK_DOWN, 0);
+  a->hud_hide_btn_down = true;
+  a->hud_hide_hold_triggered = false;
+  a->hud_hide_btn_down_ms = now_ms();
+}
+
+static void input_back_up(App *a) {
+  record_input(INPUT_REC_BACK_UP, 0);
+  a->hud_hide_btn_down = false;
+  a->hud_hide_hold_triggered = false;
+}
+
+/* Replay's stand-in for waiting on events: jumps the virtual clock to the
+   next deadline or recorded input, whichever comes first (and always
+   forward, so a deadline nothing consumes cannot stall it), then applies
+   the input recorded for that moment. Live input is drained and ignored.
+   Returns true if recorded input was applied. */
+static bool replay_step(App *a, const Sched *s, uint64_t now, Buttons *b,
+                        bool *quit) {
+  SDL_Event e;
+  while (SDL_PollEvent(&e)) {
+    if (e.type == SDL_QUIT)
+      *quit = true;
+  }
+  InputRec r;
+  if (!input_replay_peek(&r)) {
+    *quit = true;
+    return false;
+  }
+  const uint64_t at = g_input_epoch_ms + r.ms;
+  uint64_t next = now + (uint64_t)sched_timeout(s, now, LOOP_MAX_SLEEP_MS);
+  if (at < next)
+    next = at;
+  g_virtual_ms = next > now ? next : now + 1;
+  g_input_wake_ms = g_virtual_ms;
+  bool applied = false;
+  while (input_replay_peek(&r) && g_input_epoch_ms + r.ms <= g_virtual_ms) {
+    input_replay_next(&r);
+    applied = true;
+    switch (r.kind) {
+    case INPUT_REC_BUTTONS:
+      input_buttons_unpack(input_buttons_pack(b) | r.buttons, b);
+      break;
+    case INPUT_REC_MENU_DOWN:
+      input_menu_down(a);
+      break;
+    case INPUT_REC_MENU_UP:
+      input_menu_up(a);
+      break;
+    case INPUT_REC_BACK_DOWN:
+      input_back_down(a);
+      break;
+    case INPUT_REC_BACK_UP:
+      input_back_up(a);
+      break;
+    case INPUT_REC_QUIT:
+      *quit = true;
+      break;
+    default:
+      break;
+    }
+  }
+  if (applied)
+    a->ui_needs_redraw = true;
+  return applied;
+}
+
 /* ----------------------------- Main
  * ----------------------------- */
 int main(int argc, char **argv) {
+  /* Developer mode: time the pixel kernels and exit. */
+  if (argc > 1 && strcmp(argv[1], "--bench-kernels") == 0)
+    return gfx_pixel_bench();
+  /* Developer mode: --bench-render [frames] [out.csv] renders every screen
+     offscreen under the dummy video driver (see render_bench). */
+  int bench_frames = 0;
+  char bench_csv[PATH_MAX] = "";
+  if (argc > 1 && strcmp(argv[1], "--bench-render") == 0) {
+    bench_frames = (argc > 2) ? atoi(argv[2]) : 0;
+    if (bench_frames <= 0)
+      bench_frames = BENCH_RENDER_FRAMES;
+    /* Relative to where it was run from, not the exe dir we move to. */
+    const char *out = (argc > 3) ? argv[3] : BENCH_RENDER_CSV;
+    char cwd[PATH_MAX];
+    if (out[0] != '/' && getcwd(cwd, sizeof(cwd)))
+      safe_snprintf(bench_csv, sizeof(bench_csv), "%s/%s", cwd, out);
+    else
+      safe_snprintf(bench_csv, sizeof(bench_csv), "%s", out);
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+  }
+  /* Developer mode: --record FILE writes the input the loop acts on,
+     --replay FILE plays it back on a virtual clock (see input_log.h),
+     --headless runs either without a display. Files are opened here,
+     relative to where we were run from; the session itself runs in a
+     scratch directory (enter_replay_scratch). */
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      if (!input_record_open(argv[++i])) {
+        fprintf(stderr, "record: cannot write %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      if (!input_replay_open(argv[++i])) {
+        fprintf(stderr, "replay: cannot read %s\n", argv[i]);
+        return 1;
+      }
+      g_virtual_ms = REPLAY_CLOCK_START_MS;
+    } else if (strcmp(argv[i], "--headless") == 0) {
+      SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+      SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+  }
+
   chdir_to_exe_dir();
+  if ((input_recording() || input_replaying()) && !enter_replay_scratch()) {
+    fprintf(stderr, "replay: cannot set up a scratch directory\n");
+    return 1;
+  }
 
   // 1. Ensure "states" exists for other logging
   ensure_dir_exists("states");
@@ -11687,8 +12431,6 @@ int main(int argc, char **argv) {
   log_session_header();
   crash_install_handlers();
   SDL_LogSetOutputFunction(sdl_log_to_file, NULL);
-  (void)argc;
-  (void)argv;
 
   panic_log("Initializing SDL Video/GameController (Audio excluded)...");
 
@@ -11733,8 +12475,8 @@ int main(int argc, char **argv) {
   panic_log("TTF_Init success.");
 
   UI ui = (UI){0};
-  ui.w = 1024;
-  ui.h = 768;
+  ui.w = UI_DEFAULT_W;
+  ui.h = UI_DEFAULT_H;
   ui.win =
       SDL_CreateWindow("lofi pomodoro", SDL_WINDOWPOS_CENTERED,
                        SDL_WINDOWPOS_CENTERED, ui.w, ui.h, SDL_WINDOW_SHOWN);
@@ -11746,8 +12488,27 @@ int main(int argc, char **argv) {
   }
   panic_log("SDL_CreateWindow success.");
 
-  panic_log("Attempting SDL_CreateRenderer (SOFTWARE)...");
-  ui.ren = SDL_CreateRenderer(ui.win, -1, SDL_RENDERER_SOFTWARE);
+  /* Render straight into the window surface so the main loop can present
+     only damaged rectangles; otherwise a regular software renderer. */
+  panic_log("Attempting software renderer on the window surface...");
+  SDL_Surface *win_surface = NULL;
+  SDL_Surface *bench_target = NULL;
+  if (bench_frames > 0) {
+    /* The benchmark draws into a plain offscreen surface instead. */
+    bench_target = SDL_CreateRGBSurfaceWithFormat(0, ui.w, ui.h, 32,
+                                                  SDL_PIXELFORMAT_ARGB8888);
+    if (bench_target)
+      ui.ren = SDL_CreateSoftwareRenderer(bench_target);
+  } else {
+    win_surface = SDL_GetWindowSurface(ui.win);
+    if (win_surface)
+      ui.ren = SDL_CreateSoftwareRenderer(win_surface);
+    ui.surface_present = (ui.ren != NULL);
+  }
+  if (!ui.ren) {
+    panic_log("Attempting SDL_CreateRenderer (SOFTWARE)...");
+    ui.ren = SDL_CreateRenderer(ui.win, -1, SDL_RENDERER_SOFTWARE);
+  }
 
   if (!ui.ren) {
     fprintf(stderr, "createrenderer failed: %s\n", SDL_GetError());
@@ -11756,11 +12517,32 @@ int main(int argc, char **argv) {
     return 1;
   }
   panic_log("SDL_CreateRenderer (SW) success.");
+  /* Devices may hand out another size than asked; lay out for the real
+     one. */
+  if (win_surface) {
+    ui.w = win_surface->w;
+    ui.h = win_surface->h;
+  } else if (bench_target) {
+    ui.w = bench_target->w;
+    ui.h = bench_target->h;
+  } else {
+    SDL_GetWindowSize(ui.win, &ui.w, &ui.h);
+  }
+  ui.pixel_format = asset_native_format(ui.win);
+  log_printf("window %dx%d, %s", ui.w, ui.h,
+             SDL_GetPixelFormatName(ui.pixel_format));
+  /* A replay decodes backgrounds inline, so they land on the same frame
+     every run. */
+  if (input_replaying())
+    log_printf("replaying input; decoding backgrounds inline");
+  else if (!bg_loader_start(ui.w, ui.h))
+    log_printf("bg loader thread failed; decoding backgrounds inline");
 
   panic_log("Using static App struct (BSS)... Size check: %zu bytes",
             sizeof(App));
   static App app;
   memset(&app, 0, sizeof(app));
+  RenderStats render_stats = {0};
   panic_log("App struct cleared. size=%zu", sizeof(app));
 
   app.history_dirty = true;
@@ -11778,12 +12560,24 @@ int main(int argc, char **argv) {
 
   panic_log("Loading config...");
   config_load(&app.cfg, CONFIG_PATH);
+  bg_cache_set_budget((size_t)app.cfg.bg_cache_mb * 1024 * 1024);
+  bg_disk_open(STATES_CACHE_DIR, (size_t)app.cfg.bg_disk_mb * 1024 * 1024);
 
   panic_log("Loading stanza overrides...");
   stanza_overrides_load(&app);
 
   panic_log("Loading focus stats...");
   focus_stats_load(&app, FOCUS_STATS_PATH);
+  panic_log("Opening history...");
+  history_log_open(HISTORY_DIR);
+  history_log_migrate(HISTORY_LOG_ACTIVITY, ACTIVITY_LOG_PATH);
+  history_log_migrate(HISTORY_LOG_FOCUS, FOCUS_HISTORY_PATH);
+  activity_rollup_load(ACTIVITY_ROLLUP_PATH);
+  history_reader_open();
+  stats_engine_load(STATS_PATH);
+  if (stats_engine_empty())
+    stats_engine_seed(&app);
+  history_log_compact_start();
 
   /* Load persistent per-folder song selections
    * (independent of music on/off).
@@ -11822,6 +12616,21 @@ int main(int argc, char **argv) {
     audio_engine_set_music_volume(app.audio, app.cfg.vol_music);
     audio_engine_set_ambience_volume(app.audio, app.cfg.vol_ambience);
     audio_engine_set_sfx_volume(app.audio, app.cfg.vol_notifications);
+    /* Let track changes and load failures wake the main loop instead of
+       waiting for the next timeout. */
+    Uint32 wake = SDL_RegisterEvents(1);
+    if (wake != (Uint32)-1) {
+      app.audio_wake_event = wake;
+      audio_engine_set_wake_event(app.audio, wake);
+    }
+  }
+  {
+    /* And let a background decoded off-thread wake it to be shown. */
+    Uint32 wake = SDL_RegisterEvents(1);
+    if (wake != (Uint32)-1) {
+      app.bg_wake_event = wake;
+      bg_loader_set_wake_event(wake);
+    }
   }
   safe_snprintf(app.music_folder, sizeof(app.music_folder), "%s", "music");
   safe_snprintf(app.music_song, sizeof(app.music_song), "%s", "off");
@@ -11937,43 +12746,48 @@ int main(int argc, char **argv) {
   }
 
   /* Power tuning:
-     We do not redraw every loop. We wait for
-     input, timer ticks, or animation frames.
-     These timeouts keep input responsive without
-     burning battery on a static screen.
+     We do not redraw every loop. Each subsystem says when it next has
+     work (loop_schedule) and we sleep until the earliest of those or
+     until input, so a static screen stays asleep and a running timer
+     wakes once a second.
   */
-  const int IDLE_WAIT_MS = 1000; /* when nothing is running/animating
-                                  */
-  const int RUN_WAIT_MS = 100;   /* timer/stopwatch active */
-  const int ANIM_WAIT_MS = 60;   /* animated overlay active (caps
-                                    wakeups) */
+  Sched sched;
+  sched_init(&sched, now_ms());
   /* Force an initial draw. */
   app.ui_needs_redraw = true;
   bool quit = false;
+  int exit_code = 0;
+  if (bench_frames > 0) {
+    exit_code = render_bench(&ui, &app, bench_frames, bench_csv);
+    quit = true;
+  }
+  g_input_epoch_ms = now_ms();
+  g_input_wake_ms = g_input_epoch_ms;
+  const uint64_t wall_start_ms = SDL_GetTicks();
   while (!quit) {
     Buttons b;
     buttons_clear(&b);
     /* Decide how long we can sleep.
        Input wakes us immediately; otherwise we
-       wake for timer ticks or animations. */
-    int wait_ms = IDLE_WAIT_MS;
-    if (app.running && !app.paused)
-      wait_ms = RUN_WAIT_MS;
-    if (app.anim_overlay_enabled && app.anim_overlay_frame_count > 1) {
-      if (wait_ms > ANIM_WAIT_MS)
-        wait_ms = ANIM_WAIT_MS;
-    }
-    if (app.menu_btn_down && !app.help_overlay_open) {
-      if (wait_ms > 30)
-        wait_ms = 30;
-    }
-    if (app.hud_hide_btn_down && !app.hud_hide_hold_triggered) {
-      if (wait_ms > 30)
-        wait_ms = 30;
-    }
+       wake at the earliest deadline. */
+    const uint64_t now = now_ms();
+    loop_schedule(&sched, &app, now);
+    const SchedMode mode = loop_mode(&app);
 
     SDL_Event e;
-    bool got_event = SDL_WaitEventTimeout(&e, wait_ms);
+    bool got_event = false;
+    if (input_replaying()) {
+      const bool replayed = replay_step(&app, &sched, now, &b, &quit);
+      sched_woke(&sched, mode, now_ms(), replayed);
+    } else {
+      got_event = SDL_WaitEventTimeout(
+          &e, sched_timeout(&sched, now, LOOP_MAX_SLEEP_MS));
+      g_input_wake_ms = now_ms();
+      sched_woke(&sched, mode, g_input_wake_ms, got_event);
+    }
+    prof_wake();
+    const uint64_t t_frame = prof_begin();
+    uint64_t t_prof = t_frame;
     if (got_event) {
       /* Process the first event returned by
        * WaitEventTimeout, then drain the queue.
@@ -11982,53 +12796,20 @@ int main(int argc, char **argv) {
         if (e.type == SDL_QUIT) {
           quit = true;
           app.ui_needs_redraw = true;
+          record_input(INPUT_REC_QUIT, 0);
         }
         if (e.type == SDL_CONTROLLERBUTTONDOWN) {
-          /* Track held MENU (GUIDE) for
-           * contextual help overlay. */
-          if (e.cbutton.button == SDL_CONTROLLER_BUTTON_GUIDE) {
-            if (!app.menu_btn_down) {
-              app.menu_btn_down = true;
-              app.menu_btn_down_ms = now_ms();
-              if (timer_main_screen(&app)) {
-                quest_reload_list(&app);
-                quest_sync_daily(&app);
-              }
-            }
-          }
-          if (is_b_action_button(e.cbutton.button, app.cfg.swap_ab)) {
-            if (!app.hud_hide_btn_down) {
-              app.hud_hide_btn_down = true;
-              app.hud_hide_hold_triggered = false;
-              app.hud_hide_btn_down_ms = now_ms();
-            }
-          }
+          if (e.cbutton.button == SDL_CONTROLLER_BUTTON_GUIDE)
+            input_menu_down(&app);
+          if (is_b_action_button(e.cbutton.button, app.cfg.swap_ab))
+            input_back_down(&app);
           map_button(&b, e.cbutton, app.cfg.swap_ab);
           app.ui_needs_redraw = true;
         } else if (e.type == SDL_CONTROLLERBUTTONUP) {
-          if (e.cbutton.button == SDL_CONTROLLER_BUTTON_GUIDE) {
-            uint64_t held_ms = now_ms() - app.menu_btn_down_ms;
-            bool short_press = held_ms < (uint64_t)UI_HELP_OVERLAY_HOLD_MS;
-            app.menu_btn_down = false;
-            if (short_press && app.screen == SCREEN_QUEST) {
-              app.screen = SCREEN_TIMER;
-              app.timer_menu_open = false;
-              app.settings_open = false;
-              app.nav_from_timer_menu = false;
-              app.quest_from_timer_button = false;
-            } else if (short_press && timer_main_screen(&app)) {
-              app.quest_from_timer_button = true;
-              app.screen = SCREEN_QUEST;
-              app.timer_menu_open = false;
-              app.settings_open = false;
-              app.nav_from_timer_menu = false;
-            }
-            app.ui_needs_redraw = true;
-          }
-          if (is_b_action_button(e.cbutton.button, app.cfg.swap_ab)) {
-            app.hud_hide_btn_down = false;
-            app.hud_hide_hold_triggered = false;
-          }
+          if (e.cbutton.button == SDL_CONTROLLER_BUTTON_GUIDE)
+            input_menu_up(&app);
+          if (is_b_action_button(e.cbutton.button, app.cfg.swap_ab))
+            input_back_up(&app);
         } else if (e.type == SDL_CONTROLLERAXISMOTION) {
           const int TH = 16000;
           if (e.caxis.axis == SDL_CONTROLLER_AXIS_TRIGGERLEFT) {
@@ -12049,28 +12830,33 @@ int main(int argc, char **argv) {
               app.trig_r2_down = 0;
           }
         } else if (e.type == SDL_KEYDOWN) {
-          if (is_b_action_key(e.key.keysym.sym, app.cfg.swap_ab)) {
-            if (!app.hud_hide_btn_down) {
-              app.hud_hide_btn_down = true;
-              app.hud_hide_hold_triggered = false;
-              app.hud_hide_btn_down_ms = now_ms();
-            }
-          }
+          if (is_b_action_key(e.key.keysym.sym, app.cfg.swap_ab))
+            input_back_down(&app);
           map_key(&b, e.key, app.cfg.swap_ab);
           app.ui_needs_redraw = true;
         } else if (e.type == SDL_KEYUP) {
-          if (is_b_action_key(e.key.keysym.sym, app.cfg.swap_ab)) {
-            app.hud_hide_btn_down = false;
-            app.hud_hide_hold_triggered = false;
-          }
+          if (is_b_action_key(e.key.keysym.sym, app.cfg.swap_ab))
+            input_back_up(&app);
+        } else if (app.audio_wake_event && e.type == app.audio_wake_event) {
+          /* Audio engine wake-up; the events are drained by
+           * music_player_update below. */
+        } else if (app.bg_wake_event && e.type == app.bg_wake_event) {
+          /* Background ready; taken by bg_loader_take below. */
         }
         if (!SDL_PollEvent(&e))
           break;
       }
+      if (input_buttons_any(&b))
+        record_input(INPUT_REC_BUTTONS, input_buttons_pack(&b));
     }
+    prof_overlay_combo(&app, &b);
+    prof_end(PROF_INPUT, t_prof);
     if (app.screen == SCREEN_TIMER)
       app_update(&app);
+    t_prof = prof_begin();
     update_poll(&app);
+    prof_end(PROF_POLL, t_prof);
+    clock_battery_poll(&app);
 
     /* MENU button: hold to show contextual UI
      * help overlay (PNG). */
@@ -12078,6 +12864,7 @@ int main(int argc, char **argv) {
 
     /* Booklets overlay: handled globally while
      * open. */
+    t_prof = prof_begin();
     if (!app.help_overlay_open && app.booklets.open) {
       handle_booklets(&ui, &app, &b);
     }
@@ -12120,96 +12907,59 @@ int main(int argc, char **argv) {
         handle_timer(&ui, &app, &b);
       }
     }
+    prof_end(PROF_INPUT, t_prof);
     if (app.quit_requested) {
       quit = true;
     }
     music_player_update(&app);
+    {
+      /* A background decoded off-thread replaces the old one here. */
+      BgImage *bg = bg_loader_take();
+      if (bg) {
+        bg_apply_image(&ui, bg);
+        app.ui_needs_redraw = true;
+      }
+    }
     anim_overlay_update(&app);
-    if (app.ui_needs_redraw) {
-      SDL_SetRenderDrawBlendMode(ui.ren, SDL_BLENDMODE_NONE);
-      SDL_SetRenderDrawColor(ui.ren, 0, 0, 0, 255);
-      SDL_RenderClear(ui.ren);
-      /* Dim background whenever any overlay/menu
-       * is open, so all menus feel consistent.
-       */
-      bool want_dim = (app.screen != SCREEN_TIMER) || app.settings_open ||
-                      app.timer_menu_open || app.booklets.open ||
-                      app.help_overlay_open || app.end_focus_confirm_open ||
-                      app.end_focus_summary_open;
-      /* Base background first */
-      bool breathe_bg =
-          (app.screen == SCREEN_TIMER &&
-           (app.mode == MODE_MEDITATION && app.meditation_run_kind == 2 &&
-            app.meditation_guided_repeats_remaining > 0)) &&
-          !app.settings_open && !app.timer_menu_open && !app.booklets.open &&
-          !app.help_overlay_open && !app.end_focus_confirm_open &&
-          !app.end_focus_summary_open;
-      bool shift_bg_hidden =
-          (app.screen == SCREEN_TIMER && app.hud_hidden && !app.settings_open &&
-           !app.timer_menu_open && !app.booklets.open &&
-           !app.help_overlay_open && !app.end_focus_confirm_open &&
-           !app.end_focus_summary_open);
-      if (shift_bg_hidden) {
-        if (breathe_bg)
-          draw_bg_scaled(&ui, breath_phase_scale(&app), 0, true);
-        else
-          draw_bg_normal_shifted(&ui, BG_HIDDEN_SHIFT_Y);
+    if (app.ui_needs_redraw || app.ui_tick_damage) {
+      /* A tick that only changed the live widgets recomposites and
+         presents just the rectangles they covered in the last frame. */
+      const DamageList dmg = ui.live;
+      const bool partial =
+          !app.ui_needs_redraw && ui.surface_present && dmg.count > 0;
+      const uint64_t t0 = SDL_GetPerformanceCounter();
+      bool stale = false;
+      damage_clear(&ui.live);
+      if (partial) {
+        /* One pass clipped to the bounding box; only the rectangles
+           themselves are presented. */
+        const SDL_Rect clip = damage_bounds(&dmg);
+        SDL_RenderSetClipRect(ui.ren, &clip);
+        render_frame(&ui, &app);
+        SDL_RenderSetClipRect(ui.ren, NULL);
+#if STILLROOM_DEBUG_DAMAGE
+        stale = damage_debug_check(&ui, &app, &dmg);
+#endif
       } else {
-        if (want_dim)
-          draw_bg_blurred(&ui);
-        else if (app.booklets.open && app.booklets.mode == 1)
-          draw_bg_faint(&ui, 128);
-        else if (breathe_bg)
-          draw_bg_scaled(&ui, breath_phase_scale(&app), 0, true);
-        else
-          draw_bg_normal(&ui);
+        render_frame(&ui, &app);
       }
-      /* Optional animated overlay (e.g., rain)
-       */
-      anim_overlay_draw(&ui, &app);
-
-      if (app.screen == SCREEN_POMO_PICK)
-        draw_pomo_picker(&ui, &app);
-      else if (app.screen == SCREEN_MEDITATION_PICK)
-        draw_meditation_picker(&ui, &app);
-      else if (app.screen == SCREEN_CUSTOM_PICK)
-        draw_custom_picker(&ui, &app);
-      else if (app.screen == SCREEN_FOCUS_MENU)
-        draw_focus_menu(&ui, &app);
-      else if (app.screen == SCREEN_FOCUS_TEXT)
-        draw_focus_text(&ui, &app);
-      else if (app.screen == SCREEN_STATS)
-        draw_stats(&ui, &app);
-      else if (app.screen == SCREEN_TASKS_PICK)
-        draw_tasks_pick(&ui, &app);
-      else if (app.screen == SCREEN_TASKS_LIST)
-        draw_tasks_list(&ui, &app);
-      else if (app.screen == SCREEN_TASKS_TEXT)
-        draw_tasks_text(&ui, &app);
-
-      else if (app.screen == SCREEN_ROUTINE_LIST) {
-        if (app.routine.grid_view)
-          draw_routine_grid(&ui, &app);
+      t_prof = prof_begin();
+      SDL_RenderPresent(ui.ren);
+      if (ui.surface_present) {
+        if (partial)
+          SDL_UpdateWindowSurfaceRects(ui.win, dmg.rects, dmg.count);
         else
-          draw_routine_list(&ui, &app);
-      } else if (app.screen == SCREEN_ROUTINE_EDIT)
-        draw_routine_edit(&ui, &app);
-      else if (app.screen == SCREEN_SETTINGS_NAME)
-        draw_settings_name(&ui, &app);
-      else if (app.screen == SCREEN_ROUTINE_ENTRY_PICKER)
-        draw_routine_entry_picker(&ui, &app);
-      else if (app.screen == SCREEN_ROUTINE_ENTRY_TEXT)
-        draw_routine_entry_text(&ui, &app);
-      else if (app.screen == SCREEN_QUEST)
-        draw_quest(&ui, &app);
-      else
-        draw_timer(&ui, &app);
-      if (app.booklets.open) {
-        draw_booklets(&ui, &app);
+          SDL_UpdateWindowSurface(ui.win);
       }
-      draw_help_overlay(&ui, &app);
-      SDL_RenderPresent(ui.ren);
-      app.ui_needs_redraw = false;
+      prof_end(PROF_PRESENT, t_prof);
+      prof_frame_end(t_frame);
+      render_stats_add(&render_stats, partial, t0,
+                       partial ? damage_area(&dmg) : (long)ui.w * ui.h);
+      /* A live widget that moved outside the damage (state label
+         swapped, timer gained an hour digit) gets a full frame. */
+      app.ui_needs_redraw =
+          stale || (partial && !damage_covers(&dmg, &ui.live));
+      app.ui_tick_damage = false;
     }
   }
   if (app.running &&
@@ -12235,21 +12985,67 @@ int main(int argc, char **argv) {
   booklets_render_clear(&app);
   config_save(&app.cfg, CONFIG_PATH);
   routine_history_save(&app);
+  activity_rollup_save();
+  activity_rollup_free();
+  history_reader_close();
+  history_log_close();
+  stats_engine_save();
+  stats_engine_free();
 
   booklets_list_clear(&app);
-  textcache_free(&app.cache_big_time);
-  textcache_free(&app.cache_clock_min);
-  textcache_free(&app.cache_clock_hour);
-  textcache_free(&app.cache_batt_bottom);
-  textcache_free(&app.cache_batt_top);
+  {
+    TextCacheStats st;
+    text_cache_get_stats(&st);
+    log_printf("text cache: %u hits, %u misses, %u evictions, %u entries, "
+               "%zu/%zu px",
+               st.hits, st.misses, st.evictions, st.entries, st.pixels,
+               st.budget_pixels);
+  }
+  render_stats_log(&render_stats);
+  loop_stats_log(&sched);
+  if (input_replaying()) {
+    const uint64_t wall_ms = SDL_GetTicks() - wall_start_ms;
+    const uint64_t virt_ms = now_ms() - g_input_epoch_ms;
+    log_printf("replay: %d records, %.1f s virtual in %.1f s",
+               input_replay_count(), (double)virt_ms / 1000.0,
+               (double)wall_ms / 1000.0);
+    printf("replay: %d records, %.1f s virtual in %.1f s\n",
+           input_replay_count(), (double)virt_ms / 1000.0,
+           (double)wall_ms / 1000.0);
+    for (int k = 0; k < 2; k++) {
+      if (render_stats.frames[k])
+        printf("replay: %u %s frames, avg %.2f ms\n", render_stats.frames[k],
+               k ? "partial" : "full",
+               (double)render_stats.ticks[k] * 1000.0 /
+                   (double)SDL_GetPerformanceFrequency() /
+                   render_stats.frames[k]);
+    }
+  }
+  input_record_close();
+  input_replay_close();
   anim_overlay_unload(&app);
   help_overlay_close(&app);
-  if (ui.bg_tex)
-    SDL_DestroyTexture(ui.bg_tex);
-  if (ui.bg_blur_tex)
-    SDL_DestroyTexture(ui.bg_blur_tex);
+  bg_loader_stop();
+  {
+    BgCacheStats st;
+    bg_cache_get_stats(&st);
+    log_printf("bg cache: %u hits, %u misses, %u evictions, %u entries, "
+               "%zu/%zu bytes",
+               st.hits, st.misses, st.evictions, st.entries, st.bytes,
+               st.budget_bytes);
+  }
+  if (bg_disk_enabled()) {
+    BgDiskStats st;
+    bg_disk_get_stats(&st);
+    log_printf("bg disk cache: %u hits, %u misses, %u stores, %u pruned",
+               st.hits, st.misses, st.stores, st.pruned);
+  }
+  bg_use(&ui, NULL);
+  bg_cache_clear();
   ui_close_fonts(&ui);
   SDL_DestroyRenderer(ui.ren);
+  if (bench_target)
+    SDL_FreeSurface(bench_target);
   SDL_DestroyWindow(ui.win);
   music_player_stop(&app);
   sl_free(&app.music_folders);
@@ -12271,5 +13067,5 @@ int main(int argc, char **argv) {
   log_printf("Normal shutdown.");
   log_close();
   SDL_Quit();
-  return 0;
+  return exit_code;
 }
@@ -0,0 +1,139 @@
+#include "asset_norm.h"
+
+#include <SDL2/SDL_image.h>
+
+#include "../gfx/pixel.h"
+
+Uint32 asset_native_format(SDL_Window *win) {
+  const Uint32 f = win ? SDL_GetWindowPixelFormat(win)
+                       : SDL_PIXELFORMAT_UNKNOWN;
+  if (f == SDL_PIXELFORMAT_UNKNOWN || SDL_BYTESPERPIXEL(f) != 4 ||
+      SDL_ISPIXELFORMAT_FOURCC(f))
+    return SDL_PIXELFORMAT_ARGB8888;
+  return f;
+}
+
+bool asset_surface_opaque(SDL_Surface *s) {
+  Uint32 key;
+  if (!s || s->format->Amask != 0 || SDL_GetColorKey(s, &key) == 0)
+    return false;
+  const SDL_Palette *pal = s->format->palette;
+  for (int i = 0; pal && i < pal->ncolors; i++) {
+    if (pal->colors[i].a != 255)
+      return false;
+  }
+  return true;
+}
+
+bool asset_scale_into(SDL_Surface *src, SDL_Surface *dst, bool premultiplied,
+                      bool opaque) {
+  if (!src || !dst)
+    return false;
+  Uint32 *out = (Uint32 *)dst->pixels;
+  const int out_stride = dst->pitch / 4;
+  if (src->w < dst->w || src->h < dst->h) {
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+    if (SDL_BlitScaled(src, NULL, dst, NULL) != 0)
+      return false;
+    if (premultiplied && !opaque)
+      gfx_premultiply(out, dst->w, dst->h, out_stride);
+    return true;
+  }
+  /* Averaging straight alpha lets the colour of transparent pixels (usually
+   * black) bleed into the edges, so translucent sources are averaged
+   * premultiplied, on a copy. Opaque ones are averaged as they are. */
+  const bool alpha = !opaque && src->format->Amask != 0;
+  SDL_Surface *argb =
+      src->format->format == SDL_PIXELFORMAT_ARGB8888 && !alpha
+          ? src
+          : SDL_ConvertSurfaceFormat(src, SDL_PIXELFORMAT_ARGB8888, 0);
+  if (!argb)
+    return false;
+  if (SDL_MUSTLOCK(argb))
+    SDL_LockSurface(argb);
+  if (alpha)
+    gfx_premultiply((Uint32 *)argb->pixels, argb->w, argb->h,
+                    argb->pitch / 4);
+  const bool ok =
+      gfx_downscale_area((const Uint32 *)argb->pixels, argb->w, argb->h,
+                         argb->pitch / 4, out, dst->w, dst->h, out_stride);
+  if (SDL_MUSTLOCK(argb))
+    SDL_UnlockSurface(argb);
+  if (argb != src)
+    SDL_FreeSurface(argb);
+  if (ok && alpha && !premultiplied)
+    gfx_unpremultiply(out, dst->w, dst->h, out_stride);
+  return ok;
+}
+
+SDL_Surface *asset_normalize(SDL_Surface *s, int w, int h) {
+  if (!s)
+    return NULL;
+  const bool opaque = asset_surface_opaque(s);
+  if (s->format->format != SDL_PIXELFORMAT_ARGB8888) {
+    SDL_Surface *conv =
+        SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(s);
+    s = conv;
+    if (!s)
+      return NULL;
+  }
+  if ((s->w == w && s->h == h) || w <= 0 || h <= 0)
+    return s;
+  SDL_Surface *out =
+      SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+  if (!out)
+    return s;
+  if (!asset_scale_into(s, out, false, opaque)) {
+    SDL_FreeSurface(out);
+    return s;
+  }
+  SDL_FreeSurface(s);
+  return out;
+}
+
+SDL_Texture *asset_texture(SDL_Renderer *ren, SDL_Surface *s,
+                           Uint32 native_format, bool opaque) {
+  if (!ren || !s)
+    return NULL;
+  const Uint32 fmt = opaque ? native_format : SDL_PIXELFORMAT_ARGB8888;
+  SDL_Surface *conv = s->format->format == fmt
+                          ? s
+                          : SDL_ConvertSurfaceFormat(s, fmt, 0);
+  if (!conv)
+    return NULL;
+  SDL_Texture *t =
+      SDL_CreateTexture(ren, fmt, SDL_TEXTUREACCESS_STATIC, conv->w, conv->h);
+  if (t) {
+    if (SDL_MUSTLOCK(conv))
+      SDL_LockSurface(conv);
+    const bool ok =
+        SDL_UpdateTexture(t, NULL, conv->pixels, conv->pitch) == 0;
+    if (SDL_MUSTLOCK(conv))
+      SDL_UnlockSurface(conv);
+    if (ok) {
+      SDL_SetTextureBlendMode(t, opaque ? SDL_BLENDMODE_NONE
+                                        : SDL_BLENDMODE_BLEND);
+    } else {
+      SDL_DestroyTexture(t);
+      t = NULL;
+    }
+  }
+  if (conv != s)
+    SDL_FreeSurface(conv);
+  return t;
+}
+
+SDL_Texture *asset_load_texture(SDL_Renderer *ren, const char *path, int w,
+                                int h, Uint32 native_format) {
+  SDL_Surface *s = path ? IMG_Load(path) : NULL;
+  if (!s)
+    return NULL;
+  const bool opaque = asset_surface_opaque(s);
+  s = asset_normalize(s, w, h);
+  if (!s)
+    return NULL;
+  SDL_Texture *t = asset_texture(ren, s, native_format, opaque);
+  SDL_FreeSurface(s);
+  return t;
+}
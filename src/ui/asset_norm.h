@@ -0,0 +1,45 @@
+#ifndef UI_ASSET_NORM_H
+#define UI_ASSET_NORM_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+/*
+ * Full-screen assets (backgrounds, help overlays, overlay frames) are
+ * normalized once when loaded: scaled to exactly the screen size and, when
+ * opaque, uploaded in the window's own pixel format. Drawing one is then an
+ * unscaled copy, which the software renderer does as a plain row copy
+ * instead of resampling and converting every pixel on every frame.
+ */
+
+/* The window's pixel format if it is 32-bit, else ARGB8888. */
+Uint32 asset_native_format(SDL_Window *win);
+
+/* True if every pixel of s is opaque by its format: no alpha channel, no
+ * colour key and, for paletted images, no translucent palette entry. */
+bool asset_surface_opaque(SDL_Surface *s);
+
+/* Scales src (any format) into dst (ARGB8888): an area average when
+ * shrinking, nearest neighbour when growing. dst gets premultiplied alpha
+ * when premultiplied is set, straight alpha otherwise. opaque says src has
+ * no alpha to speak of, which skips the alpha passes and, for ARGB8888,
+ * the copy. */
+bool asset_scale_into(SDL_Surface *src, SDL_Surface *dst, bool premultiplied,
+                      bool opaque);
+
+/* Takes ownership of s and returns it as ARGB8888 at exactly w x h. If
+ * only the scaling fails the unscaled conversion is returned; NULL if even
+ * that fails. */
+SDL_Surface *asset_normalize(SDL_Surface *s, int w, int h);
+
+/* A static texture of s. Opaque surfaces are converted to native_format
+ * and copied without blending; others stay ARGB8888 and blend. */
+SDL_Texture *asset_texture(SDL_Renderer *ren, SDL_Surface *s,
+                           Uint32 native_format, bool opaque);
+
+/* Loads, normalizes to w x h and uploads an image; NULL if it is missing or
+ * unreadable. */
+SDL_Texture *asset_load_texture(SDL_Renderer *ren, const char *path, int w,
+                                int h, Uint32 native_format);
+
+#endif
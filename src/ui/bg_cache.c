@@ -0,0 +1,170 @@
+#include "bg_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BG_CACHE_MAX_ENTRIES 16
+/* About three backgrounds with their layers at 1024x768. */
+#define BG_CACHE_DEFAULT_BUDGET ((size_t)48 * 1024 * 1024)
+
+typedef struct {
+  BgTextures t; /* first, so a BgTextures pointer maps back to its entry */
+  char *path;
+  time_t mtime;
+  size_t bytes;
+  unsigned last_use;
+} Entry;
+
+static Entry *g_entries[BG_CACHE_MAX_ENTRIES];
+static const Entry *g_pinned;
+static unsigned g_use_clock;
+static BgCacheStats g_stats = {0, 0, 0, 0, 0, BG_CACHE_DEFAULT_BUDGET};
+
+static size_t texture_bytes(SDL_Texture *t) {
+  int w = 0, h = 0;
+  if (!t || SDL_QueryTexture(t, NULL, NULL, &w, &h) != 0)
+    return 0;
+  return (size_t)w * (size_t)h * 4;
+}
+
+static void textures_destroy(const BgTextures *t) {
+  if (t->tex)
+    SDL_DestroyTexture(t->tex);
+  if (t->blur_tex)
+    SDL_DestroyTexture(t->blur_tex);
+  for (int i = 0; i < BG_LAYER_COUNT; i++) {
+    if (t->layers[i])
+      SDL_DestroyTexture(t->layers[i]);
+  }
+}
+
+static int find(const char *path, time_t mtime) {
+  for (int i = 0; i < BG_CACHE_MAX_ENTRIES; i++) {
+    const Entry *e = g_entries[i];
+    if (e && e->mtime == mtime && strcmp(e->path, path) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static void entry_remove(int i) {
+  Entry *e = g_entries[i];
+  g_entries[i] = NULL;
+  if (e == g_pinned)
+    g_pinned = NULL;
+  textures_destroy(&e->t);
+  g_stats.bytes -= e->bytes;
+  g_stats.entries--;
+  free(e->path);
+  free(e);
+}
+
+/* Index of the least recently used entry that may be evicted, or -1. */
+static int lru_victim(const Entry *keep) {
+  int victim = -1;
+  for (int i = 0; i < BG_CACHE_MAX_ENTRIES; i++) {
+    const Entry *e = g_entries[i];
+    if (!e || e == g_pinned || e == keep)
+      continue;
+    if (victim < 0 || e->last_use < g_entries[victim]->last_use)
+      victim = i;
+  }
+  return victim;
+}
+
+static void enforce_budget(const Entry *keep) {
+  while (g_stats.bytes > g_stats.budget_bytes) {
+    int victim = lru_victim(keep);
+    if (victim < 0)
+      break;
+    entry_remove(victim);
+    g_stats.evictions++;
+  }
+}
+
+const BgTextures *bg_cache_lookup(const char *path, time_t mtime) {
+  if (!path)
+    return NULL;
+  int i = find(path, mtime);
+  if (i < 0) {
+    g_stats.misses++;
+    return NULL;
+  }
+  g_stats.hits++;
+  g_entries[i]->last_use = ++g_use_clock;
+  return &g_entries[i]->t;
+}
+
+bool bg_cache_contains(const char *path, time_t mtime) {
+  return path && find(path, mtime) >= 0;
+}
+
+const BgTextures *bg_cache_insert(const char *path, time_t mtime,
+                                  const BgTextures *t) {
+  if (!path || !t)
+    return NULL;
+  int i = find(path, mtime);
+  if (i >= 0) {
+    /* Decoded twice (e.g. a prefetch raced a request): keep the first. */
+    if (&g_entries[i]->t != t)
+      textures_destroy(t);
+    g_entries[i]->last_use = ++g_use_clock;
+    return &g_entries[i]->t;
+  }
+
+  Entry *e = (Entry *)calloc(1, sizeof(Entry));
+  char *dup = strdup(path);
+  if (!e || !dup) {
+    free(e);
+    free(dup);
+    textures_destroy(t);
+    return NULL;
+  }
+  e->t = *t;
+  e->path = dup;
+  e->mtime = mtime;
+  e->bytes = texture_bytes(t->tex) + texture_bytes(t->blur_tex);
+  for (int k = 0; k < BG_LAYER_COUNT; k++)
+    e->bytes += texture_bytes(t->layers[k]);
+  e->last_use = ++g_use_clock;
+
+  int slot = -1;
+  for (int k = 0; k < BG_CACHE_MAX_ENTRIES && slot < 0; k++) {
+    if (!g_entries[k])
+      slot = k;
+  }
+  if (slot < 0) {
+    /* Full; only the pinned entry is protected, so a victim exists. */
+    slot = lru_victim(NULL);
+    entry_remove(slot);
+    g_stats.evictions++;
+  }
+  g_entries[slot] = e;
+  g_stats.entries++;
+  g_stats.bytes += e->bytes;
+  enforce_budget(e);
+  return &e->t;
+}
+
+void bg_cache_pin(const BgTextures *t) {
+  g_pinned = (const Entry *)t;
+  enforce_budget(NULL);
+}
+
+void bg_cache_set_budget(size_t bytes) {
+  g_stats.budget_bytes = bytes;
+  enforce_budget(NULL);
+}
+
+void bg_cache_get_stats(BgCacheStats *out) {
+  if (out)
+    *out = g_stats;
+}
+
+void bg_cache_clear(void) {
+  for (int i = 0; i < BG_CACHE_MAX_ENTRIES; i++) {
+    if (g_entries[i])
+      entry_remove(i);
+  }
+  g_pinned = NULL;
+}
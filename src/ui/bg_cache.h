@@ -0,0 +1,53 @@
+#ifndef UI_BG_CACHE_H
+#define UI_BG_CACHE_H
+
+#include "../app.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Cache of uploaded background textures, keyed by (path, mtime), so going
+ * back to a recently shown background is a pointer swap instead of a decode,
+ * blur and layer build. Entries are evicted least recently used first once
+ * their textures exceed a byte budget; the pinned entry (the one on screen)
+ * is never evicted.
+ *
+ * The cache owns the textures. UI.bg_tex, UI.bg_blur_tex and UI.bg_layers
+ * borrow them from the pinned entry.
+ */
+
+typedef struct BgTextures {
+  SDL_Texture *tex;
+  SDL_Texture *blur_tex;
+  SDL_Texture *layers[BG_LAYER_COUNT];
+} BgTextures;
+
+typedef struct BgCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t entries;
+  size_t bytes; /* texture memory held (4 bytes per pixel) */
+  size_t budget_bytes;
+} BgCacheStats;
+
+/* Counts a hit or miss; a hit becomes the most recently used entry. */
+const BgTextures *bg_cache_lookup(const char *path, time_t mtime);
+/* No stats, no LRU update (for prefetch decisions). */
+bool bg_cache_contains(const char *path, time_t mtime);
+/* Takes ownership of the textures in t. Returns the cached set, or NULL (with
+ * the textures destroyed) if the entry could not be allocated. */
+const BgTextures *bg_cache_insert(const char *path, time_t mtime,
+                                  const BgTextures *t);
+/* Marks the set on screen (NULL for none); evicts down to the budget. */
+void bg_cache_pin(const BgTextures *t);
+
+void bg_cache_set_budget(size_t bytes);
+void bg_cache_get_stats(BgCacheStats *out);
+/* Destroys every texture, pinned or not. Counters are kept. */
+void bg_cache_clear(void);
+
+#endif
@@ -0,0 +1,286 @@
+#include "bg_disk.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "../utils/file_utils.h"
+#include "../utils/string_utils.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define BG_DISK_MAGIC "SRBGC001"
+#define BG_DISK_VERSION 1
+#define BG_DISK_EXT ".bgc"
+#define BG_DISK_MAX_FILES 256 /* entries considered when pruning */
+
+/* Native endian: the cache never leaves the device that wrote it. The
+ * source path (path_len bytes) follows, then the full and blur pixels. */
+typedef struct {
+  char magic[8];
+  int64_t mtime;
+  uint32_t version;
+  uint32_t w, h;
+  uint32_t blur_w, blur_h; /* 0 when there is no blurred copy */
+  uint32_t opaque;
+  uint32_t path_len;
+  uint32_t reserved;
+} Header;
+
+static char *g_dir;
+static size_t g_budget;
+static size_t g_total; /* bytes on disk as of the last prune, plus stores */
+static BgDiskStats g_stats;
+static SDL_SpinLock g_stats_lock;
+static SDL_SpinLock g_prune_lock; /* held for a whole prune */
+
+static void entry_path(char *out, size_t cap, const char *path, int w,
+                       int h) {
+  snprintf(out, cap, "%s/bg-%08x-%dx%d" BG_DISK_EXT, g_dir, fnv1a32(path), w,
+           h);
+}
+
+static void count(uint32_t *counter) {
+  SDL_AtomicLock(&g_stats_lock);
+  (*counter)++;
+  SDL_AtomicUnlock(&g_stats_lock);
+}
+
+typedef struct {
+  char *name;
+  time_t mtime;
+  off_t size;
+} DiskFile;
+
+static int by_mtime(const void *a, const void *b) {
+  const DiskFile *x = (const DiskFile *)a, *y = (const DiskFile *)b;
+  return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+/* Deletes the least recently used entries (oldest mtime, which loads
+ * refresh) until the directory fits the budget. Stores on the main thread and
+ * the loader thread can both get here; whichever comes second skips, since
+ * the prune already running rescans the directory and trims it. */
+static void prune(void) {
+  if (!SDL_AtomicTryLock(&g_prune_lock))
+    return;
+  DIR *d = opendir(g_dir);
+  if (!d) {
+    SDL_AtomicUnlock(&g_prune_lock);
+    return;
+  }
+  DiskFile files[BG_DISK_MAX_FILES];
+  int n = 0;
+  size_t total = 0;
+  char p[PATH_MAX];
+  struct dirent *e;
+  while ((e = readdir(d)) != NULL && n < BG_DISK_MAX_FILES) {
+    if (!ends_with_icase(e->d_name, BG_DISK_EXT))
+      continue;
+    snprintf(p, sizeof(p), "%s/%s", g_dir, e->d_name);
+    struct stat st;
+    if (stat(p, &st) != 0 || !S_ISREG(st.st_mode))
+      continue;
+    files[n].name = strdup(e->d_name);
+    if (!files[n].name)
+      break;
+    files[n].mtime = st.st_mtime;
+    files[n].size = st.st_size;
+    total += (size_t)st.st_size;
+    n++;
+  }
+  closedir(d);
+  qsort(files, (size_t)n, sizeof(DiskFile), by_mtime);
+  for (int i = 0; i < n; i++) {
+    if (total > g_budget) {
+      snprintf(p, sizeof(p), "%s/%s", g_dir, files[i].name);
+      if (remove(p) == 0) {
+        total -= (size_t)files[i].size;
+        count(&g_stats.pruned);
+      }
+    }
+    free(files[i].name);
+  }
+  SDL_AtomicLock(&g_stats_lock);
+  g_total = total;
+  SDL_AtomicUnlock(&g_stats_lock);
+  SDL_AtomicUnlock(&g_prune_lock);
+}
+
+void bg_disk_open(const char *dir, size_t budget_bytes) {
+  free(g_dir);
+  g_dir = NULL;
+  if (!dir || !dir[0] || budget_bytes == 0)
+    return;
+  ensure_dir(dir);
+  if (!is_dir(dir))
+    return;
+  g_dir = strdup(dir);
+  g_budget = budget_bytes;
+  if (g_dir)
+    prune();
+}
+
+bool bg_disk_enabled(void) { return g_dir != NULL; }
+
+/* Opens the entry for path and checks its header against the key. */
+static FILE *open_entry(const char *path, time_t mtime, int w, int h,
+                        Header *hdr) {
+  char p[PATH_MAX];
+  entry_path(p, sizeof(p), path, w, h);
+  FILE *f = fopen(p, "rb");
+  if (!f)
+    return NULL;
+  const size_t len = strlen(path);
+  char stored[PATH_MAX];
+  bool ok = fread(hdr, sizeof(*hdr), 1, f) == 1 &&
+            memcmp(hdr->magic, BG_DISK_MAGIC, 8) == 0 &&
+            hdr->version == BG_DISK_VERSION && hdr->mtime == (int64_t)mtime &&
+            hdr->w == (uint32_t)w && hdr->h == (uint32_t)h &&
+            hdr->path_len == len && len < sizeof(stored) &&
+            hdr->blur_w <= (uint32_t)w && hdr->blur_h <= (uint32_t)h &&
+            fread(stored, 1, len, f) == len && memcmp(stored, path, len) == 0;
+  if (!ok) {
+    fclose(f);
+    return NULL;
+  }
+  return f;
+}
+
+/* Reads w x h pixels straight into a new surface. */
+static SDL_Surface *read_surface(FILE *f, int w, int h) {
+  SDL_Surface *s =
+      SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+  if (!s)
+    return NULL;
+  const size_t row = (size_t)w * 4;
+  bool ok = true;
+  if ((size_t)s->pitch == row) {
+    ok = fread(s->pixels, row, (size_t)h, f) == (size_t)h;
+  } else {
+    for (int y = 0; ok && y < h; y++)
+      ok = fread((Uint8 *)s->pixels + (size_t)y * s->pitch, row, 1, f) == 1;
+  }
+  if (!ok) {
+    SDL_FreeSurface(s);
+    return NULL;
+  }
+  return s;
+}
+
+static bool write_surface(FILE *f, const SDL_Surface *s) {
+  const size_t row = (size_t)s->w * 4;
+  if ((size_t)s->pitch == row)
+    return fwrite(s->pixels, row, (size_t)s->h, f) == (size_t)s->h;
+  for (int y = 0; y < s->h; y++) {
+    if (fwrite((const Uint8 *)s->pixels + (size_t)y * s->pitch, row, 1, f) !=
+        1)
+      return false;
+  }
+  return true;
+}
+
+BgImage *bg_disk_load(const char *path, time_t mtime, int screen_w,
+                      int screen_h) {
+  if (!g_dir || !path || !path[0])
+    return NULL;
+  Header hdr;
+  FILE *f = open_entry(path, mtime, screen_w, screen_h, &hdr);
+  if (!f) {
+    count(&g_stats.misses);
+    return NULL;
+  }
+  BgImage *img = (BgImage *)calloc(1, sizeof(BgImage));
+  if (img)
+    img->path = strdup(path);
+  if (img && img->path) {
+    img->mtime = mtime;
+    img->opaque = hdr.opaque != 0;
+    img->full = read_surface(f, (int)hdr.w, (int)hdr.h);
+    if (img->full && hdr.blur_w && hdr.blur_h)
+      img->blur = read_surface(f, (int)hdr.blur_w, (int)hdr.blur_h);
+  }
+  fclose(f);
+  if (!img || !img->full || (hdr.blur_w && !img->blur)) {
+    /* Truncated or unreadable; the next decode rewrites it. */
+    bg_image_free(img);
+    count(&g_stats.misses);
+    return NULL;
+  }
+  /* Loads refresh the mtime that pruning goes by. */
+  char p[PATH_MAX];
+  entry_path(p, sizeof(p), path, screen_w, screen_h);
+  utime(p, NULL);
+  count(&g_stats.hits);
+  return img;
+}
+
+bool bg_disk_has(const char *path, time_t mtime, int screen_w, int screen_h) {
+  if (!g_dir || !path || !path[0])
+    return false;
+  Header hdr;
+  FILE *f = open_entry(path, mtime, screen_w, screen_h, &hdr);
+  if (!f)
+    return false;
+  fclose(f);
+  return true;
+}
+
+bool bg_disk_store(const BgImage *img) {
+  if (!g_dir || !img || !img->path || !img->path[0] || !img->full)
+    return false;
+  Header hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, BG_DISK_MAGIC, 8);
+  hdr.version = BG_DISK_VERSION;
+  hdr.mtime = (int64_t)img->mtime;
+  hdr.w = (uint32_t)img->full->w;
+  hdr.h = (uint32_t)img->full->h;
+  if (img->blur) {
+    hdr.blur_w = (uint32_t)img->blur->w;
+    hdr.blur_h = (uint32_t)img->blur->h;
+  }
+  hdr.opaque = img->opaque ? 1 : 0;
+  hdr.path_len = (uint32_t)strlen(img->path);
+
+  char p[PATH_MAX], tmp[PATH_MAX + 4];
+  entry_path(p, sizeof(p), img->path, img->full->w, img->full->h);
+  snprintf(tmp, sizeof(tmp), "%s.tmp", p);
+  FILE *f = fopen(tmp, "wb");
+  if (!f)
+    return false;
+  bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+            fwrite(img->path, 1, hdr.path_len, f) == hdr.path_len &&
+            write_surface(f, img->full) &&
+            (!img->blur || write_surface(f, img->blur));
+  ok = fclose(f) == 0 && ok;
+  /* Renamed into place whole, so a reader never sees half an entry. */
+  if (!ok || rename(tmp, p) != 0) {
+    remove(tmp);
+    return false;
+  }
+  const size_t bytes = sizeof(hdr) + hdr.path_len +
+                       (size_t)hdr.w * hdr.h * 4 +
+                       (size_t)hdr.blur_w * hdr.blur_h * 4;
+  SDL_AtomicLock(&g_stats_lock);
+  g_stats.stores++;
+  g_total += bytes;
+  const bool over = g_total > g_budget;
+  SDL_AtomicUnlock(&g_stats_lock);
+  if (over)
+    prune();
+  return true;
+}
+
+void bg_disk_get_stats(BgDiskStats *out) {
+  if (!out)
+    return;
+  SDL_AtomicLock(&g_stats_lock);
+  *out = g_stats;
+  SDL_AtomicUnlock(&g_stats_lock);
+}
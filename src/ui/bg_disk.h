@@ -0,0 +1,44 @@
+#ifndef UI_BG_DISK_H
+#define UI_BG_DISK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "bg_loader.h"
+
+/*
+ * On-disk cache of decoded backgrounds, so a background seen before (even in
+ * an earlier run) costs one read instead of a decode, scale and blur.
+ *
+ * Each entry holds the image already scaled to the screen, in ARGB8888 as
+ * the loader produces it, plus its blurred copy. Entries are keyed by source
+ * path, source mtime and screen size; a file whose source changed is simply
+ * rewritten. When the directory grows past its byte budget the entries used
+ * least recently are deleted.
+ */
+
+typedef struct BgDiskStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t stores;
+  uint32_t pruned; /* entries deleted to fit the budget */
+} BgDiskStats;
+
+/* Uses dir (created if missing) with a budget in bytes, pruning to it. A
+ * zero budget or NULL dir turns the cache off. Call before any load. */
+void bg_disk_open(const char *dir, size_t budget_bytes);
+bool bg_disk_enabled(void);
+
+/* The cached decode of path, or NULL on a miss. */
+BgImage *bg_disk_load(const char *path, time_t mtime, int screen_w,
+                      int screen_h);
+/* True if an entry for path exists (header check only). */
+bool bg_disk_has(const char *path, time_t mtime, int screen_w, int screen_h);
+/* Writes img, whose full surface must be screen size. */
+bool bg_disk_store(const BgImage *img);
+
+void bg_disk_get_stats(BgDiskStats *out);
+
+#endif
@@ -0,0 +1,387 @@
+#include "bg_loader.h"
+
+#include <SDL2/SDL_image.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../gfx/blur.h"
+#include "../gfx/pixel.h"
+#include "../utils/file_utils.h"
+#include "asset_norm.h"
+#include "bg_disk.h"
+
+#define BG_LOADER_PREFETCH_MAX 4 /* queued neighbour decodes */
+#define BG_LOADER_KEEP 4         /* decoded neighbours held for later */
+#define BG_LOADER_WARM_MAX 32    /* queued disk-cache builds */
+#define BG_BLUR_DOWNSCALE 4      /* blur source is 1/4 of the screen */
+#define BG_BLUR_RADIUS 2         /* box radius at that scale */
+#define BG_BLUR_PASSES 3         /* three box passes ~ a Gaussian */
+
+/* Blur scratch shared by the worker and synchronous loads. */
+static GfxBlur *g_blur;
+static SDL_SpinLock g_blur_lock;
+
+/* Blurs with the shared context, or a throwaway one if another thread is
+ * already using it (only at startup, when the first load is synchronous). */
+static bool blur_pixels(Uint32 *pix, int w, int h, int stride_px) {
+  bool ok;
+  if (SDL_AtomicTryLock(&g_blur_lock)) {
+    if (!g_blur)
+      g_blur = gfx_blur_create();
+    ok = gfx_blur_rgba(g_blur, pix, w, h, stride_px, BG_BLUR_RADIUS,
+                       BG_BLUR_PASSES);
+    SDL_AtomicUnlock(&g_blur_lock);
+  } else {
+    GfxBlur *b = gfx_blur_create();
+    ok = gfx_blur_rgba(b, pix, w, h, stride_px, BG_BLUR_RADIUS,
+                       BG_BLUR_PASSES);
+    gfx_blur_destroy(b);
+  }
+  return ok;
+}
+
+static SDL_Surface *make_blur(SDL_Surface *s_argb, int screen_w,
+                              int screen_h) {
+  int sw = screen_w / BG_BLUR_DOWNSCALE;
+  int sh = screen_h / BG_BLUR_DOWNSCALE;
+  if (sw < 16)
+    sw = 16;
+  if (sh < 16)
+    sh = 16;
+  SDL_Surface *out = SDL_CreateRGBSurfaceWithFormat(0, sw, sh, 32,
+                                                    SDL_PIXELFORMAT_ARGB8888);
+  if (!out)
+    return NULL;
+
+  if (SDL_MUSTLOCK(s_argb))
+    SDL_LockSurface(s_argb);
+  Uint32 *dst = (Uint32 *)out->pixels;
+  const int dst_stride = out->pitch / 4;
+  const bool scaled =
+      gfx_downscale_area((const Uint32 *)s_argb->pixels, s_argb->w, s_argb->h,
+                         s_argb->pitch / 4, dst, sw, sh, dst_stride);
+  if (SDL_MUSTLOCK(s_argb))
+    SDL_UnlockSurface(s_argb);
+
+  if (!scaled) {
+    SDL_FreeSurface(out);
+    return NULL;
+  }
+  if (!blur_pixels(dst, sw, sh, dst_stride)) {
+    SDL_FreeSurface(out);
+    return NULL;
+  }
+  gfx_dim(dst, sw, sh, dst_stride, BG_BLUR_DIM_ALPHA);
+  return out;
+}
+
+/* Decodes path and writes its disk-cache entry, skipping the cache probe. */
+static BgImage *decode_image(const char *path, time_t mtime, int screen_w,
+                             int screen_h) {
+  BgImage *img = (BgImage *)calloc(1, sizeof(BgImage));
+  if (!img)
+    return NULL;
+  img->path = strdup(path ? path : "");
+  if (!img->path) {
+    free(img);
+    return NULL;
+  }
+  img->mtime = mtime;
+  SDL_Surface *s = path ? IMG_Load(path) : NULL;
+  if (!s)
+    return img;
+  img->opaque = asset_surface_opaque(s);
+  /* ARGB8888 at screen size: safe pixel reading, and every later draw is
+   * an unscaled copy. */
+  img->full = asset_normalize(s, screen_w, screen_h);
+  if (img->full) {
+    img->blur = make_blur(img->full, screen_w, screen_h);
+    bg_disk_store(img);
+  }
+  return img;
+}
+
+BgImage *bg_image_load(const char *path, int screen_w, int screen_h) {
+  const time_t mtime = path ? file_mtime(path) : 0;
+  BgImage *img = bg_disk_load(path, mtime, screen_w, screen_h);
+  if (img)
+    return img;
+  return decode_image(path, mtime, screen_w, screen_h);
+}
+
+void bg_image_free(BgImage *img) {
+  if (!img)
+    return;
+  if (img->full)
+    SDL_FreeSurface(img->full);
+  if (img->blur)
+    SDL_FreeSurface(img->blur);
+  free(img->path);
+  free(img);
+}
+
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+  BgImage *img;
+  unsigned last_use;
+} Kept;
+
+static struct {
+  SDL_Thread *thread;
+  SDL_mutex *lock;
+  SDL_cond *cond;
+  bool quit;
+  int screen_w, screen_h;
+  char *want;      /* current request, NULL when none */
+  BgImage *result; /* decoded want, waiting for bg_loader_take() */
+  char *prefetch[BG_LOADER_PREFETCH_MAX];
+  int prefetch_count;
+  char *warm[BG_LOADER_WARM_MAX];
+  int warm_count;
+  Kept kept[BG_LOADER_KEEP];
+  unsigned use_clock;
+  Uint32 wake_event; /* 0 = don't push SDL events */
+} g;
+
+/* Lock held. Lets the UI thread know g.result is waiting. */
+static void set_result(BgImage *img) {
+  g.result = img;
+  if (g.wake_event) {
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = g.wake_event;
+    SDL_PushEvent(&e);
+  }
+}
+
+/* Lock held. Returns the kept image for path (removed from the set). */
+static BgImage *kept_take(const char *path) {
+  for (int i = 0; i < BG_LOADER_KEEP; i++) {
+    if (g.kept[i].img && strcmp(g.kept[i].img->path, path) == 0) {
+      BgImage *img = g.kept[i].img;
+      g.kept[i].img = NULL;
+      return img;
+    }
+  }
+  return NULL;
+}
+
+static bool kept_has(const char *path) {
+  for (int i = 0; i < BG_LOADER_KEEP; i++) {
+    if (g.kept[i].img && strcmp(g.kept[i].img->path, path) == 0)
+      return true;
+  }
+  return false;
+}
+
+/* Lock held. Takes ownership of img, evicting the least recently kept. */
+static void kept_put(BgImage *img) {
+  int slot = 0;
+  for (int i = 0; i < BG_LOADER_KEEP; i++) {
+    if (!g.kept[i].img) {
+      slot = i;
+      break;
+    }
+    if (g.kept[i].last_use < g.kept[slot].last_use)
+      slot = i;
+  }
+  bg_image_free(g.kept[slot].img);
+  g.kept[slot].img = img;
+  g.kept[slot].last_use = ++g.use_clock;
+}
+
+static void prefetch_clear(void) {
+  for (int i = 0; i < g.prefetch_count; i++)
+    free(g.prefetch[i]);
+  g.prefetch_count = 0;
+}
+
+/* Lock not held. Decodes path only to write its disk-cache entry. */
+static void warm_one(const char *path) {
+  const time_t mtime = file_mtime(path);
+  if (bg_disk_has(path, mtime, g.screen_w, g.screen_h))
+    return;
+  /* Straight to the decode: going through bg_image_load would open the
+   * entry a second time and count the miss the probe already found. */
+  bg_image_free(decode_image(path, mtime, g.screen_w, g.screen_h));
+}
+
+static int loader_thread(void *userdata) {
+  (void)userdata;
+  SDL_LockMutex(g.lock);
+  while (!g.quit) {
+    char *job = NULL;
+    if (g.want && !g.result) {
+      BgImage *hit = kept_take(g.want);
+      if (hit) {
+        set_result(hit);
+        continue;
+      }
+      job = strdup(g.want);
+    } else if (g.prefetch_count > 0) {
+      job = g.prefetch[0];
+      g.prefetch_count--;
+      memmove(g.prefetch, g.prefetch + 1, sizeof(char *) * g.prefetch_count);
+      if (kept_has(job) || (g.result && strcmp(g.result->path, job) == 0)) {
+        free(job);
+        continue;
+      }
+    } else if (g.warm_count > 0) {
+      job = g.warm[--g.warm_count];
+      SDL_UnlockMutex(g.lock);
+      warm_one(job);
+      free(job);
+      SDL_LockMutex(g.lock);
+      continue;
+    } else {
+      SDL_CondWait(g.cond, g.lock);
+      continue;
+    }
+    if (!job)
+      continue;
+
+    SDL_UnlockMutex(g.lock);
+    BgImage *img = bg_image_load(job, g.screen_w, g.screen_h);
+    free(job);
+    SDL_LockMutex(g.lock);
+
+    if (!img)
+      continue;
+    if (g.want && !g.result && strcmp(g.want, img->path) == 0)
+      set_result(img);
+    else if (img->full)
+      kept_put(img);
+    else
+      bg_image_free(img);
+  }
+  SDL_UnlockMutex(g.lock);
+  return 0;
+}
+
+bool bg_loader_start(int screen_w, int screen_h) {
+  if (g.thread)
+    return true;
+  g.screen_w = screen_w;
+  g.screen_h = screen_h;
+  g.quit = false;
+  g.lock = SDL_CreateMutex();
+  g.cond = SDL_CreateCond();
+  if (g.lock && g.cond)
+    g.thread = SDL_CreateThread(loader_thread, "bg_loader", NULL);
+  if (!g.thread) {
+    if (g.cond)
+      SDL_DestroyCond(g.cond);
+    if (g.lock)
+      SDL_DestroyMutex(g.lock);
+    g.cond = NULL;
+    g.lock = NULL;
+    return false;
+  }
+  return true;
+}
+
+void bg_loader_stop(void) {
+  if (!g.thread)
+    return;
+  SDL_LockMutex(g.lock);
+  g.quit = true;
+  SDL_CondSignal(g.cond);
+  SDL_UnlockMutex(g.lock);
+  SDL_WaitThread(g.thread, NULL);
+  g.thread = NULL;
+
+  prefetch_clear();
+  for (int i = 0; i < g.warm_count; i++)
+    free(g.warm[i]);
+  g.warm_count = 0;
+  free(g.want);
+  g.want = NULL;
+  bg_image_free(g.result);
+  g.result = NULL;
+  for (int i = 0; i < BG_LOADER_KEEP; i++) {
+    bg_image_free(g.kept[i].img);
+    g.kept[i].img = NULL;
+  }
+  SDL_DestroyCond(g.cond);
+  SDL_DestroyMutex(g.lock);
+  g.cond = NULL;
+  g.lock = NULL;
+
+  SDL_AtomicLock(&g_blur_lock);
+  gfx_blur_destroy(g_blur);
+  g_blur = NULL;
+  SDL_AtomicUnlock(&g_blur_lock);
+}
+
+bool bg_loader_running(void) { return g.thread != NULL; }
+
+void bg_loader_request(const char *path) {
+  if (!g.thread)
+    return;
+  SDL_LockMutex(g.lock);
+  free(g.want);
+  g.want = (path && path[0]) ? strdup(path) : NULL;
+  /* A finished image for an older request is still worth keeping. */
+  if (g.result && (!g.want || strcmp(g.result->path, g.want) != 0)) {
+    if (g.result->full)
+      kept_put(g.result);
+    else
+      bg_image_free(g.result);
+    g.result = NULL;
+  }
+  prefetch_clear();
+  SDL_CondSignal(g.cond);
+  SDL_UnlockMutex(g.lock);
+}
+
+void bg_loader_prefetch(const char *path) {
+  if (!g.thread || !path || !path[0])
+    return;
+  SDL_LockMutex(g.lock);
+  if (g.prefetch_count < BG_LOADER_PREFETCH_MAX) {
+    char *dup = strdup(path);
+    if (dup)
+      g.prefetch[g.prefetch_count++] = dup;
+  }
+  SDL_CondSignal(g.cond);
+  SDL_UnlockMutex(g.lock);
+}
+
+void bg_loader_warm(const char *path) {
+  if (!g.thread || !path || !path[0] || !bg_disk_enabled())
+    return;
+  SDL_LockMutex(g.lock);
+  bool queued = false;
+  for (int i = 0; i < g.warm_count && !queued; i++)
+    queued = strcmp(g.warm[i], path) == 0;
+  if (!queued && g.warm_count < BG_LOADER_WARM_MAX) {
+    char *dup = strdup(path);
+    if (dup)
+      g.warm[g.warm_count++] = dup;
+  }
+  SDL_CondSignal(g.cond);
+  SDL_UnlockMutex(g.lock);
+}
+
+void bg_loader_set_wake_event(Uint32 type) {
+  if (!g.thread)
+    return;
+  SDL_LockMutex(g.lock);
+  g.wake_event = type;
+  SDL_UnlockMutex(g.lock);
+}
+
+BgImage *bg_loader_take(void) {
+  if (!g.thread)
+    return NULL;
+  SDL_LockMutex(g.lock);
+  BgImage *img = g.result;
+  g.result = NULL;
+  if (img) {
+    free(g.want);
+    g.want = NULL;
+  }
+  SDL_UnlockMutex(g.lock);
+  return img;
+}
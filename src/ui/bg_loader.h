@@ -0,0 +1,56 @@
+#ifndef UI_BG_LOADER_H
+#define UI_BG_LOADER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* The blurred copy comes dimmed as if black at this alpha were drawn over
+ * it, the readability dim every blurred background gets. */
+#define BG_BLUR_DIM_ALPHA 128
+
+/*
+ * Background image pipeline.
+ *
+ * Decoding a background (IMG_Load, ARGB8888 conversion, downscale and blur)
+ * runs on a worker thread; the UI thread only turns the finished surfaces
+ * into textures. One request is current at a time (a newer request replaces
+ * it). Prefetched neighbours are decoded at lower priority and kept, a few at
+ * a time, so cycling onto them is immediate.
+ *
+ * Every decode is also written to the disk cache (bg_disk.h), and loads read
+ * from it first, so a background seen in any earlier run skips decoding.
+ */
+
+typedef struct BgImage {
+  char *path;
+  time_t mtime;      /* of path when it was decoded */
+  SDL_Surface *full; /* screen-size image (ARGB8888); NULL if decoding failed */
+  SDL_Surface *blur; /* blurred, dimmed 1/4-screen copy, may be NULL */
+  bool opaque;       /* source had no alpha channel */
+} BgImage;
+
+/* Decodes path synchronously. Returns NULL only when out of memory. */
+BgImage *bg_image_load(const char *path, int screen_w, int screen_h);
+void bg_image_free(BgImage *img);
+
+/* Starts the worker; false if it could not (callers load synchronously). */
+bool bg_loader_start(int screen_w, int screen_h);
+void bg_loader_stop(void);
+bool bg_loader_running(void);
+
+/* Makes path the current request (NULL cancels) and drops queued
+ * prefetches, which belonged to the previous position. */
+void bg_loader_request(const char *path);
+/* Queues a low-priority decode whose result is kept for a later request. */
+void bg_loader_prefetch(const char *path);
+/* Queues, at the lowest priority, writing path's disk-cache entry if it has
+ * none. Nothing is kept in memory. */
+void bg_loader_warm(const char *path);
+/* If type is non-zero (from SDL_RegisterEvents), an event of that type is
+ * pushed when the current request's image becomes ready for the taking. */
+void bg_loader_set_wake_event(Uint32 type);
+/* The decoded current request once ready (caller frees it), else NULL. */
+BgImage *bg_loader_take(void);
+
+#endif
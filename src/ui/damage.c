@@ -0,0 +1,97 @@
+#include "damage.h"
+
+static long rect_area(const SDL_Rect *r) { return (long)r->w * (long)r->h; }
+
+/* Bounding box of a and b. */
+static SDL_Rect rect_union(const SDL_Rect *a, const SDL_Rect *b) {
+  SDL_Rect u;
+  SDL_UnionRect(a, b, &u);
+  return u;
+}
+
+/* Overlapping or sharing an edge. */
+static bool rect_touches(const SDL_Rect *a, const SDL_Rect *b) {
+  return a->x <= b->x + b->w && b->x <= a->x + a->w && a->y <= b->y + b->h &&
+         b->y <= a->y + a->h;
+}
+
+static bool rect_contains(const SDL_Rect *outer, const SDL_Rect *r) {
+  return r->x >= outer->x && r->y >= outer->y &&
+         r->x + r->w <= outer->x + outer->w &&
+         r->y + r->h <= outer->y + outer->h;
+}
+
+void damage_clear(DamageList *d) {
+  if (d)
+    d->count = 0;
+}
+
+void damage_add(DamageList *d, SDL_Rect r, int screen_w, int screen_h) {
+  if (!d)
+    return;
+  SDL_Rect screen = {0, 0, screen_w, screen_h};
+  SDL_Rect c;
+  if (!SDL_IntersectRect(&r, &screen, &c))
+    return;
+
+  /* Absorb every rectangle the new one touches; repeat since the grown
+   * rectangle may now touch ones it missed. */
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (int i = 0; i < d->count; i++) {
+      if (!rect_touches(&d->rects[i], &c))
+        continue;
+      c = rect_union(&d->rects[i], &c);
+      d->rects[i] = d->rects[--d->count];
+      merged = true;
+      break;
+    }
+  }
+
+  if (d->count < DAMAGE_MAX_RECTS) {
+    d->rects[d->count++] = c;
+    return;
+  }
+  /* Full: grow the rectangle that wastes the fewest pixels. */
+  int best = 0;
+  long best_cost = -1;
+  for (int i = 0; i < d->count; i++) {
+    SDL_Rect u = rect_union(&d->rects[i], &c);
+    long cost = rect_area(&u) - rect_area(&d->rects[i]);
+    if (best_cost < 0 || cost < best_cost) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+  SDL_Rect u = rect_union(&d->rects[best], &c);
+  d->rects[best] = d->rects[--d->count];
+  damage_add(d, u, screen_w, screen_h);
+}
+
+bool damage_covers(const DamageList *outer, const DamageList *inner) {
+  if (!inner)
+    return true;
+  for (int i = 0; i < inner->count; i++) {
+    bool found = false;
+    for (int j = 0; outer && j < outer->count && !found; j++)
+      found = rect_contains(&outer->rects[j], &inner->rects[i]);
+    if (!found)
+      return false;
+  }
+  return true;
+}
+
+SDL_Rect damage_bounds(const DamageList *d) {
+  SDL_Rect b = {0, 0, 0, 0};
+  for (int i = 0; d && i < d->count; i++)
+    b = i == 0 ? d->rects[0] : rect_union(&b, &d->rects[i]);
+  return b;
+}
+
+long damage_area(const DamageList *d) {
+  long px = 0;
+  for (int i = 0; d && i < d->count; i++)
+    px += rect_area(&d->rects[i]);
+  return px;
+}
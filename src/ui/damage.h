@@ -0,0 +1,37 @@
+#ifndef UI_DAMAGE_H
+#define UI_DAMAGE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+/*
+ * Small screen-damage lists for partial redraws.
+ *
+ * Rectangles are clipped to the screen and merged as they are added
+ * (overlapping or touching rectangles become their bounding box). When the
+ * list is full, the new rectangle is merged into whichever existing one grows
+ * least, so a list never needs more than DAMAGE_MAX_RECTS clip passes.
+ */
+
+#define DAMAGE_MAX_RECTS 8
+
+typedef struct DamageList {
+  SDL_Rect rects[DAMAGE_MAX_RECTS];
+  int count;
+} DamageList;
+
+void damage_clear(DamageList *d);
+
+/* Adds r, clipped to a screen_w x screen_h screen. Empty rects are ignored. */
+void damage_add(DamageList *d, SDL_Rect r, int screen_w, int screen_h);
+
+/* True if every rectangle in inner lies inside some rectangle of outer. */
+bool damage_covers(const DamageList *outer, const DamageList *inner);
+
+/* Total pixels covered (rects never overlap after merging). */
+long damage_area(const DamageList *d);
+
+/* Bounding box of every rectangle, or an empty rect for an empty list. */
+SDL_Rect damage_bounds(const DamageList *d);
+
+#endif
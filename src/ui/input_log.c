@@ -0,0 +1,159 @@
+#include "input_log.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_LOG_HEADER "# stillroom input v1"
+
+static const char *const kind_names[INPUT_REC_KIND_COUNT] = {
+    "buttons", "menu_down", "menu_up", "back_down", "back_up", "quit"};
+
+/* Bit i of a mask is the field at button_fields[i]. Append only:
+ * recordings depend on the order. */
+static const size_t button_fields[] = {
+    offsetof(Buttons, up),     offsetof(Buttons, down),
+    offsetof(Buttons, left),   offsetof(Buttons, right),
+    offsetof(Buttons, a),      offsetof(Buttons, b),
+    offsetof(Buttons, x),      offsetof(Buttons, y),
+    offsetof(Buttons, start),  offsetof(Buttons, menu),
+    offsetof(Buttons, select), offsetof(Buttons, l1),
+    offsetof(Buttons, r1),     offsetof(Buttons, l2),
+    offsetof(Buttons, r2),     offsetof(Buttons, l3),
+    offsetof(Buttons, r3)};
+#define BUTTON_FIELD_COUNT                                                     \
+  (int)(sizeof(button_fields) / sizeof(button_fields[0]))
+
+uint32_t input_buttons_pack(const Buttons *b) {
+  uint32_t mask = 0;
+  for (int i = 0; i < BUTTON_FIELD_COUNT; i++) {
+    if (*(const bool *)((const char *)b + button_fields[i]))
+      mask |= 1u << i;
+  }
+  return mask;
+}
+
+void input_buttons_unpack(uint32_t mask, Buttons *b) {
+  for (int i = 0; i < BUTTON_FIELD_COUNT; i++)
+    *(bool *)((char *)b + button_fields[i]) = (mask >> i) & 1u;
+}
+
+bool input_buttons_any(const Buttons *b) { return input_buttons_pack(b) != 0; }
+
+static FILE *g_rec;
+
+bool input_record_open(const char *path) {
+  input_record_close();
+  g_rec = path ? fopen(path, "w") : NULL;
+  if (!g_rec)
+    return false;
+  fprintf(g_rec, "%s\n", INPUT_LOG_HEADER);
+  return true;
+}
+
+bool input_recording(void) { return g_rec != NULL; }
+
+void input_record(uint64_t ms, InputRecKind kind, uint32_t buttons) {
+  if (!g_rec || kind < 0 || kind >= INPUT_REC_KIND_COUNT)
+    return;
+  if (kind == INPUT_REC_BUTTONS)
+    fprintf(g_rec, "%" PRIu64 " %s %x\n", ms, kind_names[kind], buttons);
+  else
+    fprintf(g_rec, "%" PRIu64 " %s\n", ms, kind_names[kind]);
+}
+
+void input_record_close(void) {
+  if (g_rec)
+    fclose(g_rec);
+  g_rec = NULL;
+}
+
+static InputRec *g_play;
+static int g_play_count;
+static int g_play_pos;
+static bool g_play_open;
+
+static bool parse_line(const char *line, InputRec *out) {
+  char kind[32];
+  unsigned long long ms = 0;
+  unsigned int mask = 0;
+  const int n = sscanf(line, "%llu %31s %x", &ms, kind, &mask);
+  if (n < 2)
+    return false;
+  for (int k = 0; k < INPUT_REC_KIND_COUNT; k++) {
+    if (strcmp(kind, kind_names[k]) == 0) {
+      if (k == INPUT_REC_BUTTONS && n < 3)
+        return false;
+      out->ms = (uint64_t)ms;
+      out->kind = (InputRecKind)k;
+      out->buttons = (k == INPUT_REC_BUTTONS) ? (uint32_t)mask : 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool input_replay_open(const char *path) {
+  input_replay_close();
+  FILE *f = path ? fopen(path, "r") : NULL;
+  if (!f)
+    return false;
+  int cap = 0;
+  char line[128];
+  uint64_t last = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || line[0] == '\n')
+      continue;
+    InputRec r;
+    if (!parse_line(line, &r))
+      continue;
+    if (r.ms < last)
+      r.ms = last; /* keep the stream monotonic */
+    last = r.ms;
+    if (g_play_count == cap) {
+      const int ncap = cap ? cap * 2 : 256;
+      InputRec *grown =
+          (InputRec *)realloc(g_play, sizeof(InputRec) * (size_t)ncap);
+      if (!grown)
+        break;
+      g_play = grown;
+      cap = ncap;
+    }
+    g_play[g_play_count++] = r;
+  }
+  fclose(f);
+  g_play_pos = 0;
+  g_play_open = g_play_count > 0;
+  if (!g_play_open)
+    input_replay_close();
+  return g_play_open;
+}
+
+bool input_replaying(void) { return g_play_open; }
+
+bool input_replay_peek(InputRec *out) {
+  if (!g_play_open || g_play_pos >= g_play_count)
+    return false;
+  if (out)
+    *out = g_play[g_play_pos];
+  return true;
+}
+
+bool input_replay_next(InputRec *out) {
+  if (!input_replay_peek(out))
+    return false;
+  g_play_pos++;
+  return true;
+}
+
+int input_replay_count(void) { return g_play_count; }
+
+void input_replay_close(void) {
+  free(g_play);
+  g_play = NULL;
+  g_play_count = 0;
+  g_play_pos = 0;
+  g_play_open = false;
+}
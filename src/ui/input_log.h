@@ -0,0 +1,59 @@
+#ifndef UI_INPUT_LOG_H
+#define UI_INPUT_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../app.h"
+
+/*
+ * Recording and replaying the main loop's input.
+ *
+ * A recording is the input the loop acted on, not raw SDL events: the
+ * Buttons pressed in each iteration plus the held-button edges that drive
+ * hold gestures. Each record carries the milliseconds since the loop
+ * started, and records with the same stamp were seen in one iteration.
+ * Replaying runs the loop on a virtual clock that jumps from deadline to
+ * deadline and input to input, so a session replays identically however
+ * fast the machine is.
+ *
+ * The file is plain text, one record per line: "<ms> <kind> [<hex>]".
+ */
+
+typedef enum {
+  INPUT_REC_BUTTONS = 0, /* hex mask of the Buttons pressed */
+  INPUT_REC_MENU_DOWN,   /* MENU held */
+  INPUT_REC_MENU_UP,
+  INPUT_REC_BACK_DOWN, /* the B action button held */
+  INPUT_REC_BACK_UP,
+  INPUT_REC_QUIT,
+  INPUT_REC_KIND_COUNT
+} InputRecKind;
+
+typedef struct InputRec {
+  uint64_t ms; /* since the loop started */
+  InputRecKind kind;
+  uint32_t buttons; /* INPUT_REC_BUTTONS only */
+} InputRec;
+
+uint32_t input_buttons_pack(const Buttons *b);
+void input_buttons_unpack(uint32_t mask, Buttons *b);
+bool input_buttons_any(const Buttons *b);
+
+/* Recording. Writes are dropped when no recording is open. */
+bool input_record_open(const char *path);
+bool input_recording(void);
+void input_record(uint64_t ms, InputRecKind kind, uint32_t buttons);
+void input_record_close(void);
+
+/* Replay. Reads the whole file up front; false if it cannot be read or
+ * has no valid records. */
+bool input_replay_open(const char *path);
+bool input_replaying(void);
+/* The next record without consuming it; false once all are consumed. */
+bool input_replay_peek(InputRec *out);
+bool input_replay_next(InputRec *out);
+int input_replay_count(void);
+void input_replay_close(void);
+
+#endif
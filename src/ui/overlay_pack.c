@@ -0,0 +1,331 @@
+#include "overlay_pack.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../gfx/pixel.h"
+
+#define OVL_MAGIC "SROVLPK1"
+#define OVL_VERSION 1
+#define OVL_GAP_MERGE 4 /* clear runs up to this long stay inside a span */
+
+/*
+ * Layout (native endian; packs are built on the device that plays them):
+ *   PackHeader
+ *   PackFrame[count]
+ *   frame data, 4-byte aligned. Per bounding-box row: a span count, then
+ *   per span a word (x | len << 16) followed by len pixels.
+ */
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t w, h;
+  uint32_t first, count;
+  uint32_t reserved;
+  int64_t src_mtime;
+} PackHeader;
+
+typedef struct {
+  uint32_t offset; /* from the start of the file */
+  uint32_t size;   /* bytes */
+  uint16_t x, y, w, h;
+} PackFrame;
+
+struct OverlayPack {
+  const uint8_t *base;
+  size_t size;
+  const PackHeader *hdr;
+  const PackFrame *frames;
+};
+
+OverlayPack *overlay_pack_open(const char *path, int w, int h, int first,
+                               int count, time_t src_mtime) {
+  if (!path || count <= 0)
+    return NULL;
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackHeader)) {
+    close(fd);
+    return NULL;
+  }
+  const size_t size = (size_t)st.st_size;
+  void *m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED)
+    return NULL;
+
+  const PackHeader *hdr = (const PackHeader *)m;
+  const size_t table_end =
+      sizeof(PackHeader) + (size_t)hdr->count * sizeof(PackFrame);
+  bool ok = memcmp(hdr->magic, OVL_MAGIC, 8) == 0 &&
+            hdr->version == OVL_VERSION && hdr->w == (uint32_t)w &&
+            hdr->h == (uint32_t)h && hdr->first == (uint32_t)first &&
+            hdr->count == (uint32_t)count &&
+            hdr->src_mtime == (int64_t)src_mtime && table_end <= size;
+  const PackFrame *frames = (const PackFrame *)(hdr + 1);
+  for (int i = 0; ok && i < count; i++) {
+    const PackFrame *f = &frames[i];
+    ok = f->offset % 4 == 0 && f->offset >= table_end &&
+         (size_t)f->offset + f->size <= size &&
+         (uint32_t)f->x + f->w <= hdr->w && (uint32_t)f->y + f->h <= hdr->h;
+  }
+  OverlayPack *p = ok ? (OverlayPack *)calloc(1, sizeof(OverlayPack)) : NULL;
+  if (!p) {
+    munmap(m, size);
+    return NULL;
+  }
+  p->base = (const uint8_t *)m;
+  p->size = size;
+  p->hdr = hdr;
+  p->frames = frames;
+  return p;
+}
+
+void overlay_pack_close(OverlayPack *p) {
+  if (!p)
+    return;
+  munmap((void *)p->base, p->size);
+  free(p);
+}
+
+int overlay_pack_frame_count(const OverlayPack *p) {
+  return p ? (int)p->hdr->count : 0;
+}
+
+size_t overlay_pack_size(const OverlayPack *p) { return p ? p->size : 0; }
+
+void overlay_pack_draw(const OverlayPack *p, int frame, uint32_t *dst,
+                       int dst_stride, const SDL_Rect *clip) {
+  if (!p || !dst || frame < 0 || frame >= (int)p->hdr->count)
+    return;
+  const PackFrame *f = &p->frames[frame];
+  int cx0 = 0, cy0 = 0, cx1 = (int)p->hdr->w, cy1 = (int)p->hdr->h;
+  if (clip) {
+    cx0 = clip->x > 0 ? clip->x : 0;
+    cy0 = clip->y > 0 ? clip->y : 0;
+    if (clip->x + clip->w < cx1)
+      cx1 = clip->x + clip->w;
+    if (clip->y + clip->h < cy1)
+      cy1 = clip->y + clip->h;
+  }
+  if (cx0 >= cx1 || cy0 >= cy1)
+    return;
+
+  /* Rows are variable length, so rows above the clip are walked over. */
+  const uint32_t *q = (const uint32_t *)(p->base + f->offset);
+  const uint32_t *end = q + f->size / 4;
+  for (int r = 0; r < f->h; r++) {
+    const int y = f->y + r;
+    if (y >= cy1 || q >= end)
+      return;
+    const uint32_t spans = *q++;
+    const bool visible = y >= cy0;
+    uint32_t *row = dst + (size_t)y * dst_stride;
+    for (uint32_t s = 0; s < spans; s++) {
+      if (q >= end)
+        return;
+      const int x = (int)(*q & 0xFFFF);
+      const int len = (int)(*q >> 16);
+      q++;
+      if (end - q < len)
+        return;
+      if (visible) {
+        const int a = x > cx0 ? x : cx0;
+        const int b = x + len < cx1 ? x + len : cx1;
+        if (a < b)
+          gfx_over(row + a, 0, q + (a - x), 0, b - a, 1);
+      }
+      q += len;
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+struct OverlayPackWriter {
+  FILE *f;
+  char *path;
+  char *tmp;
+  PackHeader hdr;
+  PackFrame *frames;
+  int added;
+  uint32_t offset;
+  uint32_t *buf; /* one encoded frame */
+  size_t cap;
+  size_t len;
+};
+
+OverlayPackWriter *overlay_pack_begin(const char *path, int w, int h,
+                                      int first, int count, time_t src_mtime) {
+  if (!path || w <= 0 || h <= 0 || w > 0xFFFF || h > 0xFFFF || count <= 0)
+    return NULL;
+  OverlayPackWriter *wr =
+      (OverlayPackWriter *)calloc(1, sizeof(OverlayPackWriter));
+  if (!wr)
+    return NULL;
+  const size_t n = strlen(path);
+  wr->path = strdup(path);
+  wr->tmp = (char *)malloc(n + 5);
+  wr->frames = (PackFrame *)calloc((size_t)count, sizeof(PackFrame));
+  if (!wr->path || !wr->tmp || !wr->frames) {
+    overlay_pack_abort(wr);
+    return NULL;
+  }
+  memcpy(wr->tmp, path, n);
+  memcpy(wr->tmp + n, ".tmp", 5);
+  memcpy(wr->hdr.magic, OVL_MAGIC, 8);
+  wr->hdr.version = OVL_VERSION;
+  wr->hdr.w = (uint32_t)w;
+  wr->hdr.h = (uint32_t)h;
+  wr->hdr.first = (uint32_t)first;
+  wr->hdr.count = (uint32_t)count;
+  wr->hdr.src_mtime = (int64_t)src_mtime;
+
+  wr->f = fopen(wr->tmp, "wb");
+  if (!wr->f) {
+    overlay_pack_abort(wr);
+    return NULL;
+  }
+  /* Header and table are written last; frame data starts after them. */
+  wr->offset =
+      (uint32_t)(sizeof(PackHeader) + (size_t)count * sizeof(PackFrame));
+  if (fseek(wr->f, (long)wr->offset, SEEK_SET) != 0) {
+    overlay_pack_abort(wr);
+    return NULL;
+  }
+  return wr;
+}
+
+static bool buf_push(OverlayPackWriter *wr, const uint32_t *words, size_t n) {
+  if (wr->len + n > wr->cap) {
+    size_t cap = wr->cap ? wr->cap : 4096;
+    while (cap < wr->len + n)
+      cap *= 2;
+    uint32_t *b = (uint32_t *)realloc(wr->buf, cap * sizeof(uint32_t));
+    if (!b)
+      return false;
+    wr->buf = b;
+    wr->cap = cap;
+  }
+  if (words)
+    memcpy(wr->buf + wr->len, words, n * sizeof(uint32_t));
+  wr->len += n;
+  return true;
+}
+
+/* Appends one row's spans of non-clear pixels in [x0, x1). */
+static bool encode_row(OverlayPackWriter *wr, const uint32_t *row, int x0,
+                       int x1) {
+  const size_t count_at = wr->len;
+  uint32_t spans = 0;
+  if (!buf_push(wr, NULL, 1))
+    return false;
+  int x = x0;
+  while (x < x1) {
+    while (x < x1 && !row[x])
+      x++;
+    if (x >= x1)
+      break;
+    const int start = x;
+    int last = x;
+    for (x++; x < x1 && x - last <= OVL_GAP_MERGE; x++) {
+      if (row[x])
+        last = x;
+    }
+    const uint32_t len = (uint32_t)(last - start + 1);
+    const uint32_t head = (uint32_t)start | len << 16;
+    if (!buf_push(wr, &head, 1) || !buf_push(wr, row + start, len))
+      return false;
+    spans++;
+    x = last + 1;
+  }
+  wr->buf[count_at] = spans;
+  return true;
+}
+
+bool overlay_pack_add(OverlayPackWriter *wr, const uint32_t *pix, int stride) {
+  if (!wr || !pix || wr->added >= (int)wr->hdr.count)
+    return false;
+  const int w = (int)wr->hdr.w, h = (int)wr->hdr.h;
+  int bx0 = w, by0 = h, bx1 = -1, by1 = -1;
+  for (int y = 0; y < h; y++) {
+    const uint32_t *row = pix + (size_t)y * stride;
+    for (int x = 0; x < w; x++) {
+      if (!row[x])
+        continue;
+      if (x < bx0)
+        bx0 = x;
+      if (x > bx1)
+        bx1 = x;
+      if (y < by0)
+        by0 = y;
+      by1 = y;
+    }
+  }
+
+  PackFrame *f = &wr->frames[wr->added];
+  wr->len = 0;
+  if (bx1 >= 0) {
+    for (int y = by0; y <= by1; y++) {
+      if (!encode_row(wr, pix + (size_t)y * stride, bx0, bx1 + 1))
+        return false;
+    }
+    f->x = (uint16_t)bx0;
+    f->y = (uint16_t)by0;
+    f->w = (uint16_t)(bx1 - bx0 + 1);
+    f->h = (uint16_t)(by1 - by0 + 1);
+  }
+  const size_t bytes = wr->len * sizeof(uint32_t);
+  if ((uint64_t)wr->offset + bytes > 0xFFFFFFFFu)
+    return false;
+  if (bytes && fwrite(wr->buf, 1, bytes, wr->f) != bytes)
+    return false;
+  f->offset = wr->offset;
+  f->size = (uint32_t)bytes;
+  wr->offset += (uint32_t)bytes;
+  wr->added++;
+  return true;
+}
+
+bool overlay_pack_finish(OverlayPackWriter *wr) {
+  if (!wr)
+    return false;
+  bool ok = wr->added == (int)wr->hdr.count && fseek(wr->f, 0, SEEK_SET) == 0 &&
+            fwrite(&wr->hdr, sizeof(wr->hdr), 1, wr->f) == 1 &&
+            fwrite(wr->frames, sizeof(PackFrame), wr->hdr.count, wr->f) ==
+                wr->hdr.count;
+  ok = fclose(wr->f) == 0 && ok;
+  wr->f = NULL;
+  ok = ok && rename(wr->tmp, wr->path) == 0;
+  if (!ok) {
+    overlay_pack_abort(wr);
+    return false;
+  }
+  free(wr->buf);
+  free(wr->frames);
+  free(wr->tmp);
+  free(wr->path);
+  free(wr);
+  return true;
+}
+
+void overlay_pack_abort(OverlayPackWriter *wr) {
+  if (!wr)
+    return;
+  if (wr->f)
+    fclose(wr->f);
+  if (wr->tmp)
+    remove(wr->tmp);
+  free(wr->buf);
+  free(wr->frames);
+  free(wr->tmp);
+  free(wr->path);
+  free(wr);
+}
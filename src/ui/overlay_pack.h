@@ -0,0 +1,50 @@
+#ifndef UI_OVERLAY_PACK_H
+#define UI_OVERLAY_PACK_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Packed overlay animations (<dir>/<tag>.ovl).
+ *
+ * A whole <tag>_NNN.png sequence in one file, already decoded: each frame
+ * is its bounding box of non-clear pixels, stored row by row as spans of
+ * premultiplied ARGB8888. The file is mmapped and drawn by compositing only
+ * the spans, so the clear parts of rain or snow cost nothing to load or
+ * blend.
+ *
+ * The header records the screen size and the source sequence (first frame
+ * number, frame count, newest PNG mtime); a pack that doesn't match is
+ * ignored and rebuilt.
+ */
+
+typedef struct OverlayPack OverlayPack;
+
+/* Maps path if it is a valid pack for this sequence at w x h, else NULL. */
+OverlayPack *overlay_pack_open(const char *path, int w, int h, int first,
+                               int count, time_t src_mtime);
+void overlay_pack_close(OverlayPack *p);
+int overlay_pack_frame_count(const OverlayPack *p);
+size_t overlay_pack_size(const OverlayPack *p);
+
+/* Composites frame over dst (the pack's w x h, stride in pixels), touching
+ * only pixels inside clip. */
+void overlay_pack_draw(const OverlayPack *p, int frame, uint32_t *dst,
+                       int dst_stride, const SDL_Rect *clip);
+
+/* Converter. Frames are added in order as premultiplied w x h pixels; the
+ * pack is written to a temporary file and renamed into place by finish. */
+typedef struct OverlayPackWriter OverlayPackWriter;
+
+OverlayPackWriter *overlay_pack_begin(const char *path, int w, int h,
+                                      int first, int count, time_t src_mtime);
+bool overlay_pack_add(OverlayPackWriter *wr, const uint32_t *pix, int stride);
+/* Returns true if the pack is complete and in place. Frees wr either way. */
+bool overlay_pack_finish(OverlayPackWriter *wr);
+/* Discards the partial pack. */
+void overlay_pack_abort(OverlayPackWriter *wr);
+
+#endif
@@ -0,0 +1,479 @@
+#include "overlay_player.h"
+
+#include <SDL2/SDL_image.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../gfx/pixel.h"
+#include "../utils/file_utils.h"
+#include "../utils/string_utils.h"
+#include "asset_norm.h"
+#include "overlay_pack.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define OVERLAY_MAX_FRAMES 240 /* <tag>_001.png .. <tag>_240.png */
+#define OVERLAY_SLOTS_MAX 8
+
+typedef enum { SLOT_FREE, SLOT_DECODING, SLOT_READY, SLOT_SHOWN } SlotState;
+
+typedef struct {
+  SDL_Surface *surf;
+  SlotState state;
+  int64_t seq; /* position in the endless loop; file is seq % count */
+} Slot;
+
+static struct {
+  SDL_Thread *thread;
+  SDL_mutex *lock;
+  SDL_cond *cond;
+  bool quit;
+  char *dir;
+  char *tag;
+  int first; /* number of the first frame file */
+  int count;
+  int w, h;
+  bool premultiply;
+  bool sync; /* one slot: decoded in advance, on the caller's thread */
+  bool failed[OVERLAY_MAX_FRAMES]; /* by file index; never retried */
+  int failed_count;
+  Slot slots[OVERLAY_SLOTS_MAX];
+  int nslots;
+  int current;       /* slot on screen, -1 before the first frame */
+  int64_t next_seq;  /* worker: next frame to decode */
+  int64_t want_seq;  /* worker: skip ahead to at least this frame */
+  int64_t shown_seq; /* frame time reached, shown or dropped */
+  OverlayPack *pack;   /* when set, frames come from here: no worker, ring */
+  int pack_frame;      /* frame on screen, -1 before the first */
+  OverlayPackWriter *writer; /* builds <tag>.ovl from the first lap */
+  int64_t pack_next;          /* next frame the writer wants */
+  time_t src_mtime;
+  OverlayPlayerStats stats;
+} g = {.current = -1, .pack_frame = -1};
+
+static void pack_path(char *out, size_t cap) {
+  snprintf(out, cap, "%s/%s.ovl", g.dir, g.tag);
+}
+
+/* Packs that could not be written (read-only dir, full disk), by path
+ * hash, so they aren't attempted on every open. */
+#define PACK_FAILED_MAX 16
+static uint32_t g_pack_failed[PACK_FAILED_MAX];
+static int g_pack_failed_count;
+
+static bool pack_failed_before(void) {
+  char path[PATH_MAX];
+  pack_path(path, sizeof(path));
+  const uint32_t h = fnv1a32(path);
+  for (int i = 0; i < g_pack_failed_count && i < PACK_FAILED_MAX; i++) {
+    if (g_pack_failed[i] == h)
+      return true;
+  }
+  return false;
+}
+
+static void pack_failed_remember(void) {
+  char path[PATH_MAX];
+  pack_path(path, sizeof(path));
+  g_pack_failed[g_pack_failed_count++ % PACK_FAILED_MAX] = fnv1a32(path);
+}
+
+/* Lock not held. Decodes frame file number index into dst without
+ * allocating a new surface (beyond IMG_Load's own). */
+static bool decode_file(SDL_Surface *dst, int index) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s_%03d.png", g.dir, g.tag,
+           g.first + index);
+  SDL_Surface *s = IMG_Load(path);
+  if (!s)
+    return false;
+  bool ok = false;
+  /* Without any alpha straight and premultiplied are the same. */
+  const bool opaque = asset_surface_opaque(s);
+  if (s->w == dst->w && s->h == dst->h) {
+    ok = SDL_ConvertPixels(s->w, s->h, s->format->format, s->pixels,
+                           s->pitch, SDL_PIXELFORMAT_ARGB8888, dst->pixels,
+                           dst->pitch) == 0;
+    if (ok && g.premultiply && !opaque)
+      gfx_premultiply((uint32_t *)dst->pixels, dst->w, dst->h,
+                      dst->pitch / 4);
+  }
+  if (!ok) {
+    /* Another size, or a paletted PNG. */
+    ok = asset_scale_into(s, dst, g.premultiply, opaque);
+  }
+  SDL_FreeSurface(s);
+  return ok;
+}
+
+/* Moves *seq on past frames that failed to decode. False if all have. */
+static bool skip_failed(int64_t *seq) {
+  if (g.failed_count >= g.count)
+    return false;
+  while (g.failed[*seq % g.count])
+    (*seq)++;
+  return true;
+}
+
+/* Lock held (when there is one). Records that frame file index failed. */
+static void mark_failed(int index) {
+  if (!g.failed[index]) {
+    g.failed[index] = true;
+    g.failed_count++;
+    g.stats.failed++;
+  }
+}
+
+/* Worker only. Adds the frame just decoded for file index to the pack
+ * being built. Frames must arrive in order on the first lap; a skipped or
+ * failed frame abandons the pack until the next open. */
+static void pack_feed(const SDL_Surface *s, int64_t seq) {
+  if (!g.writer || seq >= g.count)
+    return;
+  bool ok = seq == g.pack_next &&
+            overlay_pack_add(g.writer, (const uint32_t *)s->pixels,
+                             s->pitch / 4);
+  if (ok && ++g.pack_next < g.count)
+    return;
+  if (!ok)
+    overlay_pack_abort(g.writer);
+  else if (!overlay_pack_finish(g.writer))
+    pack_failed_remember();
+  g.writer = NULL;
+}
+
+static int player_thread(void *userdata) {
+  (void)userdata;
+  SDL_LockMutex(g.lock);
+  while (!g.quit) {
+    if (g.next_seq < g.want_seq)
+      g.next_seq = g.want_seq;
+    int free_i = -1;
+    for (int i = 0; i < g.nslots && free_i < 0; i++) {
+      if (g.slots[i].state == SLOT_FREE)
+        free_i = i;
+    }
+    /* A single still frame is decoded once; with every file failed there
+       is nothing left to try. */
+    int64_t seq = g.next_seq;
+    const bool done =
+        (g.count == 1 && g.next_seq > 0) || !skip_failed(&seq);
+    if (free_i < 0 || done) {
+      SDL_CondWait(g.cond, g.lock);
+      continue;
+    }
+    Slot *sl = &g.slots[free_i];
+    g.next_seq = seq + 1;
+    sl->state = SLOT_DECODING;
+    SDL_UnlockMutex(g.lock);
+
+    const Uint32 t0 = SDL_GetTicks();
+    const bool ok = decode_file(sl->surf, (int)(seq % g.count));
+    const Uint32 ms = SDL_GetTicks() - t0;
+    if (g.writer)
+      pack_feed(ok ? sl->surf : NULL, ok ? seq : -1);
+
+    SDL_LockMutex(g.lock);
+    /* A frame that is already late still beats the one on screen. */
+    if (ok && (g.current < 0 || seq > g.slots[g.current].seq)) {
+      sl->state = SLOT_READY;
+      sl->seq = seq;
+      g.stats.decoded++;
+      if (ms > g.stats.decode_ms)
+        g.stats.decode_ms = ms;
+    } else {
+      if (!ok)
+        mark_failed((int)(seq % g.count));
+      sl->state = SLOT_FREE;
+    }
+  }
+  SDL_UnlockMutex(g.lock);
+  return 0;
+}
+
+static void free_slots(void) {
+  for (int i = 0; i < OVERLAY_SLOTS_MAX; i++) {
+    if (g.slots[i].surf)
+      SDL_FreeSurface(g.slots[i].surf);
+    g.slots[i].surf = NULL;
+    g.slots[i].state = SLOT_FREE;
+  }
+  g.nslots = 0;
+  g.current = -1;
+  g.sync = false;
+  memset(g.failed, 0, sizeof(g.failed));
+  g.failed_count = 0;
+}
+
+bool overlay_player_open(const char *dir, const char *tag, int w, int h,
+                         bool premultiply, size_t budget_bytes) {
+  overlay_player_close();
+  if (!dir || !tag || !tag[0] || w <= 0 || h <= 0)
+    return false;
+
+  /* Leading gaps are skipped; the sequence ends at the first gap after. */
+  char path[PATH_MAX];
+  int first = -1, count = 0;
+  time_t src_mtime = 0;
+  for (int i = 1; i <= OVERLAY_MAX_FRAMES; i++) {
+    snprintf(path, sizeof(path), "%s/%s_%03d.png", dir, tag, i);
+    const time_t mt = file_mtime(path);
+    if (mt == 0) {
+      if (count > 0)
+        break;
+      continue;
+    }
+    if (first < 0)
+      first = i;
+    count++;
+    if (mt > src_mtime)
+      src_mtime = mt;
+  }
+  if (count == 0)
+    return false;
+
+  memset(&g.stats, 0, sizeof(g.stats));
+  g.dir = strdup(dir);
+  g.tag = strdup(tag);
+  if (!g.dir || !g.tag) {
+    overlay_player_close();
+    return false;
+  }
+  g.first = first;
+  g.count = count;
+  g.w = w;
+  g.h = h;
+  g.premultiply = premultiply;
+  g.src_mtime = src_mtime;
+
+  /* A pack holds premultiplied frames, which only gfx_over() wants. Its
+     mapping counts against the budget like the ring would. */
+  if (premultiply) {
+    pack_path(path, sizeof(path));
+    g.pack = overlay_pack_open(path, w, h, first, count, src_mtime);
+    if (g.pack && overlay_pack_size(g.pack) > budget_bytes) {
+      overlay_pack_close(g.pack);
+      g.pack = NULL;
+    }
+    if (g.pack) {
+      g.pack_frame = -1;
+      g.stats.packed = true;
+      g.stats.bytes = overlay_pack_size(g.pack);
+      g.stats.budget_bytes = budget_bytes;
+      return true;
+    }
+  }
+
+  /* The ring needs two slots, the shown frame and the next; with room for
+     one only, frames are decoded on demand into it. Building a pack takes
+     a frame's worth more, so it only runs when that fits as well. */
+  const size_t frame_bytes = (size_t)w * (size_t)h * 4;
+  size_t n = budget_bytes / frame_bytes;
+  if (n == 0) {
+    overlay_player_close();
+    return false;
+  }
+  const bool sync = n == 1;
+  const bool pack = premultiply && n >= 3;
+  if (pack)
+    n--;
+  if (n > OVERLAY_SLOTS_MAX)
+    n = OVERLAY_SLOTS_MAX;
+  if (n > (size_t)count + 1)
+    n = (size_t)count + 1;
+
+  for (size_t i = 0; i < n; i++) {
+    g.slots[i].surf = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32,
+                                                     SDL_PIXELFORMAT_ARGB8888);
+    if (!g.slots[i].surf) {
+      overlay_player_close();
+      return false;
+    }
+  }
+  g.nslots = (int)n;
+  g.current = -1;
+  g.next_seq = 0;
+  g.want_seq = 0;
+  g.shown_seq = -1;
+  g.stats.slots = (uint32_t)n;
+  g.stats.bytes = (n + (pack ? 1 : 0)) * frame_bytes;
+  g.stats.budget_bytes = budget_bytes;
+  if (sync) {
+    g.sync = true;
+    return true;
+  }
+
+  if (pack && !pack_failed_before()) {
+    pack_path(path, sizeof(path));
+    g.writer = overlay_pack_begin(path, w, h, first, count, src_mtime);
+    if (!g.writer)
+      pack_failed_remember();
+    g.pack_next = 0;
+  }
+
+  g.quit = false;
+  g.lock = SDL_CreateMutex();
+  g.cond = SDL_CreateCond();
+  if (g.lock && g.cond)
+    g.thread = SDL_CreateThread(player_thread, "overlay_player", NULL);
+  if (!g.thread) {
+    overlay_player_close();
+    return false;
+  }
+  return true;
+}
+
+void overlay_player_close(void) {
+  if (g.thread) {
+    SDL_LockMutex(g.lock);
+    g.quit = true;
+    SDL_CondSignal(g.cond);
+    SDL_UnlockMutex(g.lock);
+    SDL_WaitThread(g.thread, NULL);
+    g.thread = NULL;
+  }
+  /* An unfinished pack is dropped; the next open starts over. */
+  overlay_pack_abort(g.writer);
+  g.writer = NULL;
+  overlay_pack_close(g.pack);
+  g.pack = NULL;
+  g.pack_frame = -1;
+  if (g.cond)
+    SDL_DestroyCond(g.cond);
+  if (g.lock)
+    SDL_DestroyMutex(g.lock);
+  g.cond = NULL;
+  g.lock = NULL;
+  free_slots();
+  free(g.dir);
+  free(g.tag);
+  g.dir = NULL;
+  g.tag = NULL;
+  g.count = 0;
+  g.stats.bytes = 0;
+}
+
+bool overlay_player_active(void) { return g.thread || g.pack || g.sync; }
+
+/* Single-slot mode: decodes the frame due now straight into the slot. */
+static bool advance_sync(int steps) {
+  if (g.current >= 0 && (steps <= 0 || g.count == 1))
+    return false;
+  int64_t seq = g.current < 0 ? 0 : g.shown_seq + steps;
+  while (skip_failed(&seq)) {
+    const Uint32 t0 = SDL_GetTicks();
+    if (decode_file(g.slots[0].surf, (int)(seq % g.count))) {
+      const Uint32 ms = SDL_GetTicks() - t0;
+      if (ms > g.stats.decode_ms)
+        g.stats.decode_ms = ms;
+      g.stats.decoded++;
+      if (g.current >= 0 && steps > 1)
+        g.stats.dropped += (uint32_t)(steps - 1);
+      g.current = 0;
+      g.slots[0].seq = seq;
+      g.shown_seq = seq;
+      g.stats.shown++;
+      return true;
+    }
+    mark_failed((int)(seq % g.count));
+  }
+  return false;
+}
+
+int overlay_player_frame_count(void) {
+  return overlay_player_active() ? g.count : 0;
+}
+
+bool overlay_player_advance(int steps) {
+  if (g.pack) {
+    /* Every frame is at hand: nothing is ever dropped. */
+    if (g.pack_frame >= 0 && steps <= 0)
+      return false;
+    g.pack_frame = g.pack_frame < 0 ? 0 : (g.pack_frame + steps) % g.count;
+    g.stats.shown++;
+    return true;
+  }
+  if (g.sync)
+    return advance_sync(steps);
+  if (!g.thread)
+    return false;
+  if (g.current >= 0 && steps <= 0)
+    return false;
+
+  SDL_LockMutex(g.lock);
+  /* Until the first frame arrives there is nothing to drop. */
+  const bool first = g.current < 0;
+  const int64_t target = first ? INT64_MAX : g.shown_seq + steps;
+  int best = -1;
+  for (int i = 0; i < g.nslots; i++) {
+    Slot *sl = &g.slots[i];
+    if (sl->state != SLOT_READY || sl->seq > target)
+      continue;
+    if (best < 0 || (first ? sl->seq < g.slots[best].seq
+                           : sl->seq > g.slots[best].seq))
+      best = i;
+  }
+  if (!first) {
+    /* Older ready frames than the one shown are stale. */
+    for (int i = 0; i < g.nslots; i++) {
+      Slot *sl = &g.slots[i];
+      if (i != best && sl->state == SLOT_READY && sl->seq <= target)
+        sl->state = SLOT_FREE;
+    }
+    g.stats.dropped += (uint32_t)(steps - (best >= 0 ? 1 : 0));
+    g.shown_seq = target;
+  }
+  if (best >= 0) {
+    if (g.current >= 0)
+      g.slots[g.current].state = SLOT_FREE;
+    g.current = best;
+    g.slots[best].state = SLOT_SHOWN;
+    if (first)
+      g.shown_seq = g.slots[best].seq;
+    g.stats.shown++;
+  }
+  if (g.shown_seq >= 0)
+    g.want_seq = g.shown_seq + 1;
+  SDL_CondSignal(g.cond);
+  SDL_UnlockMutex(g.lock);
+  return best >= 0;
+}
+
+SDL_Surface *overlay_player_frame(void) {
+  return g.current >= 0 ? g.slots[g.current].surf : NULL;
+}
+
+bool overlay_player_ready(void) {
+  return g.pack ? g.pack_frame >= 0 : g.current >= 0;
+}
+
+void overlay_player_composite(uint32_t *dst, int dst_stride,
+                              const SDL_Rect *clip) {
+  if (!dst || !clip)
+    return;
+  if (g.pack) {
+    overlay_pack_draw(g.pack, g.pack_frame, dst, dst_stride, clip);
+    return;
+  }
+  SDL_Surface *f = overlay_player_frame();
+  SDL_Rect r = {0, 0, f ? f->w : 0, f ? f->h : 0};
+  if (!f || !SDL_IntersectRect(&r, clip, &r))
+    return;
+  const int fs = f->pitch / 4;
+  gfx_over(dst + (size_t)r.y * dst_stride + r.x, dst_stride,
+           (const uint32_t *)f->pixels + (size_t)r.y * fs + r.x, fs, r.w, r.h);
+}
+
+void overlay_player_get_stats(OverlayPlayerStats *out) {
+  if (!out)
+    return;
+  if (g.lock)
+    SDL_LockMutex(g.lock);
+  *out = g.stats;
+  if (g.lock)
+    SDL_UnlockMutex(g.lock);
+}
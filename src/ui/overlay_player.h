@@ -0,0 +1,67 @@
+#ifndef UI_OVERLAY_PLAYER_H
+#define UI_OVERLAY_PLAYER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Streaming playback of animated overlays (<dir>/<tag>_001.png ...).
+ *
+ * Only the frame numbers are scanned up front. A worker thread decodes
+ * frames in order into a small ring of preallocated screen-size surfaces,
+ * a few frames ahead of the one shown, so memory is bounded by the budget
+ * whatever the sequence length. When decoding falls behind, the frames
+ * whose time has passed are skipped and counted as dropped. A budget with
+ * room for one frame only decodes on the caller's thread as frames come
+ * due; one without room for a frame plays nothing. A frame file that fails
+ * to decode is skipped from then on.
+ *
+ * Premultiplied sequences are also written to <tag>.ovl (see overlay_pack.h)
+ * as the worker decodes their first lap, if it gets through it in order.
+ * Later opens play that instead, with no decoding at all, until a PNG
+ * changes. A pack that can't be written isn't tried again this run.
+ *
+ * One sequence plays at a time; opening another replaces it.
+ */
+
+typedef struct OverlayPlayerStats {
+  uint32_t shown;   /* frames displayed */
+  uint32_t dropped; /* frames due but not decoded in time */
+  uint32_t decoded;
+  uint32_t failed;    /* frame files that could not be decoded */
+  uint32_t slots;     /* ring surfaces, the shown frame included */
+  uint32_t decode_ms; /* slowest decode */
+  size_t bytes;       /* surface memory held, or the pack mapped */
+  size_t budget_bytes;
+  bool packed; /* playing from <tag>.ovl */
+} OverlayPlayerStats;
+
+/* Scans the sequence and starts decoding it at w x h (frames of another
+ * size are scaled). Premultiplied frames are for gfx_over(). Returns false
+ * if there are no frames, budget_bytes can't hold one, or the worker could
+ * not start. */
+bool overlay_player_open(const char *dir, const char *tag, int w, int h,
+                         bool premultiply, size_t budget_bytes);
+/* Stops the worker and frees the ring. Stats are kept until the next open. */
+void overlay_player_close(void);
+bool overlay_player_active(void);
+int overlay_player_frame_count(void);
+
+/* Moves steps frames on (0 just picks up the first frame once decoded).
+ * Returns true if the current frame changed. */
+bool overlay_player_advance(int steps);
+/* The current frame (ARGB8888), NULL until the first one is decoded or
+ * when playing from a pack. Valid until the next advance or close. */
+SDL_Surface *overlay_player_frame(void);
+/* True once there is a frame to show. */
+bool overlay_player_ready(void);
+/* Composites the current premultiplied frame over dst (w x h, stride in
+ * pixels) within clip. */
+void overlay_player_composite(uint32_t *dst, int dst_stride,
+                              const SDL_Rect *clip);
+
+void overlay_player_get_stats(OverlayPlayerStats *out);
+
+#endif
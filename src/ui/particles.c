@@ -0,0 +1,306 @@
+#include "particles.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils/string_utils.h"
+
+#define PARTICLES_SWAY_HZ 0.25f    /* sideways wobble cycles per second */
+#define PARTICLES_STREAK_POINTS 32 /* longest streak drawn, in points */
+#define PARTICLES_PUFF_RINGS 3     /* nested squares that soften a puff */
+#define PARTICLES_PI 3.14159265f
+
+/* Structure of arrays, so the update loop streams through flat floats. */
+struct ParticleSystem {
+  ParticleParams p;
+  int w, h;
+  int n;
+  float *x, *y;  /* head position */
+  float *v;      /* speed along the fall direction, px/s */
+  float *phase;  /* sway phase, radians */
+  int layer_end[PARTICLES_MAX_LAYERS]; /* layer l is [end[l-1], end[l]) */
+  float dir_x, dir_y;                  /* unit fall direction */
+  uint32_t rng;
+  SDL_Point *points; /* draw batch, one layer at a time */
+  SDL_Rect *rects;
+  int batch_cap;
+  size_t bytes;
+};
+
+static const struct {
+  const char *name;
+  ParticleParams p;
+} presets[] = {
+    {"rain",
+     {PARTICLE_STREAK, 240, 3, 900.0f, 0.2f, 12.0f, 0.0f, 18,
+      {200, 210, 230, 110}}},
+    {"snow",
+     {PARTICLE_FLAKE, 200, 3, 60.0f, 0.4f, 0.0f, 14.0f, 4,
+      {255, 255, 255, 200}}},
+    {"fog",
+     {PARTICLE_PUFF, 24, 2, 12.0f, 0.5f, 90.0f, 6.0f, 220,
+      {220, 220, 230, 10}}},
+};
+
+bool particles_preset(const char *name, ParticleParams *p) {
+  for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++) {
+    if (name && strcmp(name, presets[i].name) == 0) {
+      *p = presets[i].p;
+      return true;
+    }
+  }
+  *p = presets[0].p;
+  return false;
+}
+
+static float clampf(float v, float lo, float hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static int clampi(int v, int lo, int hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+bool particles_load(const char *path, ParticleParams *p) {
+  particles_preset(NULL, p);
+  FILE *f = path ? fopen(path, "r") : NULL;
+  if (!f)
+    return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    config_trim(line);
+    if (!line[0] || line[0] == '#')
+      continue;
+    char *eq = strchr(line, '=');
+    if (!eq)
+      continue;
+    *eq = 0;
+    char *key = line, *val = eq + 1;
+    config_trim(key);
+    config_trim(val);
+    if (strcmp(key, "preset") == 0)
+      particles_preset(val, p);
+    else if (strcmp(key, "shape") == 0)
+      p->shape = strcmp(val, "flake") == 0  ? PARTICLE_FLAKE
+                 : strcmp(val, "puff") == 0 ? PARTICLE_PUFF
+                                            : PARTICLE_STREAK;
+    else if (strcmp(key, "count") == 0)
+      p->count = atoi(val);
+    else if (strcmp(key, "layers") == 0)
+      p->layers = atoi(val);
+    else if (strcmp(key, "speed") == 0)
+      p->speed = (float)atof(val);
+    else if (strcmp(key, "speed_jitter") == 0)
+      p->speed_jitter = (float)atof(val);
+    else if (strcmp(key, "angle") == 0)
+      p->angle = (float)atof(val);
+    else if (strcmp(key, "sway") == 0)
+      p->sway = (float)atof(val);
+    else if (strcmp(key, "size") == 0)
+      p->size = atoi(val);
+    else if (strcmp(key, "color") == 0) {
+      const unsigned long rgb = strtoul(val[0] == '#' ? val + 1 : val, NULL,
+                                        16);
+      p->color.r = (Uint8)(rgb >> 16);
+      p->color.g = (Uint8)(rgb >> 8);
+      p->color.b = (Uint8)rgb;
+    } else if (strcmp(key, "alpha") == 0)
+      p->color.a = (Uint8)clampi(atoi(val), 0, 255);
+  }
+  fclose(f);
+  p->count = clampi(p->count, 1, PARTICLES_MAX_COUNT);
+  p->layers = clampi(p->layers, 1, PARTICLES_MAX_LAYERS);
+  p->speed = clampf(p->speed, 0.0f, 5000.0f);
+  p->speed_jitter = clampf(p->speed_jitter, 0.0f, 1.0f);
+  p->angle = clampf(p->angle, -90.0f, 90.0f);
+  p->sway = clampf(p->sway, 0.0f, 200.0f);
+  p->size = clampi(p->size, 1, 512);
+  return true;
+}
+
+static uint32_t rng_next(uint32_t *s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 17;
+  *s ^= *s << 5;
+  return *s;
+}
+
+/* Uniform in [0, 1). */
+static float rng_unit(uint32_t *s) {
+  return (float)(rng_next(s) >> 8) * (1.0f / 16777216.0f);
+}
+
+/* Depth of layer l in (0, 1]: the nearest layer is 1. */
+static float layer_depth(const ParticleSystem *ps, int l) {
+  return (float)(l + 1) / (float)ps->p.layers;
+}
+
+/* Size in px of a particle on layer l. */
+static int layer_size(const ParticleSystem *ps, int l) {
+  const int s = (int)((float)ps->p.size * layer_depth(ps, l) + 0.5f);
+  return s > 0 ? s : 1;
+}
+
+/* Room left around the screen so particles enter and leave whole. */
+static float margin(const ParticleSystem *ps) {
+  return (float)ps->p.size + ps->p.sway;
+}
+
+ParticleSystem *particles_create(const ParticleParams *p, int w, int h,
+                                 uint32_t seed) {
+  if (!p || w <= 0 || h <= 0)
+    return NULL;
+  ParticleSystem *ps = (ParticleSystem *)calloc(1, sizeof(ParticleSystem));
+  if (!ps)
+    return NULL;
+  ps->p = *p;
+  ps->p.count = clampi(p->count, 1, PARTICLES_MAX_COUNT);
+  ps->p.layers = clampi(p->layers, 1, PARTICLES_MAX_LAYERS);
+  ps->p.size = clampi(p->size, 1, 512);
+  ps->w = w;
+  ps->h = h;
+  ps->n = ps->p.count;
+  ps->rng = seed ? seed : 0x2545F491u;
+
+  const size_t n = (size_t)ps->n;
+  const bool streak = ps->p.shape == PARTICLE_STREAK;
+  const int streak_len = ps->p.size < PARTICLES_STREAK_POINTS
+                             ? ps->p.size
+                             : PARTICLES_STREAK_POINTS;
+  ps->batch_cap = ps->n * (streak ? streak_len : PARTICLES_PUFF_RINGS);
+  const size_t batch_bytes = (size_t)ps->batch_cap *
+                             (streak ? sizeof(SDL_Point) : sizeof(SDL_Rect));
+  ps->bytes = n * 4 * sizeof(float) + batch_bytes;
+  ps->x = (float *)malloc(n * 4 * sizeof(float));
+  if (streak)
+    ps->points = (SDL_Point *)malloc(batch_bytes);
+  else
+    ps->rects = (SDL_Rect *)malloc(batch_bytes);
+  if (!ps->x || (!ps->points && !ps->rects)) {
+    particles_destroy(ps);
+    return NULL;
+  }
+  ps->y = ps->x + n;
+  ps->v = ps->y + n;
+  ps->phase = ps->v + n;
+
+  const float rad = ps->p.angle * (PARTICLES_PI / 180.0f);
+  ps->dir_x = sinf(rad);
+  ps->dir_y = cosf(rad);
+
+  /* Equal shares per layer, far to near, so each layer draws in one batch
+     and nearer ones cover farther ones. */
+  const float m = margin(ps);
+  for (int l = 0; l < ps->p.layers; l++) {
+    const int begin = l ? ps->layer_end[l - 1] : 0;
+    const int end = ps->n * (l + 1) / ps->p.layers;
+    const float speed = ps->p.speed * layer_depth(ps, l);
+    for (int i = begin; i < end; i++) {
+      ps->x[i] = -m + rng_unit(&ps->rng) * ((float)w + 2.0f * m);
+      ps->y[i] = -m + rng_unit(&ps->rng) * ((float)h + 2.0f * m);
+      ps->v[i] =
+          speed * (1.0f + ps->p.speed_jitter * (rng_unit(&ps->rng) - 0.5f));
+      ps->phase[i] = rng_unit(&ps->rng) * 2.0f * PARTICLES_PI;
+    }
+    ps->layer_end[l] = end;
+  }
+  return ps;
+}
+
+void particles_destroy(ParticleSystem *ps) {
+  if (!ps)
+    return;
+  free(ps->x);
+  free(ps->points);
+  free(ps->rects);
+  free(ps);
+}
+
+void particles_update(ParticleSystem *ps, float dt) {
+  if (!ps || dt <= 0.0f)
+    return;
+  const float m = margin(ps);
+  const float span_x = (float)ps->w + 2.0f * m;
+  const float span_y = (float)ps->h + 2.0f * m;
+  const float fx = ps->dir_x * dt, fy = ps->dir_y * dt;
+  const float dphase = 2.0f * PARTICLES_PI * PARTICLES_SWAY_HZ * dt;
+  float *x = ps->x, *y = ps->y, *phase = ps->phase;
+  const float *v = ps->v;
+  for (int i = 0; i < ps->n; i++) {
+    x[i] += v[i] * fx;
+    y[i] += v[i] * fy;
+    phase[i] += dphase;
+    if (phase[i] > 2.0f * PARTICLES_PI)
+      phase[i] -= 2.0f * PARTICLES_PI;
+    if (x[i] > (float)ps->w + m)
+      x[i] -= span_x;
+    else if (x[i] < -m)
+      x[i] += span_x;
+  }
+  /* Whatever falls off the bottom re-enters at the top somewhere else. */
+  for (int i = 0; i < ps->n; i++) {
+    if (y[i] > (float)ps->h + m) {
+      y[i] -= span_y;
+      x[i] = -m + rng_unit(&ps->rng) * span_x;
+    }
+  }
+}
+
+static void draw_layer(const ParticleSystem *ps, SDL_Renderer *ren, int l) {
+  const int begin = l ? ps->layer_end[l - 1] : 0;
+  const int end = ps->layer_end[l];
+  const int size = layer_size(ps, l);
+  const float sway = ps->p.sway * layer_depth(ps, l);
+  int k = 0;
+  for (int i = begin; i < end; i++) {
+    const float sx = sway != 0.0f ? sway * sinf(ps->phase[i]) : 0.0f;
+    const float px = ps->x[i] + sx, py = ps->y[i];
+    if (ps->p.shape == PARTICLE_STREAK) {
+      /* Back from the head along the fall direction. */
+      const int len =
+          size < PARTICLES_STREAK_POINTS ? size : PARTICLES_STREAK_POINTS;
+      for (int j = 0; j < len; j++) {
+        ps->points[k].x = (int)(px - ps->dir_x * (float)j);
+        ps->points[k].y = (int)(py - ps->dir_y * (float)j);
+        k++;
+      }
+    } else if (ps->p.shape == PARTICLE_FLAKE) {
+      ps->rects[k++] = (SDL_Rect){(int)px - size / 2, (int)py - size / 2, size,
+                                  size};
+    } else {
+      /* Nested squares stack up to a denser middle. */
+      for (int r = 0; r < PARTICLES_PUFF_RINGS; r++) {
+        const int s = size * (PARTICLES_PUFF_RINGS - r) / PARTICLES_PUFF_RINGS;
+        ps->rects[k++] = (SDL_Rect){(int)px - s / 2, (int)py - s / 2, s, s};
+      }
+    }
+  }
+  if (k == 0)
+    return;
+  const float alpha = (float)ps->p.color.a * (0.5f + 0.5f * layer_depth(ps, l));
+  SDL_SetRenderDrawColor(ren, ps->p.color.r, ps->p.color.g, ps->p.color.b,
+                         (Uint8)(alpha + 0.5f));
+  if (ps->p.shape == PARTICLE_STREAK)
+    SDL_RenderDrawPoints(ren, ps->points, k);
+  else
+    SDL_RenderFillRects(ren, ps->rects, k);
+}
+
+void particles_draw(const ParticleSystem *ps, SDL_Renderer *ren) {
+  if (!ps || !ren)
+    return;
+  SDL_BlendMode old = SDL_BLENDMODE_NONE;
+  SDL_GetRenderDrawBlendMode(ren, &old);
+  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+  for (int l = 0; l < ps->p.layers; l++)
+    draw_layer(ps, ren, l);
+  SDL_SetRenderDrawBlendMode(ren, old);
+}
+
+size_t particles_bytes(const ParticleSystem *ps) {
+  return ps ? sizeof(*ps) + ps->bytes : 0;
+}
+
+int particles_count(const ParticleSystem *ps) { return ps ? ps->n : 0; }
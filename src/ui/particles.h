@@ -0,0 +1,73 @@
+#ifndef UI_PARTICLES_H
+#define UI_PARTICLES_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Procedural weather overlays: a few hundred small sprites (rain streaks,
+ * snow flakes, fog puffs) instead of a full-screen PNG sequence. Memory is
+ * tens of KB for the presets (about 38 KB for rain, mostly the streak draw
+ * batch; under 300 KB at PARTICLES_MAX_COUNT) and the cost follows the
+ * particle count, not the screen area.
+ *
+ * Parameters come from a tiny key=value file, <dir>/<tag>.particles:
+ *
+ *   preset=snow        rain, snow or fog; sets every key below
+ *   count=240          particles over all layers
+ *   layers=3           depth layers; far ones are smaller, slower, fainter
+ *   speed=60           px/s along the fall direction, nearest layer
+ *   speed_jitter=0.4   per-particle speed spread, 0..1
+ *   angle=10           degrees off vertical, positive drifts right
+ *   sway=14            px of sideways wobble
+ *   size=4             streak length or flake/puff size, nearest layer
+ *   color=FFFFFF       RRGGBB
+ *   alpha=200          nearest layer's opacity
+ *
+ * preset should come first; later keys override it.
+ */
+
+#define PARTICLES_MAX_COUNT 1024
+#define PARTICLES_MAX_LAYERS 4
+
+typedef enum {
+  PARTICLE_STREAK, /* rain: a line along the fall direction */
+  PARTICLE_FLAKE,  /* snow: a small square */
+  PARTICLE_PUFF    /* fog: a large, very faint, soft-edged square */
+} ParticleShape;
+
+typedef struct ParticleParams {
+  ParticleShape shape;
+  int count;
+  int layers;
+  float speed;
+  float speed_jitter;
+  float angle;
+  float sway;
+  int size;
+  SDL_Color color;
+} ParticleParams;
+
+typedef struct ParticleSystem ParticleSystem;
+
+/* Fills p from a named preset ("rain", "snow", "fog"). Returns false, leaving
+ * p as the rain preset, for an unknown name. */
+bool particles_preset(const char *name, ParticleParams *p);
+/* Reads a .particles file over the rain preset. Returns false if it can't be
+ * opened. Values are clamped to sane ranges. */
+bool particles_load(const char *path, ParticleParams *p);
+
+/* Spreads the particles over a w x h screen. */
+ParticleSystem *particles_create(const ParticleParams *p, int w, int h,
+                                 uint32_t seed);
+void particles_destroy(ParticleSystem *ps);
+void particles_update(ParticleSystem *ps, float dt);
+/* Blends the particles onto the current render target. */
+void particles_draw(const ParticleSystem *ps, SDL_Renderer *ren);
+/* Heap memory held, for the log. */
+size_t particles_bytes(const ParticleSystem *ps);
+int particles_count(const ParticleSystem *ps);
+
+#endif
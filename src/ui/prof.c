@@ -0,0 +1,135 @@
+#include "prof.h"
+
+#include <SDL2/SDL.h>
+#include <string.h>
+
+static bool g_on;
+static bool g_paused;
+static double g_ms_per_tick;
+static ProfFrame g_cur;
+static uint64_t g_paused_ticks; /* this frame's, taken off its total */
+static ProfFrame g_ring[PROF_HISTORY];
+static int g_head; /* next slot to write */
+static int g_count;
+/* Wakeups in the second that started at g_wake_sec_ms; the previous
+ * second's count is what gets reported. */
+static Uint32 g_wake_sec_ms;
+static int g_wakes;
+static float g_wakes_per_sec;
+
+void prof_set_enabled(bool on) {
+  if (on && !g_on) {
+    g_ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    memset(&g_cur, 0, sizeof(g_cur));
+    g_paused = false;
+    g_paused_ticks = 0;
+    g_head = 0;
+    g_count = 0;
+    g_wake_sec_ms = SDL_GetTicks();
+    g_wakes = 0;
+    g_wakes_per_sec = 0.0f;
+  }
+  g_on = on;
+}
+
+bool prof_enabled(void) { return g_on; }
+
+uint64_t prof_begin(void) {
+  return g_on && !g_paused ? (uint64_t)SDL_GetPerformanceCounter() : 0;
+}
+
+void prof_end(ProfSection section, uint64_t t0) {
+  if (!g_on || t0 == 0 || section < 0 || section >= PROF_SECTION_COUNT)
+    return;
+  const uint64_t dt = (uint64_t)SDL_GetPerformanceCounter() - t0;
+  g_cur.ms[section] += (float)((double)dt * g_ms_per_tick);
+}
+
+uint64_t prof_pause(void) {
+  const uint64_t t0 = prof_begin();
+  if (t0 != 0)
+    g_paused = true;
+  return t0;
+}
+
+void prof_resume(uint64_t t0) {
+  if (!g_on || t0 == 0)
+    return;
+  g_paused = false;
+  g_paused_ticks += (uint64_t)SDL_GetPerformanceCounter() - t0;
+}
+
+void prof_wake(void) {
+  if (!g_on)
+    return;
+  const Uint32 now = SDL_GetTicks();
+  if (now - g_wake_sec_ms >= 1000) {
+    const Uint32 elapsed = now - g_wake_sec_ms;
+    /* A long sleep spans several seconds; average over all of them. */
+    g_wakes_per_sec = (float)g_wakes * 1000.0f / (float)elapsed;
+    g_wake_sec_ms = now;
+    g_wakes = 0;
+  }
+  g_wakes++;
+}
+
+void prof_frame_end(uint64_t t0) {
+  if (!g_on)
+    return;
+  if (t0 != 0) {
+    uint64_t dt = (uint64_t)SDL_GetPerformanceCounter() - t0;
+    dt = dt > g_paused_ticks ? dt - g_paused_ticks : 0;
+    g_cur.total_ms = (float)((double)dt * g_ms_per_tick);
+  }
+  g_paused_ticks = 0;
+  g_ring[g_head] = g_cur;
+  g_head = (g_head + 1) % PROF_HISTORY;
+  if (g_count < PROF_HISTORY)
+    g_count++;
+  memset(&g_cur, 0, sizeof(g_cur));
+}
+
+void prof_summary(ProfSummary *out) {
+  if (!out)
+    return;
+  memset(out, 0, sizeof(*out));
+  out->frames = g_count;
+  out->wakeups_per_sec = g_wakes_per_sec;
+  if (g_count == 0)
+    return;
+  for (int i = 0; i < g_count; i++) {
+    const ProfFrame *f = &g_ring[i];
+    for (int s = 0; s < PROF_SECTION_COUNT; s++) {
+      out->avg_ms[s] += f->ms[s];
+      if (f->ms[s] > out->max_ms[s])
+        out->max_ms[s] = f->ms[s];
+    }
+    out->avg_total_ms += f->total_ms;
+    if (f->total_ms > out->max_total_ms)
+      out->max_total_ms = f->total_ms;
+  }
+  for (int s = 0; s < PROF_SECTION_COUNT; s++)
+    out->avg_ms[s] /= (float)g_count;
+  out->avg_total_ms /= (float)g_count;
+}
+
+int prof_history(ProfFrame *out, int max) {
+  if (!out || max <= 0)
+    return 0;
+  const int n = g_count < max ? g_count : max;
+  /* The oldest of the last n frames. */
+  int idx = (g_head - n + PROF_HISTORY) % PROF_HISTORY;
+  for (int i = 0; i < n; i++) {
+    out[i] = g_ring[idx];
+    idx = (idx + 1) % PROF_HISTORY;
+  }
+  return n;
+}
+
+const char *prof_section_name(ProfSection section) {
+  static const char *const names[PROF_SECTION_COUNT] = {
+      "bg", "hud", "screen", "text", "present", "input", "poll"};
+  if (section < 0 || section >= PROF_SECTION_COUNT)
+    return "?";
+  return names[section];
+}
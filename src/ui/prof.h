@@ -0,0 +1,74 @@
+#ifndef UI_PROF_H
+#define UI_PROF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Frame profiler behind the debug overlay.
+ *
+ * Scoped timers around the main loop's phases add into the current frame;
+ * each presented frame is then closed into a ring of the last PROF_HISTORY
+ * frames, which the overlay summarizes and which can be dumped to the log.
+ * While profiling is off prof_begin() returns 0 and prof_end() does
+ * nothing, so the timers can stay in place.
+ *
+ *   const uint64_t t = prof_begin();
+ *   draw_something();
+ *   prof_end(PROF_SCREEN, t);
+ */
+
+#define PROF_HISTORY 120 /* frames kept */
+
+typedef enum {
+  PROF_BG = 0,  /* background and animated overlay composite */
+  PROF_HUD,     /* top HUD */
+  PROF_SCREEN,  /* the current screen's draw_* */
+  PROF_TEXT,    /* text rasterization, part of the three above */
+  PROF_PRESENT, /* SDL_RenderPresent and the window update */
+  PROF_INPUT,   /* event handling and the handle_* calls */
+  PROF_POLL,    /* update_poll */
+  PROF_SECTION_COUNT
+} ProfSection;
+
+typedef struct ProfFrame {
+  float ms[PROF_SECTION_COUNT];
+  float total_ms; /* wakeup to present */
+} ProfFrame;
+
+typedef struct ProfSummary {
+  int frames; /* in the history */
+  float avg_ms[PROF_SECTION_COUNT];
+  float max_ms[PROF_SECTION_COUNT];
+  float avg_total_ms;
+  float max_total_ms;
+  float wakeups_per_sec; /* over the last whole second */
+} ProfSummary;
+
+void prof_set_enabled(bool on);
+bool prof_enabled(void);
+
+/* Start of a timed scope; 0 while profiling is off. */
+uint64_t prof_begin(void);
+/* Adds the time since t0 to section (ignored if t0 is 0). */
+void prof_end(ProfSection section, uint64_t t0);
+
+/* Stops timing until prof_resume(): scopes begun in between are ignored and
+ * the time is left out of the frame total. For the overlay's own drawing;
+ * call outside any open scope. Returns the t0 to hand to prof_resume(). */
+uint64_t prof_pause(void);
+void prof_resume(uint64_t t0);
+
+/* Counts a main-loop wakeup. */
+void prof_wake(void);
+/* Closes the current frame, which began at t0 (prof_begin), into the
+ * history. */
+void prof_frame_end(uint64_t t0);
+
+void prof_summary(ProfSummary *out);
+/* Copies up to max frames, oldest first; returns how many. */
+int prof_history(ProfFrame *out, int max);
+
+const char *prof_section_name(ProfSection section);
+
+#endif
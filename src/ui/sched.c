@@ -0,0 +1,80 @@
+#include "sched.h"
+
+#include <string.h>
+
+void sched_init(Sched *s, uint64_t now) {
+  if (!s)
+    return;
+  memset(s, 0, sizeof(*s));
+  s->last_wake_ms = now;
+  s->next = -1;
+}
+
+void sched_reset(Sched *s) {
+  if (!s)
+    return;
+  for (int i = 0; i < SCHED_SOURCE_COUNT; i++)
+    s->due[i] = 0;
+  s->next = -1;
+}
+
+void sched_at(Sched *s, SchedSource src, uint64_t due_ms) {
+  if (!s || src < 0 || src >= SCHED_SOURCE_COUNT)
+    return;
+  if (due_ms == 0)
+    due_ms = 1; /* 0 means "none" */
+  if (s->due[src] == 0 || due_ms < s->due[src])
+    s->due[src] = due_ms;
+  if (s->next < 0 || s->due[src] < s->due[s->next])
+    s->next = (int)src;
+}
+
+int sched_timeout(const Sched *s, uint64_t now, int max_ms) {
+  if (!s || s->next < 0)
+    return max_ms;
+  const uint64_t due = s->due[s->next];
+  if (due <= now)
+    return 0;
+  const uint64_t wait = due - now;
+  return wait < (uint64_t)max_ms ? (int)wait : max_ms;
+}
+
+void sched_woke(Sched *s, SchedMode mode, uint64_t now, bool input) {
+  if (!s || mode < 0 || mode >= SCHED_MODE_COUNT)
+    return;
+  if (now > s->last_wake_ms)
+    s->ms_in[mode] += now - s->last_wake_ms;
+  s->last_wake_ms = now;
+  s->wakeups[mode]++;
+  if (input)
+    s->input[mode]++;
+  else if (s->next >= 0)
+    s->fired[s->next]++;
+}
+
+double sched_per_minute(const Sched *s, SchedMode mode) {
+  if (!s || mode < 0 || mode >= SCHED_MODE_COUNT || s->ms_in[mode] == 0)
+    return 0.0;
+  return (double)s->wakeups[mode] * 60000.0 / (double)s->ms_in[mode];
+}
+
+const char *sched_mode_name(SchedMode mode) {
+  switch (mode) {
+  case SCHED_MODE_IDLE:
+    return "idle";
+  case SCHED_MODE_RUN:
+    return "run";
+  case SCHED_MODE_ANIM:
+    return "anim";
+  default:
+    return "?";
+  }
+}
+
+const char *sched_source_name(SchedSource src) {
+  static const char *const names[SCHED_SOURCE_COUNT] = {
+      "timer", "bell", "anim", "battery", "clock", "hold", "poll"};
+  if (src < 0 || src >= SCHED_SOURCE_COUNT)
+    return "?";
+  return names[src];
+}
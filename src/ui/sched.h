@@ -0,0 +1,72 @@
+#ifndef UI_SCHED_H
+#define UI_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Deadline scheduling for the main loop.
+ *
+ * Before it sleeps, the loop asks every subsystem when it next has work:
+ * the timer its next whole second, the overlay its next frame, the battery
+ * readout its next sample, a bell its next strike. It then sleeps until the
+ * earliest of those or until input arrives, instead of waking at a fixed
+ * rate picked from whatever happens to be running.
+ *
+ * Deadlines are in now_ms() time and are collected afresh every iteration,
+ * so nothing needs cancelling. Wakeups are counted per loop mode so the
+ * saving can be read off a device log.
+ */
+
+typedef enum {
+  SCHED_TIMER = 0, /* running timer: next second (or breathing frame) */
+  SCHED_BELL,      /* next strike of a queued bell sequence */
+  SCHED_ANIM,      /* next overlay or particle frame */
+  SCHED_BATTERY,   /* next battery sample, while it is shown */
+  SCHED_CLOCK,     /* next minute, while the clock is shown */
+  SCHED_HOLD,      /* a held button reaching its hold time */
+  SCHED_POLL,      /* waiting on a worker that cannot wake the loop */
+  SCHED_SOURCE_COUNT
+} SchedSource;
+
+typedef enum {
+  SCHED_MODE_IDLE = 0,
+  SCHED_MODE_RUN,  /* a timer is running */
+  SCHED_MODE_ANIM, /* an overlay is animating (with or without a timer) */
+  SCHED_MODE_COUNT
+} SchedMode;
+
+typedef struct Sched {
+  uint64_t due[SCHED_SOURCE_COUNT]; /* 0 = nothing pending */
+  /* Stats. */
+  uint64_t last_wake_ms;
+  uint64_t ms_in[SCHED_MODE_COUNT];  /* time spent asleep + awake per mode */
+  uint32_t wakeups[SCHED_MODE_COUNT];
+  uint32_t input[SCHED_MODE_COUNT];  /* of which input or a wake event */
+  uint32_t fired[SCHED_SOURCE_COUNT]; /* timeouts, by earliest source */
+  int next;                           /* earliest source, -1 if none */
+} Sched;
+
+void sched_init(Sched *s, uint64_t now);
+
+/* Forgets every deadline; call once per loop iteration before sched_at. */
+void sched_reset(Sched *s);
+
+/* Registers a deadline for src, keeping the earlier if it already has one. */
+void sched_at(Sched *s, SchedSource src, uint64_t due_ms);
+
+/* Milliseconds from now until the earliest deadline, 0 if one has passed,
+ * max_ms if there is none or it is further away. */
+int sched_timeout(const Sched *s, uint64_t now, int max_ms);
+
+/* Records a wakeup at now; mode is what the loop was in while it slept,
+ * input whether an event (rather than a deadline) woke it. */
+void sched_woke(Sched *s, SchedMode mode, uint64_t now, bool input);
+
+/* Wakeups per minute spent in mode, 0 if the mode was never seen. */
+double sched_per_minute(const Sched *s, SchedMode mode);
+
+const char *sched_mode_name(SchedMode mode);
+const char *sched_source_name(SchedSource src);
+
+#endif
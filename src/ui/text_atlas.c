@@ -0,0 +1,365 @@
+#include "text_atlas.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils/string_utils.h"
+#include "prof.h"
+
+#define TEXT_ATLAS_MAX 12      /* (font, style) pairs kept at once */
+#define TEXT_ATLAS_SLOTS 512   /* glyphs per atlas, power of two */
+#define TEXT_ATLAS_W 1024      /* texture width; height scales with the font */
+#define TEXT_ATLAS_PAD 1       /* gap between glyphs (no bleeding) */
+#define TEXT_ATLAS_BATCH 64    /* glyph quads per draw call */
+#define TEXT_ATLAS_MAX_GLYPHS 256 /* longer strings use the fallback path */
+
+/* 32-bit glyph APIs and SDL_RenderGeometry need SDL(_ttf) 2.0.18. */
+#ifdef SDL_TTF_VERSION_ATLEAST
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+#define TEXT_ATLAS_TTF32 1
+#endif
+#endif
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define TEXT_ATLAS_GEOMETRY 1
+#endif
+
+typedef struct {
+  uint32_t key;       /* codepoint + 1; 0 = empty slot */
+  int16_t x, y, w, h; /* rect in the atlas texture */
+  int16_t off_x;      /* glyph surface x relative to the pen position */
+  int16_t advance;
+} Glyph;
+
+typedef struct {
+  TTF_Font *font;
+  int style;
+  SDL_Renderer *ren;
+  SDL_Texture *tex;
+  int tex_h;
+  int shelf_x, shelf_y, shelf_h;
+  int used;
+  unsigned last_use;
+  Glyph slots[TEXT_ATLAS_SLOTS];
+} Atlas;
+
+static Atlas *g_atlases[TEXT_ATLAS_MAX];
+static unsigned g_use_clock;
+
+/* ---------------------------------------------------------------------- */
+
+static SDL_Surface *render_glyph(TTF_Font *font, uint32_t cp) {
+  SDL_Color white = {255, 255, 255, 255};
+  const uint64_t t = prof_begin();
+#ifdef TEXT_ATLAS_TTF32
+  SDL_Surface *s = TTF_RenderGlyph32_Blended(font, cp, white);
+#else
+  SDL_Surface *s = TTF_RenderGlyph_Blended(
+      font, (Uint16)(cp > 0xFFFF ? 0xFFFD : cp), white);
+#endif
+  prof_end(PROF_TEXT, t);
+  return s;
+}
+
+static bool glyph_metrics(TTF_Font *font, uint32_t cp, int *minx,
+                          int *advance) {
+  int maxx = 0, miny = 0, maxy = 0;
+#ifdef TEXT_ATLAS_TTF32
+  return TTF_GlyphMetrics32(font, cp, minx, &maxx, &miny, &maxy, advance) == 0;
+#else
+  return TTF_GlyphMetrics(font, (Uint16)(cp > 0xFFFF ? 0xFFFD : cp), minx,
+                          &maxx, &miny, &maxy, advance) == 0;
+#endif
+}
+
+static int glyph_kerning(TTF_Font *font, uint32_t prev, uint32_t cp) {
+  if (!prev || !TTF_GetFontKerning(font))
+    return 0;
+#ifdef TEXT_ATLAS_TTF32
+  return TTF_GetFontKerningSizeGlyphs32(font, prev, cp);
+#else
+  if (prev > 0xFFFF || cp > 0xFFFF)
+    return 0;
+  return TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, (Uint16)cp);
+#endif
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void atlas_free(Atlas *at) {
+  if (!at)
+    return;
+  if (at->tex)
+    SDL_DestroyTexture(at->tex);
+  free(at);
+}
+
+/* Forget every glyph; the texture is reused and overwritten. */
+static void atlas_reset(Atlas *at) {
+  memset(at->slots, 0, sizeof(at->slots));
+  at->shelf_x = 0;
+  at->shelf_y = 0;
+  at->shelf_h = 0;
+  at->used = 0;
+}
+
+static Atlas *atlas_get(SDL_Renderer *ren, TTF_Font *font, int style) {
+  int free_idx = -1;
+  int lru_idx = 0;
+  for (int i = 0; i < TEXT_ATLAS_MAX; i++) {
+    Atlas *at = g_atlases[i];
+    if (!at) {
+      if (free_idx < 0)
+        free_idx = i;
+      continue;
+    }
+    if (at->font == font && at->style == style && at->ren == ren) {
+      at->last_use = ++g_use_clock;
+      return at;
+    }
+    if (g_atlases[lru_idx] && at->last_use < g_atlases[lru_idx]->last_use)
+      lru_idx = i;
+  }
+  int idx = free_idx;
+  if (idx < 0) {
+    idx = lru_idx;
+    atlas_free(g_atlases[idx]);
+    g_atlases[idx] = NULL;
+  }
+
+  Atlas *at = (Atlas *)calloc(1, sizeof(Atlas));
+  if (!at)
+    return NULL;
+  /* Room for about six rows of glyphs. */
+  int h = TTF_FontHeight(font) * 6;
+  if (h < 128)
+    h = 128;
+  if (h > 2048)
+    h = 2048;
+  at->tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888,
+                              SDL_TEXTUREACCESS_STATIC, TEXT_ATLAS_W, h);
+  if (!at->tex) {
+    free(at);
+    return NULL;
+  }
+  SDL_SetTextureBlendMode(at->tex, SDL_BLENDMODE_BLEND);
+  at->font = font;
+  at->style = style;
+  at->ren = ren;
+  at->tex_h = h;
+  at->last_use = ++g_use_clock;
+  g_atlases[idx] = at;
+  return at;
+}
+
+/* Returns the glyph for cp, rasterizing it into the atlas if needed. NULL
+ * with *full set when the atlas has no room left. */
+static const Glyph *atlas_glyph(Atlas *at, uint32_t cp, bool *full) {
+  const uint32_t key = cp + 1u;
+  uint32_t i = (cp * 2654435761u) & (TEXT_ATLAS_SLOTS - 1);
+  while (at->slots[i].key) {
+    if (at->slots[i].key == key)
+      return &at->slots[i];
+    i = (i + 1) & (TEXT_ATLAS_SLOTS - 1);
+  }
+  if (at->used >= TEXT_ATLAS_SLOTS * 3 / 4) {
+    *full = true;
+    return NULL;
+  }
+
+  int old_style = TTF_GetFontStyle(at->font);
+  if (old_style != at->style)
+    TTF_SetFontStyle(at->font, at->style);
+  int minx = 0, advance = 0;
+  bool have_metrics = glyph_metrics(at->font, cp, &minx, &advance);
+  SDL_Surface *s = render_glyph(at->font, cp);
+  if (old_style != at->style)
+    TTF_SetFontStyle(at->font, old_style);
+  if (!have_metrics && !s)
+    return NULL;
+
+  Glyph g;
+  memset(&g, 0, sizeof(g));
+  g.key = key;
+  g.advance = (int16_t)advance;
+  g.off_x = (int16_t)(minx < 0 ? minx : 0);
+
+  if (s) {
+    if (s->format->format != SDL_PIXELFORMAT_ARGB8888) {
+      SDL_Surface *conv =
+          SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+      SDL_FreeSurface(s);
+      s = conv;
+      if (!s)
+        return NULL;
+    }
+    if (at->shelf_x + s->w > TEXT_ATLAS_W) {
+      at->shelf_y += at->shelf_h + TEXT_ATLAS_PAD;
+      at->shelf_x = 0;
+      at->shelf_h = 0;
+    }
+    if (s->w > TEXT_ATLAS_W || at->shelf_y + s->h > at->tex_h) {
+      SDL_FreeSurface(s);
+      *full = true;
+      return NULL;
+    }
+    SDL_Rect r = {at->shelf_x, at->shelf_y, s->w, s->h};
+    if (SDL_UpdateTexture(at->tex, &r, s->pixels, s->pitch) != 0) {
+      SDL_FreeSurface(s);
+      return NULL;
+    }
+    g.x = (int16_t)r.x;
+    g.y = (int16_t)r.y;
+    g.w = (int16_t)r.w;
+    g.h = (int16_t)r.h;
+    at->shelf_x += s->w + TEXT_ATLAS_PAD;
+    if (s->h > at->shelf_h)
+      at->shelf_h = s->h;
+    SDL_FreeSurface(s);
+  }
+
+  at->slots[i] = g;
+  at->used++;
+  return &at->slots[i];
+}
+
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+  const Glyph *g;
+  int x; /* left edge of the glyph quad, relative to the text origin */
+} PlacedGlyph;
+
+/* Lays out text into out[]; returns the glyph count or -1 on failure.
+ * *out_left is the leftmost quad edge (<= 0) and *out_right the text's right
+ * extent, both relative to the pen origin. */
+static int layout(Atlas *at, const char *text, PlacedGlyph *out,
+                  int *out_left, int *out_right) {
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool full = false;
+    bool failed = false;
+    int n = 0;
+    int pen = 0, left = 0, right = 0;
+    uint32_t prev = 0;
+    const char *p = text;
+    while (*p) {
+      uint32_t cp = utf8_next_codepoint(&p);
+      if (n >= TEXT_ATLAS_MAX_GLYPHS)
+        return -1;
+      const Glyph *g = atlas_glyph(at, cp, &full);
+      if (!g) {
+        failed = !full;
+        break;
+      }
+      pen += glyph_kerning(at->font, prev, cp);
+      const int gx = pen + g->off_x;
+      if (gx < left)
+        left = gx;
+      if (gx + g->w > right)
+        right = gx + g->w;
+      out[n].g = g;
+      out[n].x = gx;
+      n++;
+      pen += g->advance;
+      prev = cp;
+    }
+    if (full) {
+      /* Start over with an empty atlas; a single string always fits. */
+      atlas_reset(at);
+      continue;
+    }
+    if (failed)
+      return -1;
+    if (pen > right)
+      right = pen;
+    *out_left = left;
+    *out_right = right;
+    return n;
+  }
+  return -1;
+}
+
+static void draw_batch(Atlas *at, const PlacedGlyph *pg, int n, int ox, int oy,
+                       SDL_Color col) {
+#ifdef TEXT_ATLAS_GEOMETRY
+  SDL_Vertex v[TEXT_ATLAS_BATCH * 4];
+  int idx[TEXT_ATLAS_BATCH * 6];
+  const float tw = (float)TEXT_ATLAS_W;
+  const float th = (float)at->tex_h;
+  int q = 0;
+  for (int i = 0; i <= n; i++) {
+    if (q == TEXT_ATLAS_BATCH || (i == n && q > 0)) {
+      SDL_RenderGeometry(at->ren, at->tex, v, q * 4, idx, q * 6);
+      q = 0;
+    }
+    if (i == n)
+      break;
+    const Glyph *g = pg[i].g;
+    if (g->w <= 0 || g->h <= 0)
+      continue;
+    const float x0 = (float)(ox + pg[i].x), y0 = (float)oy;
+    const float x1 = x0 + (float)g->w, y1 = y0 + (float)g->h;
+    const float u0 = (float)g->x / tw, v0 = (float)g->y / th;
+    const float u1 = (float)(g->x + g->w) / tw;
+    const float v1 = (float)(g->y + g->h) / th;
+    SDL_Vertex *vq = &v[q * 4];
+    vq[0] = (SDL_Vertex){{x0, y0}, col, {u0, v0}};
+    vq[1] = (SDL_Vertex){{x1, y0}, col, {u1, v0}};
+    vq[2] = (SDL_Vertex){{x1, y1}, col, {u1, v1}};
+    vq[3] = (SDL_Vertex){{x0, y1}, col, {u0, v1}};
+    int *iq = &idx[q * 6];
+    iq[0] = q * 4 + 0;
+    iq[1] = q * 4 + 1;
+    iq[2] = q * 4 + 2;
+    iq[3] = q * 4 + 0;
+    iq[4] = q * 4 + 2;
+    iq[5] = q * 4 + 3;
+    q++;
+  }
+#else
+  SDL_SetTextureColorMod(at->tex, col.r, col.g, col.b);
+  SDL_SetTextureAlphaMod(at->tex, col.a);
+  for (int i = 0; i < n; i++) {
+    const Glyph *g = pg[i].g;
+    if (g->w <= 0 || g->h <= 0)
+      continue;
+    SDL_Rect src = {g->x, g->y, g->w, g->h};
+    SDL_Rect dst = {ox + pg[i].x, oy, g->w, g->h};
+    SDL_RenderCopy(at->ren, at->tex, &src, &dst);
+  }
+#endif
+}
+
+bool text_atlas_draw(SDL_Renderer *ren, TTF_Font *font, int style, int x,
+                     int y, const char *text, SDL_Color col,
+                     bool right_align) {
+  if (!ren || !font)
+    return false;
+  if (!text || !text[0])
+    return true;
+  Atlas *at = atlas_get(ren, font, style);
+  if (!at)
+    return false;
+
+  PlacedGlyph pg[TEXT_ATLAS_MAX_GLYPHS];
+  int left = 0, right = 0;
+  int n = layout(at, text, pg, &left, &right);
+  if (n < 0)
+    return false;
+
+  /* Same placement as a TTF_RenderUTF8_Blended surface drawn at (x, y): the
+   * surface starts at the leftmost glyph edge. */
+  const int w = right - left;
+  int ox = x - left;
+  if (right_align)
+    ox -= w;
+  draw_batch(at, pg, n, ox, y, col);
+  return true;
+}
+
+void text_atlas_clear(void) {
+  for (int i = 0; i < TEXT_ATLAS_MAX; i++) {
+    atlas_free(g_atlases[i]);
+    g_atlases[i] = NULL;
+  }
+}
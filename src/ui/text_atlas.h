@@ -0,0 +1,30 @@
+#ifndef UI_TEXT_ATLAS_H
+#define UI_TEXT_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+
+/*
+ * Glyph-atlas text rendering.
+ *
+ * Each (font, style) pair gets one texture that glyphs are rasterized into
+ * on first use (white, so any color is a texture color/alpha mod). A string
+ * is then drawn as a batch of glyph quads with SDL_ttf kerning, instead of
+ * rasterizing the whole string and creating a texture on every call.
+ *
+ * Atlases hold TTF_Font pointers: call text_atlas_clear() before closing or
+ * reloading fonts, and before destroying the renderer.
+ */
+
+/* Draws text with its top-left at (x, y) (top-right if right_align), using
+ * the given SDL_ttf style for rasterization. Returns false if the atlas could
+ * not be used (callers fall back to TTF_RenderUTF8_Blended). */
+bool text_atlas_draw(SDL_Renderer *ren, TTF_Font *font, int style, int x,
+                     int y, const char *text, SDL_Color col,
+                     bool right_align);
+
+/* Drops every atlas (textures and glyph tables). */
+void text_atlas_clear(void);
+
+#endif
@@ -0,0 +1,197 @@
+#include "text_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "prof.h"
+
+#define TEXT_CACHE_BUCKETS 1024 /* power of two */
+#define TEXT_CACHE_MAX_ENTRIES 1024
+/* Two screens' worth of text at 1024x768 (about 6 MB of ARGB). */
+#define TEXT_CACHE_DEFAULT_BUDGET_PX ((size_t)1024 * 768 * 2)
+
+typedef struct Entry {
+  struct Entry *next_hash;
+  struct Entry *lru_prev; /* towards most recently used */
+  struct Entry *lru_next; /* towards least recently used */
+  uint32_t hash;
+  TTF_Font *font;
+  int style;
+  SDL_Color col;
+  SDL_Texture *tex; /* NULL until the string is seen a second time */
+  bool failed;      /* rasterizing it failed; not tried again until a clear */
+  int w, h;
+  char *text;
+} Entry;
+
+static Entry *g_buckets[TEXT_CACHE_BUCKETS];
+static Entry *g_lru_head;
+static Entry *g_lru_tail;
+static TextCacheStats g_stats = {0, 0, 0, 0, 0, TEXT_CACHE_DEFAULT_BUDGET_PX};
+
+static uint32_t entry_hash(TTF_Font *font, int style, SDL_Color col,
+                           const char *text) {
+  /* FNV-1a over the string, then mix in the rest of the key. */
+  uint32_t h = 2166136261u;
+  for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+    h ^= *p;
+    h *= 16777619u;
+  }
+  uintptr_t f = (uintptr_t)font;
+  h ^= (uint32_t)(f >> 4) * 2654435761u;
+  h ^= (uint32_t)style * 0x9E3779B9u;
+  h ^= ((uint32_t)col.r << 24 | (uint32_t)col.g << 16 | (uint32_t)col.b << 8 |
+        (uint32_t)col.a) *
+       0x85EBCA6Bu;
+  return h;
+}
+
+static void lru_unlink(Entry *e) {
+  if (e->lru_prev)
+    e->lru_prev->lru_next = e->lru_next;
+  else
+    g_lru_head = e->lru_next;
+  if (e->lru_next)
+    e->lru_next->lru_prev = e->lru_prev;
+  else
+    g_lru_tail = e->lru_prev;
+  e->lru_prev = e->lru_next = NULL;
+}
+
+static void lru_push_front(Entry *e) {
+  e->lru_prev = NULL;
+  e->lru_next = g_lru_head;
+  if (g_lru_head)
+    g_lru_head->lru_prev = e;
+  g_lru_head = e;
+  if (!g_lru_tail)
+    g_lru_tail = e;
+}
+
+/* evicted: dropped to stay within limits, as opposed to a clear. */
+static void entry_remove(Entry *e, bool evicted) {
+  Entry **pp = &g_buckets[e->hash & (TEXT_CACHE_BUCKETS - 1)];
+  while (*pp && *pp != e)
+    pp = &(*pp)->next_hash;
+  if (*pp)
+    *pp = e->next_hash;
+  lru_unlink(e);
+  if (e->tex) {
+    SDL_DestroyTexture(e->tex);
+    g_stats.pixels -= (size_t)e->w * (size_t)e->h;
+    if (evicted)
+      g_stats.evictions++;
+  }
+  g_stats.entries--;
+  free(e->text);
+  free(e);
+}
+
+/* Evicts from the LRU end until within limits, never touching keep. */
+static void enforce_limits(Entry *keep) {
+  while (g_lru_tail && g_lru_tail != keep &&
+         (g_stats.pixels > g_stats.budget_pixels ||
+          g_stats.entries > TEXT_CACHE_MAX_ENTRIES)) {
+    entry_remove(g_lru_tail, true);
+  }
+}
+
+static bool entry_rasterize(Entry *e, SDL_Renderer *ren) {
+  int old = TTF_GetFontStyle(e->font);
+  if (old != e->style)
+    TTF_SetFontStyle(e->font, e->style);
+  const uint64_t t = prof_begin();
+  SDL_Surface *s = TTF_RenderUTF8_Blended(e->font, e->text, e->col);
+  prof_end(PROF_TEXT, t);
+  if (old != e->style)
+    TTF_SetFontStyle(e->font, old);
+  if (!s)
+    return false;
+  e->tex = SDL_CreateTextureFromSurface(ren, s);
+  e->w = s->w;
+  e->h = s->h;
+  SDL_FreeSurface(s);
+  if (!e->tex)
+    return false;
+  g_stats.pixels += (size_t)e->w * (size_t)e->h;
+  return true;
+}
+
+TextCacheResult text_cache_draw(SDL_Renderer *ren, TTF_Font *font, int style,
+                                int x, int y, const char *text, SDL_Color col,
+                                bool right_align) {
+  if (!ren || !font || !text || !text[0])
+    return TEXT_CACHE_MISS;
+
+  const uint32_t h = entry_hash(font, style, col, text);
+  Entry *e = g_buckets[h & (TEXT_CACHE_BUCKETS - 1)];
+  while (e) {
+    if (e->hash == h && e->font == font && e->style == style &&
+        e->col.r == col.r && e->col.g == col.g && e->col.b == col.b &&
+        e->col.a == col.a && strcmp(e->text, text) == 0)
+      break;
+    e = e->next_hash;
+  }
+
+  if (!e) {
+    /* First sighting: remember the key only. */
+    g_stats.misses++;
+    e = (Entry *)calloc(1, sizeof(Entry));
+    if (!e)
+      return TEXT_CACHE_MISS;
+    e->text = strdup(text);
+    if (!e->text) {
+      free(e);
+      return TEXT_CACHE_MISS;
+    }
+    e->hash = h;
+    e->font = font;
+    e->style = style;
+    e->col = col;
+    Entry **bucket = &g_buckets[h & (TEXT_CACHE_BUCKETS - 1)];
+    e->next_hash = *bucket;
+    *bucket = e;
+    lru_push_front(e);
+    g_stats.entries++;
+    enforce_limits(e);
+    return TEXT_CACHE_MISS;
+  }
+
+  lru_unlink(e);
+  lru_push_front(e);
+  if (e->failed) {
+    g_stats.misses++;
+    return TEXT_CACHE_FAILED;
+  }
+  if (!e->tex) {
+    g_stats.misses++;
+    if (!entry_rasterize(e, ren)) {
+      e->failed = true;
+      return TEXT_CACHE_FAILED;
+    }
+    enforce_limits(e);
+  } else {
+    g_stats.hits++;
+  }
+
+  SDL_Rect dst = {x, y, e->w, e->h};
+  if (right_align)
+    dst.x -= e->w;
+  SDL_RenderCopy(ren, e->tex, NULL, &dst);
+  return TEXT_CACHE_DRAWN;
+}
+
+void text_cache_set_budget(size_t pixels) {
+  g_stats.budget_pixels = pixels;
+  enforce_limits(NULL);
+}
+
+void text_cache_get_stats(TextCacheStats *out) {
+  if (out)
+    *out = g_stats;
+}
+
+void text_cache_clear(void) {
+  while (g_lru_head)
+    entry_remove(g_lru_head, false);
+}
@@ -0,0 +1,52 @@
+#ifndef UI_TEXT_CACHE_H
+#define UI_TEXT_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Global cache of rendered text textures, keyed by (font, style, color,
+ * string). A string is only rasterized into its own texture the second time
+ * it is drawn; one-off strings (a ticking timer) stay on the glyph atlas and
+ * don't churn the cache. A string that fails to rasterize is remembered as
+ * such and left to the caller until the cache is cleared. Entries are
+ * evicted least recently used first once the textures exceed a pixel
+ * budget.
+ *
+ * Like the glyph atlas, entries hold TTF_Font pointers: call
+ * text_cache_clear() before closing fonts or destroying the renderer.
+ */
+
+typedef struct TextCacheStats {
+  uint32_t hits;      /* drawn from a cached texture */
+  uint32_t misses;    /* not cached (first sighting or just rasterized) */
+  uint32_t evictions; /* textures dropped for the budget or entry limit */
+  uint32_t entries;   /* strings tracked, with or without a texture */
+  size_t pixels;      /* texture pixels currently held */
+  size_t budget_pixels;
+} TextCacheStats;
+
+typedef enum {
+  TEXT_CACHE_MISS = 0, /* not cached yet: the caller draws it another way */
+  TEXT_CACHE_DRAWN,
+  TEXT_CACHE_FAILED, /* it could not be rasterized before: don't retry */
+} TextCacheResult;
+
+/* Draws text with its top-left at (x, y) (top-right if right_align) from the
+ * cache. */
+TextCacheResult text_cache_draw(SDL_Renderer *ren, TTF_Font *font, int style,
+                                int x, int y, const char *text, SDL_Color col,
+                                bool right_align);
+
+/* Texture memory budget in pixels (4 bytes each); evicts down to it. */
+void text_cache_set_budget(size_t pixels);
+
+void text_cache_get_stats(TextCacheStats *out);
+
+/* Drops every entry. Counters are kept; a clear is not an eviction. */
+void text_cache_clear(void);
+
+#endif
@@ -0,0 +1,295 @@
+#include "text_measure.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils/string_utils.h"
+
+#define TEXT_MEASURE_SLOTS 2048 /* string widths, power of two */
+#define TEXT_MEASURE_PROBE 8    /* linear probe length before overwriting */
+#define TEXT_MEASURE_KEY_MAX 64 /* longer strings are measured uncached */
+#define TEXT_MEASURE_FONTS 12   /* (font, style) advance tables kept at once */
+#define TEXT_MEASURE_ADV_MAX 512 /* codepoints below this get cached advances */
+#define TEXT_MEASURE_KERN_LO 0x20 /* printable ASCII kerning pairs */
+#define TEXT_MEASURE_KERN_N 95
+#define TEXT_MEASURE_UNKNOWN_ADV (-1)
+#define TEXT_MEASURE_UNKNOWN_KERN INT8_MIN
+
+/* Same version split as the glyph atlas. */
+#ifdef SDL_TTF_VERSION_ATLEAST
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+#define TEXT_MEASURE_TTF32 1
+#endif
+#endif
+
+typedef struct {
+  uint32_t hash; /* 0 = empty slot */
+  TTF_Font *font;
+  int style;
+  int w;
+  char text[TEXT_MEASURE_KEY_MAX];
+} Slot;
+
+typedef struct {
+  TTF_Font *font;
+  int style;
+  unsigned last_use;
+  int16_t adv[TEXT_MEASURE_ADV_MAX];
+  int8_t kern[TEXT_MEASURE_KERN_N * TEXT_MEASURE_KERN_N];
+} Metrics;
+
+static Slot *g_slots;
+static Metrics *g_metrics[TEXT_MEASURE_FONTS];
+static unsigned g_use_clock;
+
+/* Applies a style for FreeType queries on the first cache miss only, since
+ * changing the style flushes SDL_ttf's own glyph cache. */
+typedef struct {
+  TTF_Font *font;
+  int style;
+  int old;
+  bool applied;
+} StyleScope;
+
+static void scope_apply(StyleScope *sc) {
+  if (sc->applied)
+    return;
+  sc->applied = true;
+  sc->old = TTF_GetFontStyle(sc->font);
+  if (sc->old != sc->style)
+    TTF_SetFontStyle(sc->font, sc->style);
+}
+
+static void scope_restore(StyleScope *sc) {
+  if (sc->applied && sc->old != sc->style)
+    TTF_SetFontStyle(sc->font, sc->old);
+  sc->applied = false;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static uint32_t key_hash(TTF_Font *font, int style, const char *s,
+                         size_t *out_len) {
+  uint32_t h = 2166136261u;
+  const unsigned char *p = (const unsigned char *)s;
+  for (; *p; p++) {
+    h ^= *p;
+    h *= 16777619u;
+  }
+  *out_len = (size_t)(p - (const unsigned char *)s);
+  h ^= (uint32_t)((uintptr_t)font >> 4) * 2654435761u;
+  h ^= (uint32_t)style * 0x9E3779B9u;
+  return h ? h : 1;
+}
+
+static int measure_uncached(TTF_Font *font, int style, const char *s) {
+  StyleScope sc = {font, style, 0, false};
+  scope_apply(&sc);
+  int w = 0;
+  if (TTF_SizeUTF8(font, s, &w, NULL) != 0)
+    w = 0;
+  scope_restore(&sc);
+  return w;
+}
+
+int text_measure(TTF_Font *font, int style, const char *s) {
+  if (!font || !s || !s[0])
+    return 0;
+
+  size_t len = 0;
+  const uint32_t h = key_hash(font, style, s, &len);
+  if (len >= TEXT_MEASURE_KEY_MAX)
+    return measure_uncached(font, style, s);
+  if (!g_slots) {
+    g_slots = (Slot *)calloc(TEXT_MEASURE_SLOTS, sizeof(Slot));
+    if (!g_slots)
+      return measure_uncached(font, style, s);
+  }
+
+  const size_t home = h & (TEXT_MEASURE_SLOTS - 1);
+  Slot *victim = NULL;
+  for (size_t i = 0; i < TEXT_MEASURE_PROBE; i++) {
+    Slot *sl = &g_slots[(home + i) & (TEXT_MEASURE_SLOTS - 1)];
+    if (!sl->hash) {
+      victim = sl;
+      break;
+    }
+    if (sl->hash == h && sl->font == font && sl->style == style &&
+        memcmp(sl->text, s, len + 1) == 0)
+      return sl->w;
+  }
+  /* Probe window full: overwrite the home slot. */
+  if (!victim)
+    victim = &g_slots[home];
+
+  const int w = measure_uncached(font, style, s);
+  victim->hash = h;
+  victim->font = font;
+  victim->style = style;
+  victim->w = w;
+  memcpy(victim->text, s, len + 1);
+  return w;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static Metrics *metrics_get(TTF_Font *font, int style) {
+  int free_i = -1, lru_i = 0;
+  for (int i = 0; i < TEXT_MEASURE_FONTS; i++) {
+    Metrics *m = g_metrics[i];
+    if (!m) {
+      if (free_i < 0)
+        free_i = i;
+      continue;
+    }
+    if (m->font == font && m->style == style) {
+      m->last_use = ++g_use_clock;
+      return m;
+    }
+    if (g_metrics[lru_i] && m->last_use < g_metrics[lru_i]->last_use)
+      lru_i = i;
+  }
+
+  Metrics *m;
+  if (free_i >= 0) {
+    m = (Metrics *)malloc(sizeof(Metrics));
+    if (!m)
+      return NULL;
+    g_metrics[free_i] = m;
+  } else {
+    m = g_metrics[lru_i];
+  }
+  m->font = font;
+  m->style = style;
+  m->last_use = ++g_use_clock;
+  for (int i = 0; i < TEXT_MEASURE_ADV_MAX; i++)
+    m->adv[i] = TEXT_MEASURE_UNKNOWN_ADV;
+  memset(m->kern, TEXT_MEASURE_UNKNOWN_KERN, sizeof(m->kern));
+  return m;
+}
+
+static int query_advance(TTF_Font *font, uint32_t cp) {
+  int minx = 0, maxx = 0, miny = 0, maxy = 0, adv = 0;
+#ifdef TEXT_MEASURE_TTF32
+  if (TTF_GlyphMetrics32(font, cp, &minx, &maxx, &miny, &maxy, &adv) != 0)
+    return 0;
+#else
+  if (TTF_GlyphMetrics(font, (Uint16)(cp > 0xFFFF ? 0xFFFD : cp), &minx,
+                       &maxx, &miny, &maxy, &adv) != 0)
+    return 0;
+#endif
+  return adv;
+}
+
+static int query_kerning(TTF_Font *font, uint32_t prev, uint32_t cp) {
+#ifdef TEXT_MEASURE_TTF32
+  return TTF_GetFontKerningSizeGlyphs32(font, prev, cp);
+#else
+  if (prev > 0xFFFF || cp > 0xFFFF)
+    return 0;
+  return TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, (Uint16)cp);
+#endif
+}
+
+static int metrics_advance(Metrics *m, StyleScope *sc, uint32_t cp) {
+  if (m && cp < TEXT_MEASURE_ADV_MAX &&
+      m->adv[cp] != TEXT_MEASURE_UNKNOWN_ADV)
+    return m->adv[cp];
+  scope_apply(sc);
+  const int adv = query_advance(sc->font, cp);
+  if (m && cp < TEXT_MEASURE_ADV_MAX && adv >= 0 && adv <= INT16_MAX)
+    m->adv[cp] = (int16_t)adv;
+  return adv;
+}
+
+static int metrics_kerning(Metrics *m, StyleScope *sc, uint32_t prev,
+                           uint32_t cp) {
+  const uint32_t a = prev - TEXT_MEASURE_KERN_LO;
+  const uint32_t b = cp - TEXT_MEASURE_KERN_LO;
+  const bool tabled = m && a < TEXT_MEASURE_KERN_N && b < TEXT_MEASURE_KERN_N;
+  if (tabled) {
+    const int8_t k = m->kern[a * TEXT_MEASURE_KERN_N + b];
+    if (k != TEXT_MEASURE_UNKNOWN_KERN)
+      return k;
+  }
+  scope_apply(sc);
+  const int k = query_kerning(sc->font, prev, cp);
+  if (tabled && k > INT8_MIN && k <= INT8_MAX)
+    m->kern[a * TEXT_MEASURE_KERN_N + b] = (int8_t)k;
+  return k;
+}
+
+int text_measure_advance(TTF_Font *font, int style, uint32_t cp) {
+  if (!font)
+    return 0;
+  StyleScope sc = {font, style, 0, false};
+  const int adv = metrics_advance(metrics_get(font, style), &sc, cp);
+  scope_restore(&sc);
+  return adv;
+}
+
+/* Walks s adding advances and kerning until the pen would pass max_w.
+ * Returns the pen position reached; *out_bytes is the length of the prefix
+ * that fit. */
+static int walk(TTF_Font *font, int style, const char *s, int max_w,
+                size_t *out_bytes) {
+  Metrics *m = metrics_get(font, style);
+  StyleScope sc = {font, style, 0, false};
+  const bool kerning = TTF_GetFontKerning(font) != 0;
+  const char *p = s;
+  uint32_t prev = 0;
+  int pen = 0;
+  while (*p) {
+    const char *at = p;
+    const uint32_t cp = utf8_next_codepoint(&p);
+    int next = pen + metrics_advance(m, &sc, cp);
+    if (kerning && prev)
+      next += metrics_kerning(m, &sc, prev, cp);
+    if (next > max_w) {
+      p = at;
+      break;
+    }
+    pen = next;
+    prev = cp;
+  }
+  scope_restore(&sc);
+  if (out_bytes)
+    *out_bytes = (size_t)(p - s);
+  return pen;
+}
+
+int text_measure_sum(TTF_Font *font, int style, const char *s) {
+  if (!font || !s || !s[0])
+    return 0;
+  return walk(font, style, s, 0x7FFFFFFF, NULL);
+}
+
+size_t text_measure_fit(TTF_Font *font, int style, const char *s, int max_w) {
+  if (!font || !s || !s[0] || max_w <= 0)
+    return 0;
+  size_t n = 0;
+  walk(font, style, s, max_w, &n);
+  return n;
+}
+
+bool text_measure_line_fits(TTF_Font *font, int style, const char *line,
+                            int sum_w, int max_w) {
+  if (sum_w > max_w)
+    return false;
+  /* About the most a glyph overhangs its advance, kerning across the
+     spaces included. */
+  const int slack = font ? TTF_FontHeight(font) / 4 : 0;
+  if (sum_w < max_w - slack || !font || !line)
+    return true;
+  return text_measure(font, style, line) <= max_w;
+}
+
+void text_measure_clear(void) {
+  free(g_slots);
+  g_slots = NULL;
+  for (int i = 0; i < TEXT_MEASURE_FONTS; i++) {
+    free(g_metrics[i]);
+    g_metrics[i] = NULL;
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef UI_TEXT_MEASURE_H
+#define UI_TEXT_MEASURE_H
+
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Text measurement caches.
+ *
+ * text_measure() is TTF_SizeUTF8 (with the style applied) behind a hashed
+ * cache keyed by (font, style, string), so layout code can measure the same
+ * labels every frame for free. For wrapping and truncation, per-font tables
+ * of codepoint advances and kerning pairs let widths be summed without going
+ * back to FreeType.
+ *
+ * Everything is keyed by TTF_Font pointer: call text_measure_clear() whenever
+ * fonts are closed or reloaded.
+ */
+
+/* Exact rendered width of s in font with the given style (cached). */
+int text_measure(TTF_Font *font, int style, const char *s);
+
+/* Horizontal advance of one codepoint (cached per font and style). */
+int text_measure_advance(TTF_Font *font, int style, uint32_t cp);
+
+/* Pen advance of s: the sum of codepoint advances plus kerning. Can differ
+ * from text_measure() by a pixel or two of glyph overhang. */
+int text_measure_sum(TTF_Font *font, int style, const char *s);
+
+/* Byte length of the longest prefix of s whose advance fits in max_w (never
+ * splits a UTF-8 sequence). */
+size_t text_measure_fit(TTF_Font *font, int style, const char *s, int max_w);
+
+/* Whether line, whose summed advances come to sum_w, fits in max_w. The
+ * wrap loops use this for every word: a sum over max_w doesn't fit, one
+ * comfortably under it does, and only a line close enough to max_w for
+ * kerning and overhang to matter is measured whole with text_measure(). */
+bool text_measure_line_fits(TTF_Font *font, int style, const char *line,
+                            int sum_w, int max_w);
+
+void text_measure_clear(void);
+
+#endif
@@ -24,12 +24,16 @@
 #define HUD_HIDDEN_STACK_BOTTOM_PAD 70
 #define HUD_HIDDEN_STACK_Y_OFFSET 70
 #define BG_HIDDEN_SHIFT_Y 120
+#define BG_FAINT_ALPHA 128
 #define HUD_HIDE_HOLD_MS 450
 #define UI_HELP_OVERLAY_HOLD_MS 450
 #define UI_HELP_OVERLAY_DIR "layouts"
 #define UI_HELP_OVERLAY_PREFIX "ui_"
 #define USABLE_COLUMN_WIDTH 540
-#define CIRCLE_LAYOUT_CX (1024 / 2)
+#define CIRCLE_LAYOUT_CX(ui) ((ui)->w / 2)
+/* Window size asked for; the layout follows whatever size is granted. */
+#define UI_DEFAULT_W 1024
+#define UI_DEFAULT_H 768
 
 /* Structs */
 typedef struct UI UI;
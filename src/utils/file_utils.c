@@ -26,6 +26,13 @@ bool is_file(const char *path) {
   return S_ISREG(st.st_mode);
 }
 
+time_t file_mtime(const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+    return 0;
+  return st.st_mtime;
+}
+
 void ensure_dir(const char *path) {
   if (!path || !path[0])
     return;
@@ -4,9 +4,12 @@
 #include "string_utils.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <time.h>
 
 bool is_dir(const char *path);
 bool is_file(const char *path);
+/* Modification time of a regular file, or 0 if it isn't one. */
+time_t file_mtime(const char *path);
 void ensure_dir(const char *path);
 char *read_entire_file(const char *path, size_t *out_len);
 
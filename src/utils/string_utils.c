@@ -52,6 +52,36 @@ void utf8_pop_back_inplace(char *s) {
   s[n] = 0;
 }
 
+uint32_t utf8_next_codepoint(const char **p) {
+  const unsigned char *s = (const unsigned char *)*p;
+  uint32_t c = s[0];
+  int n = 0;
+  if (c < 0x80) {
+    n = 0;
+  } else if ((c & 0xE0) == 0xC0) {
+    c &= 0x1F;
+    n = 1;
+  } else if ((c & 0xF0) == 0xE0) {
+    c &= 0x0F;
+    n = 2;
+  } else if ((c & 0xF8) == 0xF0) {
+    c &= 0x07;
+    n = 3;
+  } else {
+    *p += 1;
+    return 0xFFFD;
+  }
+  for (int i = 1; i <= n; i++) {
+    if ((s[i] & 0xC0) != 0x80) {
+      *p += i;
+      return 0xFFFD;
+    }
+    c = (c << 6) | (s[i] & 0x3F);
+  }
+  *p += n + 1;
+  return c;
+}
+
 char *str_dup(const char *s) {
   size_t n = strlen(s);
   char *r = (char *)malloc(n + 1);
@@ -17,6 +17,9 @@ void safe_snprintf(char *dst, size_t cap, const char *fmt, ...);
 void trim_ascii_inplace(char *s);
 void ascii_lower_inplace(char *s);
 void utf8_pop_back_inplace(char *s);
+/* Decodes the codepoint at *p and advances *p past it (U+FFFD on bad
+ * input). *p must not point at the terminator. */
+uint32_t utf8_next_codepoint(const char **p);
 char *str_dup(const char *s);
 void trim_newline(char *s);
 
@@ -0,0 +1,65 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The few helpers the tests share. Each test is its own program: CHECK
+ * reports a failure and carries on, and main returns check_done(), which
+ * is non-zero if anything failed. `make test` builds and runs them all.
+ */
+
+static int check_failures;
+
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,       \
+              #cond);                                                        \
+      check_failures++;                                                      \
+    }                                                                        \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                       \
+  do {                                                                       \
+    const long long check_a = (long long)(a), check_b = (long long)(b);      \
+    if (check_a != check_b) {                                                \
+      fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n", __FILE__,    \
+              __LINE__, #a, #b, check_a, check_b);                           \
+      check_failures++;                                                      \
+    }                                                                        \
+  } while (0)
+
+/* A fresh empty directory under /tmp; exits if none can be made. */
+static inline const char *check_scratch_dir(void) {
+  static char dir[64];
+  snprintf(dir, sizeof(dir), "/tmp/stillroom-test-XXXXXX");
+  if (!mkdtemp(dir)) {
+    perror("mkdtemp");
+    exit(2);
+  }
+  return dir;
+}
+
+/* Writes text to path, replacing it. */
+static inline void check_write_file(const char *path, const char *text) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    exit(2);
+  }
+  fputs(text, f);
+  fclose(f);
+}
+
+static inline int check_done(const char *name) {
+  if (check_failures)
+    fprintf(stderr, "%s: %d failed\n", name, check_failures);
+  else
+    printf("%s: ok\n", name);
+  return check_failures ? 1 : 0;
+}
+
+#endif // TESTS_CHECK_H
@@ -0,0 +1,137 @@
+#include "features/stats/activity_rollup.h"
+
+#include <SDL2/SDL.h>
+#include <time.h>
+
+#include "check.h"
+#include "features/stats/history_log.h"
+
+static char g_dir[256], g_hist[256], g_rollup[256];
+
+static int this_month(void) {
+  const time_t now = time(NULL);
+  struct tm tmv;
+  localtime_r(&now, &tmv);
+  return (tmv.tm_year + 1900) * 100 + tmv.tm_mon + 1;
+}
+
+/* Waits for the compaction worker to have rewritten n segments. */
+static void wait_generation(uint32_t n) {
+  for (int i = 0; i < 500 && history_log_generation() < n; i++)
+    SDL_Delay(10);
+}
+
+static void reopen(void) {
+  activity_rollup_free();
+  history_log_close();
+  CHECK(history_log_open(g_hist));
+  activity_rollup_load(g_rollup);
+}
+
+static void test_append_and_query(void) {
+  CHECK(history_log_open(g_hist));
+  activity_rollup_load(g_rollup);
+  CHECK_EQ(activity_rollup_day_count(), 0);
+  CHECK(activity_rollup_append(20261002, 60));
+  CHECK(activity_rollup_append(20261001, 30)); /* out of order */
+  CHECK(activity_rollup_append(20261002, 15));
+  CHECK(!activity_rollup_append(0, 15));
+  CHECK_EQ(activity_rollup_day(20261002), 75);
+  CHECK_EQ(activity_rollup_day(20261001), 30);
+  CHECK_EQ(activity_rollup_day(20261003), 0);
+  CHECK_EQ(activity_rollup_since(20261002), 75);
+  CHECK_EQ(activity_rollup_since(0), 105);
+  CHECK_EQ(activity_rollup_day_count(), 2);
+  int date = 0;
+  CHECK_EQ(activity_rollup_day_at(0, &date), 30);
+  CHECK_EQ(date, 20261001);
+  CHECK_EQ(activity_rollup_day_at(2, &date), 0);
+}
+
+/* Rows written while the rollup wasn't saved are picked up on load, and
+ * a half-written last row only once it is complete. */
+static void test_catch_up(void) {
+  activity_rollup_save();
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20261003, "2026-10-03\t5",
+                           NULL));
+  char path[512];
+  history_log_segment_path(HISTORY_LOG_ACTIVITY, 202610, path, sizeof(path));
+  FILE *f = fopen(path, "a");
+  fputs("2026-10-03\t4", f); /* no newline yet */
+  fclose(f);
+  reopen();
+  CHECK_EQ(activity_rollup_day(20261003), 5);
+  f = fopen(path, "a");
+  fputs("0\n", f);
+  fclose(f);
+  reopen();
+  CHECK_EQ(activity_rollup_day(20261003), 45);
+  CHECK_EQ(activity_rollup_since(0), 150);
+}
+
+/* A segment replaced by another file of the same size is read again,
+ * whether it was renamed over the old one or rewritten in place. */
+static void test_replaced_segment(void) {
+  activity_rollup_save();
+  char path[512], tmp[520];
+  history_log_segment_path(HISTORY_LOG_ACTIVITY, 202610, path, sizeof(path));
+  snprintf(tmp, sizeof(tmp), "%s.new", path);
+  /* The same length as the five rows there, with other dates. */
+  check_write_file(tmp, "2026-10-04\t60\n2026-10-04\t30\n2026-10-05\t15\n"
+                        "2026-10-05\t5\n2026-10-06\t40\n");
+  CHECK(rename(tmp, path) == 0);
+  reopen();
+  CHECK_EQ(activity_rollup_day(20261002), 0);
+  CHECK_EQ(activity_rollup_day(20261004), 90);
+  CHECK_EQ(activity_rollup_since(0), 150);
+  activity_rollup_save();
+  check_write_file(path, "2026-10-04\t60\n2026-10-04\t30\n2026-10-05\t15\n"
+                         "2026-10-05\t5\n2026-10-07\t41\n");
+  reopen();
+  CHECK_EQ(activity_rollup_day(20261006), 0);
+  CHECK_EQ(activity_rollup_day(20261007), 41);
+  CHECK_EQ(activity_rollup_since(0), 151);
+}
+
+/* Compaction rewrites old months to one row per day; the totals stay. */
+static void test_after_compaction(void) {
+  CHECK(activity_rollup_append(20240105, 10));
+  CHECK(activity_rollup_append(20240105, 20));
+  CHECK(activity_rollup_append(20240220, 7));
+  activity_rollup_save();
+  reopen(); /* a segment still open for appending is left alone */
+  /* Every month before this one is compacted, 2026-10 too once past. */
+  const uint32_t want =
+      history_log_generation() + 2 + (this_month() > 202610);
+  CHECK(history_log_compact_start());
+  wait_generation(want);
+  CHECK_EQ(history_log_generation(), want);
+  reopen();
+  CHECK_EQ(activity_rollup_day(20240105), 30);
+  CHECK_EQ(activity_rollup_day(20240220), 7);
+  CHECK_EQ(activity_rollup_since(0), 188);
+  char path[512];
+  history_log_segment_path(HISTORY_LOG_ACTIVITY, 202401, path, sizeof(path));
+  size_t len = 0;
+  FILE *f = fopen(path, "r");
+  char buf[64] = {0};
+  if (f) {
+    len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+  }
+  CHECK(len > 0 && strcmp(buf, "2024-01-05\t30\n") == 0);
+}
+
+int main(void) {
+  const char *dir = check_scratch_dir();
+  snprintf(g_dir, sizeof(g_dir), "%s", dir);
+  snprintf(g_hist, sizeof(g_hist), "%s/history", dir);
+  snprintf(g_rollup, sizeof(g_rollup), "%s/rollup.txt", dir);
+  test_append_and_query();
+  test_catch_up();
+  test_replaced_segment();
+  test_after_compaction();
+  activity_rollup_free();
+  history_log_close();
+  return check_done("activity_rollup");
+}
@@ -0,0 +1,158 @@
+#include "features/stats/history_log.h"
+
+#include <SDL2/SDL.h>
+#include <time.h>
+
+#include "check.h"
+
+static char g_dir[256], g_hist[256];
+
+static int this_month(void) {
+  const time_t now = time(NULL);
+  struct tm tmv;
+  localtime_r(&now, &tmv);
+  return (tmv.tm_year + 1900) * 100 + tmv.tm_mon + 1;
+}
+
+/* The contents of a segment, or "" if it can't be read. */
+static const char *segment_text(HistoryLogKind kind, int month) {
+  static char buf[1024];
+  char path[512];
+  history_log_segment_path(kind, month, path, sizeof(path));
+  buf[0] = 0;
+  FILE *f = fopen(path, "r");
+  if (f) {
+    buf[fread(buf, 1, sizeof(buf) - 1, f)] = 0;
+    fclose(f);
+  }
+  return buf;
+}
+
+static void reopen(void) {
+  history_log_close();
+  CHECK(history_log_open(g_hist));
+}
+
+/* Rows go to the segment of their month, which is listed in the manifest
+ * the first time round. */
+static void test_append(void) {
+  CHECK(history_log_open(g_hist));
+  CHECK_EQ(history_log_segment_count(HISTORY_LOG_ACTIVITY), 0);
+  long long end = -1;
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20260905, "2026-09-05\t10",
+                           &end));
+  CHECK_EQ(end, 14);
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20260905, "2026-09-05\t5",
+                           &end));
+  CHECK_EQ(end, 27);
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20261001, "2026-10-01\t7",
+                           NULL));
+  CHECK(!history_log_append(HISTORY_LOG_ACTIVITY, 0, "x", NULL));
+  CHECK(!history_log_append(HISTORY_LOG_KIND_COUNT, 20261001, "x", NULL));
+  CHECK_EQ(history_log_segment_count(HISTORY_LOG_ACTIVITY), 2);
+  CHECK_EQ(history_log_segment_count(HISTORY_LOG_FOCUS), 0);
+  CHECK(strcmp(segment_text(HISTORY_LOG_ACTIVITY, 202609),
+               "2026-09-05\t10\n2026-09-05\t5\n") == 0);
+  char path[512];
+  history_log_segment_path(HISTORY_LOG_FOCUS, 202601, path, sizeof(path));
+  CHECK(strstr(path, "/focus-2026-01.txt") != NULL);
+  CHECK_EQ(history_log_generation(), 0);
+  /* Rows for a month before the newest shift every later offset. */
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20260906, "2026-09-06\t1",
+                           NULL));
+  CHECK_EQ(history_log_generation(), 1);
+  reopen();
+  HistorySegment segs[4];
+  CHECK_EQ(history_log_segments(HISTORY_LOG_ACTIVITY, segs, 4), 2);
+  CHECK_EQ(segs[0].month, 202609);
+  CHECK_EQ(segs[0].gen, 1);
+  CHECK_EQ(segs[1].month, 202610);
+  CHECK_EQ(segs[1].gen, 0);
+  CHECK(!segs[0].compacted);
+  CHECK_EQ(history_log_segments(HISTORY_LOG_ACTIVITY, segs, 1), 1);
+}
+
+/* A single-file log is split by month and renamed out of the way. */
+static void test_migrate(void) {
+  char legacy[512], done[528];
+  snprintf(legacy, sizeof(legacy), "%s/focus_history.txt", g_dir);
+  snprintf(done, sizeof(done), "%s.migrated", legacy);
+  check_write_file(legacy, "2023-01-03 09:00\t600\tcompleted\tRead\n"
+                           "not a row\n"
+                           "2023-02-01 09:00\t300\taborted\tWrite\n"
+                           "2023-01-04 09:00\t900\tended\tRead\n");
+  history_log_migrate(HISTORY_LOG_FOCUS, legacy);
+  CHECK_EQ(history_log_segment_count(HISTORY_LOG_FOCUS), 2);
+  CHECK(strcmp(segment_text(HISTORY_LOG_FOCUS, 202301),
+               "2023-01-03 09:00\t600\tcompleted\tRead\n"
+               "2023-01-04 09:00\t900\tended\tRead\n") == 0);
+  CHECK(strcmp(segment_text(HISTORY_LOG_FOCUS, 202302),
+               "2023-02-01 09:00\t300\taborted\tWrite\n") == 0);
+  FILE *f = fopen(legacy, "r");
+  CHECK(f == NULL);
+  if (f)
+    fclose(f);
+  f = fopen(done, "r");
+  CHECK(f != NULL);
+  if (f)
+    fclose(f);
+  /* Another legacy file once there are segments is only renamed. */
+  check_write_file(legacy, "2023-03-01 09:00\t1\tcompleted\tRead\n");
+  history_log_migrate(HISTORY_LOG_FOCUS, legacy);
+  CHECK_EQ(history_log_segment_count(HISTORY_LOG_FOCUS), 2);
+  reopen();
+  CHECK_EQ(history_log_segment_count(HISTORY_LOG_FOCUS), 2);
+}
+
+/* Old activity months end up with a row per day, old focus months with a
+ * row per day and activity, already summarized rows counted as theirs. */
+static void test_compaction(void) {
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20230507, "2023-05-07\t10",
+                           NULL));
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20230502, "2023-05-02\t4",
+                           NULL));
+  CHECK(history_log_append(HISTORY_LOG_ACTIVITY, 20230507, "2023-05-07\t20",
+                           NULL));
+  CHECK(history_log_append(HISTORY_LOG_FOCUS, 20230103,
+                           "2023-01-03 10:00\t60\tcompleted\tAlgebra", NULL));
+  CHECK(history_log_append(HISTORY_LOG_FOCUS, 20230103,
+                           "2023-01-03\t1000\t3 sessions\tRead", NULL));
+  reopen(); /* a segment still open for appending is left alone */
+  /* 2023-05, 2026-09 and, once past, 2026-10 of the activity; both
+   * focus months. */
+  const uint32_t want =
+      history_log_generation() + 4 + (this_month() > 202610);
+  CHECK(history_log_compact_start());
+  CHECK(!history_log_compact_start());
+  for (int i = 0; i < 500 && history_log_generation() < want; i++)
+    SDL_Delay(10);
+  CHECK_EQ(history_log_generation(), want);
+  CHECK(strcmp(segment_text(HISTORY_LOG_ACTIVITY, 202305),
+               "2023-05-02\t4\n2023-05-07\t30\n") == 0);
+  CHECK(strcmp(segment_text(HISTORY_LOG_ACTIVITY, 202609),
+               "2026-09-05\t15\n2026-09-06\t1\n") == 0);
+  CHECK(strcmp(segment_text(HISTORY_LOG_FOCUS, 202301),
+               "2023-01-03\t60\t1 session\tAlgebra\n"
+               "2023-01-03\t1600\t4 sessions\tRead\n"
+               "2023-01-04\t900\t1 session\tRead\n") == 0);
+  HistorySegment segs[4];
+  CHECK_EQ(history_log_segments(HISTORY_LOG_FOCUS, segs, 4), 2);
+  CHECK(segs[0].compacted && segs[1].compacted);
+  /* Compacted segments are left alone the next time. */
+  reopen();
+  const uint32_t gen = history_log_generation();
+  CHECK(history_log_compact_start());
+  reopen();
+  CHECK_EQ(history_log_generation(), gen);
+}
+
+int main(void) {
+  const char *dir = check_scratch_dir();
+  snprintf(g_dir, sizeof(g_dir), "%s", dir);
+  snprintf(g_hist, sizeof(g_hist), "%s/history", dir);
+  test_append();
+  test_migrate();
+  test_compaction();
+  history_log_close();
+  return check_done("history_log");
+}
@@ -0,0 +1,148 @@
+#include "features/stats/history_reader.h"
+
+#include <SDL2/SDL.h>
+#include <time.h>
+
+#include "check.h"
+#include "features/stats/history_log.h"
+
+static char g_hist[256];
+
+static int this_month(void) {
+  const time_t now = time(NULL);
+  struct tm tmv;
+  localtime_r(&now, &tmv);
+  return (tmv.tm_year + 1900) * 100 + tmv.tm_mon + 1;
+}
+
+/* Appends a September row whose seconds double as its number. */
+static void append_row(int i) {
+  char row[128];
+  snprintf(row, sizeof(row), "2026-09-%02d %02d:%02d\t%d\tcompleted\tact%d",
+           1 + i / 24 % 28, i % 24, i % 60, i, i % 3);
+  CHECK(history_log_append(HISTORY_LOG_FOCUS, 20260901 + i / 24 % 28, row,
+                           NULL));
+}
+
+static void test_empty(void) {
+  history_reader_open();
+  FocusHistoryRow out[4];
+  CHECK_EQ(history_reader_page(0, out, 4), 0);
+  CHECK_EQ(history_reader_total(), 0);
+}
+
+/* Pages come newest first; the total is known once a read reaches the
+ * oldest row, and rows deep in the file are found again from the index. */
+static void test_paging(void) {
+  for (int i = 0; i < 150; i++)
+    append_row(i);
+  FocusHistoryRow out[20];
+  CHECK_EQ(history_reader_page(0, out, 10), 10);
+  CHECK_EQ(out[0].seconds, 149);
+  CHECK_EQ(out[9].seconds, 140);
+  CHECK(strcmp(out[0].status, "completed") == 0);
+  CHECK(strcmp(out[0].activity, "act2") == 0);
+  CHECK(strcmp(out[0].dt, "2026-09-07 05:29") == 0);
+  CHECK_EQ(history_reader_total(), -1);
+  CHECK_EQ(history_reader_page(140, out, 20), 10);
+  CHECK_EQ(out[9].seconds, 0);
+  CHECK_EQ(history_reader_total(), 150);
+  CHECK_EQ(history_reader_page(70, out, 5), 5);
+  CHECK_EQ(out[0].seconds, 79);
+  CHECK_EQ(out[4].seconds, 75);
+  CHECK_EQ(history_reader_page(150, out, 5), 0);
+}
+
+/* Rows appended while open become the newest and shift the rest; a row
+ * still being written is left out until its newline arrives. */
+static void test_appends(void) {
+  for (int i = 150; i < 153; i++)
+    append_row(i);
+  FocusHistoryRow out[4];
+  CHECK_EQ(history_reader_page(0, out, 1), 1);
+  CHECK_EQ(out[0].seconds, 152);
+  CHECK_EQ(history_reader_total(), 153);
+  CHECK_EQ(history_reader_page(150, out, 4), 3);
+  CHECK_EQ(out[0].seconds, 2);
+  CHECK_EQ(out[2].seconds, 0);
+  char path[512];
+  history_log_segment_path(HISTORY_LOG_FOCUS, 202609, path, sizeof(path));
+  FILE *f = fopen(path, "a");
+  fputs("2026-09-28 10:00\t999\tended\tpartial", f);
+  fclose(f);
+  CHECK_EQ(history_reader_page(0, out, 1), 1);
+  CHECK_EQ(out[0].seconds, 152);
+  CHECK_EQ(history_reader_total(), 153);
+  f = fopen(path, "a");
+  fputs("\n", f);
+  fclose(f);
+  CHECK_EQ(history_reader_page(0, out, 1), 1);
+  CHECK_EQ(out[0].seconds, 999);
+  CHECK(strcmp(out[0].activity, "partial") == 0);
+  CHECK_EQ(history_reader_total(), 154);
+}
+
+/* Old months come first and, once compacted, as one row per day and
+ * activity. */
+static void test_after_compaction(void) {
+  CHECK(history_log_append(HISTORY_LOG_FOCUS, 20240305,
+                           "2024-03-05 10:00\t100\tcompleted\tRead", NULL));
+  CHECK(history_log_append(HISTORY_LOG_FOCUS, 20240305,
+                           "2024-03-05 11:00\t50\tended\tWrite", NULL));
+  CHECK(history_log_append(HISTORY_LOG_FOCUS, 20240305,
+                           "2024-03-05 12:00\t20\tcompleted\tRead", NULL));
+  FocusHistoryRow out[4];
+  CHECK_EQ(history_reader_page(154, out, 4), 3);
+  CHECK_EQ(out[0].seconds, 20);
+  CHECK_EQ(out[2].seconds, 100);
+  CHECK_EQ(history_reader_total(), 157);
+  /* A segment still open for appending is left alone. */
+  history_log_close();
+  CHECK(history_log_open(g_hist));
+  /* Focus months are kept as they are for HISTORY_FOCUS_KEEP_MONTHS. */
+  const int cutoff = this_month() - HISTORY_FOCUS_KEEP_MONTHS / 12 * 100;
+  const uint32_t want = history_log_generation() + 1 + (202609 <= cutoff);
+  CHECK(history_log_compact_start());
+  for (int i = 0; i < 500 && history_log_generation() < want; i++)
+    SDL_Delay(10);
+  CHECK_EQ(history_log_generation(), want);
+  if (202609 > cutoff) {
+    CHECK_EQ(history_reader_page(0, out, 1), 1);
+    CHECK_EQ(out[0].seconds, 999);
+    CHECK_EQ(history_reader_page(154, out, 4), 2);
+    CHECK_EQ(history_reader_total(), 156);
+    CHECK(strcmp(out[0].activity, "Write") == 0);
+    CHECK(strcmp(out[0].status, "1 session") == 0);
+    CHECK(strcmp(out[1].dt, "2024-03-05") == 0);
+    CHECK_EQ(out[1].seconds, 120);
+    CHECK(strcmp(out[1].status, "2 sessions") == 0);
+  }
+}
+
+/* A segment replaced by a shorter one is read from scratch. */
+static void test_replaced(void) {
+  char path[512];
+  history_log_segment_path(HISTORY_LOG_FOCUS, 202609, path, sizeof(path));
+  check_write_file(path, "2026-09-01 08:00\t7\tcompleted\tWalk\n"
+                         "2026-09-02 08:00\t8\taborted\tRun\n");
+  FocusHistoryRow out[8];
+  CHECK_EQ(history_reader_page(0, out, 8), 4);
+  CHECK_EQ(out[0].seconds, 8);
+  CHECK(strcmp(out[0].status, "aborted") == 0);
+  CHECK_EQ(out[1].seconds, 7);
+  CHECK_EQ(history_reader_total(), 4);
+}
+
+int main(void) {
+  const char *dir = check_scratch_dir();
+  snprintf(g_hist, sizeof(g_hist), "%s/history", dir);
+  CHECK(history_log_open(g_hist));
+  test_empty();
+  test_paging();
+  test_appends();
+  test_after_compaction();
+  test_replaced();
+  history_reader_close();
+  history_log_close();
+  return check_done("history_reader");
+}
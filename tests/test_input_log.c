@@ -0,0 +1,92 @@
+#include "ui/input_log.h"
+
+#include "check.h"
+
+static void test_pack(void) {
+  Buttons b;
+  memset(&b, 0, sizeof(b));
+  CHECK(!input_buttons_any(&b));
+  CHECK_EQ(input_buttons_pack(&b), 0);
+  b.up = b.select = b.r3 = true;
+  const uint32_t mask = input_buttons_pack(&b);
+  /* Bit order is part of the file format. */
+  CHECK_EQ(mask, (1u << 0) | (1u << 10) | (1u << 16));
+  Buttons back;
+  memset(&back, 0xFF, sizeof(back));
+  input_buttons_unpack(mask, &back);
+  CHECK(memcmp(&b, &back, sizeof(b)) == 0);
+  CHECK(input_buttons_any(&back));
+}
+
+/* What is recorded replays as the same records, in order. */
+static void test_round_trip(const char *path) {
+  CHECK(input_record_open(path));
+  CHECK(input_recording());
+  input_record(0, INPUT_REC_BUTTONS, 0x11);
+  input_record(0, INPUT_REC_MENU_DOWN, 0);
+  input_record(1250, INPUT_REC_MENU_UP, 0);
+  input_record(90000000000ull, INPUT_REC_QUIT, 0);
+  input_record(5, INPUT_REC_KIND_COUNT, 0); /* dropped */
+  input_record_close();
+  CHECK(!input_recording());
+  input_record(7, INPUT_REC_QUIT, 0); /* nothing open: dropped */
+
+  CHECK(input_replay_open(path));
+  CHECK(input_replaying());
+  CHECK_EQ(input_replay_count(), 4);
+  InputRec r;
+  CHECK(input_replay_peek(&r));
+  CHECK(input_replay_next(&r));
+  CHECK_EQ(r.ms, 0);
+  CHECK_EQ(r.kind, INPUT_REC_BUTTONS);
+  CHECK_EQ(r.buttons, 0x11);
+  CHECK(input_replay_next(&r));
+  CHECK_EQ(r.kind, INPUT_REC_MENU_DOWN);
+  CHECK(input_replay_next(&r));
+  CHECK_EQ(r.ms, 1250);
+  CHECK_EQ(r.kind, INPUT_REC_MENU_UP);
+  CHECK(input_replay_next(&r));
+  CHECK(r.ms == 90000000000ull);
+  CHECK_EQ(r.kind, INPUT_REC_QUIT);
+  CHECK(!input_replay_peek(&r));
+  CHECK(!input_replay_next(&r));
+  input_replay_close();
+  CHECK(!input_replaying());
+}
+
+/* Bad lines are skipped and time never runs backwards. */
+static void test_hand_edited(const char *path) {
+  check_write_file(path, "# stillroom input v1\n"
+                         "100 buttons 4\n"
+                         "garbage\n"
+                         "150 buttons\n" /* mask missing */
+                         "200 teleport\n"
+                         "\n"
+                         "90 back_down\n"
+                         "300 back_up\n");
+  CHECK(input_replay_open(path));
+  CHECK_EQ(input_replay_count(), 3);
+  InputRec r;
+  input_replay_next(&r);
+  CHECK_EQ(r.ms, 100);
+  input_replay_next(&r);
+  CHECK_EQ(r.kind, INPUT_REC_BACK_DOWN);
+  CHECK_EQ(r.ms, 100);
+  input_replay_next(&r);
+  CHECK_EQ(r.ms, 300);
+  input_replay_close();
+
+  check_write_file(path, "# stillroom input v1\n");
+  CHECK(!input_replay_open(path));
+  CHECK(!input_replaying());
+}
+
+int main(void) {
+  const char *dir = check_scratch_dir();
+  char path[256];
+  snprintf(path, sizeof(path), "%s/input.txt", dir);
+  test_pack();
+  test_round_trip(path);
+  test_hand_edited(path);
+  return check_done("input_log");
+}
@@ -0,0 +1,109 @@
+#include "ui/overlay_pack.h"
+
+#include <unistd.h>
+
+#include "check.h"
+#include "gfx/pixel.h"
+
+#define W 40
+#define H 24
+#define FRAMES 3
+#define MTIME 1700000000
+
+static uint32_t g_frames[FRAMES][W * H];
+
+/* Frame 0 is clear, 1 a few scattered drops, 2 a translucent band. */
+static void make_frames(void) {
+  memset(g_frames, 0, sizeof(g_frames));
+  g_frames[1][3 * W + 5] = 0xFFFFFFFF;
+  g_frames[1][3 * W + 6] = 0x80402010;
+  g_frames[1][17 * W + 30] = 0x40404040;
+  for (int y = 8; y < 12; y++)
+    for (int x = 0; x < W; x++)
+      g_frames[2][y * W + x] = x % 4 ? 0x60302010 : 0;
+}
+
+static void background(uint32_t *p) {
+  for (int i = 0; i < W * H; i++)
+    p[i] = 0xFF000000u | (uint32_t)(i * 2654435761u >> 8);
+}
+
+static bool write_pack(const char *path, int frames) {
+  OverlayPackWriter *wr = overlay_pack_begin(path, W, H, 1, FRAMES, MTIME);
+  if (!wr)
+    return false;
+  for (int i = 0; i < frames; i++) {
+    if (!overlay_pack_add(wr, g_frames[i], W)) {
+      overlay_pack_abort(wr);
+      return false;
+    }
+  }
+  return overlay_pack_finish(wr);
+}
+
+/* Drawing a packed frame gives exactly what compositing it whole does. */
+static void test_round_trip(const char *path) {
+  CHECK(write_pack(path, FRAMES));
+  OverlayPack *p = overlay_pack_open(path, W, H, 1, FRAMES, MTIME);
+  CHECK(p != NULL);
+  if (!p)
+    return;
+  CHECK_EQ(overlay_pack_frame_count(p), FRAMES);
+  CHECK(overlay_pack_size(p) > 0);
+  static uint32_t want[W * H], got[W * H], bg[W * H];
+  for (int f = 0; f < FRAMES; f++) {
+    background(want);
+    background(got);
+    gfx_over(want, W, g_frames[f], W, W, H);
+    const SDL_Rect all = {0, 0, W, H};
+    overlay_pack_draw(p, f, got, W, &all);
+    CHECK(memcmp(want, got, sizeof(want)) == 0);
+  }
+  /* A clip keeps every pixel outside it as it was. */
+  const SDL_Rect clip = {4, 9, 10, 2};
+  background(got);
+  overlay_pack_draw(p, 2, got, W, &clip);
+  background(want);
+  gfx_over(want, W, g_frames[2], W, W, H);
+  background(bg);
+  for (int y = 0; y < H; y++) {
+    for (int x = 0; x < W; x++) {
+      const bool in = x >= clip.x && x < clip.x + clip.w && y >= clip.y &&
+                      y < clip.y + clip.h;
+      CHECK_EQ(got[y * W + x], in ? want[y * W + x] : bg[y * W + x]);
+    }
+  }
+  overlay_pack_close(p);
+}
+
+/* A pack for another size or sequence is not used. */
+static void test_mismatch(const char *path) {
+  CHECK(overlay_pack_open(path, W + 1, H, 1, FRAMES, MTIME) == NULL);
+  CHECK(overlay_pack_open(path, W, H, 2, FRAMES, MTIME) == NULL);
+  CHECK(overlay_pack_open(path, W, H, 1, FRAMES + 1, MTIME) == NULL);
+  CHECK(overlay_pack_open(path, W, H, 1, FRAMES, MTIME + 1) == NULL);
+}
+
+/* A pack missing frames is never put in place. */
+static void test_incomplete(const char *dir) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/short.ovl", dir);
+  CHECK(!write_pack(path, FRAMES - 1));
+  CHECK(access(path, F_OK) != 0);
+  OverlayPackWriter *wr = overlay_pack_begin(path, W, H, 1, FRAMES, MTIME);
+  CHECK(wr != NULL);
+  if (wr)
+    overlay_pack_abort(wr);
+  CHECK(access(path, F_OK) != 0);
+}
+
+int main(void) {
+  const char *dir = check_scratch_dir();
+  char path[256];
+  snprintf(path, sizeof(path), "%s/rain.ovl", dir);
+  make_frames();
+  test_round_trip(path);
+  test_mismatch(path);
+  test_incomplete(dir);
+  return check_done("overlay_pack");
+}
@@ -0,0 +1,103 @@
+#include "gfx/pixel.h"
+
+#include "check.h"
+
+#define W 37 /* odd, so the SIMD paths also leave a scalar tail */
+#define H 5
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void) {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return g_seed;
+}
+
+static void fill_random(uint32_t *p, int n) {
+  for (int i = 0; i < n; i++)
+    p[i] = rnd();
+}
+
+static void test_downscale(void) {
+  /* Each 2x2 block averages to its own value, rounded. */
+  const uint32_t src[16] = {
+      0xFF000000, 0xFF000002, 0x00FFFFFF, 0x00FFFFFF,
+      0xFF000004, 0xFF000006, 0x00FFFFFF, 0x00FFFFFF,
+      0x10203040, 0x10203040, 0xFFFFFFFF, 0xFFFFFFFF,
+      0x10203040, 0x10203040, 0xFFFFFFFF, 0xFF000000,
+  };
+  uint32_t dst[4] = {0};
+  CHECK(gfx_downscale_area(src, 4, 4, 4, dst, 2, 2, 2));
+  CHECK_EQ(dst[0], 0xFF000003);
+  CHECK_EQ(dst[1], 0x00FFFFFF);
+  CHECK_EQ(dst[2], 0x10203040);
+  /* Three white and one opaque black: 191.25 rounds to 191. */
+  CHECK_EQ(dst[3], 0xFFBFBFBF);
+  CHECK(!gfx_downscale_area(src, 4, 4, 4, dst, 0, 2, 2));
+}
+
+static void test_premultiply(void) {
+  uint32_t p[3] = {0x80FF4020, 0x00FFFFFF, 0xFF123456};
+  gfx_premultiply(p, 3, 1, 3);
+  CHECK_EQ(p[0], 0x80802010);
+  CHECK_EQ(p[1], 0x00000000);
+  CHECK_EQ(p[2], 0xFF123456);
+}
+
+static void test_dim(void) {
+  uint32_t p[2] = {0x80FFFFFF, 0xFF102030};
+  gfx_dim(p, 2, 1, 2, 255);
+  CHECK_EQ(p[0], 0x80000000); /* alpha is left alone */
+  CHECK_EQ(p[1], 0xFF000000);
+  uint32_t q = 0xFFC86432;
+  gfx_dim(&q, 1, 1, 1, 0);
+  CHECK_EQ(q, 0xFFC86432);
+}
+
+static void test_over(void) {
+  uint32_t d[3] = {0xFF0000FF, 0xFF0000FF, 0xFF0000FF};
+  const uint32_t s[3] = {0x00000000, 0xFFFF0000, 0x80800000};
+  gfx_over(d, 3, s, 3, 3, 1);
+  CHECK_EQ(d[0], 0xFF0000FF); /* transparent: untouched */
+  CHECK_EQ(d[1], 0xFFFF0000); /* opaque: replaced */
+  CHECK_EQ(d[2], 0xFF80007F); /* half red over blue */
+}
+
+/* Every kernel gives the same bytes with and without SIMD. */
+static void test_simd_matches_scalar(void) {
+  static uint32_t src[W * H], a[W * H], b[W * H], over[W * H];
+  fill_random(src, W * H);
+  fill_random(over, W * H);
+  gfx_premultiply(over, W, H, W);
+  for (int i = 0; i < W; i += 3)
+    over[i] = 0; /* some transparent runs */
+
+  const int dw = 11, dh = 2;
+  uint32_t da[11 * 2], db[11 * 2];
+  gfx_pixel_set_simd(true);
+  gfx_downscale_area(src, W, H, W, da, dw, dh, dw);
+  gfx_pixel_set_simd(false);
+  gfx_downscale_area(src, W, H, W, db, dw, dh, dw);
+  CHECK(memcmp(da, db, sizeof(da)) == 0);
+
+  memcpy(a, src, sizeof(a));
+  memcpy(b, src, sizeof(b));
+  gfx_pixel_set_simd(true);
+  gfx_premultiply(a, W, H, W);
+  gfx_dim(a, W, H, W, 77);
+  gfx_over(a, W, over, W, W, H);
+  gfx_pixel_set_simd(false);
+  gfx_premultiply(b, W, H, W);
+  gfx_dim(b, W, H, W, 77);
+  gfx_over(b, W, over, W, W, H);
+  CHECK(memcmp(a, b, sizeof(a)) == 0);
+  gfx_pixel_set_simd(true);
+}
+
+int main(void) {
+  test_downscale();
+  test_premultiply();
+  test_dim();
+  test_over();
+  test_simd_matches_scalar();
+  return check_done("pixel");
+}
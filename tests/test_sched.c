@@ -0,0 +1,60 @@
+#include "ui/sched.h"
+
+#include "check.h"
+
+static void test_earliest_deadline(void) {
+  Sched s;
+  sched_init(&s, 1000);
+  CHECK_EQ(sched_timeout(&s, 1000, 500), 500); /* nothing pending */
+  sched_at(&s, SCHED_BATTERY, 5000);
+  sched_at(&s, SCHED_TIMER, 1250);
+  sched_at(&s, SCHED_ANIM, 1400);
+  CHECK_EQ(s.next, SCHED_TIMER);
+  CHECK_EQ(sched_timeout(&s, 1000, 10000), 250);
+  CHECK_EQ(sched_timeout(&s, 1000, 100), 100); /* capped */
+  CHECK_EQ(sched_timeout(&s, 1250, 10000), 0);
+  CHECK_EQ(sched_timeout(&s, 2000, 10000), 0); /* overdue */
+  /* A source keeps its earlier deadline. */
+  sched_at(&s, SCHED_TIMER, 3000);
+  CHECK_EQ(s.due[SCHED_TIMER], 1250);
+  sched_at(&s, SCHED_HOLD, 1100);
+  CHECK_EQ(s.next, SCHED_HOLD);
+  /* 0 is "none", so a deadline at 0 still counts, as already due. */
+  sched_at(&s, SCHED_BELL, 0);
+  CHECK_EQ(s.next, SCHED_BELL);
+  CHECK_EQ(sched_timeout(&s, 1000, 10000), 0);
+  sched_reset(&s);
+  CHECK_EQ(s.next, -1);
+  CHECK_EQ(s.due[SCHED_BATTERY], 0);
+  CHECK_EQ(sched_timeout(&s, 1000, 700), 700);
+}
+
+static void test_wakeup_stats(void) {
+  Sched s;
+  sched_init(&s, 0);
+  sched_at(&s, SCHED_TIMER, 1000);
+  sched_woke(&s, SCHED_MODE_RUN, 1000, false);
+  sched_woke(&s, SCHED_MODE_RUN, 1500, true);
+  sched_reset(&s);
+  sched_at(&s, SCHED_CLOCK, 60000);
+  sched_woke(&s, SCHED_MODE_IDLE, 60000, false);
+  CHECK_EQ(s.wakeups[SCHED_MODE_RUN], 2);
+  CHECK_EQ(s.input[SCHED_MODE_RUN], 1);
+  CHECK_EQ(s.fired[SCHED_TIMER], 1);
+  CHECK_EQ(s.fired[SCHED_CLOCK], 1);
+  CHECK_EQ(s.ms_in[SCHED_MODE_RUN], 1500);
+  CHECK_EQ(s.ms_in[SCHED_MODE_IDLE], 58500);
+  CHECK(sched_per_minute(&s, SCHED_MODE_RUN) == 80.0);
+  CHECK(sched_per_minute(&s, SCHED_MODE_ANIM) == 0.0);
+  /* A clock that steps back adds no time. */
+  sched_woke(&s, SCHED_MODE_IDLE, 100, true);
+  CHECK_EQ(s.ms_in[SCHED_MODE_IDLE], 58500);
+}
+
+int main(void) {
+  test_earliest_deadline();
+  test_wakeup_stats();
+  CHECK(strcmp(sched_source_name(SCHED_POLL), "poll") == 0);
+  CHECK(strcmp(sched_mode_name(SCHED_MODE_COUNT), "?") == 0);
+  return check_done("sched");
+}
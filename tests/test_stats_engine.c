@@ -0,0 +1,223 @@
+#include "features/stats/stats_engine.h"
+
+#include "check.h"
+
+static char g_path[256], g_journal[280];
+
+/* A local time on date (YYYYMMDD). */
+static time_t at(int date, int hour, int min) {
+  struct tm tmv;
+  memset(&tmv, 0, sizeof(tmv));
+  tmv.tm_year = date / 10000 - 1900;
+  tmv.tm_mon = date / 100 % 100 - 1;
+  tmv.tm_mday = date % 100;
+  tmv.tm_hour = hour;
+  tmv.tm_min = min;
+  tmv.tm_isdst = -1;
+  return mktime(&tmv);
+}
+
+static bool file_exists(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (f)
+    fclose(f);
+  return f != NULL;
+}
+
+static void test_empty(void) {
+  stats_engine_load(g_path);
+  CHECK(stats_engine_empty());
+  StatsSummary s;
+  stats_engine_summary(20261014, &s);
+  CHECK_EQ(s.active_days, 0);
+  CHECK_EQ(s.best_day_date, 0);
+  CHECK_EQ(stats_engine_activity_count(), 0);
+  CHECK_EQ(stats_month_minus(202603, 2), 202601);
+  CHECK_EQ(stats_month_minus(202601, 1), 202512);
+  CHECK_EQ(stats_month_minus(202601, 13), 202412);
+}
+
+/* Days, weeks (from Monday), months, streaks and hours from a few
+ * sessions; 2026-10-12 is a Monday. */
+static void test_sessions(void) {
+  stats_engine_add(at(20260920, 12, 0), 300, "Run");
+  stats_engine_add(at(20261009, 12, 0), 500, "Read");
+  stats_engine_add(at(20261012, 10, 30), 600, "Read");
+  stats_engine_add(at(20261013, 9, 0), 1200, "Write");
+  stats_engine_add(at(20261014, 10, 20), 1800, "Read"); /* from 9:50 */
+  stats_engine_add(at(20261014, 10, 20), 0, "Nothing");
+  CHECK(!stats_engine_empty());
+  StatsSummary s;
+  stats_engine_summary(20261014, &s);
+  CHECK_EQ(s.current_streak, 3);
+  CHECK_EQ(s.longest_streak, 3);
+  CHECK_EQ(s.active_days, 5);
+  CHECK_EQ(s.today_secs, 1800);
+  CHECK_EQ(s.week_secs, 3600);
+  CHECK_EQ(s.last_week_secs, 500);
+  CHECK_EQ(s.month_secs, 4100);
+  CHECK_EQ(s.last_month_secs, 300);
+  CHECK_EQ(s.best_day_secs, 1800);
+  CHECK_EQ(s.best_day_date, 20261014);
+  stats_engine_summary(20261015, &s);
+  CHECK_EQ(s.current_streak, 3);
+  CHECK_EQ(s.today_secs, 0);
+  stats_engine_summary(20261016, &s);
+  CHECK_EQ(s.current_streak, 0);
+  CHECK_EQ(s.longest_streak, 3);
+  stats_engine_summary(20261019, &s); /* the next Monday */
+  CHECK_EQ(s.week_secs, 0);
+  CHECK_EQ(s.last_week_secs, 3600);
+  uint64_t hours[24];
+  stats_engine_hours(hours);
+  CHECK_EQ(hours[8], 1200);
+  CHECK_EQ(hours[9], 600);
+  CHECK_EQ(hours[10], 1800);
+  CHECK_EQ(hours[11], 800);
+  CHECK_EQ(stats_engine_month(202610), 4100);
+  CHECK_EQ(stats_engine_month(202608), 0);
+  CHECK_EQ(stats_engine_activity_count(), 3);
+  CHECK_EQ(stats_engine_activity_month("Read", 202610), 2900);
+  CHECK_EQ(stats_engine_activity_month("Run", 202609), 300);
+  CHECK_EQ(stats_engine_activity_month("Swim", 202609), 0);
+  StatsActivity top[4];
+  CHECK_EQ(stats_engine_activities(top, 4), 3);
+  CHECK(strcmp(top[0].name, "Read") == 0);
+  CHECK_EQ(top[0].secs, 2900);
+  CHECK_EQ(top[0].sessions, 3);
+  CHECK(strcmp(top[1].name, "Write") == 0);
+  CHECK(strcmp(top[2].name, "Run") == 0);
+  /* The order follows the totals as they change. */
+  stats_engine_add(at(20261014, 11, 0), 3000, "Run");
+  CHECK_EQ(stats_engine_activities(top, 2), 2);
+  CHECK(strcmp(top[0].name, "Run") == 0);
+  CHECK_EQ(top[0].secs, 3300);
+  CHECK(strcmp(top[1].name, "Read") == 0);
+  stats_engine_hours(hours);
+  CHECK_EQ(hours[10], 4800);
+}
+
+/* Sessions not yet saved come back from the journal, whether or not there
+ * is a state file; a journal the state file already has is dropped. */
+static void test_journal(void) {
+  StatsSummary before, after;
+  stats_engine_summary(20261014, &before);
+  stats_engine_free(); /* no save: as if the power went */
+  CHECK(!file_exists(g_path));
+  CHECK(file_exists(g_journal));
+  stats_engine_load(g_path);
+  stats_engine_summary(20261014, &after);
+  CHECK_EQ(after.month_secs, before.month_secs);
+  CHECK_EQ(after.active_days, before.active_days);
+  CHECK_EQ(stats_engine_activity_month("Run", 202610), 3000);
+  stats_engine_save();
+  CHECK(file_exists(g_path));
+  CHECK(!file_exists(g_journal));
+  stats_engine_add(at(20261015, 8, 0), 60, "Write");
+  stats_engine_free();
+  stats_engine_load(g_path);
+  stats_engine_summary(20261015, &after);
+  CHECK_EQ(after.today_secs, 60);
+  CHECK_EQ(after.current_streak, 4);
+  stats_engine_save();
+  /* Left behind by a save cut short after the rename. */
+  char text[128];
+  snprintf(text, sizeof(text),
+           "# stillroom stats journal 1\nadd %lld 999\tGhost\n",
+           (long long)at(20261015, 9, 0));
+  check_write_file(g_journal, text);
+  stats_engine_free();
+  stats_engine_load(g_path);
+  stats_engine_summary(20261015, &after);
+  CHECK_EQ(after.today_secs, 60);
+  CHECK_EQ(stats_engine_activity_month("Ghost", 202610), 0);
+  CHECK(!file_exists(g_journal));
+}
+
+/* Names too long to store stay apart, cut on a character boundary, and
+ * survive a save. */
+static void test_long_names(void) {
+  char a[128] = "", b[128];
+  for (int i = 0; i < 40; i++)
+    strcat(a, "\xc3\xa9"); /* e acute */
+  snprintf(b, sizeof(b), "%sB", a);
+  strcat(a, "A");
+  const int count = stats_engine_activity_count();
+  stats_engine_add(at(20261015, 12, 0), 100, a);
+  stats_engine_add(at(20261015, 13, 0), 200, b);
+  stats_engine_add(at(20261015, 14, 0), 300, a);
+  CHECK_EQ(stats_engine_activity_count(), count + 2);
+  CHECK_EQ(stats_engine_activity_month(a, 202610), 400);
+  CHECK_EQ(stats_engine_activity_month(b, 202610), 200);
+  StatsActivity top[16];
+  const int n = stats_engine_activities(top, 16);
+  int found = 0;
+  for (int i = 0; i < n; i++) {
+    if (strncmp(top[i].name, a, 10) != 0)
+      continue;
+    found++;
+    CHECK(strlen(top[i].name) < 64);
+    CHECK_EQ(top[i].name[52], '~');
+  }
+  CHECK_EQ(found, 2);
+  stats_engine_save();
+  stats_engine_load(g_path);
+  CHECK_EQ(stats_engine_activity_count(), count + 2);
+  CHECK_EQ(stats_engine_activity_month(a, 202610), 400);
+  CHECK_EQ(stats_engine_activity_month(b, 202610), 200);
+}
+
+/* Seeded totals count as days and activities, but not as sessions or
+ * hours. */
+static void test_seed_and_remove(void) {
+  uint64_t hours[24], seeded[24];
+  stats_engine_hours(hours);
+  StatsSummary s;
+  stats_engine_summary(20261015, &s);
+  const int days = s.active_days;
+  stats_engine_seed_day(20250101, 7200);
+  stats_engine_seed_day(20250102, 0);
+  stats_engine_seed_activity("Old", 9000);
+  stats_engine_seed_activity("", 9000);
+  stats_engine_summary(20261015, &s);
+  CHECK_EQ(s.active_days, days + 1);
+  CHECK_EQ(s.best_day_secs, 7200);
+  CHECK_EQ(s.best_day_date, 20250101);
+  CHECK_EQ(stats_engine_month(202501), 7200);
+  stats_engine_hours(seeded);
+  CHECK(memcmp(hours, seeded, sizeof(hours)) == 0);
+  StatsActivity top[2];
+  CHECK_EQ(stats_engine_activities(top, 2), 2);
+  CHECK(strcmp(top[0].name, "Old") == 0);
+  CHECK_EQ(top[0].sessions, 0);
+  const int count = stats_engine_activity_count();
+  stats_engine_remove_activity("Old");
+  stats_engine_remove_activity("Nobody");
+  CHECK_EQ(stats_engine_activity_count(), count - 1);
+  stats_engine_activities(top, 2);
+  CHECK(strcmp(top[0].name, "Run") == 0);
+  CHECK_EQ(stats_engine_activity_month("Run", 202610), 3000);
+  stats_engine_save();
+  stats_engine_load(g_path);
+  CHECK_EQ(stats_engine_activity_count(), count - 1);
+  stats_engine_summary(20261015, &s);
+  CHECK_EQ(s.active_days, days + 1);
+  CHECK_EQ(s.longest_streak, 4);
+  CHECK_EQ(s.current_streak, 4);
+  CHECK_EQ(s.best_day_date, 20250101);
+  stats_engine_hours(seeded);
+  CHECK(memcmp(hours, seeded, sizeof(hours)) == 0);
+}
+
+int main(void) {
+  const char *dir = check_scratch_dir();
+  snprintf(g_path, sizeof(g_path), "%s/stats.txt", dir);
+  snprintf(g_journal, sizeof(g_journal), "%s.journal", g_path);
+  test_empty();
+  test_sessions();
+  test_journal();
+  test_long_names();
+  test_seed_and_remove();
+  stats_engine_free();
+  return check_done("stats_engine");
+}